@@ -433,6 +433,7 @@ else ()
     src/ripple/app/ledger/impl/LedgerToJson.cpp
     src/ripple/app/ledger/impl/LocalTxs.cpp
     src/ripple/app/ledger/impl/OpenLedger.cpp
+    src/ripple/app/ledger/impl/ParsedSLECache.cpp
     src/ripple/app/ledger/impl/TransactionAcquire.cpp
     src/ripple/app/ledger/impl/TransactionMaster.cpp
     src/ripple/app/main/Application.cpp
@@ -516,6 +517,7 @@ else ()
     src/ripple/basics/impl/BasicConfig.cpp
     src/ripple/basics/impl/PerfLogImp.cpp
     src/ripple/basics/impl/ResolverAsio.cpp
+    src/ripple/basics/impl/SlabAllocator.cpp
     src/ripple/basics/impl/Sustain.cpp
     src/ripple/basics/impl/UptimeClock.cpp
     src/ripple/basics/impl/make_SSLContext.cpp
@@ -586,16 +588,21 @@ else ()
     src/ripple/nodestore/backend/NullFactory.cpp
     src/ripple/nodestore/backend/RocksDBFactory.cpp
     src/ripple/nodestore/impl/BatchWriter.cpp
+    src/ripple/nodestore/impl/BloomFilter.cpp
+    src/ripple/nodestore/impl/CompressionDictionary.cpp
     src/ripple/nodestore/impl/Database.cpp
     src/ripple/nodestore/impl/DatabaseNodeImp.cpp
     src/ripple/nodestore/impl/DatabaseRotatingImp.cpp
     src/ripple/nodestore/impl/DatabaseShardImp.cpp
+    src/ripple/nodestore/impl/DatabaseTieredImp.cpp
     src/ripple/nodestore/impl/DecodedBlob.cpp
     src/ripple/nodestore/impl/DummyScheduler.cpp
     src/ripple/nodestore/impl/EncodedBlob.cpp
+    src/ripple/nodestore/impl/FilteredBackend.cpp
     src/ripple/nodestore/impl/ManagerImp.cpp
     src/ripple/nodestore/impl/NodeObject.cpp
     src/ripple/nodestore/impl/Shard.cpp
+    src/ripple/nodestore/impl/Trace.cpp
     #[===============================[
        nounity, main sources:
          subdir: overlay
@@ -607,8 +614,12 @@ else ()
     src/ripple/overlay/impl/PeerImp.cpp
     src/ripple/overlay/impl/PeerReservationTable.cpp
     src/ripple/overlay/impl/PeerSet.cpp
+    src/ripple/overlay/impl/ReceivedTransactions.cpp
+    src/ripple/overlay/impl/SendQueue.cpp
+    src/ripple/overlay/impl/Squelch.cpp
     src/ripple/overlay/impl/TMHello.cpp
     src/ripple/overlay/impl/TrafficCount.cpp
+    src/ripple/overlay/impl/TransactionRelay.cpp
     #[===============================[
        nounity, main sources:
          subdir: peerfinder
@@ -718,6 +729,7 @@ else ()
     src/ripple/shamap/impl/SHAMapNodeID.cpp
     src/ripple/shamap/impl/SHAMapSync.cpp
     src/ripple/shamap/impl/SHAMapTreeNode.cpp
+    src/ripple/shamap/impl/SHAMapWorkers.cpp
     #[===============================[
        nounity, test sources:
          subdir: app
@@ -734,6 +746,7 @@ else ()
     src/test/app/Flow_test.cpp
     src/test/app/Freeze_test.cpp
     src/test/app/HashRouter_test.cpp
+    src/test/app/LedgerFetchPack_test.cpp
     src/test/app/LedgerHistory_test.cpp
     src/test/app/LedgerLoad_test.cpp
     src/test/app/LedgerReplay_test.cpp
@@ -772,6 +785,7 @@ else ()
     src/test/basics/KeyCache_test.cpp
     src/test/basics/PerfLog_test.cpp
     src/test/basics/RangeSet_test.cpp
+    src/test/basics/SlabAllocator_test.cpp
     src/test/basics/Slice_test.cpp
     src/test/basics/StringUtilities_test.cpp
     src/test/basics/TaggedCache_test.cpp
@@ -897,6 +911,7 @@ else ()
     src/test/ledger/CashDiff_test.cpp
     src/test/ledger/Directory_test.cpp
     src/test/ledger/Invariants_test.cpp
+    src/test/ledger/ParsedSLECache_test.cpp
     src/test/ledger/PaymentSandbox_test.cpp
     src/test/ledger/PendingSaves_test.cpp
     src/test/ledger/SkipList_test.cpp
@@ -914,6 +929,7 @@ else ()
     src/test/nodestore/Basics_test.cpp
     src/test/nodestore/Database_test.cpp
     src/test/nodestore/Timing_test.cpp
+    src/test/nodestore/TraceReplay_test.cpp
     src/test/nodestore/import_test.cpp
     src/test/nodestore/varint_test.cpp
     #[===============================[
@@ -921,8 +937,14 @@ else ()
          subdir: overlay
     #]===============================]
     src/test/overlay/TMHello_test.cpp
+    src/test/overlay/broadcast_test.cpp
     src/test/overlay/cluster_test.cpp
+    src/test/overlay/compression_test.cpp
+    src/test/overlay/received_transactions_test.cpp
+    src/test/overlay/send_queue_test.cpp
     src/test/overlay/short_read_test.cpp
+    src/test/overlay/squelch_test.cpp
+    src/test/overlay/transaction_relay_test.cpp
     #[===============================[
        nounity, test sources:
          subdir: peerfinder
@@ -949,6 +971,7 @@ else ()
     src/test/protocol/TER_test.cpp
     src/test/protocol/XRPAmount_test.cpp
     src/test/protocol/digest_test.cpp
+    src/test/protocol/sha512HalfMany_test.cpp
     src/test/protocol/types_test.cpp
     #[===============================[
        nounity, test sources:
@@ -1004,8 +1027,12 @@ else ()
          subdir: shamap
     #]===============================]
     src/test/shamap/FetchPack_test.cpp
+    src/test/shamap/SHAMapCompare_test.cpp
+    src/test/shamap/SHAMapFlush_test.cpp
+    src/test/shamap/SHAMapMemory_test.cpp
     src/test/shamap/SHAMapSync_test.cpp
     src/test/shamap/SHAMap_test.cpp
+    src/test/shamap/SHAMapWorkers_test.cpp
     #[===============================[
        nounity, test sources:
          subdir: unit_test
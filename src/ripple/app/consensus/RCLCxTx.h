@@ -91,7 +91,7 @@ public:
         insert(Tx const& t)
         {
             return map_->addItem(
-                SHAMapItem{t.id(), t.tx_.peekData()}, true, false);
+                SHAMapItem{t.id(), t.tx_.slice()}, true, false);
         }
 
         /** Remove a transaction from the set.
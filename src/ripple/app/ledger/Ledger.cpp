@@ -24,6 +24,7 @@
 #include <ripple/consensus/LedgerTiming.h>
 #include <ripple/app/ledger/LedgerToJson.h>
 #include <ripple/app/ledger/OrderBookDB.h>
+#include <ripple/app/ledger/ParsedSLECache.h>
 #include <ripple/app/ledger/PendingSaves.h>
 #include <ripple/app/ledger/TransactionMaster.h>
 #include <ripple/app/main/Application.h>
@@ -428,9 +429,9 @@ Ledger::read (Keylet const& k) const
         stateMap_->peekItem(k.key);
     if (! item)
         return nullptr;
-    auto sle = std::make_shared<SLE>(
-        SerialIter{item->data(),
-            item->size()}, item->key());
+    auto const cache = stateMap_->family().parsedSLEs();
+    auto sle = cache ? cache->fetch(item) : std::make_shared<SLE const>(
+        SerialIter{item->data(), item->size()}, item->key());
     if (! k.check(*sle))
         return nullptr;
     return sle;
@@ -524,9 +525,7 @@ Ledger::rawInsert(std::shared_ptr<SLE> const& sle)
 {
     Serializer ss;
     sle->add(ss);
-    auto item = std::make_shared<
-        SHAMapItem const>(sle->key(),
-            std::move(ss));
+    auto item = makeSHAMapItem(sle->key(), std::move(ss));
     // VFALCO NOTE addGiveItem should take ownership
     if (! stateMap_->addGiveItem(
             std::move(item), false, false))
@@ -538,9 +537,7 @@ Ledger::rawReplace(std::shared_ptr<SLE> const& sle)
 {
     Serializer ss;
     sle->add(ss);
-    auto item = std::make_shared<
-        SHAMapItem const>(sle->key(),
-            std::move(ss));
+    auto item = makeSHAMapItem(sle->key(), std::move(ss));
     // VFALCO NOTE updateGiveItem should take ownership
     if (! stateMap_->updateGiveItem(
             std::move(item), false, false))
@@ -560,8 +557,7 @@ Ledger::rawTxInsert (uint256 const& key,
         metaData->getDataLength () + 16);
     s.addVL (txn->peekData ());
     s.addVL (metaData->peekData ());
-    auto item = std::make_shared<
-        SHAMapItem const> (key, std::move(s));
+    auto item = makeSHAMapItem(key, std::move(s));
     if (! txMap().addGiveItem
             (std::move(item), true, true))
         LogicError("duplicate_tx: " + to_string(key));
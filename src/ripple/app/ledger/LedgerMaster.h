@@ -30,16 +30,20 @@
 #include <ripple/app/ledger/LedgerReplay.h>
 #include <ripple/app/misc/CanonicalTXSet.h>
 #include <ripple/basics/chrono.h>
+#include <ripple/basics/DecayingSample.h>
 #include <ripple/basics/RangeSet.h>
 #include <ripple/basics/StringUtilities.h>
 #include <ripple/beast/insight/Collector.h>
 #include <ripple/beast/utility/PropertyStream.h>
 #include <ripple/core/Stoppable.h>
+#include <ripple/overlay/Peer.h>
 #include <ripple/protocol/messages.h>
 #include <ripple/protocol/Protocol.h>
 #include <ripple/protocol/RippleLedgerHash.h>
 #include <ripple/protocol/STValidation.h>
+#include <ripple/resource/Charge.h>
 
+#include <atomic>
 #include <mutex>
 
 namespace ripple {
@@ -236,6 +240,45 @@ public:
         uint256 const& hash,
         std::shared_ptr<Blob>& data);
 
+    /** An object received in a fetch pack. */
+    struct FetchPackObject
+    {
+        uint256 hash;
+        std::uint32_t ledgerSeq;
+        Blob data;
+    };
+
+    /** Returns whether a fetch pack reply is one we asked for.
+
+        Only the peer the last fetch pack was requested from may answer,
+        for the ledger that was requested, until the request times out.
+    */
+    bool wantFetchPack (
+        Peer::id_t peer,
+        uint256 const& ledgerHash);
+
+    /** Take a fetch pack reply from a peer.
+
+        A reply we did not ask for is ignored. Otherwise the objects
+        for ledgers we do not have yet are stored. Returns the fee to
+        charge the peer.
+    */
+    Resource::Charge receiveFetchPack (
+        Peer::id_t peer,
+        protocol::TMGetObjectByHash const& packet);
+
+    /** Verify received fetch pack objects and write them to the node store.
+
+        The work is done on the job queue, in batches, after which
+        gotFetchPack is called with progress and seq. Returns false,
+        dropping the objects, if too many batches are already queued;
+        the pack is then requested again.
+    */
+    bool storeFetchPack (
+        std::vector<FetchPackObject> objects,
+        bool progress,
+        std::uint32_t seq);
+
     boost::optional<Blob>
     getFetchPack (uint256 const& hash) override;
 
@@ -247,6 +290,9 @@ public:
 
     std::size_t getFetchPackCacheSize () const;
 
+    /** Returns the number of fetch pack objects stored per minute. */
+    std::size_t getFetchPackRate ();
+
     //! Whether we have ever fully validated a ledger.
     bool
     haveValidated()
@@ -365,7 +411,21 @@ private:
 
     TaggedCache<uint256, Blob> fetch_packs_;
 
-    std::uint32_t fetch_seq_ {0};
+    Stopwatch& stopwatch_;
+    std::mutex fetchPackRateMutex_;
+    // measures fetch pack objects stored per second
+    DecayWindow<30, Stopwatch> fetchPackRate_;
+
+    std::atomic<std::uint32_t> fetch_seq_ {0};
+
+    // The outstanding fetch pack request
+    std::mutex fetchPackRequestMutex_;
+    Peer::id_t fetchPackPeer_ {0};
+    uint256 fetchPackHash_;
+    Stopwatch::time_point fetchPackExpires_;
+
+    // Fetch pack batches waiting to be stored
+    std::atomic<int> fetchPackJobs_ {0};
 
     // Try to keep a validator from switching from test to live network
     // without first wiping the database.
@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#ifndef RIPPLE_APP_LEDGER_PARSEDSLECACHE_H_INCLUDED
+#define RIPPLE_APP_LEDGER_PARSEDSLECACHE_H_INCLUDED
+
+#include <ripple/protocol/STLedgerEntry.h>
+#include <ripple/shamap/SHAMapItem.h>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace ripple {
+
+/** Keeps parsed ledger entries attached to the state map items they
+    were parsed from.
+
+    A SHAMapItem is immutable and shared by every ledger whose state map
+    contains it, so its parsed form can be too. The first read of an
+    item parses it and attaches the result; later reads, from any
+    ledger, return the attached entry.
+
+    The memory held by parsed entries is bounded by a budget. When the
+    budget is exceeded the entries attached longest ago are detached
+    from their items, and are parsed again on their next read.
+*/
+class ParsedSLECache
+{
+public:
+    ParsedSLECache (ParsedSLECache const&) = delete;
+    ParsedSLECache& operator= (ParsedSLECache const&) = delete;
+
+    explicit
+    ParsedSLECache (std::size_t budget);
+
+    /** Returns the item parsed as a ledger entry.
+
+        The entry is attached to the item if the budget permits.
+    */
+    std::shared_ptr<SLE const>
+    fetch (std::shared_ptr<SHAMapItem const> const& item);
+
+    /** Set the number of bytes parsed entries may hold.
+
+        A budget of zero detaches every entry and stops attaching new ones.
+    */
+    void
+    setBudget (std::size_t bytes);
+
+    /** Returns the estimated number of bytes held by attached entries. */
+    std::size_t
+    size() const;
+
+    /** Returns the number of attached entries. */
+    std::size_t
+    count() const;
+
+    /** Returns the fraction of fetches that found an attached entry. */
+    double
+    rate() const;
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<SHAMapItem const> item;
+        std::size_t bytes;
+    };
+
+    void
+    evict (std::lock_guard<std::mutex> const&);
+
+    std::mutex mutable mutex_;
+    std::size_t budget_;
+    std::size_t bytes_ = 0;
+    std::atomic<std::size_t> hit_ {0};
+    std::atomic<std::size_t> miss_ {0};
+
+    // Attached entries, oldest first
+    std::deque<Entry> entries_;
+};
+
+} // ripple
+
+#endif
@@ -912,6 +912,9 @@ bool InboundLedger::takeTxNode (const std::vector<SHAMapNodeID>& nodeIDs,
     TransactionStateSF filter(mLedger->txMap().family().db(),
         app_.getLedgerMaster());
 
+    std::vector<std::pair<SHAMapNodeID, Slice>> nodes;
+    nodes.reserve (nodeIDs.size ());
+
     while (nodeIDit != nodeIDs.cend ())
     {
         if (nodeIDit->isRoot ())
@@ -924,16 +927,20 @@ bool InboundLedger::takeTxNode (const std::vector<SHAMapNodeID>& nodeIDs,
         }
         else
         {
-            san +=  mLedger->txMap().addKnownNode (
-                *nodeIDit, makeSlice(*nodeDatait), &filter);
-            if (!san.isGood())
-                return false;
+            nodes.emplace_back (*nodeIDit, makeSlice(*nodeDatait));
         }
 
         ++nodeIDit;
         ++nodeDatait;
     }
 
+    if (!nodes.empty ())
+    {
+        san += mLedger->txMap().addKnownNodes (nodes, &filter);
+        if (!san.isGood())
+            return false;
+    }
+
     if (!mLedger->txMap().isSynching ())
     {
         mHaveTransactions = true;
@@ -984,6 +991,9 @@ bool InboundLedger::takeAsNode (const std::vector<SHAMapNodeID>& nodeIDs,
     AccountStateSF filter(mLedger->stateMap().family().db(),
         app_.getLedgerMaster());
 
+    std::vector<std::pair<SHAMapNodeID, Slice>> nodes;
+    nodes.reserve (nodeIDs.size ());
+
     while (nodeIDit != nodeIDs.cend ())
     {
         if (nodeIDit->isRoot ())
@@ -1000,20 +1010,24 @@ bool InboundLedger::takeAsNode (const std::vector<SHAMapNodeID>& nodeIDs,
         }
         else
         {
-            san += mLedger->stateMap().addKnownNode (
-                *nodeIDit, makeSlice(*nodeDatait), &filter);
-            if (!san.isGood ())
-            {
-                JLOG (m_journal.warn()) <<
-                    "Unable to add AS node";
-                return false;
-            }
+            nodes.emplace_back (*nodeIDit, makeSlice(*nodeDatait));
         }
 
         ++nodeIDit;
         ++nodeDatait;
     }
 
+    if (!nodes.empty ())
+    {
+        san += mLedger->stateMap().addKnownNodes (nodes, &filter);
+        if (!san.isGood ())
+        {
+            JLOG (m_journal.warn()) <<
+                "Unable to add AS node";
+            return false;
+        }
+    }
+
     if (!mLedger->stateMap().isSynching ())
     {
         mHaveState = true;
@@ -139,6 +139,45 @@ static constexpr std::chrono::minutes MAX_LEDGER_AGE_ACQUIRE {1};
 // Don't acquire history if write load is too high
 static constexpr int MAX_WRITE_LOAD_ACQUIRE {8192};
 
+// Send fetch packs in messages of at most this many objects or bytes
+static constexpr int FETCH_PACK_CHUNK_OBJECTS {256};
+static constexpr std::size_t FETCH_PACK_CHUNK_BYTES {256 * 1024};
+
+// Verify received fetch pack objects in batches of this many
+static constexpr std::size_t FETCH_PACK_STORE_BATCH {256};
+
+// Accept fetch pack replies for this long after the request
+static constexpr std::chrono::seconds FETCH_PACK_REPLY_TIMEOUT {45};
+
+// Drop received fetch pack messages while this many wait to be stored,
+// and request the pack again
+static constexpr int MAX_FETCH_PACK_JOBS {8};
+
+// Returns the node store type of a fetch pack object, from its prefix
+static NodeObjectType
+fetchPackType (Blob const& data)
+{
+    if (data.size () < 4)
+        return hotUNKNOWN;
+
+    std::uint32_t const prefix =
+        (std::uint32_t (data[0]) << 24) | (std::uint32_t (data[1]) << 16) |
+        (std::uint32_t (data[2]) << 8) | std::uint32_t (data[3]);
+
+    if (prefix == HashPrefix::ledgerMaster)
+        return hotLEDGER;
+
+    // Inner nodes do not say which tree they belong to, and most
+    // fetch pack nodes are state nodes.
+    if (prefix == HashPrefix::innerNode || prefix == HashPrefix::leafNode)
+        return hotACCOUNT_NODE;
+
+    if (prefix == HashPrefix::txNode || prefix == HashPrefix::transactionID)
+        return hotTRANSACTION_NODE;
+
+    return hotUNKNOWN;
+}
+
 LedgerMaster::LedgerMaster (Application& app, Stopwatch& stopwatch,
     Stoppable& parent,
     beast::insight::Collector::ptr const& collector, beast::Journal journal)
@@ -155,6 +194,8 @@ LedgerMaster::LedgerMaster (Application& app, Stopwatch& stopwatch,
     , ledger_fetch_size_ (app_.config().getSize (siLedgerFetch))
     , fetch_packs_ ("FetchPack", 65536, std::chrono::seconds {45}, stopwatch,
         app_.journal("TaggedCache"))
+    , stopwatch_ (stopwatch)
+    , fetchPackRate_ (stopwatch.now())
 {
 }
 
@@ -721,6 +762,13 @@ LedgerMaster::getFetchPack (LedgerIndex missing,
         auto packet = std::make_shared<Message> (
             tmBH, protocol::mtGET_OBJECTS);
 
+        {
+            std::lock_guard lock (fetchPackRequestMutex_);
+            fetchPackPeer_ = target->id ();
+            fetchPackHash_ = *haveHash;
+            fetchPackExpires_ = stopwatch_.now () + FETCH_PACK_REPLY_TIMEOUT;
+        }
+
         target->send (packet);
         JLOG(m_journal.trace()) << "Requested fetch pack for " << missing;
     }
@@ -1921,6 +1969,140 @@ LedgerMaster::addFetchPack (
     fetch_packs_.canonicalize (hash, data);
 }
 
+bool
+LedgerMaster::wantFetchPack (
+    Peer::id_t peer,
+    uint256 const& ledgerHash)
+{
+    std::lock_guard lock (fetchPackRequestMutex_);
+    return peer == fetchPackPeer_ && ledgerHash == fetchPackHash_ &&
+        stopwatch_.now () < fetchPackExpires_;
+}
+
+Resource::Charge
+LedgerMaster::receiveFetchPack (
+    Peer::id_t peer,
+    protocol::TMGetObjectByHash const& packet)
+{
+    if (! packet.has_ledgerhash () ||
+        packet.ledgerhash ().size () != uint256::size () ||
+        ! wantFetchPack (peer, uint256 {packet.ledgerhash ()}))
+    {
+        JLOG (m_journal.debug()) << "Unsolicited fetch pack from " << peer;
+        return Resource::feeUnwantedData;
+    }
+
+    std::uint32_t seq = 0;
+    bool want = true;
+    bool progress = false;
+    std::vector<FetchPackObject> objects;
+    objects.reserve (packet.objects_size ());
+    for (auto const& obj : packet.objects ())
+    {
+        if (! obj.has_hash () || obj.hash ().size () != uint256::size ())
+            continue;
+
+        if (obj.has_ledgerseq () && obj.ledgerseq () != seq)
+        {
+            seq = obj.ledgerseq ();
+            want = ! haveLedger (seq);
+            if (want)
+                progress = true;
+            else
+                JLOG (m_journal.debug()) << "Late fetch pack for " << seq;
+        }
+
+        if (want)
+        {
+            objects.push_back ({uint256 {obj.hash ()}, seq,
+                Blob (obj.data ().begin (), obj.data ().end ())});
+        }
+    }
+
+    storeFetchPack (std::move (objects), progress, seq);
+    return Resource::feeLightPeer;
+}
+
+bool
+LedgerMaster::storeFetchPack (
+    std::vector<FetchPackObject> objects,
+    bool progress,
+    std::uint32_t seq)
+{
+    if (++fetchPackJobs_ > MAX_FETCH_PACK_JOBS)
+    {
+        --fetchPackJobs_;
+        // The pack is now incomplete, let the next pass over the
+        // missing ledgers ask for it again
+        fetch_seq_ = 0;
+        JLOG (m_journal.debug()) << "Dropped " << objects.size () <<
+            " fetch pack objects, too many waiting to be stored";
+        return false;
+    }
+
+    bool const added = app_.getJobQueue().addJob (
+        jtLEDGER_DATA, "storeFetchPack",
+        [this, objects = std::move (objects), progress, seq] (Job&) mutable
+        {
+            --fetchPackJobs_;
+
+            auto& db = app_.getNodeStore ();
+            auto const start = stopwatch_.now ();
+            std::size_t stored = 0;
+            std::size_t bytes = 0;
+
+            std::vector<Slice> slices;
+            std::vector<uint256> digests;
+            for (std::size_t begin = 0; begin < objects.size ();
+                begin += FETCH_PACK_STORE_BATCH)
+            {
+                auto const end = std::min (
+                    objects.size (), begin + FETCH_PACK_STORE_BATCH);
+
+                slices.clear ();
+                for (auto i = begin; i < end; ++i)
+                    slices.push_back (makeSlice (objects[i].data));
+                digests.resize (slices.size ());
+                sha512HalfMany (slices.data (), digests.data (), slices.size ());
+
+                for (auto i = begin; i < end; ++i)
+                {
+                    auto& object = objects[i];
+                    auto const type = fetchPackType (object.data);
+                    if (type == hotUNKNOWN || digests[i - begin] != object.hash)
+                        continue;
+
+                    bytes += object.data.size ();
+                    db.store (type, std::move (object.data),
+                        object.hash, object.ledgerSeq);
+                    ++stored;
+                }
+            }
+
+            auto const now = stopwatch_.now ();
+            {
+                std::lock_guard lock (fetchPackRateMutex_);
+                fetchPackRate_.add (stored, now);
+            }
+
+            using namespace std::chrono;
+            JLOG (m_journal.debug()) <<
+                "Stored " << stored << " of " << objects.size () <<
+                " fetch pack objects (" << bytes << " bytes) in " <<
+                duration_cast<milliseconds> (now - start).count () << "ms";
+            if (stored != objects.size ())
+            {
+                JLOG (m_journal.warn()) << "Fetch pack had " <<
+                    objects.size () - stored << " invalid objects";
+            }
+
+            gotFetchPack (progress, seq);
+        });
+    if (! added)
+        --fetchPackJobs_;
+    return added;
+}
+
 boost::optional<Blob>
 LedgerMaster::getFetchPack (
     uint256 const& hash)
@@ -1932,6 +2114,14 @@ LedgerMaster::getFetchPack (
         if (hash == sha512Half(makeSlice(data)))
             return data;
     }
+
+    // Fetch packs are written to the node store as they arrive, but
+    // shard acquisitions only look in the shard store.
+    if (app_.getShardStore ())
+    {
+        if (auto node = app_.getNodeStore ().fetch (hash, 0))
+            return node->getData ();
+    }
     return boost::none;
 }
 
@@ -2018,21 +2208,16 @@ LedgerMaster::makeFetchPack (
     }
 
 
-    auto fpAppender = [](
-        protocol::TMGetObjectByHash* reply,
-        std::uint32_t ledgerSeq,
-        SHAMapHash const& hash,
-        const Blob& blob)
-    {
-        protocol::TMIndexedObject& newObj = * (reply->add_objects ());
-        newObj.set_ledgerseq (ledgerSeq);
-        newObj.set_hash (hash.as_uint256().begin (), 256 / 8);
-        newObj.set_data (&blob[0], blob.size ());
-    };
+    // The fetch pack is sent in bounded messages as it is built, so the
+    // memory used does not depend on the size of the pack.
+    protocol::TMGetObjectByHash reply;
+    std::size_t replyBytes = 0;
+    int total = 0;
+    int messages = 0;
 
-    try
+    auto startReply = [&]()
     {
-        protocol::TMGetObjectByHash reply;
+        reply.Clear ();
         reply.set_query (false);
 
         if (request->has_seq ())
@@ -2040,6 +2225,41 @@ LedgerMaster::makeFetchPack (
 
         reply.set_ledgerhash (request->ledgerhash ());
         reply.set_type (protocol::TMGetObjectByHash::otFETCH_PACK);
+        replyBytes = 0;
+    };
+
+    auto sendReply = [&]()
+    {
+        if (reply.objects_size () == 0)
+            return;
+        total += reply.objects_size ();
+        ++messages;
+        peer->send (std::make_shared<Message> (
+            reply, protocol::mtGET_OBJECTS));
+        startReply ();
+    };
+
+    auto fpAppender = [&](
+        std::uint32_t ledgerSeq,
+        SHAMapHash const& hash,
+        void const* data,
+        std::size_t size)
+    {
+        protocol::TMIndexedObject& newObj = * (reply.add_objects ());
+        newObj.set_ledgerseq (ledgerSeq);
+        newObj.set_hash (hash.as_uint256().begin (), 256 / 8);
+        newObj.set_data (data, size);
+
+        replyBytes += size;
+        if (reply.objects_size () >= FETCH_PACK_CHUNK_OBJECTS ||
+                replyBytes >= FETCH_PACK_CHUNK_BYTES)
+            sendReply ();
+    };
+
+    try
+    {
+        auto const start = std::chrono::steady_clock::now ();
+        startReply ();
 
         // Building a fetch pack:
         //  1. Add the header for the requested ledger.
@@ -2047,34 +2267,33 @@ LedgerMaster::makeFetchPack (
         //  3. If there are transactions, add the nodes for the
         //     transactions of the ledger.
         //  4. If the FetchPack now contains greater than or equal to
-        //     256 entries then stop.
+        //     512 entries then stop.
         //  5. If not very much time has elapsed, then loop back and repeat
         //     the same process adding the previous ledger to the FetchPack.
         do
         {
             std::uint32_t lSeq = wantLedger->info().seq;
 
-            protocol::TMIndexedObject& newObj = *reply.add_objects ();
-            newObj.set_hash (
-                wantLedger->info().hash.data(), 256 / 8);
             Serializer s (256);
             s.add32 (HashPrefix::ledgerMaster);
             addRaw(wantLedger->info(), s);
-            newObj.set_data (s.getDataPtr (), s.getLength ());
-            newObj.set_ledgerseq (lSeq);
+            fpAppender (lSeq, SHAMapHash{wantLedger->info().hash},
+                s.getDataPtr (), s.getLength ());
+
+            auto appendNode = [&fpAppender, lSeq] (
+                SHAMapHash const& hash, Blob const& blob)
+            {
+                fpAppender (lSeq, hash, blob.data (), blob.size ());
+            };
 
             wantLedger->stateMap().getFetchPack
-                (&haveLedger->stateMap(), true, 16384,
-                    std::bind (fpAppender, &reply, lSeq, std::placeholders::_1,
-                               std::placeholders::_2));
+                (&haveLedger->stateMap(), true, 16384, appendNode);
 
             if (wantLedger->info().txHash.isNonZero ())
                 wantLedger->txMap().getFetchPack (
-                    nullptr, true, 512,
-                    std::bind (fpAppender, &reply, lSeq, std::placeholders::_1,
-                               std::placeholders::_2));
+                    nullptr, true, 512, appendNode);
 
-            if (reply.objects ().size () >= 512)
+            if (total + reply.objects_size () >= 512)
                 break;
 
             // move may save a ref/unref
@@ -2084,10 +2303,14 @@ LedgerMaster::makeFetchPack (
         while (wantLedger &&
                UptimeClock::now() <= uptime + 1s);
 
+        sendReply ();
+
+        using namespace std::chrono;
         JLOG(m_journal.info())
-            << "Built fetch pack with " << reply.objects ().size () << " nodes";
-        auto msg = std::make_shared<Message> (reply, protocol::mtGET_OBJECTS);
-        peer->send (msg);
+            << "Sent fetch pack with " << total << " nodes in "
+            << messages << " messages, "
+            << duration_cast<milliseconds> (steady_clock::now () - start).count ()
+            << "ms";
     }
     catch (std::exception const&)
     {
@@ -2101,4 +2324,11 @@ LedgerMaster::getFetchPackCacheSize () const
     return fetch_packs_.getCacheSize ();
 }
 
+std::size_t
+LedgerMaster::getFetchPackRate ()
+{
+    std::lock_guard lock (fetchPackRateMutex_);
+    return 60 * fetchPackRate_.value (stopwatch_.now ());
+}
+
 } // ripple
@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <ripple/app/ledger/ParsedSLECache.h>
+#include <ripple/protocol/Serializer.h>
+
+namespace ripple {
+
+ParsedSLECache::ParsedSLECache (std::size_t budget)
+    : budget_ (budget)
+{
+}
+
+std::shared_ptr<SLE const>
+ParsedSLECache::fetch (std::shared_ptr<SHAMapItem const> const& item)
+{
+    if (auto sle = item->getSLE())
+    {
+        hit_.fetch_add (1, std::memory_order_relaxed);
+        return sle;
+    }
+
+    miss_.fetch_add (1, std::memory_order_relaxed);
+    std::shared_ptr<SLE const> sle = std::make_shared<SLE> (
+        SerialIter{item->data(), item->size()}, item->key());
+
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        if (budget_ == 0)
+            return sle;
+
+        // Another thread may have attached the item meanwhile
+        if (auto attached = item->getSLE())
+            return attached;
+
+        std::size_t const bytes = sizeof (SLE) +
+            sle->getCount() * sizeof (detail::STVar) + item->size();
+        item->setSLE (sle);
+        entries_.push_back ({item, bytes});
+        bytes_ += bytes;
+        evict (lock);
+    }
+    return sle;
+}
+
+void
+ParsedSLECache::setBudget (std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    budget_ = bytes;
+    evict (lock);
+}
+
+void
+ParsedSLECache::evict (std::lock_guard<std::mutex> const&)
+{
+    // Items that were destroyed while attached still count against the
+    // budget until they reach the front.
+    while (bytes_ > budget_ && ! entries_.empty())
+    {
+        auto& entry = entries_.front();
+        if (auto item = entry.item.lock())
+            item->setSLE (nullptr);
+        bytes_ -= entry.bytes;
+        entries_.pop_front();
+    }
+}
+
+std::size_t
+ParsedSLECache::size() const
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    return bytes_;
+}
+
+std::size_t
+ParsedSLECache::count() const
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    return entries_.size();
+}
+
+double
+ParsedSLECache::rate() const
+{
+    auto const hit = hit_.load (std::memory_order_relaxed);
+    auto const tot = hit + miss_.load (std::memory_order_relaxed);
+    if (tot == 0)
+        return 0;
+    return double (hit) / tot;
+}
+
+} // ripple
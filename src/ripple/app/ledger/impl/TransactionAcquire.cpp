@@ -207,6 +207,7 @@ SHAMapAddNode TransactionAcquire::takeNodes (const std::list<SHAMapNodeID>& node
         std::list<SHAMapNodeID>::const_iterator nodeIDit = nodeIDs.begin ();
         std::list< Blob >::const_iterator nodeDatait = data.begin ();
         ConsensusTransSetSF sf (app_, app_.getTempNodeCache ());
+        std::vector<std::pair<SHAMapNodeID, Slice>> nodes;
 
         while (nodeIDit != nodeIDs.end ())
         {
@@ -222,16 +223,21 @@ SHAMapAddNode TransactionAcquire::takeNodes (const std::list<SHAMapNodeID>& node
                 else
                     mHaveRoot = true;
             }
-            else if (!mMap->addKnownNode (*nodeIDit, makeSlice(*nodeDatait), &sf).isGood())
+            else
             {
-                JLOG (j_.warn()) << "TX acquire got bad non-root node";
-                return SHAMapAddNode::invalid ();
+                nodes.emplace_back (*nodeIDit, makeSlice(*nodeDatait));
             }
 
             ++nodeIDit;
             ++nodeDatait;
         }
 
+        if (!nodes.empty () && mMap->addKnownNodes (nodes, &sf).isInvalid ())
+        {
+            JLOG (j_.warn()) << "TX acquire got bad non-root node";
+            return SHAMapAddNode::invalid ();
+        }
+
         trigger (peer);
         progress ();
         return SHAMapAddNode::useful ();
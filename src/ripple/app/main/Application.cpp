@@ -29,6 +29,7 @@
 #include <ripple/app/ledger/LedgerToJson.h>
 #include <ripple/app/ledger/OpenLedger.h>
 #include <ripple/app/ledger/OrderBookDB.h>
+#include <ripple/app/ledger/ParsedSLECache.h>
 #include <ripple/app/ledger/PendingSaves.h>
 #include <ripple/app/ledger/InboundTransactions.h>
 #include <ripple/app/ledger/TransactionMaster.h>
@@ -92,6 +93,7 @@ private:
     FullBelowCache fullbelow_;
     NodeStore::Database& db_;
     bool const shardBacked_;
+    SHAMapWorkers workers_;
     beast::Journal j_;
 
     // missing node handler
@@ -183,6 +185,18 @@ public:
         return shardBacked_;
     }
 
+    SHAMapWorkers&
+    workers() override
+    {
+        return workers_;
+    }
+
+    ParsedSLECache*
+    parsedSLEs() override
+    {
+        return &app_.parsedSLEs();
+    }
+
     void
     missing_node (std::uint32_t seq) override
     {
@@ -335,6 +349,7 @@ public:
     NodeCache m_tempNodeCache;
     std::unique_ptr <CollectorManager> m_collectorManager;
     CachedSLEs cachedSLEs_;
+    ParsedSLECache parsedSLEs_;
     std::pair<PublicKey, SecretKey> nodeIdentity_;
     ValidatorKeys const validatorKeys_;
 
@@ -440,6 +455,7 @@ public:
         , m_collectorManager (CollectorManager::New (
             config_->section (SECTION_INSIGHT), logs_->journal("Collector")))
         , cachedSLEs_ (std::chrono::minutes(1), stopwatch())
+        , parsedSLEs_ (megabytes(config_->getSize(siParsedSLESize)))
         , validatorKeys_(*config_, m_journal)
 
         , m_resourceManager (Resource::make_Manager (
@@ -572,6 +588,8 @@ public:
 
         // VFALCO HACK
         m_nodeStoreScheduler.setJobQueue (*m_jobQueue);
+        m_nodeStoreScheduler.setCollector (
+            m_collectorManager->group ("nodestore"));
 
         add (m_ledgerMaster->getPropertySource ());
     }
@@ -736,6 +754,12 @@ public:
         return cachedSLEs_;
     }
 
+    ParsedSLECache&
+    parsedSLEs() override
+    {
+        return parsedSLEs_;
+    }
+
     AmendmentTable& getAmendmentTable() override
     {
         return *m_amendmentTable;
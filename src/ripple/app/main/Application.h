@@ -41,6 +41,7 @@ namespace perf { class PerfLog; }
 // VFALCO TODO Fix forward declares required for header dependency loops
 class AmendmentTable;
 class CachedSLEs;
+class ParsedSLECache;
 class CollectorManager;
 class Family;
 class HashRouter;
@@ -129,6 +130,7 @@ public:
     virtual JobQueue&                   getJobQueue () = 0;
     virtual NodeCache&                  getTempNodeCache () = 0;
     virtual CachedSLEs&                 cachedSLEs() = 0;
+    virtual ParsedSLECache&             parsedSLEs() = 0;
     virtual AmendmentTable&             getAmendmentTable() = 0;
     virtual HashRouter&                 getHashRouter () = 0;
     virtual LoadFeeTrack&               getFeeTrack () = 0;
@@ -32,6 +32,13 @@ void NodeStoreScheduler::setJobQueue (JobQueue& jobQueue)
     m_jobQueue = &jobQueue;
 }
 
+void NodeStoreScheduler::setCollector (
+    beast::insight::Collector::ptr const& collector)
+{
+    m_writeTime = collector->make_event ("write_time");
+    m_writeQueue = collector->make_event ("write_queue");
+}
+
 void NodeStoreScheduler::onStop ()
 {
 }
@@ -76,13 +83,18 @@ void NodeStoreScheduler::onFetch (NodeStore::FetchReport const& report)
     if (report.wentToDisk)
         m_jobQueue->addLoadEvents (
             report.isAsync ? jtNS_ASYNC_READ : jtNS_SYNC_READ,
-                1, report.elapsed);
+                report.fetchCount, report.elapsed);
 }
 
 void NodeStoreScheduler::onBatchWrite (NodeStore::BatchWriteReport const& report)
 {
     m_jobQueue->addLoadEvents (jtNS_WRITE,
         report.writeCount, report.elapsed);
+    m_writeTime.notify (report.elapsed);
+    // An event carries any integral value, the collector
+    // aggregates the depths like it does the times.
+    m_writeQueue.notify (
+        beast::insight::Event::value_type{report.queueDepth});
 }
 
 } // ripple
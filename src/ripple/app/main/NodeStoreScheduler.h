@@ -23,6 +23,7 @@
 #include <ripple/nodestore/Scheduler.h>
 #include <ripple/core/JobQueue.h>
 #include <ripple/core/Stoppable.h>
+#include <ripple/beast/insight/Collector.h>
 #include <atomic>
 
 namespace ripple {
@@ -40,6 +41,9 @@ public:
     //
     void setJobQueue (JobQueue& jobQueue);
 
+    /** Report batch write times and queue depths to the collector. */
+    void setCollector (beast::insight::Collector::ptr const& collector);
+
     void onStop () override;
     void onChildrenStopped () override;
     void scheduleTask (NodeStore::Task& task) override;
@@ -51,6 +55,8 @@ private:
 
     JobQueue* m_jobQueue {nullptr};
     std::atomic <int> m_taskCount {0};
+    beast::insight::Event m_writeTime;
+    beast::insight::Event m_writeQueue;
 };
 
 } // ripple
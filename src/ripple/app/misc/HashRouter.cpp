@@ -81,6 +81,28 @@ bool HashRouter::shouldProcess (uint256 const& key, PeerShortID peer,
     return s.shouldProcess (suppressionMap_.clock().now(), tx_interval);
 }
 
+std::vector<bool> HashRouter::shouldProcess (std::vector<uint256> const& keys,
+    PeerShortID peer, std::vector<int>& flags,
+        std::chrono::seconds tx_interval)
+{
+    std::vector<bool> process;
+    process.reserve (keys.size ());
+    flags.clear ();
+    flags.reserve (keys.size ());
+
+    std::lock_guard lock (mutex_);
+
+    auto const now = suppressionMap_.clock().now();
+    for (auto const& key : keys)
+    {
+        auto& s = emplace(key).first;
+        s.addPeer (peer);
+        flags.push_back (s.getFlags ());
+        process.push_back (s.shouldProcess (now, tx_interval));
+    }
+    return process;
+}
+
 int HashRouter::getFlags (uint256 const& key)
 {
     std::lock_guard lock (mutex_);
@@ -26,6 +26,7 @@
 #include <ripple/basics/UnorderedContainers.h>
 #include <ripple/beast/container/aged_unordered_map.h>
 #include <boost/optional.hpp>
+#include <vector>
 
 namespace ripple {
 
@@ -174,6 +175,15 @@ public:
     bool shouldProcess (uint256 const& key, PeerShortID peer, int& flags,
         std::chrono::seconds tx_interval);
 
+    /** Add a peer suppression for each of several keys under one lock.
+
+        @param flags Set to the flags of each entry.
+        @return For each key, whether the entry should be processed.
+    */
+    std::vector<bool> shouldProcess (std::vector<uint256> const& keys,
+        PeerShortID peer, std::vector<int>& flags,
+            std::chrono::seconds tx_interval);
+
     /** Set the flags on a hash.
 
         @return `true` if the flags were changed. `false` if unchanged.
@@ -48,6 +48,7 @@
 #include <ripple/crypto/csprng.h>
 #include <ripple/crypto/RFC1751.h>
 #include <ripple/json/to_string.h>
+#include <ripple/nodestore/DatabaseShard.h>
 #include <ripple/overlay/Cluster.h>
 #include <ripple/overlay/Overlay.h>
 #include <ripple/overlay/predicates.h>
@@ -1040,6 +1041,10 @@ void NetworkOPsImp::apply (std::unique_lock<std::mutex>& batchLock)
 
     batchLock.unlock();
 
+    // Transactions to relay, with the peers that already have them
+    std::vector<std::pair<protocol::TMTransaction,
+        std::set<Peer::id_t>>> relays;
+
     {
         std::unique_lock masterLock{app_.getMasterMutex(), std::defer_lock};
         bool changed = false;
@@ -1181,14 +1186,16 @@ void NetworkOPsImp::apply (std::unique_lock<std::mutex>& batchLock)
                     tx.set_receivetimestamp (app_.timeKeeper().now().time_since_epoch().count());
                     tx.set_deferred(e.result == terQUEUED);
                     // FIXME: This should be when we received it
-                    app_.overlay().foreach (send_if_not (
-                        std::make_shared<Message> (tx, protocol::mtTRANSACTION),
-                        peer_in_set(*toSkip)));
+                    relays.emplace_back (std::move (tx), std::move (*toSkip));
                 }
             }
         }
     }
 
+    // Relay the whole batch at once so peers can get it in one message
+    if (! relays.empty())
+        app_.overlay().relay (relays);
+
     batchLock.lock();
 
     for (TransactionStatus& e : transactions)
@@ -1502,7 +1509,8 @@ void NetworkOPsImp::processTrustedProposal (
     if (mConsensus.peerProposal(
             app_.timeKeeper().closeTime(), peerPos))
     {
-        app_.overlay().relay(*set, peerPos.suppressionID());
+        app_.overlay().relay(
+            *set, peerPos.suppressionID(), peerPos.publicKey());
     }
     else
         JLOG(m_journal.info()) << "Not relaying trusted proposal";
@@ -2225,6 +2233,29 @@ Json::Value NetworkOPsImp::getServerInfo (bool human, bool admin, bool counters)
     info[jss::io_latency_ms] = static_cast<Json::UInt> (
         app_.getIOLatency().count());
 
+    if (admin)
+    {
+        auto filterJson = [](NodeStore::FilterCounts const& counts)
+        {
+            Json::Value ret = Json::objectValue;
+            ret[jss::rejected] = std::to_string(counts.rejected);
+            ret[jss::false_positives] = std::to_string(counts.falsePositives);
+            ret[jss::false_positive_rate] = counts.falsePositiveRate();
+            return ret;
+        };
+
+        auto const counts = app_.getNodeStore().getFilterCounts();
+        if (counts.enabled)
+            info[jss::node_filter] = filterJson(counts);
+
+        if (auto shardStore = app_.getShardStore())
+        {
+            auto const shardCounts = shardStore->getFilterCounts();
+            if (shardCounts.enabled)
+                info[jss::shards][jss::node_filter] = filterJson(shardCounts);
+        }
+    }
+
     if (admin)
     {
         if (!app_.getValidationPublicKey().empty())
@@ -64,6 +64,10 @@ public:
 
     /** Returns the number of file descriptors that are needed. */
     virtual int fdRequired() const = 0;
+
+    /** Duration and amount copied by the last rotation, or null
+        if online delete is not enabled. */
+    virtual Json::Value getRotationStats() const = 0;
 };
 
 //------------------------------------------------------------------------------
@@ -24,6 +24,9 @@
 #include <ripple/beast/core/CurrentThreadName.h>
 #include <ripple/core/ConfigSections.h>
 #include <ripple/nodestore/impl/DatabaseRotatingImp.h>
+#include <ripple/nodestore/impl/DatabaseTieredImp.h>
+#include <ripple/protocol/jss.h>
+#include <ripple/shamap/SHAMapTreeNode.h>
 
 #include <boost/algorithm/string/predicate.hpp>
 
@@ -204,8 +207,19 @@ SHAMapStoreImp::SHAMapStoreImp(
 
     if (deleteInterval_)
     {
+        if (! config.section(ConfigSection::nodeDatabaseCold()).empty())
+        {
+            Throw<std::runtime_error>(
+                "online_delete can not be used with [" +
+                ConfigSection::nodeDatabaseCold() + "]");
+        }
+
         get_if_exists(section, "advisory_delete", advisoryDelete_);
 
+        std::uint32_t incrementalCopy = 0;
+        get_if_exists(section, "incremental_copy", incrementalCopy);
+        incrementalCopy_ = std::chrono::milliseconds(incrementalCopy);
+
         auto const minInterval = config.standalone() ?
             minimumDeletionIntervalSA_ : minimumDeletionInterval_;
         if (deleteInterval_ < minInterval)
@@ -258,6 +272,24 @@ SHAMapStoreImp::makeNodeStore(std::string const& name, std::int32_t readThreads)
         dbRotating_ = dbr.get();
         db.reset(dynamic_cast<NodeStore::Database*>(dbr.release()));
     }
+    else if (auto const& cold = app_.config().section(
+        ConfigSection::nodeDatabaseCold()); ! cold.empty())
+    {
+        // Recent objects on the [node_db] backend, older ones
+        // demoted to the [node_db_cold] backend
+        auto coldBackend = NodeStore::Manager::instance().make_Backend(
+            cold, scheduler_, app_.logs().journal(nodeStoreName_));
+        coldBackend->open();
+        db = std::make_unique<NodeStore::DatabaseTieredImp>(
+            name,
+            scheduler_,
+            readThreads,
+            app_.getJobQueue(),
+            std::move(coldBackend),
+            app_.config().section(ConfigSection::nodeDatabase()),
+            app_.logs().journal(nodeStoreName_));
+        fdRequired_ += db->fdRequired();
+    }
     else
     {
         db = NodeStore::Manager::instance().make_Database(
@@ -303,6 +335,27 @@ SHAMapStoreImp::fdRequired() const
     return fdRequired_;
 }
 
+Json::Value
+SHAMapStoreImp::getRotationStats() const
+{
+    if (! deleteInterval_)
+        return Json::nullValue;
+
+    std::lock_guard lock (statsMutex_);
+    Json::Value ret (Json::objectValue);
+    ret[jss::ledger_index] = stats_.seq;
+    ret[jss::duration_us] = std::to_string(stats_.duration.count());
+    ret[jss::nodes] = std::to_string(stats_.nodes);
+    ret[jss::bytes] = std::to_string(stats_.bytes);
+    if (incrementalCopy_ != std::chrono::milliseconds::zero())
+    {
+        Json::Value& jv = (ret[jss::incremental] = Json::objectValue);
+        jv[jss::nodes] = std::to_string(stats_.incrementalNodes);
+        jv[jss::bytes] = std::to_string(stats_.incrementalBytes);
+    }
+    return ret;
+}
+
 bool
 SHAMapStoreImp::copyNode (std::uint64_t& nodeCount,
         SHAMapAbstractNode const& node)
@@ -318,6 +371,107 @@ SHAMapStoreImp::copyNode (std::uint64_t& nodeCount,
     return true;
 }
 
+std::shared_ptr<NodeObject>
+SHAMapStoreImp::copyLiveNode (uint256 const& hash)
+{
+    // Cached nodes may be only in the archive, so go to the backends
+    bool copied;
+    auto obj = dbRotating_->fetchToWritable(hash, copied);
+    if (copied)
+    {
+        ++liveNodes_;
+        liveBytes_ += obj->getData().size();
+    }
+    return obj;
+}
+
+bool
+SHAMapStoreImp::copyLive (std::shared_ptr<Ledger const> const& ledger,
+    std::uint64_t& nodeCount, std::chrono::steady_clock::time_point deadline)
+{
+    if (! copied_)
+    {
+        if (! baseline_)
+        {
+            baseline_ = ledger;
+            walk_.clear();
+            if (ledger->info().accountHash.isNonZero())
+                walk_.push_back(ledger->info().accountHash);
+        }
+
+        // Walk the baseline state through the node store rather than
+        // the SHAMap so the walk can be suspended between ledgers
+        // without holding the nodes in memory.
+        auto const seq = baseline_->info().seq;
+        while (! walk_.empty())
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+                return false;
+
+            auto const hash = walk_.back();
+            walk_.pop_back();
+            auto const obj = copyLiveNode(hash);
+            if (! obj)
+            {
+                JLOG(journal_.warn()) << "ledger " << seq
+                    << " missing node " << hash;
+                continue;
+            }
+
+            std::shared_ptr<SHAMapAbstractNode> node;
+            try
+            {
+                node = SHAMapAbstractNode::make(makeSlice(obj->getData()),
+                    0, snfPREFIX, SHAMapHash{hash}, true, journal_);
+            }
+            catch (std::exception const& e)
+            {
+                JLOG(journal_.warn()) << "ledger " << seq
+                    << " invalid node " << hash << ": " << e.what();
+                continue;
+            }
+
+            if (node && node->isInner())
+            {
+                auto const inner =
+                    std::static_pointer_cast<SHAMapInnerNode>(node);
+                for (int i = 0; i < 16; ++i)
+                {
+                    if (! inner->isEmptyBranch(i))
+                        walk_.push_back(inner->getChildHash(i).as_uint256());
+                }
+            }
+
+            if (! (++nodeCount % checkHealthInterval_) && health())
+                return false;
+        }
+
+        JLOG(journal_.debug()) << "copied baseline ledger " << seq;
+        copied_ = std::move(baseline_);
+    }
+
+    if (ledger == copied_)
+        return true;
+
+    // Everything reachable from copied_ is already in the writable
+    // backend, so only the nodes that differ need to be visited.
+    bool complete = true;
+    ledger->stateMap().snapShot(false)->visitDifferences(
+        &copied_->stateMap(),
+        [&](SHAMapAbstractNode& node)
+        {
+            copyLiveNode(node.getNodeHash().as_uint256());
+            if (! (++nodeCount % checkHealthInterval_) && health())
+                complete = false;
+            return complete;
+        });
+    if (! complete)
+        return false;
+
+    copied_ = ledger;
+    return true;
+}
+
 void
 SHAMapStoreImp::run()
 {
@@ -383,6 +537,12 @@ SHAMapStoreImp::run()
                     ;
             }
 
+            auto const start = std::chrono::steady_clock::now();
+            auto const copyCount = dbRotating_->getCopyCount();
+            auto const copySize = dbRotating_->getCopySize();
+            auto const liveNodes = liveNodes_;
+            auto const liveBytes = liveBytes_;
+
             clearPrior (lastRotated);
             switch (health())
             {
@@ -397,10 +557,18 @@ SHAMapStoreImp::run()
             }
 
             std::uint64_t nodeCount = 0;
-            validatedLedger->stateMap().snapShot (
-                    false)->visitNodes (
-                    std::bind (&SHAMapStoreImp::copyNode, this,
-                    std::ref(nodeCount), std::placeholders::_1));
+            if (incrementalCopy_ != std::chrono::milliseconds::zero())
+            {
+                copyLive (validatedLedger, nodeCount,
+                    std::chrono::steady_clock::time_point::max());
+            }
+            else
+            {
+                validatedLedger->stateMap().snapShot (
+                        false)->visitNodes (
+                        std::bind (&SHAMapStoreImp::copyNode, this,
+                        std::ref(nodeCount), std::placeholders::_1));
+            }
             JLOG(journal_.debug()) << "copied ledger " << validatedSeq
                     << " nodecount " << nodeCount;
             switch (health())
@@ -461,8 +629,45 @@ SHAMapStoreImp::run()
             }
             JLOG(journal_.debug()) << "finished rotation " << validatedSeq;
 
+            {
+                using namespace std::chrono;
+                std::lock_guard lock (statsMutex_);
+                stats_.seq = validatedSeq;
+                stats_.duration = duration_cast<microseconds>(
+                    steady_clock::now() - start);
+                stats_.nodes = dbRotating_->getCopyCount() - copyCount;
+                stats_.bytes = dbRotating_->getCopySize() - copySize;
+                stats_.incrementalNodes = liveNodes;
+                stats_.incrementalBytes = liveBytes;
+
+                JLOG(journal_.info()) << "rotated at ledger " << validatedSeq
+                    << " in " << duration_cast<milliseconds>(
+                        stats_.duration).count() << "ms, copied "
+                    << stats_.nodes << " nodes, " << stats_.bytes
+                    << " bytes";
+            }
+
+            // The live state has to be copied again into the new
+            // writable backend.
+            baseline_.reset();
+            walk_.clear();
+            copied_.reset();
+            liveNodes_ = 0;
+            liveBytes_ = 0;
+
             oldBackend->setDeletePath();
         }
+        else if (incrementalCopy_ != std::chrono::milliseconds::zero())
+        {
+            std::uint64_t nodeCount = 0;
+            copyLive (validatedLedger, nodeCount,
+                std::chrono::steady_clock::now() + incrementalCopy_);
+            if (health() == Health::stopping)
+            {
+                stopped();
+                return;
+            }
+        }
     }
 }
 
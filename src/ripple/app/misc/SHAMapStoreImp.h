@@ -106,6 +106,32 @@ private:
     std::uint32_t backOff_ = 100;
     std::int32_t ageThreshold_ = 60;
 
+    // Time spent per validated ledger copying live nodes between
+    // rotations. Zero copies the whole state at rotation time.
+    std::chrono::milliseconds incrementalCopy_ {0};
+    // Ledger whose state is being copied to the writable backend
+    std::shared_ptr<Ledger const> baseline_;
+    // Hashes of the baseline nodes not yet visited
+    std::vector<uint256> walk_;
+    // Newest ledger whose state is entirely in the writable backend
+    std::shared_ptr<Ledger const> copied_;
+    // Copied from the archive by copyLive since the last rotation
+    std::uint64_t liveNodes_ = 0;
+    std::uint64_t liveBytes_ = 0;
+
+    struct RotationStats
+    {
+        LedgerIndex seq = 0;
+        std::chrono::microseconds duration {0};
+        std::uint64_t nodes = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t incrementalNodes = 0;
+        std::uint64_t incrementalBytes = 0;
+    };
+
+    mutable std::mutex statsMutex_;
+    RotationStats stats_;
+
     // these do not exist upon SHAMapStore creation, but do exist
     // as of onPrepare() or before
     NetworkOPs* netOPs_ = nullptr;
@@ -175,9 +201,24 @@ public:
     void rendezvous() const override;
     int fdRequired() const override;
 
+    Json::Value getRotationStats() const override;
+
 private:
     // callback for visitNodes
     bool copyNode (std::uint64_t& nodeCount, SHAMapAbstractNode const &node);
+
+    /** Make sure the state of ledger is in the writable backend.
+
+        Resumes copying the baseline ledger, then copies the nodes
+        that changed since the last ledger processed. Returns false
+        if the deadline passed or the node store is unhealthy, in
+        which case the next call picks up where this one left off.
+    */
+    bool copyLive (std::shared_ptr<Ledger const> const& ledger,
+        std::uint64_t& nodeCount,
+        std::chrono::steady_clock::time_point deadline);
+    // Make sure a live node is in the writable backend
+    std::shared_ptr<NodeObject> copyLiveNode (uint256 const& hash);
     void run();
     void dbPaths();
 
@@ -0,0 +1,371 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#ifndef RIPPLE_BASICS_SHARDEDTAGGEDCACHE_H_INCLUDED
+#define RIPPLE_BASICS_SHARDEDTAGGEDCACHE_H_INCLUDED
+
+#include <ripple/basics/hardened_hash.h>
+#include <ripple/basics/Log.h>
+#include <ripple/basics/impl/TaggedCacheMap.h>
+#include <ripple/beast/clock/abstract_clock.h>
+#include <ripple/beast/insight/Insight.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace ripple {
+
+/** Map/cache combination split into independently locked stripes.
+
+    This behaves like TaggedCache, but each key is assigned to one of a
+    fixed number of stripes, and each stripe has its own lock and map.
+    Lookups of keys in different stripes do not contend.
+
+    Sweeping visits the stripes one at a time, so a sweep never blocks
+    more than one stripe, and objects it releases are destroyed outside
+    the lock. The target size applies to the cache as a whole, as in
+    TaggedCache. Hit and miss counters are atomic and take no lock.
+
+    Unlike TaggedCache there is no single mutex to hold across several
+    operations, so callers that need that must use TaggedCache.
+
+    @note Callers must not modify data objects that are stored in the cache.
+*/
+template <
+    class Key,
+    class T,
+    class Hash = hardened_hash <>,
+    class KeyEqual = std::equal_to <Key>
+>
+class ShardedTaggedCache
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using weak_mapped_ptr = std::weak_ptr <mapped_type>;
+    using mapped_ptr = std::shared_ptr <mapped_type>;
+    using clock_type = beast::abstract_clock <std::chrono::steady_clock>;
+
+    /** The number of independently locked stripes. */
+    static std::size_t constexpr stripeCount = 16;
+
+public:
+    ShardedTaggedCache (std::string const& name, int size,
+        clock_type::duration expiration, clock_type& clock, beast::Journal journal,
+            beast::insight::Collector::ptr const& collector = beast::insight::NullCollector::New ())
+        : m_journal (journal)
+        , m_clock (clock)
+        , m_stats (name,
+            std::bind (&ShardedTaggedCache::collect_metrics, this),
+                collector)
+        , m_name (name)
+        , m_target_size (size)
+        , m_target_age (expiration)
+    {
+    }
+
+public:
+    /** Return the clock associated with the cache. */
+    clock_type& clock ()
+    {
+        return m_clock;
+    }
+
+    int getTargetSize () const
+    {
+        return m_target_size.load ();
+    }
+
+    void setTargetSize (int s)
+    {
+        m_target_size = s;
+
+        if (s > 0)
+        {
+            // Room for an even share of the target in each stripe
+            auto const share = (s + stripeCount - 1) / stripeCount;
+            for (auto& stripe : m_stripes)
+            {
+                std::lock_guard lock (stripe.mutex);
+                stripe.cache.reserve (share);
+            }
+        }
+
+        JLOG(m_journal.debug()) <<
+            m_name << " target size set to " << s;
+    }
+
+    clock_type::duration getTargetAge () const
+    {
+        return m_target_age.load ();
+    }
+
+    void setTargetAge (clock_type::duration s)
+    {
+        m_target_age = s;
+        JLOG(m_journal.debug()) <<
+            m_name << " target age set to " << s.count();
+    }
+
+    int getCacheSize () const
+    {
+        return m_cache_count.load (std::memory_order_relaxed);
+    }
+
+    int getTrackSize () const
+    {
+        std::size_t size = 0;
+        for (auto const& stripe : m_stripes)
+        {
+            std::lock_guard lock (stripe.mutex);
+            size += stripe.cache.size ();
+        }
+        return static_cast<int> (size);
+    }
+
+    float getHitRate ()
+    {
+        auto const hits = m_hits.load (std::memory_order_relaxed);
+        auto const total = static_cast<float> (
+            hits + m_misses.load (std::memory_order_relaxed));
+        return hits * (100.0f / std::max (1.0f, total));
+    }
+
+    void clear ()
+    {
+        for (auto& stripe : m_stripes)
+        {
+            std::lock_guard lock (stripe.mutex);
+            m_cache_count -= stripe.cache.count ();
+            stripe.cache.clear ();
+        }
+    }
+
+    void reset ()
+    {
+        clear ();
+        m_hits = 0;
+        m_misses = 0;
+    }
+
+    /** Remove expired entries, one stripe at a time. */
+    void sweep ()
+    {
+        int cacheRemovals = 0;
+        int mapRemovals = 0;
+
+        // Age every stripe by the size of the whole cache,
+        // so that the target is met exactly as in TaggedCache
+        clock_type::time_point const now (m_clock.now());
+        auto const when_expire = map_type::whenExpire (now,
+            getTrackSize (), m_target_size.load (), m_target_age.load ());
+
+        for (auto& stripe : m_stripes)
+        {
+            // Keep references to all the stuff we sweep
+            // so that we can destroy them outside the lock.
+            std::vector <mapped_ptr> stuffToSweep;
+
+            {
+                std::lock_guard lock (stripe.mutex);
+                auto const before = stripe.cache.count ();
+                stripe.cache.sweep (when_expire, stuffToSweep,
+                    cacheRemovals, mapRemovals);
+                recount (stripe, before);
+            }
+        }
+
+        if (mapRemovals || cacheRemovals)
+        {
+            JLOG(m_journal.trace()) <<
+                m_name << ": cache = " << getTrackSize () <<
+                "-" << cacheRemovals << ", map-=" << mapRemovals;
+        }
+    }
+
+    bool del (const key_type& key, bool valid)
+    {
+        // Remove from cache, if !valid, remove from map too. Returns true if removed from cache
+        auto& stripe = stripeFor (key);
+        std::lock_guard lock (stripe.mutex);
+        auto const before = stripe.cache.count ();
+        auto const ret = stripe.cache.del (key, valid);
+        recount (stripe, before);
+        return ret;
+    }
+
+    /** Replace aliased objects with originals.
+
+        @see TaggedCache::canonicalize
+    */
+    bool canonicalize (const key_type& key, std::shared_ptr<T>& data, bool replace = false)
+    {
+        // Return canonical value, store if needed, refresh in cache
+        // Return values: true=we had the data already
+        auto& stripe = stripeFor (key);
+        std::lock_guard lock (stripe.mutex);
+        auto const before = stripe.cache.count ();
+        auto const ret = stripe.cache.canonicalize (
+            key, data, replace, m_clock.now());
+        recount (stripe, before);
+        return ret;
+    }
+
+    std::shared_ptr<T> fetch (const key_type& key)
+    {
+        // fetch us a shared pointer to the stored data object
+        auto& stripe = stripeFor (key);
+        std::lock_guard lock (stripe.mutex);
+        auto const before = stripe.cache.count ();
+
+        typename map_type::Found found;
+        auto ret = stripe.cache.fetch (key, m_clock.now(), found);
+        recount (stripe, before);
+
+        // A revived object is independent of cache
+        // size, so not counted as a hit
+        if (found == map_type::Found::hit)
+            m_hits.fetch_add (1, std::memory_order_relaxed);
+        else if (found == map_type::Found::miss)
+            m_misses.fetch_add (1, std::memory_order_relaxed);
+        return ret;
+    }
+
+    /** Insert the element into the container.
+        If the key already exists, nothing happens.
+        @return `true` If the element was inserted
+    */
+    bool insert (key_type const& key, T const& value)
+    {
+        mapped_ptr p (std::make_shared <T> (
+            std::cref (value)));
+        return canonicalize (key, p);
+    }
+
+    bool retrieve (const key_type& key, T& data)
+    {
+        // retrieve the value of the stored data
+        mapped_ptr entry = fetch (key);
+
+        if (!entry)
+            return false;
+
+        data = *entry;
+        return true;
+    }
+
+    /** Refresh the expiration time on a key.
+
+        @param key The key to refresh.
+        @return `true` if the key was found and the object is cached.
+    */
+    bool refreshIfPresent (const key_type& key)
+    {
+        auto& stripe = stripeFor (key);
+        std::lock_guard lock (stripe.mutex);
+        auto const before = stripe.cache.count ();
+        auto const ret = stripe.cache.refreshIfPresent (key, m_clock.now());
+        recount (stripe, before);
+        return ret;
+    }
+
+    std::vector <key_type> getKeys () const
+    {
+        std::vector <key_type> v;
+
+        for (auto const& stripe : m_stripes)
+        {
+            std::lock_guard lock (stripe.mutex);
+            stripe.cache.keys (v);
+        }
+
+        return v;
+    }
+
+private:
+    using map_type = detail::TaggedCacheMap <Key, T, Hash, KeyEqual>;
+
+    // Aligned so that stripes locked by different threads
+    // do not share a cache line.
+    struct alignas(64) Stripe
+    {
+        std::mutex mutable mutex;
+        map_type cache;
+    };
+
+    Stripe& stripeFor (key_type const& key)
+    {
+        return m_stripes[m_stripe_hash (key) % stripeCount];
+    }
+
+    // Carry a change in the stripe's count to the total
+    void recount (Stripe const& stripe, int before)
+    {
+        if (auto const delta = stripe.cache.count () - before)
+            m_cache_count.fetch_add (delta, std::memory_order_relaxed);
+    }
+
+    void collect_metrics ()
+    {
+        m_stats.size.set (getCacheSize ());
+
+        {
+            beast::insight::Gauge::value_type hit_rate (0);
+            {
+                auto const hits = m_hits.load (std::memory_order_relaxed);
+                auto const total = hits +
+                    m_misses.load (std::memory_order_relaxed);
+                if (total != 0)
+                    hit_rate = (hits * 100) / total;
+            }
+            m_stats.hit_rate.set (hit_rate);
+        }
+    }
+
+private:
+    beast::Journal m_journal;
+    clock_type& m_clock;
+    detail::TaggedCacheStats m_stats;
+
+    // Used for logging
+    std::string m_name;
+
+    // Desired number of cache entries (0 = ignore)
+    std::atomic<int> m_target_size;
+
+    // Desired maximum cache age
+    std::atomic<clock_type::duration> m_target_age;
+
+    // Selects the stripe for a key
+    Hash m_stripe_hash;
+
+    std::array <Stripe, stripeCount> m_stripes;
+
+    // Number of items cached, across all stripes
+    std::atomic<int> m_cache_count {0};
+    std::atomic<std::uint64_t> m_hits {0};
+    std::atomic<std::uint64_t> m_misses {0};
+};
+
+}
+
+#endif
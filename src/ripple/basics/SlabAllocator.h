@@ -0,0 +1,126 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_BASICS_SLABALLOCATOR_H_INCLUDED
+#define RIPPLE_BASICS_SLABALLOCATOR_H_INCLUDED
+
+#include <ripple/basics/ByteUtilities.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace ripple {
+
+/** A process-wide pool of small blocks, grouped by size.
+
+    Requests are rounded up to a multiple of the alignment and served
+    from a free list for that size. The lists are refilled by carving
+    slabs of memory which are kept for the life of the process, so the
+    space freed by one burst of allocations is reused by the next.
+
+    Each thread keeps a few blocks of every size and exchanges them
+    with the shared lists in batches, so most calls take no lock. A
+    thread's blocks return to the shared lists when it exits.
+
+    Requests larger than maxSize are passed to operator new.
+
+    Thread Safety:
+
+        May be called concurrently.
+*/
+class SlabPool
+{
+public:
+    static constexpr std::size_t alignment = 16;
+    static constexpr std::size_t maxSize = 1024;
+    static constexpr std::size_t slabSize = kilobytes(64);
+
+    static
+    void*
+    allocate (std::size_t bytes);
+
+    static
+    void
+    deallocate (void* p, std::size_t bytes) noexcept;
+
+    /** Bytes held in slabs, whether in use or free. */
+    static
+    std::size_t
+    reserved();
+
+    /** Bytes in slabs not on the shared free lists.
+
+        Blocks held by a thread for reuse count as used.
+    */
+    static
+    std::size_t
+    used();
+};
+
+/** An allocator drawing from the SlabPool.
+
+    Suited to std::allocate_shared and containers of small nodes.
+    All instances are interchangeable.
+*/
+template <class T>
+class SlabAllocator
+{
+    static_assert (alignof(T) <= SlabPool::alignment,
+        "SlabAllocator: type is over-aligned");
+
+public:
+    using value_type = T;
+
+    SlabAllocator() = default;
+
+    template <class U>
+    SlabAllocator (SlabAllocator<U> const&) noexcept
+    {
+    }
+
+    T*
+    allocate (std::size_t n)
+    {
+        return static_cast<T*>(SlabPool::allocate (n * sizeof(T)));
+    }
+
+    void
+    deallocate (T* p, std::size_t n) noexcept
+    {
+        SlabPool::deallocate (p, n * sizeof(T));
+    }
+
+    template <class U>
+    bool
+    operator== (SlabAllocator<U> const&) const noexcept
+    {
+        return true;
+    }
+
+    template <class U>
+    bool
+    operator!= (SlabAllocator<U> const&) const noexcept
+    {
+        return false;
+    }
+};
+
+} // ripple
+
+#endif
@@ -22,7 +22,7 @@
 
 #include <ripple/basics/hardened_hash.h>
 #include <ripple/basics/Log.h>
-#include <ripple/basics/UnorderedContainers.h>
+#include <ripple/basics/impl/TaggedCacheMap.h>
 #include <ripple/beast/clock/abstract_clock.h>
 #include <ripple/beast/insight/Insight.h>
 #include <functional>
@@ -78,7 +78,6 @@ public:
         , m_name (name)
         , m_target_size (size)
         , m_target_age (expiration)
-        , m_cache_count (0)
         , m_hits (0)
         , m_misses (0)
     {
@@ -103,7 +102,7 @@ public:
         m_target_size = s;
 
         if (s > 0)
-            m_cache.rehash (static_cast<std::size_t> ((s + (s >> 2)) / m_cache.max_load_factor () + 1));
+            m_cache.reserve (s);
 
         JLOG(m_journal.debug()) <<
             m_name << " target size set to " << s;
@@ -126,7 +125,7 @@ public:
     int getCacheSize () const
     {
         std::lock_guard lock (m_mutex);
-        return m_cache_count;
+        return m_cache.count ();
     }
 
     int getTrackSize () const
@@ -146,14 +145,12 @@ public:
     {
         std::lock_guard lock (m_mutex);
         m_cache.clear ();
-        m_cache_count = 0;
     }
 
     void reset ()
     {
         std::lock_guard lock (m_mutex);
         m_cache.clear();
-        m_cache_count = 0;
         m_hits = 0;
         m_misses = 0;
     }
@@ -162,7 +159,6 @@ public:
     {
         int cacheRemovals = 0;
         int mapRemovals = 0;
-        int cc = 0;
 
         // Keep references to all the stuff we sweep
         // so that we can destroy them outside the lock.
@@ -171,73 +167,22 @@ public:
 
         {
             clock_type::time_point const now (m_clock.now());
-            clock_type::time_point when_expire;
 
             std::lock_guard lock (m_mutex);
 
-            if (m_target_size == 0 ||
-                (static_cast<int> (m_cache.size ()) <= m_target_size))
-            {
-                when_expire = now - m_target_age;
-            }
-            else
-            {
-                when_expire = now - m_target_age*m_target_size/m_cache.size();
-
-                clock_type::duration const minimumAge (
-                    std::chrono::seconds (1));
-                if (when_expire > (now - minimumAge))
-                    when_expire = now - minimumAge;
+            auto const when_expire = map_type::whenExpire (
+                now, m_cache.size (), m_target_size, m_target_age);
 
+            if (m_target_size != 0 &&
+                (static_cast<int> (m_cache.size ()) > m_target_size))
+            {
                 JLOG(m_journal.trace()) <<
                     m_name << " is growing fast " << m_cache.size () << " of " << m_target_size <<
                         " aging at " << (now - when_expire).count() << " of " << m_target_age.count();
             }
 
-            stuffToSweep.reserve (m_cache.size ());
-
-            cache_iterator cit = m_cache.begin ();
-
-            while (cit != m_cache.end ())
-            {
-                if (cit->second.isWeak ())
-                {
-                    // weak
-                    if (cit->second.isExpired ())
-                    {
-                        ++mapRemovals;
-                        cit = m_cache.erase (cit);
-                    }
-                    else
-                    {
-                        ++cit;
-                    }
-                }
-                else if (cit->second.last_access <= when_expire)
-                {
-                    // strong, expired
-                    --m_cache_count;
-                    ++cacheRemovals;
-                    if (cit->second.ptr.unique ())
-                    {
-                        stuffToSweep.push_back (cit->second.ptr);
-                        ++mapRemovals;
-                        cit = m_cache.erase (cit);
-                    }
-                    else
-                    {
-                        // remains weakly cached
-                        cit->second.ptr.reset ();
-                        ++cit;
-                    }
-                }
-                else
-                {
-                    // strong, not expired
-                    ++cc;
-                    ++cit;
-                }
-            }
+            m_cache.sweep (when_expire, stuffToSweep,
+                cacheRemovals, mapRemovals);
         }
 
         if (mapRemovals || cacheRemovals)
@@ -255,27 +200,7 @@ public:
     {
         // Remove from cache, if !valid, remove from map too. Returns true if removed from cache
         std::lock_guard lock (m_mutex);
-
-        cache_iterator cit = m_cache.find (key);
-
-        if (cit == m_cache.end ())
-            return false;
-
-        Entry& entry = cit->second;
-
-        bool ret = false;
-
-        if (entry.isCached ())
-        {
-            --m_cache_count;
-            entry.ptr.reset ();
-            ret = true;
-        }
-
-        if (!valid || entry.isExpired ())
-            m_cache.erase (cit);
-
-        return ret;
+        return m_cache.del (key, valid);
     }
 
     /** Replace aliased objects with originals.
@@ -296,60 +221,7 @@ public:
         // Return canonical value, store if needed, refresh in cache
         // Return values: true=we had the data already
         std::lock_guard lock (m_mutex);
-
-        cache_iterator cit = m_cache.find (key);
-
-        if (cit == m_cache.end ())
-        {
-            m_cache.emplace (std::piecewise_construct,
-                std::forward_as_tuple(key),
-                std::forward_as_tuple(m_clock.now(), data));
-            ++m_cache_count;
-            return false;
-        }
-
-        Entry& entry = cit->second;
-        entry.touch (m_clock.now());
-
-        if (entry.isCached ())
-        {
-            if (replace)
-            {
-                entry.ptr = data;
-                entry.weak_ptr = data;
-            }
-            else
-            {
-                data = entry.ptr;
-            }
-
-            return true;
-        }
-
-        mapped_ptr cachedData = entry.lock ();
-
-        if (cachedData)
-        {
-            if (replace)
-            {
-                entry.ptr = data;
-                entry.weak_ptr = data;
-            }
-            else
-            {
-                entry.ptr = cachedData;
-                data = cachedData;
-            }
-
-            ++m_cache_count;
-            return true;
-        }
-
-        entry.ptr = data;
-        entry.weak_ptr = data;
-        ++m_cache_count;
-
-        return false;
+        return m_cache.canonicalize (key, data, replace, m_clock.now());
     }
 
     std::shared_ptr<T> fetch (const key_type& key)
@@ -357,35 +229,16 @@ public:
         // fetch us a shared pointer to the stored data object
         std::lock_guard lock (m_mutex);
 
-        cache_iterator cit = m_cache.find (key);
-
-        if (cit == m_cache.end ())
-        {
-            ++m_misses;
-            return mapped_ptr ();
-        }
-
-        Entry& entry = cit->second;
-        entry.touch (m_clock.now());
+        typename map_type::Found found;
+        auto ret = m_cache.fetch (key, m_clock.now(), found);
 
-        if (entry.isCached ())
-        {
+        // A revived object is independent of cache
+        // size, so not counted as a hit
+        if (found == map_type::Found::hit)
             ++m_hits;
-            return entry.ptr;
-        }
-
-        entry.ptr = entry.lock ();
-
-        if (entry.isCached ())
-        {
-            // independent of cache size, so not counted as a hit
-            ++m_cache_count;
-            return entry.ptr;
-        }
-
-        m_cache.erase (cit);
-        ++m_misses;
-        return mapped_ptr ();
+        else if (found == map_type::Found::miss)
+            ++m_misses;
+        return ret;
     }
 
     /** Insert the element into the container.
@@ -423,49 +276,9 @@ public:
     */
     bool refreshIfPresent (const key_type& key)
     {
-        bool found = false;
-
         // If present, make current in cache
         std::lock_guard lock (m_mutex);
-
-        cache_iterator cit = m_cache.find (key);
-
-        if (cit != m_cache.end ())
-        {
-            Entry& entry = cit->second;
-
-            if (! entry.isCached ())
-            {
-                // Convert weak to strong.
-                entry.ptr = entry.lock ();
-
-                if (entry.isCached ())
-                {
-                    // We just put the object back in cache
-                    ++m_cache_count;
-                    entry.touch (m_clock.now());
-                    found = true;
-                }
-                else
-                {
-                    // Couldn't get strong pointer,
-                    // object fell out of the cache so remove the entry.
-                    m_cache.erase (cit);
-                }
-            }
-            else
-            {
-                // It's cached so update the timer
-                entry.touch (m_clock.now());
-                found = true;
-            }
-        }
-        else
-        {
-            // not present
-        }
-
-        return found;
+        return m_cache.refreshIfPresent (key, m_clock.now());
     }
 
     mutex_type& peekMutex ()
@@ -479,9 +292,7 @@ public:
 
         {
             std::lock_guard lock (m_mutex);
-            v.reserve (m_cache.size());
-            for (auto const& _ : m_cache)
-                v.push_back (_.first);
+            m_cache.keys (v);
         }
 
         return v;
@@ -505,49 +316,11 @@ private:
     }
 
 private:
-    struct Stats
-    {
-        template <class Handler>
-        Stats (std::string const& prefix, Handler const& handler,
-            beast::insight::Collector::ptr const& collector)
-            : hook (collector->make_hook (handler))
-            , size (collector->make_gauge (prefix, "size"))
-            , hit_rate (collector->make_gauge (prefix, "hit_rate"))
-            { }
-
-        beast::insight::Hook hook;
-        beast::insight::Gauge size;
-        beast::insight::Gauge hit_rate;
-    };
-
-    class Entry
-    {
-    public:
-        mapped_ptr ptr;
-        weak_mapped_ptr weak_ptr;
-        clock_type::time_point last_access;
-
-        Entry (clock_type::time_point const& last_access_,
-            mapped_ptr const& ptr_)
-            : ptr (ptr_)
-            , weak_ptr (ptr_)
-            , last_access (last_access_)
-        {
-        }
-
-        bool isWeak () const { return ptr == nullptr; }
-        bool isCached () const { return ptr != nullptr; }
-        bool isExpired () const { return weak_ptr.expired (); }
-        mapped_ptr lock () { return weak_ptr.lock (); }
-        void touch (clock_type::time_point const& now) { last_access = now; }
-    };
-
-    using cache_type = hardened_hash_map <key_type, Entry, Hash, KeyEqual>;
-    using cache_iterator = typename cache_type::iterator;
+    using map_type = detail::TaggedCacheMap <Key, T, Hash, KeyEqual>;
 
     beast::Journal m_journal;
     clock_type& m_clock;
-    Stats m_stats;
+    detail::TaggedCacheStats m_stats;
 
     mutex_type mutable m_mutex;
 
@@ -560,9 +333,7 @@ private:
     // Desired maximum cache age
     clock_type::duration m_target_age;
 
-    // Number of items cached
-    int m_cache_count;
-    cache_type m_cache;  // Hold strong reference to recent objects
+    map_type m_cache;  // Hold strong reference to recent objects
     std::uint64_t m_hits;
     std::uint64_t m_misses;
 };
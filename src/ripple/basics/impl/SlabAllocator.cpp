@@ -0,0 +1,284 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/basics/SlabAllocator.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace ripple {
+
+namespace detail {
+
+struct SlabBlock
+{
+    SlabBlock* next;
+};
+
+// The shared free list for one block size
+class SlabList
+{
+private:
+    std::mutex mutex_;
+    SlabBlock* head_ = nullptr;
+    std::size_t count_ = 0;
+
+public:
+    std::size_t size = 0;
+
+    // Remove up to n blocks, carving a new slab if the list is empty.
+    // Returns the number removed, at least one.
+    std::size_t
+    take (SlabBlock*& head, std::size_t n);
+
+    // Add a chain of n blocks ending at tail
+    void
+    give (SlabBlock* head, SlabBlock* tail, std::size_t n);
+
+    std::size_t
+    free();
+};
+
+// The blocks of every size kept by one thread
+class SlabCache
+{
+public:
+    struct List
+    {
+        SlabBlock* head = nullptr;
+        std::size_t count = 0;
+    };
+
+    std::array<List, SlabPool::maxSize / SlabPool::alignment> lists;
+
+    SlabCache() = default;
+    SlabCache (SlabCache const&) = delete;
+    SlabCache& operator= (SlabCache const&) = delete;
+
+    ~SlabCache();
+};
+
+static std::atomic<std::size_t> slabBytes {0};
+
+// Never destroyed: blocks may be freed by static destructors
+static
+std::array<SlabList, SlabPool::maxSize / SlabPool::alignment>&
+slabLists()
+{
+    static auto const lists = []
+    {
+        auto p = new std::array<SlabList,
+            SlabPool::maxSize / SlabPool::alignment>;
+        for (std::size_t i = 0; i < p->size(); ++i)
+            (*p)[i].size = (i + 1) * SlabPool::alignment;
+        return p;
+    }();
+    return *lists;
+}
+
+// Blocks moved between a thread and the shared list at a time
+static
+std::size_t
+batchSize (std::size_t size)
+{
+    auto const n = kilobytes(4) / size;
+    if (n < 4)
+        return 4;
+    if (n > 64)
+        return 64;
+    return n;
+}
+
+std::size_t
+SlabList::take (SlabBlock*& head, std::size_t n)
+{
+    std::lock_guard lock (mutex_);
+    if (head_ == nullptr)
+    {
+        auto const slab = static_cast<std::uint8_t*>(::operator new (
+            SlabPool::slabSize, std::align_val_t {SlabPool::alignment}));
+        slabBytes += SlabPool::slabSize;
+        auto const blocks = SlabPool::slabSize / size;
+        for (std::size_t i = blocks; i-- > 0;)
+        {
+            auto const b = reinterpret_cast<SlabBlock*>(slab + i * size);
+            b->next = head_;
+            head_ = b;
+        }
+        count_ += blocks;
+    }
+
+    head = head_;
+    auto tail = head_;
+    std::size_t taken = 1;
+    while (taken < n && tail->next != nullptr)
+    {
+        tail = tail->next;
+        ++taken;
+    }
+    head_ = tail->next;
+    tail->next = nullptr;
+    count_ -= taken;
+    return taken;
+}
+
+void
+SlabList::give (SlabBlock* head, SlabBlock* tail, std::size_t n)
+{
+    std::lock_guard lock (mutex_);
+    tail->next = head_;
+    head_ = head;
+    count_ += n;
+}
+
+std::size_t
+SlabList::free()
+{
+    std::lock_guard lock (mutex_);
+    return count_ * size;
+}
+
+SlabCache::~SlabCache()
+{
+    auto& shared = slabLists();
+    for (std::size_t i = 0; i < lists.size(); ++i)
+    {
+        auto& list = lists[i];
+        if (list.head == nullptr)
+            continue;
+        auto tail = list.head;
+        while (tail->next != nullptr)
+            tail = tail->next;
+        shared[i].give (list.head, tail, list.count);
+        list.head = nullptr;
+        list.count = 0;
+    }
+}
+
+// Set once the calling thread's cache is destroyed. Blocks freed
+// after that, by later thread_local or static destructors, go
+// straight to the shared lists.
+static thread_local bool slabCacheGone = false;
+
+static
+SlabCache*
+slabCache()
+{
+    struct Owner
+    {
+        SlabCache cache;
+
+        ~Owner()
+        {
+            slabCacheGone = true;
+        }
+    };
+
+    if (slabCacheGone)
+        return nullptr;
+    static thread_local Owner owner;
+    return &owner.cache;
+}
+
+} // detail
+
+void*
+SlabPool::allocate (std::size_t bytes)
+{
+    if (bytes > maxSize)
+        return ::operator new (bytes);
+
+    auto const index = bytes == 0 ? 0 : (bytes - 1) / alignment;
+    auto& shared = detail::slabLists()[index];
+    auto const cache = detail::slabCache();
+    if (cache == nullptr)
+    {
+        detail::SlabBlock* b;
+        shared.take (b, 1);
+        return b;
+    }
+
+    auto& list = cache->lists[index];
+    if (list.head == nullptr)
+        list.count = shared.take (list.head, detail::batchSize (shared.size));
+    auto const b = list.head;
+    list.head = b->next;
+    --list.count;
+    return b;
+}
+
+void
+SlabPool::deallocate (void* p, std::size_t bytes) noexcept
+{
+    if (p == nullptr)
+        return;
+
+    if (bytes > maxSize)
+    {
+        ::operator delete (p);
+        return;
+    }
+
+    auto const index = bytes == 0 ? 0 : (bytes - 1) / alignment;
+    auto& shared = detail::slabLists()[index];
+    auto const b = static_cast<detail::SlabBlock*>(p);
+    auto const cache = detail::slabCache();
+    if (cache == nullptr)
+    {
+        shared.give (b, b, 1);
+        return;
+    }
+
+    auto& list = cache->lists[index];
+    b->next = list.head;
+    list.head = b;
+    ++list.count;
+
+    // Keep one batch and return the rest
+    auto const batch = detail::batchSize (shared.size);
+    if (list.count >= 2 * batch)
+    {
+        auto tail = list.head;
+        for (std::size_t i = 1; i < batch; ++i)
+            tail = tail->next;
+        auto const rest = tail->next;
+        shared.give (list.head, tail, batch);
+        list.head = rest;
+        list.count -= batch;
+    }
+}
+
+std::size_t
+SlabPool::reserved()
+{
+    return detail::slabBytes.load();
+}
+
+std::size_t
+SlabPool::used()
+{
+    std::size_t free = 0;
+    for (auto& list : detail::slabLists())
+        free += list.free();
+    auto const total = reserved();
+    return total > free ? total - free : 0;
+}
+
+} // ripple
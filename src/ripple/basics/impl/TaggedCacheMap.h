@@ -0,0 +1,366 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_BASICS_TAGGEDCACHEMAP_H_INCLUDED
+#define RIPPLE_BASICS_TAGGEDCACHEMAP_H_INCLUDED
+
+#include <ripple/basics/hardened_hash.h>
+#include <ripple/basics/UnorderedContainers.h>
+#include <ripple/beast/clock/abstract_clock.h>
+#include <ripple/beast/insight/Insight.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace ripple {
+namespace detail {
+
+/** The map of a TaggedCache, or of one stripe of a ShardedTaggedCache.
+
+    Holds each object strongly while it is cached, and weakly after it
+    ages out for as long as something else keeps it alive. Callers
+    provide the locking and keep the hit and miss counts.
+*/
+template <
+    class Key,
+    class T,
+    class Hash,
+    class KeyEqual
+>
+class TaggedCacheMap
+{
+public:
+    using key_type = Key;
+    using mapped_ptr = std::shared_ptr <T>;
+    using clock_type = beast::abstract_clock <std::chrono::steady_clock>;
+
+    /** The outcome of a fetch. */
+    enum class Found
+    {
+        // The object was cached
+        hit,
+
+        // The object was weakly held and is cached again
+        revived,
+
+        // The object is gone
+        miss
+    };
+
+    /** Number of objects cached. */
+    int count () const
+    {
+        return m_count;
+    }
+
+    /** Number of objects tracked, cached or not. */
+    std::size_t size () const
+    {
+        return m_cache.size ();
+    }
+
+    void clear ()
+    {
+        m_cache.clear ();
+        m_count = 0;
+    }
+
+    void reserve (int s)
+    {
+        m_cache.rehash (static_cast<std::size_t> (
+            (s + (s >> 2)) / m_cache.max_load_factor () + 1));
+    }
+
+    void keys (std::vector <key_type>& v) const
+    {
+        v.reserve (v.size () + m_cache.size ());
+        for (auto const& _ : m_cache)
+            v.push_back (_.first);
+    }
+
+    /** Returns when a cache of the given size stops holding
+        objects last accessed, if it aims for the target.
+    */
+    static
+    clock_type::time_point
+    whenExpire (clock_type::time_point now, std::size_t size,
+        int targetSize, clock_type::duration targetAge)
+    {
+        if (targetSize == 0 || (static_cast<int> (size) <= targetSize))
+            return now - targetAge;
+
+        auto const when = now - targetAge * targetSize / size;
+        clock_type::duration const minimumAge (std::chrono::seconds (1));
+        if (when > (now - minimumAge))
+            return now - minimumAge;
+        return when;
+    }
+
+    /** Drops the objects last accessed at or before when_expire.
+
+        The dropped objects that nothing else holds are moved into
+        stuffToSweep, so that the caller can destroy them unlocked.
+    */
+    void sweep (clock_type::time_point when_expire,
+        std::vector <mapped_ptr>& stuffToSweep,
+            int& cacheRemovals, int& mapRemovals)
+    {
+        stuffToSweep.reserve (stuffToSweep.size () + m_cache.size ());
+
+        cache_iterator cit = m_cache.begin ();
+
+        while (cit != m_cache.end ())
+        {
+            if (cit->second.isWeak ())
+            {
+                // weak
+                if (cit->second.isExpired ())
+                {
+                    ++mapRemovals;
+                    cit = m_cache.erase (cit);
+                }
+                else
+                {
+                    ++cit;
+                }
+            }
+            else if (cit->second.last_access <= when_expire)
+            {
+                // strong, expired
+                --m_count;
+                ++cacheRemovals;
+                if (cit->second.ptr.unique ())
+                {
+                    stuffToSweep.push_back (cit->second.ptr);
+                    ++mapRemovals;
+                    cit = m_cache.erase (cit);
+                }
+                else
+                {
+                    // remains weakly cached
+                    cit->second.ptr.reset ();
+                    ++cit;
+                }
+            }
+            else
+            {
+                // strong, not expired
+                ++cit;
+            }
+        }
+    }
+
+    bool del (const key_type& key, bool valid)
+    {
+        cache_iterator cit = m_cache.find (key);
+
+        if (cit == m_cache.end ())
+            return false;
+
+        Entry& entry = cit->second;
+
+        bool ret = false;
+
+        if (entry.isCached ())
+        {
+            --m_count;
+            entry.ptr.reset ();
+            ret = true;
+        }
+
+        if (!valid || entry.isExpired ())
+            m_cache.erase (cit);
+
+        return ret;
+    }
+
+    bool canonicalize (const key_type& key, std::shared_ptr<T>& data,
+        bool replace, clock_type::time_point now)
+    {
+        cache_iterator cit = m_cache.find (key);
+
+        if (cit == m_cache.end ())
+        {
+            m_cache.emplace (std::piecewise_construct,
+                std::forward_as_tuple(key),
+                std::forward_as_tuple(now, data));
+            ++m_count;
+            return false;
+        }
+
+        Entry& entry = cit->second;
+        entry.touch (now);
+
+        if (entry.isCached ())
+        {
+            if (replace)
+            {
+                entry.ptr = data;
+                entry.weak_ptr = data;
+            }
+            else
+            {
+                data = entry.ptr;
+            }
+
+            return true;
+        }
+
+        mapped_ptr cachedData = entry.lock ();
+
+        if (cachedData)
+        {
+            if (replace)
+            {
+                entry.ptr = data;
+                entry.weak_ptr = data;
+            }
+            else
+            {
+                entry.ptr = cachedData;
+                data = cachedData;
+            }
+
+            ++m_count;
+            return true;
+        }
+
+        entry.ptr = data;
+        entry.weak_ptr = data;
+        ++m_count;
+
+        return false;
+    }
+
+    mapped_ptr fetch (const key_type& key, clock_type::time_point now,
+        Found& found)
+    {
+        cache_iterator cit = m_cache.find (key);
+
+        if (cit == m_cache.end ())
+        {
+            found = Found::miss;
+            return mapped_ptr ();
+        }
+
+        Entry& entry = cit->second;
+        entry.touch (now);
+
+        if (entry.isCached ())
+        {
+            found = Found::hit;
+            return entry.ptr;
+        }
+
+        entry.ptr = entry.lock ();
+
+        if (entry.isCached ())
+        {
+            ++m_count;
+            found = Found::revived;
+            return entry.ptr;
+        }
+
+        m_cache.erase (cit);
+        found = Found::miss;
+        return mapped_ptr ();
+    }
+
+    bool refreshIfPresent (const key_type& key, clock_type::time_point now)
+    {
+        cache_iterator cit = m_cache.find (key);
+
+        if (cit == m_cache.end ())
+            return false;
+
+        Entry& entry = cit->second;
+
+        if (! entry.isCached ())
+        {
+            // Convert weak to strong.
+            entry.ptr = entry.lock ();
+
+            if (! entry.isCached ())
+            {
+                // Couldn't get strong pointer,
+                // object fell out of the cache so remove the entry.
+                m_cache.erase (cit);
+                return false;
+            }
+
+            // We just put the object back in cache
+            ++m_count;
+        }
+
+        entry.touch (now);
+        return true;
+    }
+
+private:
+    class Entry
+    {
+    public:
+        mapped_ptr ptr;
+        std::weak_ptr <T> weak_ptr;
+        clock_type::time_point last_access;
+
+        Entry (clock_type::time_point const& last_access_,
+            mapped_ptr const& ptr_)
+            : ptr (ptr_)
+            , weak_ptr (ptr_)
+            , last_access (last_access_)
+        {
+        }
+
+        bool isWeak () const { return ptr == nullptr; }
+        bool isCached () const { return ptr != nullptr; }
+        bool isExpired () const { return weak_ptr.expired (); }
+        mapped_ptr lock () { return weak_ptr.lock (); }
+        void touch (clock_type::time_point const& now) { last_access = now; }
+    };
+
+    using cache_type = hardened_hash_map <key_type, Entry, Hash, KeyEqual>;
+    using cache_iterator = typename cache_type::iterator;
+
+    cache_type m_cache;  // Hold strong reference to recent objects
+
+    // Number of items cached
+    int m_count = 0;
+};
+
+/** The insight metrics of a tagged cache. */
+struct TaggedCacheStats
+{
+    template <class Handler>
+    TaggedCacheStats (std::string const& prefix, Handler const& handler,
+        beast::insight::Collector::ptr const& collector)
+        : hook (collector->make_hook (handler))
+        , size (collector->make_gauge (prefix, "size"))
+        , hit_rate (collector->make_gauge (prefix, "hit_rate"))
+        { }
+
+    beast::insight::Hook hook;
+    beast::insight::Gauge size;
+    beast::insight::Gauge hit_rate;
+};
+
+} // detail
+} // ripple
+
+#endif
@@ -56,11 +56,12 @@ enum SizedItemName
     siLedgerFetch,
     siHashNodeDBCache,
     siTxnDBCache,
-    siLgrDBCache
+    siLgrDBCache,
+    siParsedSLESize
 };
 
 static constexpr
-std::array<std::array<int, 5>, 13> sizedItems
+std::array<std::array<int, 5>, 14> sizedItems
 {{
     //  tiny      small   medium  large   huge
     {{  10,       30,     60,     90,     120     }}, // siSweepInterval
@@ -80,7 +81,8 @@ std::array<std::array<int, 5>, 13> sizedItems
 
     {{  4,        12,     24,     64,     128     }}, // siHashNodeDBCache
     {{  4,        12,     24,     64,     128     }}, // siTxnDBCache
-    {{  4,        8,      16,     32,     128     }}  // siLgrDBCache
+    {{  4,        8,      16,     32,     128     }}, // siLgrDBCache
+    {{  16,       32,     64,     128,    256     }}  // siParsedSLESize (MB)
 }};
 
 //  This entire derived class is deprecated.
@@ -30,6 +30,7 @@ struct ConfigSection
     explicit ConfigSection() = default;
 
     static std::string nodeDatabase ()       { return "node_db"; }
+    static std::string nodeDatabaseCold ()   { return "node_db_cold"; }
     static std::string shardDatabase ()      { return "shard_db"; }
     static std::string importNodeDatabase () { return "import_db"; }
 };
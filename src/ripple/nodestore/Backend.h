@@ -76,7 +76,15 @@ public:
     bool
     canFetchBatch() = 0;
 
-    /** Fetch a batch synchronously. */
+    /** Fetch a batch synchronously.
+        The returned vector has one entry for each key, in the same order.
+        An entry is `nullptr` if the object was not found or could not be
+        decoded.
+        @note This will be called concurrently.
+        @param n The number of keys.
+        @param keys An array of pointers to the key data.
+        @return The fetched objects.
+    */
     virtual
     std::vector<std::shared_ptr<NodeObject>>
     fetchBatch (std::size_t n, void const* const* keys) = 0;
@@ -106,6 +114,15 @@ public:
     /** Estimate the number of write operations pending. */
     virtual int getWriteLoad () = 0;
 
+    /** Block until every object stored so far has been written.
+        Backends that write synchronously have nothing to wait for.
+    */
+    virtual
+    void
+    sync()
+    {
+    }
+
     /** Remove contents on disk upon destruction. */
     virtual void setDeletePath() = 0;
 
@@ -115,6 +132,16 @@ public:
     /** Returns the number of file descriptors the backend expects to need. */
     virtual int fdRequired() const = 0;
 
+    /** Returns the counts of the backend's negative lookup filter.
+        Backends without a filter report it as disabled.
+    */
+    virtual
+    FilterCounts
+    getFilterCounts() const
+    {
+        return {};
+    }
+
     /** Returns true if the backend uses permanent storage. */
     bool
     backed() const
@@ -20,15 +20,19 @@
 #ifndef RIPPLE_NODESTORE_DATABASE_H_INCLUDED
 #define RIPPLE_NODESTORE_DATABASE_H_INCLUDED
 
-#include <ripple/basics/TaggedCache.h>
+#include <ripple/basics/ShardedTaggedCache.h>
 #include <ripple/basics/KeyCache.h>
 #include <ripple/core/Stoppable.h>
 #include <ripple/nodestore/Backend.h>
 #include <ripple/nodestore/impl/Tuning.h>
 #include <ripple/nodestore/Scheduler.h>
 #include <ripple/nodestore/NodeObject.h>
+#include <ripple/nodestore/Trace.h>
 #include <ripple/protocol/SystemParameters.h>
 
+#include <boost/optional.hpp>
+
+#include <future>
 #include <thread>
 
 namespace ripple {
@@ -37,6 +41,8 @@ class Ledger;
 
 namespace NodeStore {
 
+class IOBudget;
+
 /** Persistency layer for NodeObject
 
     A Node is a ledger object which is uniquely identified by a key, which is
@@ -125,6 +131,21 @@ public:
     std::shared_ptr<NodeObject>
     fetch(uint256 const& hash, std::uint32_t seq) = 0;
 
+    /** Fetch a batch of objects.
+        Objects found in the cache are returned directly, the remaining
+        keys are looked up in the backend with as few calls as the
+        backend supports.
+
+        @note This can be called concurrently.
+        @param hashes The keys of the objects to retrieve.
+        @param seq The sequence of the ledger where the objects are stored.
+        @return One entry for each key, in the same order. An entry is
+                nullptr if the object couldn't be retrieved.
+    */
+    virtual
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch(std::vector<uint256> const& hashes, std::uint32_t seq) = 0;
+
     /** Fetch an object without waiting.
         If I/O is required to determine whether or not the object is present,
         `false` is returned. Otherwise, `true` is returned and `object` is set
@@ -142,6 +163,21 @@ public:
     asyncFetch(uint256 const& hash, std::uint32_t seq,
         std::shared_ptr<NodeObject>& object) = 0;
 
+    /** Fetch an object only if it is cached.
+        Like asyncFetch, but no I/O is scheduled when the object is in
+        neither the positive nor the negative cache.
+
+        @note This can be called concurrently.
+        @param hash The key of the object to retrieve
+        @param seq The sequence of the ledger where the object is stored.
+        @param object The object retrieved
+        @return Whether the object's presence is known
+    */
+    virtual
+    bool
+    fetchCached(uint256 const& hash, std::uint32_t seq,
+        std::shared_ptr<NodeObject>& object) = 0;
+
     /** Copies a ledger stored in a different database to this one.
 
         @param ledger The ledger to copy.
@@ -156,6 +192,14 @@ public:
     void
     waitReads();
 
+    /** Wait until at most `count` async reads are queued or running.
+
+        Lets a caller keep reads in flight while it works on the
+        results of those already done.
+    */
+    void
+    waitReads(std::size_t count);
+
     /** Get the maximum number of async reads the node store prefers.
 
         @param seq A ledger sequence specifying a shard to query.
@@ -171,6 +215,11 @@ public:
     float
     getCacheHitRate() = 0;
 
+    /** Get the counts of the backends' negative lookup filters. */
+    virtual
+    FilterCounts
+    getFilterCounts() = 0;
+
     /** Set the maximum number of entries and maximum cache age for both caches.
 
         @param size Number of cache entries (0 = ignore)
@@ -198,6 +247,10 @@ public:
     std::uint32_t
     getFetchHitCount() const { return fetchHitCount_; }
 
+    /** Number of fetches that shared a concurrent read of the same object. */
+    std::uint32_t
+    getFetchSharedCount() const { return fetchSharedCount_; }
+
     std::uint32_t
     getStoreSize() const { return storeSz_; }
 
@@ -228,53 +281,85 @@ protected:
     stopThreads();
 
     void
-    storeStats(size_t sz)
+    storeStats(NodeObject const& nObj, std::uint32_t seq)
     {
         ++storeCount_;
-        storeSz_ += sz;
+        storeSz_ += nObj.getData().size();
+        if (trace_)
+        {
+            trace_->record(TraceRecord::Op::store, nObj.getHash(), seq,
+                nObj.getData().size(), TraceWriter::clock_type::now());
+        }
     }
 
     void
     asyncFetch(uint256 const& hash, std::uint32_t seq,
-        std::shared_ptr<TaggedCache<uint256, NodeObject>> const& pCache,
+        std::shared_ptr<ShardedTaggedCache<uint256, NodeObject>> const& pCache,
             std::shared_ptr<KeyCache<uint256>> const& nCache);
 
     std::shared_ptr<NodeObject>
     fetchInternal(uint256 const& hash, Backend& srcBackend);
 
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchInternal(std::vector<uint256> const& hashes,
+        Backend& srcBackend);
+
     void
     importInternal(Backend& dstBackend, Database& srcDB);
 
     std::shared_ptr<NodeObject>
     doFetch(uint256 const& hash, std::uint32_t seq,
-        TaggedCache<uint256, NodeObject>& pCache,
+        ShardedTaggedCache<uint256, NodeObject>& pCache,
+            KeyCache<uint256>& nCache, bool isAsync);
+
+    std::vector<std::shared_ptr<NodeObject>>
+    doFetchBatch(std::vector<uint256> const& hashes, std::uint32_t seq,
+        ShardedTaggedCache<uint256, NodeObject>& pCache,
             KeyCache<uint256>& nCache, bool isAsync);
 
     bool
     copyLedger(Backend& dstBackend, Ledger const& srcLedger,
-        std::shared_ptr<TaggedCache<uint256, NodeObject>> const& pCache,
+        std::shared_ptr<ShardedTaggedCache<uint256, NodeObject>> const& pCache,
             std::shared_ptr<KeyCache<uint256>> const& nCache,
-                std::shared_ptr<Ledger const> const& srcNext);
+                std::shared_ptr<Ledger const> const& srcNext,
+                    IOBudget* budget = nullptr);
 
 private:
     std::atomic<std::uint32_t> storeCount_ {0};
     std::atomic<std::uint32_t> fetchTotalCount_ {0};
     std::atomic<std::uint32_t> fetchHitCount_ {0};
+    std::atomic<std::uint32_t> fetchSharedCount_ {0};
     std::atomic<std::uint32_t> storeSz_ {0};
     std::atomic<std::uint32_t> fetchSz_ {0};
 
+    // Records every fetch and store when trace_file is configured
+    std::unique_ptr<TraceWriter> trace_;
+
+    using FetchFuture = std::shared_future<std::shared_ptr<NodeObject>>;
+    using FetchPromise = std::promise<std::shared_ptr<NodeObject>>;
+
+    // Reads from the database(s) in progress, keyed by cache and hash.
+    // Concurrent fetches of the same object through the same cache
+    // wait for the result of the first one instead of reading again.
+    std::mutex inFlightLock_;
+    std::map<std::pair<ShardedTaggedCache<uint256, NodeObject> const*, uint256>,
+        FetchFuture> inFlight_;
+
     std::mutex readLock_;
     std::condition_variable readCondVar_;
     std::condition_variable readGenCondVar_;
 
     // reads to do
     std::map<uint256, std::tuple<std::uint32_t,
-        std::weak_ptr<TaggedCache<uint256, NodeObject>>,
+        std::weak_ptr<ShardedTaggedCache<uint256, NodeObject>>,
             std::weak_ptr<KeyCache<uint256>>>> read_;
 
     // last read
     uint256 readLastHash_;
 
+    // reads taken from read_ and not yet done
+    std::size_t readActive_ {0};
+
     std::vector<std::thread> readThreads_;
     bool readShut_ {false};
 
@@ -289,6 +374,13 @@ private:
     std::shared_ptr<NodeObject>
     fetchFrom(uint256 const& hash, std::uint32_t seq) = 0;
 
+    /** Fetch a batch of objects from the backend(s).
+        The default implementation fetches each object with fetchFrom.
+    */
+    virtual
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchFrom(std::vector<uint256> const& hashes, std::uint32_t seq);
+
     /** Visit every object in the database
         This is usually called during import.
 
@@ -300,6 +392,24 @@ private:
     void
     for_each(std::function <void(std::shared_ptr<NodeObject>)> f) = 0;
 
+    // Register a read of an object. Returns the future of the read
+    // in progress if there is one, otherwise the caller becomes the
+    // reader and must complete the promise with finishFetch.
+    boost::optional<FetchFuture>
+    startFetch(uint256 const& hash,
+        ShardedTaggedCache<uint256, NodeObject> const& pCache,
+            FetchPromise& promise);
+
+    void
+    finishFetch(uint256 const& hash,
+        ShardedTaggedCache<uint256, NodeObject> const& pCache);
+
+    // Read an object from the database(s) and update the caches
+    std::shared_ptr<NodeObject>
+    fetchAndCache(uint256 const& hash, std::uint32_t seq,
+        ShardedTaggedCache<uint256, NodeObject>& pCache,
+            KeyCache<uint256>& nCache);
+
     void
     threadEntry();
 };
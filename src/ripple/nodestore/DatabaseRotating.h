@@ -44,7 +44,7 @@ public:
     {}
 
     virtual
-    TaggedCache<uint256, NodeObject> const&
+    ShardedTaggedCache<uint256, NodeObject> const&
     getPositiveCache() = 0;
 
     virtual std::mutex& peekMutex() const = 0;
@@ -56,6 +56,29 @@ public:
     virtual
     std::unique_ptr<Backend>
     rotateBackends(std::unique_ptr<Backend> newBackend) = 0;
+
+    /** Make sure an object is in the writable backend.
+
+        The backends are read without consulting the caches, so an
+        object only in the archive is copied even if it is cached.
+
+        @param hash The key of the object.
+        @param copied Set to true if the object was copied.
+        @return The object, or nullptr if neither backend has it.
+    */
+    virtual
+    std::shared_ptr<NodeObject>
+    fetchToWritable(uint256 const& hash, bool& copied) = 0;
+
+    /** Number of objects copied from the archive to the writable backend. */
+    virtual
+    std::uint64_t
+    getCopyCount() const = 0;
+
+    /** Bytes copied from the archive to the writable backend. */
+    virtual
+    std::uint64_t
+    getCopySize() const = 0;
 };
 
 }
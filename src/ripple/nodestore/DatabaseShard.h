@@ -23,6 +23,7 @@
 #include <ripple/nodestore/Database.h>
 #include <ripple/app/ledger/Ledger.h>
 #include <ripple/basics/RangeSet.h>
+#include <ripple/json/json_value.h>
 #include <ripple/nodestore/Types.h>
 
 #include <boost/optional.hpp>
@@ -162,6 +163,15 @@ public:
     void
     validate() = 0;
 
+    /** Report shards being imported or validated
+
+        @return The shards in progress with the ledgers and bytes processed
+                so far, and the totals since the server started
+    */
+    virtual
+    Json::Value
+    getShardProgress() const = 0;
+
     /** @return The maximum number of ledgers stored in a shard
     */
     virtual
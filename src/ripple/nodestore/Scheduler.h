@@ -35,6 +35,9 @@ struct FetchReport
     bool isAsync;
     bool wentToDisk;
     bool wasFound;
+
+    // Objects the elapsed time was spent on, more than one for a batch
+    int fetchCount = 1;
 };
 
 /** Contains information about a batch write operation. */
@@ -44,6 +47,9 @@ struct BatchWriteReport
 
     std::chrono::milliseconds elapsed;
     int writeCount;
+
+    // Objects waiting to be written when the batch started
+    int queueDepth = 0;
 };
 
 /** Scheduling for asynchronous backend activity
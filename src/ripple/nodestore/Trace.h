@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_TRACE_H_INCLUDED
+#define RIPPLE_NODESTORE_TRACE_H_INCLUDED
+
+#include <ripple/basics/base_uint.h>
+#include <boost/filesystem/path.hpp>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace ripple {
+namespace NodeStore {
+
+/** One access to a node store, as recorded in a trace. */
+struct TraceRecord
+{
+    enum class Op : std::uint8_t
+    {
+        fetch = 0,
+        store = 1
+    };
+
+    uint256 hash;
+    std::uint32_t seq = 0;
+    Op op = Op::fetch;
+
+    // Microseconds from the start of the trace to the access
+    std::uint64_t time = 0;
+
+    // Size of the object, zero if a fetch didn't find it
+    std::uint32_t size = 0;
+};
+
+/** Records the accesses to a node store in a file.
+
+    Set `trace_file` in the database configuration to record every fetch
+    and store. The trace can be replayed against any backend with the
+    NodeStore.TraceReplay manual unit test.
+
+    The file holds fixed size records in host byte order, so it can only
+    be read on a host of the same endianness.
+*/
+class TraceWriter
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    /** Create the trace file, throws if it can not be written. */
+    explicit
+    TraceWriter(boost::filesystem::path const& path);
+
+    TraceWriter(TraceWriter const&) = delete;
+    TraceWriter& operator=(TraceWriter const&) = delete;
+
+    /** Append a record.
+
+        @param start When the access started.
+    */
+    void
+    record(TraceRecord::Op op, uint256 const& hash, std::uint32_t seq,
+        std::uint32_t size, clock_type::time_point start);
+
+private:
+    clock_type::time_point const start_;
+    std::mutex mutex_;
+    std::ofstream out_;
+};
+
+/** Read a trace file.
+
+    @return The records in the order they were written.
+    @throws std::runtime_error if the file is not a trace.
+*/
+std::vector<TraceRecord>
+readTrace(boost::filesystem::path const& path);
+
+} // NodeStore
+} // ripple
+
+#endif
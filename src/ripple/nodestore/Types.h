@@ -22,6 +22,7 @@
 
 #include <ripple/nodestore/NodeObject.h>
 #include <ripple/basics/BasicConfig.h>
+#include <chrono>
 #include <vector>
 
 namespace ripple {
@@ -34,13 +35,17 @@ enum
     //
     batchWritePreallocationSize = 256,
 
-    // This sets a limit on the maximum number of writes
-    // in a batch. Actual usage can be twice this since
-    // we have a new batch growing as we write the old.
+    // This sets a limit on the number of objects waiting to be
+    // written. Stores block when it is reached. It is also the
+    // largest group written at once.
     //
     batchWriteLimitSize = 65536
 };
 
+// Writes are grouped so that a group takes about this long to
+// write, based on how fast the backend has been writing.
+std::chrono::milliseconds constexpr batchWriteTargetLatency {100};
+
 /** Return codes from Backend operations. */
 enum Status
 {
@@ -52,6 +57,36 @@ enum Status
     customCode = 100
 };
 
+/** Lookups screened by the negative lookup filters of backends. */
+struct FilterCounts
+{
+    // True if at least one backend has a filter
+    bool enabled = false;
+
+    // Lookups answered as absent without reading the backend
+    std::uint64_t rejected = 0;
+
+    // Lookups passed to the backend that did not find the object
+    std::uint64_t falsePositives = 0;
+
+    FilterCounts&
+    operator+= (FilterCounts const& other)
+    {
+        enabled = enabled || other.enabled;
+        rejected += other.rejected;
+        falsePositives += other.falsePositives;
+        return *this;
+    }
+
+    /** The fraction of absent objects the filters failed to reject. */
+    double
+    falsePositiveRate() const
+    {
+        auto const absent = rejected + falsePositives;
+        return absent ? static_cast<double>(falsePositives) / absent : 0.0;
+    }
+};
+
 /** A batch of NodeObjects to write at once. */
 using Batch = std::vector <std::shared_ptr<NodeObject>>;
 
@@ -141,14 +141,27 @@ public:
     bool
     canFetchBatch() override
     {
-        return false;
+        return true;
     }
 
     std::vector<std::shared_ptr<NodeObject>>
     fetchBatch (std::size_t n, void const* const* keys) override
     {
-        Throw<std::runtime_error> ("pure virtual called");
-        return {};
+        assert(db_);
+        std::vector<std::shared_ptr<NodeObject>> results;
+        results.reserve (n);
+
+        std::lock_guard _(db_->mutex);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            uint256 const hash (uint256::fromVoid (keys[i]));
+            auto const iter = db_->table.find (hash);
+            if (iter != db_->table.end())
+                results.push_back (iter->second);
+            else
+                results.push_back (nullptr);
+        }
+        return results;
     }
 
     void
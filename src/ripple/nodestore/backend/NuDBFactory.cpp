@@ -22,6 +22,7 @@
 #include <ripple/nodestore/Factory.h>
 #include <ripple/nodestore/Manager.h>
 #include <ripple/nodestore/impl/codec.h>
+#include <ripple/nodestore/impl/CompressionDictionary.h>
 #include <ripple/nodestore/impl/DecodedBlob.h>
 #include <ripple/nodestore/impl/EncodedBlob.h>
 #include <nudb/nudb.hpp>
@@ -42,12 +43,17 @@ class NuDBBackend
 public:
     static constexpr std::size_t currentType = 1;
 
+    // Objects may be compressed with a dictionary. The id of
+    // the dictionary is kept in the upper 32 bits of the appnum.
+    static constexpr std::size_t dictionaryType = 2;
+
     beast::Journal j_;
     size_t const keyBytes_;
     std::string const name_;
     nudb::store db_;
     std::atomic <bool> deletePath_;
     Scheduler& scheduler_;
+    std::shared_ptr<CompressionDictionary const> dict_;
 
     NuDBBackend (
         size_t keyBytes,
@@ -63,6 +69,7 @@ public:
         if (name_.empty())
             Throw<std::runtime_error> (
                 "nodestore: Missing path in NuDB backend");
+        loadDictionary (keyValues);
     }
 
     NuDBBackend (
@@ -81,6 +88,7 @@ public:
         if (name_.empty())
             Throw<std::runtime_error> (
                 "nodestore: Missing path in NuDB backend");
+        loadDictionary (keyValues);
     }
 
     ~NuDBBackend () override
@@ -88,6 +96,49 @@ public:
         close();
     }
 
+    void
+    loadDictionary (Section const& keyValues)
+    {
+        std::string file;
+        if (! get_if_exists (keyValues, "compression_dictionary", file) ||
+            file.empty())
+            return;
+        dict_ = CompressionDictionary::load (file);
+        if (! dict_)
+            Throw<std::runtime_error> (
+                "nodestore: Unable to read compression dictionary " + file);
+    }
+
+    static
+    std::uint64_t
+    appnum (CompressionDictionary const& dict)
+    {
+        return dictionaryType |
+            (static_cast<std::uint64_t>(dict.id()) << 32);
+    }
+
+    // Decode a stored value, decompressing it straight into the
+    // buffer the NodeObject keeps. Returns nullptr if it is corrupt.
+    std::shared_ptr<NodeObject>
+    decode (void const* key, void const* data, std::size_t size) const
+    {
+        Blob value;
+        auto const result = nodeobject_decompress (data, size,
+            [&value](std::size_t n)
+            {
+                value.resize (n);
+                return value.data ();
+            }, dict_.get());
+        DecodedBlob decoded (key, result.first, result.second);
+        if (! decoded.wasOk ())
+            return nullptr;
+
+        // Uncompressed values are read in place and must be copied
+        if (result.first != value.data ())
+            return decoded.createObject ();
+        return decoded.createObject (std::move (value));
+    }
+
     std::string
     getName() override
     {
@@ -114,7 +165,8 @@ public:
         {
             create_directories(folder);
             nudb::create<nudb::xxhasher>(dp, kp, lp,
-                currentType, nudb::make_salt(), keyBytes_,
+                dict_ ? appnum(*dict_) : currentType,
+                    nudb::make_salt(), keyBytes_,
                     nudb::block_size(kp), 0.50, ec);
             if(ec == nudb::errc::file_exists)
                 ec = {};
@@ -124,9 +176,29 @@ public:
         db_.open (dp, kp, lp, ec);
         if(ec)
             Throw<nudb::system_error>(ec);
-        if (db_.appnum() != currentType)
+        if (db_.appnum() == currentType)
+        {
+            if (dict_)
+            {
+                // Objects in this database must stay readable
+                // without a dictionary.
+                JLOG(j_.warn()) <<
+                    name_ << " was created without a compression "
+                    "dictionary, not using it";
+                dict_.reset();
+            }
+        }
+        else if ((db_.appnum() & 0xffffffff) == dictionaryType)
+        {
+            if (! dict_ || appnum(*dict_) != db_.appnum())
+                Throw<std::runtime_error>(
+                    "nodestore: compression dictionary mismatch");
+        }
+        else
+        {
             Throw<std::runtime_error>(
                 "nodestore: unknown appnum");
+        }
     }
 
     void
@@ -152,19 +224,10 @@ public:
         pno->reset();
         nudb::error_code ec;
         db_.fetch (key,
-            [key, pno, &status](void const* data, std::size_t size)
+            [this, key, pno, &status](void const* data, std::size_t size)
             {
-                nudb::detail::buffer bf;
-                auto const result =
-                    nodeobject_decompress(data, size, bf);
-                DecodedBlob decoded (key, result.first, result.second);
-                if (! decoded.wasOk ())
-                {
-                    status = dataCorrupt;
-                    return;
-                }
-                *pno = decoded.createObject();
-                status = ok;
+                *pno = decode (key, data, size);
+                status = *pno ? ok : dataCorrupt;
             }, ec);
         if(ec == nudb::error::key_not_found)
             return notFound;
@@ -179,11 +242,24 @@ public:
         return false;
     }
 
+    // NuDB has no multi-key lookup, each key is one bucket read
     std::vector<std::shared_ptr<NodeObject>>
     fetchBatch (std::size_t n, void const* const* keys) override
     {
-        Throw<std::runtime_error> ("pure virtual called");
-        return {};
+        std::vector<std::shared_ptr<NodeObject>> results;
+        results.reserve (n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            std::shared_ptr<NodeObject> nObj;
+            Status const status = fetch (keys[i], &nObj);
+            if (status == dataCorrupt)
+            {
+                JLOG(j_.error()) <<
+                    "Corrupt NodeObject #" << uint256::fromVoid (keys[i]);
+            }
+            results.push_back (status == ok ? std::move (nObj) : nullptr);
+        }
+        return results;
     }
 
     void
@@ -194,7 +270,7 @@ public:
         nudb::error_code ec;
         nudb::detail::buffer bf;
         auto const result = nodeobject_compress(
-            e.getData(), e.getSize(), bf);
+            e.getData(), e.getSize(), bf, dict_.get());
         db_.insert (e.getKey(), result.first, result.second, ec);
         if(ec && ec != nudb::error::key_exists)
             Throw<nudb::system_error>(ec);
@@ -246,16 +322,13 @@ public:
                 void const* data, std::size_t size,
                 nudb::error_code&)
             {
-                nudb::detail::buffer bf;
-                auto const result =
-                    nodeobject_decompress(data, size, bf);
-                DecodedBlob decoded (key, result.first, result.second);
-                if (! decoded.wasOk ())
+                auto nObj = decode (key, data, size);
+                if (! nObj)
                 {
                     ec = make_error_code(nudb::error::missing_value);
                     return;
                 }
-                f (decoded.createObject());
+                f (std::move (nObj));
             }, nudb::no_progress{}, ec);
         if(ec)
             Throw<nudb::system_error>(ec);
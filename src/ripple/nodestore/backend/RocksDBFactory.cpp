@@ -108,7 +108,10 @@ public:
         , m_journal (journal)
         , m_keyBytes (keyBytes)
         , m_scheduler (scheduler)
-        , m_batch (*this, scheduler)
+        // RocksDB accepts concurrent writes, so batches can be
+        // written by more than one thread.
+        , m_batch (*this, scheduler,
+            get<int>(keyValues, "batch_write_threads", 2))
     {
         if (! get_if_exists(keyValues, "path", m_name))
             Throw<std::runtime_error> ("Missing path in RocksDBFactory backend");
@@ -299,14 +302,50 @@ public:
     bool
     canFetchBatch() override
     {
-        return false;
+        return true;
     }
 
     std::vector<std::shared_ptr<NodeObject>>
     fetchBatch (std::size_t n, void const* const* keys) override
     {
-        Throw<std::runtime_error> ("pure virtual called");
-        return {};
+        assert(m_db);
+
+        std::vector<rocksdb::Slice> slices;
+        slices.reserve (n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            slices.emplace_back (
+                static_cast <char const*> (keys[i]), m_keyBytes);
+        }
+
+        rocksdb::ReadOptions const options;
+        std::vector<std::string> values;
+        auto const statuses = m_db->MultiGet (options, slices, &values);
+
+        std::vector<std::shared_ptr<NodeObject>> results;
+        results.reserve (n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            std::shared_ptr<NodeObject> nObj;
+            if (statuses[i].ok ())
+            {
+                DecodedBlob decoded (
+                    keys[i], values[i].data (), values[i].size ());
+                if (decoded.wasOk ())
+                    nObj = decoded.createObject ();
+                else
+                {
+                    JLOG(m_journal.error()) <<
+                        "Corrupt NodeObject #" << uint256::fromVoid (keys[i]);
+                }
+            }
+            else if (! statuses[i].IsNotFound ())
+            {
+                JLOG(m_journal.error()) << statuses[i].ToString ();
+            }
+            results.push_back (std::move (nObj));
+        }
+        return results;
     }
 
     void
@@ -386,6 +425,12 @@ public:
         return m_batch.getWriteLoad ();
     }
 
+    void
+    sync() override
+    {
+        m_batch.waitForWriting ();
+    }
+
     void
     setDeletePath() override
     {
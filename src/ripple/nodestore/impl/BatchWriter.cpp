@@ -18,17 +18,18 @@
 //==============================================================================
 
 #include <ripple/nodestore/impl/BatchWriter.h>
+#include <algorithm>
+#include <iterator>
 
 namespace ripple {
 namespace NodeStore {
 
-BatchWriter::BatchWriter (Callback& callback, Scheduler& scheduler)
+BatchWriter::BatchWriter (Callback& callback, Scheduler& scheduler,
+        int threads)
     : m_callback (callback)
     , m_scheduler (scheduler)
-    , mWriteLoad (0)
-    , mWritePending (false)
+    , m_threads (std::max (threads, 1))
 {
-    mWriteSet.reserve (batchWritePreallocationSize);
 }
 
 BatchWriter::~BatchWriter ()
@@ -39,19 +40,32 @@ BatchWriter::~BatchWriter ()
 void
 BatchWriter::store (std::shared_ptr<NodeObject> const& object)
 {
-    std::unique_lock<decltype(mWriteMutex)> sl (mWriteMutex);
-
-    // If the batch has reached its limit, we wait
-    // until the batch writer is finished
-    while (mWriteSet.size() >= batchWriteLimitSize)
-        mWriteCondition.wait (sl);
-
-    mWriteSet.push_back (object);
-
-    if (! mWritePending)
+    // If the writers have fallen too far behind, we wait
+    if (m_pending.load () >= batchWriteLimitSize)
     {
-        mWritePending = true;
+        std::unique_lock<std::mutex> sl (m_waitMutex);
+        m_waitCondition.wait (sl, [this]
+        {
+            return m_pending.load () < batchWriteLimitSize;
+        });
+    }
 
+    auto const node = new Node {object,
+        m_staged.load (std::memory_order_relaxed)};
+    // Sequentially consistent, pairing with the writer that gives up:
+    // either we see it still running or it sees what we staged.
+    while (! m_staged.compare_exchange_weak (node->next, node,
+            std::memory_order_seq_cst, std::memory_order_relaxed))
+        ;
+    auto const pending = ++m_pending;
+
+    // Add a writer if there is none, or if there is more
+    // staged than the running writers can take in one group.
+    auto const writers = m_writers.load (std::memory_order_seq_cst);
+    if ((writers == 0 ||
+            (writers < m_threads && pending > writers * groupSize ())) &&
+        tryStartWriter ())
+    {
         m_scheduler.scheduleTask (*this);
     }
 }
@@ -59,64 +73,121 @@ BatchWriter::store (std::shared_ptr<NodeObject> const& object)
 int
 BatchWriter::getWriteLoad ()
 {
-    std::lock_guard sl (mWriteMutex);
-
-    return std::max (mWriteLoad, static_cast<int> (mWriteSet.size ()));
+    return m_pending.load ();
 }
 
 void
 BatchWriter::performScheduledTask ()
-{
-    writeBatch ();
-}
-
-void
-BatchWriter::writeBatch ()
 {
     for (;;)
     {
-        std::vector< std::shared_ptr<NodeObject> > set;
-
-        set.reserve (batchWritePreallocationSize);
+        auto const depth = m_pending.load ();
+        auto const group = takeGroup ();
 
+        if (group.empty ())
         {
-            std::lock_guard sl (mWriteMutex);
-
-            mWriteSet.swap (set);
-            assert (mWriteSet.empty ());
-            mWriteLoad = set.size ();
+            std::lock_guard<std::mutex> sl (m_waitMutex);
+            m_writers.fetch_sub (1, std::memory_order_seq_cst);
 
-            if (set.empty ())
-            {
-                mWritePending = false;
-                mWriteCondition.notify_all ();
-
-                // VFALCO NOTE Fix this function to not return from the middle
-                return;
-            }
+            // An object staged after the group was taken may have seen
+            // this writer running and not scheduled another.
+            if (m_staged.load (std::memory_order_seq_cst) != nullptr &&
+                    tryStartWriter ())
+                continue;
 
+            m_waitCondition.notify_all ();
+            return;
         }
 
         BatchWriteReport report;
-        report.writeCount = set.size();
-        auto const before = std::chrono::steady_clock::now();
+        report.writeCount = group.size ();
+        report.queueDepth = depth;
+        auto const before = std::chrono::steady_clock::now ();
+
+        m_callback.writeBatch (group);
 
-        m_callback.writeBatch (set);
+        auto const elapsed = std::chrono::steady_clock::now () - before;
+        report.elapsed = std::chrono::duration_cast <
+            std::chrono::milliseconds> (elapsed);
 
-        report.elapsed = std::chrono::duration_cast <std::chrono::milliseconds>
-            (std::chrono::steady_clock::now() - before);
+        auto const cost = std::chrono::duration_cast <
+            std::chrono::nanoseconds> (elapsed).count () / group.size ();
+        auto const previous = m_writeCost.load ();
+        m_writeCost = previous ? (3 * previous + cost) / 4 : cost;
 
         m_scheduler.onBatchWrite (report);
+
+        {
+            std::lock_guard<std::mutex> sl (m_waitMutex);
+            m_pending -= group.size ();
+        }
+        m_waitCondition.notify_all ();
     }
 }
 
+bool
+BatchWriter::tryStartWriter ()
+{
+    auto writers = m_writers.load ();
+    while (writers < m_threads)
+    {
+        if (m_writers.compare_exchange_weak (writers, writers + 1))
+            return true;
+    }
+    return false;
+}
+
+std::size_t
+BatchWriter::groupSize () const
+{
+    auto const cost = m_writeCost.load ();
+    if (cost == 0)
+        return batchWritePreallocationSize;
+    auto const target = std::chrono::duration_cast <
+        std::chrono::nanoseconds> (batchWriteTargetLatency).count ();
+    return std::min<std::size_t> (std::max<std::size_t> (
+        target / cost, batchWritePreallocationSize), batchWriteLimitSize);
+}
+
+Batch
+BatchWriter::takeGroup ()
+{
+    auto const size = groupSize ();
+
+    std::lock_guard<std::mutex> sl (m_groupMutex);
+
+    if (m_backlog.size () < size)
+    {
+        // Take everything staged, oldest first
+        auto const first = m_backlog.size ();
+        auto node = m_staged.exchange (nullptr, std::memory_order_acquire);
+        while (node)
+        {
+            m_backlog.push_back (std::move (node->object));
+            auto const next = node->next;
+            delete node;
+            node = next;
+        }
+        std::reverse (m_backlog.begin () + first, m_backlog.end ());
+    }
+
+    auto const end = m_backlog.begin () +
+        std::min (size, m_backlog.size ());
+    Batch group (std::make_move_iterator (m_backlog.begin ()),
+        std::make_move_iterator (end));
+    m_backlog.erase (m_backlog.begin (), end);
+    return group;
+}
+
 void
 BatchWriter::waitForWriting ()
 {
-    std::unique_lock <decltype(mWriteMutex)> sl (mWriteMutex);
+    std::unique_lock<std::mutex> sl (m_waitMutex);
 
-    while (mWritePending)
-        mWriteCondition.wait (sl);
+    m_waitCondition.wait (sl, [this]
+    {
+        return m_pending.load () == 0 && m_writers.load () == 0;
+    });
 }
 
 }
@@ -23,7 +23,10 @@
 #include <ripple/nodestore/Scheduler.h>
 #include <ripple/nodestore/Task.h>
 #include <ripple/nodestore/Types.h>
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <mutex>
 
 namespace ripple {
@@ -35,6 +38,12 @@ namespace NodeStore {
     class it not required. A backend can implement its own write batching,
     or skip write batching if doing so yields a performance benefit.
 
+    Stored objects are staged without locking. A writer takes whatever
+    has been staged as one group, up to the number of objects the backend
+    can write in about batchWriteTargetLatency. When objects are staged
+    faster than one writer can keep up, more writers are scheduled, up to
+    the limit given at construction.
+
     @see Scheduler
 */
 class BatchWriter : private Task
@@ -51,8 +60,13 @@ public:
         virtual void writeBatch (Batch const& batch) = 0;
     };
 
-    /** Create a batch writer. */
-    BatchWriter (Callback& callback, Scheduler& scheduler);
+    /** Create a batch writer.
+
+        @param threads The largest number of batches written at once.
+                       More than one requires a callback that can be
+                       called concurrently.
+    */
+    BatchWriter (Callback& callback, Scheduler& scheduler, int threads = 1);
 
     /** Destroy a batch writer.
 
@@ -70,22 +84,44 @@ public:
     /** Get an estimate of the amount of writing I/O pending. */
     int getWriteLoad ();
 
-private:
-    void performScheduledTask () override;
-    void writeBatch ();
+    /** Block until every object stored has been written. */
     void waitForWriting ();
 
 private:
-    using LockType = std::recursive_mutex;
-    using CondvarType = std::condition_variable_any;
+    // An object staged for writing
+    struct Node
+    {
+        std::shared_ptr<NodeObject> object;
+        Node* next;
+    };
+
+    void performScheduledTask () override;
+    bool tryStartWriter ();
+    std::size_t groupSize () const;
+    Batch takeGroup ();
 
+private:
     Callback& m_callback;
     Scheduler& m_scheduler;
-    LockType mWriteMutex;
-    CondvarType mWriteCondition;
-    int mWriteLoad;
-    bool mWritePending;
-    Batch mWriteSet;
+    int const m_threads;
+
+    // Most recently staged first
+    std::atomic <Node*> m_staged {nullptr};
+
+    // Objects staged or being written
+    std::atomic <int> m_pending {0};
+
+    std::atomic <int> m_writers {0};
+
+    // Average recent write time per object, in nanoseconds
+    std::atomic <std::uint64_t> m_writeCost {0};
+
+    // Staged objects taken by writers but not yet in a group
+    std::mutex m_groupMutex;
+    std::deque <std::shared_ptr<NodeObject>> m_backlog;
+
+    std::mutex m_waitMutex;
+    std::condition_variable m_waitCondition;
 };
 
 }
@@ -0,0 +1,165 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/nodestore/impl/BloomFilter.h>
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ripple {
+namespace NodeStore {
+
+namespace {
+
+// Identifies filter files and their layout
+std::uint32_t constexpr filterMagic = 0x4d4c4252; // "RBLM"
+std::uint32_t constexpr filterVersion = 1;
+
+std::uint32_t
+optimalHashes(std::uint32_t bitsPerKey)
+{
+    // k = ln(2) * m / n minimizes the false positive rate
+    auto const k = static_cast<std::uint32_t>(
+        std::lround(bitsPerKey * 0.69314718056));
+    return std::clamp<std::uint32_t>(k, 1, 16);
+}
+
+} // namespace
+
+BloomFilter::BloomFilter(std::uint64_t keys, std::uint32_t bitsPerKey)
+    : BloomFilter(
+        std::max<std::uint64_t>(64, keys * std::max(bitsPerKey, 1u)),
+        optimalHashes(bitsPerKey),
+        0)
+{
+}
+
+BloomFilter::BloomFilter(
+    std::uint64_t numBits, std::uint32_t numHashes, int)
+    : numBits_((numBits + 63) & ~std::uint64_t(63))
+    , numHashes_(numHashes)
+    , words_(numBits_ / 64)
+{
+    for (auto& word : words_)
+        word.store(0, std::memory_order_relaxed);
+}
+
+template <class F>
+void
+BloomFilter::forEachBit(void const* key, F&& f) const
+{
+    // Double hashing: bit i is h1 + i * h2
+    std::uint64_t h1;
+    std::uint64_t h2;
+    std::memcpy(&h1, key, sizeof(h1));
+    std::memcpy(&h2, static_cast<std::uint8_t const*>(key) + 8, sizeof(h2));
+    h2 |= 1;
+    for (std::uint32_t i = 0; i < numHashes_; ++i)
+    {
+        f((h1 + i * h2) % numBits_);
+    }
+}
+
+void
+BloomFilter::insert(void const* key)
+{
+    forEachBit(key,
+        [this](std::uint64_t bit)
+        {
+            words_[bit / 64].fetch_or(
+                std::uint64_t(1) << (bit % 64), std::memory_order_relaxed);
+        });
+}
+
+bool
+BloomFilter::mayContain(void const* key) const
+{
+    bool result = true;
+    forEachBit(key,
+        [this, &result](std::uint64_t bit)
+        {
+            if ((words_[bit / 64].load(std::memory_order_relaxed) &
+                (std::uint64_t(1) << (bit % 64))) == 0)
+            {
+                result = false;
+            }
+        });
+    return result;
+}
+
+bool
+BloomFilter::save(boost::filesystem::path const& path) const
+{
+    boost::filesystem::ofstream ofs(path,
+        std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open())
+        return false;
+
+    auto write = [&ofs](auto const& v)
+    {
+        ofs.write(reinterpret_cast<char const*>(&v), sizeof(v));
+    };
+    write(filterMagic);
+    write(filterVersion);
+    write(numBits_);
+    write(numHashes_);
+    for (auto const& word : words_)
+        write(word.load(std::memory_order_relaxed));
+    return ofs.good();
+}
+
+std::unique_ptr<BloomFilter>
+BloomFilter::load(boost::filesystem::path const& path)
+{
+    boost::filesystem::ifstream ifs(path, std::ios::in | std::ios::binary);
+    if (!ifs.is_open())
+        return nullptr;
+
+    auto read = [&ifs](auto& v)
+    {
+        ifs.read(reinterpret_cast<char*>(&v), sizeof(v));
+        return ifs.good();
+    };
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t numBits;
+    std::uint32_t numHashes;
+    if (!read(magic) || magic != filterMagic ||
+        !read(version) || version != filterVersion ||
+        !read(numBits) || numBits == 0 || numBits % 64 != 0 ||
+        !read(numHashes) || numHashes == 0 || numHashes > 16)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<BloomFilter> filter(
+        new BloomFilter(numBits, numHashes, 0));
+    for (auto& word : filter->words_)
+    {
+        std::uint64_t v;
+        if (!read(v))
+            return nullptr;
+        word.store(v, std::memory_order_relaxed);
+    }
+    return filter;
+}
+
+} // NodeStore
+} // ripple
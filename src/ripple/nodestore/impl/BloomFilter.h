@@ -0,0 +1,98 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_BLOOMFILTER_H_INCLUDED
+#define RIPPLE_NODESTORE_BLOOMFILTER_H_INCLUDED
+
+#include <ripple/basics/base_uint.h>
+#include <boost/filesystem/path.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ripple {
+namespace NodeStore {
+
+/** A fixed size Bloom filter over NodeObject keys.
+
+    Keys are 256-bit hashes of the object data, so their bits are already
+    uniformly distributed and are used directly as the filter's hashes.
+    Inserts and lookups may be called concurrently.
+*/
+class BloomFilter
+{
+public:
+    BloomFilter() = delete;
+    BloomFilter(BloomFilter const&) = delete;
+    BloomFilter& operator=(BloomFilter const&) = delete;
+
+    /** Create an empty filter.
+
+        @param keys The expected number of keys.
+        @param bitsPerKey The number of filter bits to allocate per key.
+    */
+    BloomFilter(std::uint64_t keys, std::uint32_t bitsPerKey);
+
+    void
+    insert(void const* key);
+
+    /** Returns `false` if the key was definitely never inserted. */
+    bool
+    mayContain(void const* key) const;
+
+    /** Returns the size of the filter in bits. */
+    std::uint64_t
+    size() const
+    {
+        return numBits_;
+    }
+
+    /** Write the filter to a file.
+
+        @return `true` if the filter was saved.
+    */
+    bool
+    save(boost::filesystem::path const& path) const;
+
+    /** Read a filter written by save.
+
+        @return The filter, or nullptr if the file is missing or invalid.
+    */
+    static
+    std::unique_ptr<BloomFilter>
+    load(boost::filesystem::path const& path);
+
+private:
+    BloomFilter(std::uint64_t numBits, std::uint32_t numHashes, int);
+
+    std::uint64_t numBits_;
+    std::uint32_t numHashes_;
+    std::vector<std::atomic<std::uint64_t>> words_;
+
+    // Calls f with the index of each bit that represents the key
+    template <class F>
+    void
+    forEachBit(void const* key, F&& f) const;
+};
+
+} // NodeStore
+} // ripple
+
+#endif
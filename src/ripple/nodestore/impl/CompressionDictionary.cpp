@@ -0,0 +1,241 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/nodestore/impl/CompressionDictionary.h>
+#include <ripple/basics/contract.h>
+#include <ripple/basics/FileUtilities.h>
+#include <ripple/protocol/digest.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace ripple {
+namespace NodeStore {
+
+CompressionDictionary::CompressionDictionary(Blob data)
+    : data_(std::move(data))
+    , stream_(std::make_unique<LZ4_stream_t>())
+{
+    if (data_.empty() || data_.size() > maxSize)
+        Throw<std::runtime_error>(
+            "nodestore: invalid compression dictionary size " +
+                std::to_string(data_.size()));
+
+    sha512_half_hasher h;
+    h(data_.data(), data_.size());
+    auto const digest =
+        static_cast<sha512_half_hasher::result_type>(h);
+    std::memcpy(&id_, digest.data(), sizeof(id_));
+    // Zero means no dictionary
+    if (id_ == 0)
+        id_ = 1;
+
+    std::memset(stream_.get(), 0, sizeof(LZ4_stream_t));
+    LZ4_loadDict(stream_.get(),
+        reinterpret_cast<char const*>(data_.data()),
+            static_cast<int>(data_.size()));
+}
+
+std::shared_ptr<CompressionDictionary const>
+CompressionDictionary::load(boost::filesystem::path const& path)
+{
+    boost::system::error_code ec;
+    auto const contents = getFileContents(ec, path, maxSize);
+    if (ec || contents.empty())
+        return nullptr;
+    return std::make_shared<CompressionDictionary const>(
+        Blob(contents.begin(), contents.end()));
+}
+
+bool
+CompressionDictionary::save(boost::filesystem::path const& path) const
+{
+    std::ofstream out(path.string(),
+        std::ios::out | std::ios::binary | std::ios::trunc);
+    if (! out)
+        return false;
+    out.write(reinterpret_cast<char const*>(data_.data()), data_.size());
+    return static_cast<bool>(out);
+}
+
+//------------------------------------------------------------------------------
+
+namespace {
+
+// Training looks for the segments of the samples made of the
+// byte sequences (dmers) found in the largest number of samples.
+constexpr std::size_t dmerSize = 8;
+constexpr std::size_t segmentSize = 64;
+
+std::uint64_t
+dmerAt(std::uint8_t const* p)
+{
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+class Trainer
+{
+public:
+    explicit
+    Trainer(std::vector<Blob const*> samples)
+        : samples_(std::move(samples))
+    {
+        // Count each dmer once per sample it appears in
+        std::unordered_set<std::uint64_t> seen;
+        for (auto const s : samples_)
+        {
+            seen.clear();
+            for (std::size_t i = 0; i + dmerSize <= s->size(); ++i)
+            {
+                auto const dmer = dmerAt(s->data() + i);
+                if (seen.insert(dmer).second)
+                    ++frequency_[dmer];
+            }
+        }
+    }
+
+    // Choose the best segment from samples [first, last) and forget
+    // its dmers so later segments cover something else.
+    // Returns false if no segment adds anything.
+    bool
+    select(std::size_t first, std::size_t last, Blob& segment)
+    {
+        std::uint64_t bestScore = 0;
+        Blob const* bestSample = nullptr;
+        std::size_t bestOffset = 0;
+        for (auto i = first; i < last; ++i)
+        {
+            auto const s = samples_[i];
+            active_.clear();
+            score_ = 0;
+            std::size_t const dmers = segmentSize - dmerSize + 1;
+            for (std::size_t j = 0; j < dmers; ++j)
+                add(dmerAt(s->data() + j));
+            for (std::size_t offset = 0;; ++offset)
+            {
+                if (score_ > bestScore)
+                {
+                    bestScore = score_;
+                    bestSample = s;
+                    bestOffset = offset;
+                }
+                if (offset + segmentSize >= s->size())
+                    break;
+                remove(dmerAt(s->data() + offset));
+                add(dmerAt(s->data() + offset + dmers));
+            }
+        }
+        if (bestSample == nullptr)
+            return false;
+
+        auto const begin = bestSample->begin() + bestOffset;
+        segment.assign(begin, begin + segmentSize);
+        for (std::size_t j = 0; j + dmerSize <= segmentSize; ++j)
+            frequency_[dmerAt(segment.data() + j)] = 0;
+        return true;
+    }
+
+private:
+    void
+    add(std::uint64_t dmer)
+    {
+        if (active_[dmer]++ == 0)
+            score_ += frequency_[dmer];
+    }
+
+    void
+    remove(std::uint64_t dmer)
+    {
+        auto const it = active_.find(dmer);
+        if (--it->second == 0)
+        {
+            score_ -= frequency_[dmer];
+            active_.erase(it);
+        }
+    }
+
+    std::vector<Blob const*> const samples_;
+    std::unordered_map<std::uint64_t, std::uint32_t> frequency_;
+    std::unordered_map<std::uint64_t, std::uint32_t> active_;
+    std::uint64_t score_ = 0;
+};
+
+} // namespace
+
+Blob
+trainDictionary(std::vector<Blob> const& samples, std::size_t size)
+{
+    size = std::min(size, CompressionDictionary::maxSize);
+
+    std::vector<Blob const*> usable;
+    std::size_t total = 0;
+    for (auto const& s : samples)
+    {
+        if (s.size() < segmentSize)
+            continue;
+        usable.push_back(&s);
+        total += s.size();
+    }
+    std::size_t const segments = size / segmentSize;
+    if (usable.empty() || segments == 0)
+        return {};
+
+    // Split the samples into one epoch per segment and take the best
+    // segment from each, repeating until the dictionary is full or
+    // nothing new is found.
+    Trainer trainer(usable);
+    std::vector<Blob> chosen;
+    auto const epochSize = std::max<std::size_t>(total / segments, 1);
+    Blob segment;
+    for (bool progress = true; progress && chosen.size() < segments;)
+    {
+        progress = false;
+        std::size_t first = 0;
+        std::size_t bytes = 0;
+        for (std::size_t i = 0; i < usable.size() &&
+            chosen.size() < segments; ++i)
+        {
+            bytes += usable[i]->size();
+            if (bytes < epochSize && i + 1 < usable.size())
+                continue;
+            if (trainer.select(first, i + 1, segment))
+            {
+                chosen.push_back(segment);
+                progress = true;
+            }
+            first = i + 1;
+            bytes = 0;
+        }
+    }
+
+    // The compressor finds matches near the end of the dictionary
+    // most cheaply, so the best segments go last.
+    Blob result;
+    result.reserve(chosen.size() * segmentSize);
+    for (auto it = chosen.rbegin(); it != chosen.rend(); ++it)
+        result.insert(result.end(), it->begin(), it->end());
+    return result;
+}
+
+} // NodeStore
+} // ripple
@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_COMPRESSIONDICTIONARY_H_INCLUDED
+#define RIPPLE_NODESTORE_COMPRESSIONDICTIONARY_H_INCLUDED
+
+// Disable lz4 deprecation warning due to incompatibility with clang attributes
+#define LZ4_DISABLE_DEPRECATE_WARNINGS
+
+#include <ripple/basics/Blob.h>
+#include <boost/filesystem/path.hpp>
+#include <lz4.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ripple {
+namespace NodeStore {
+
+/** A dictionary used to compress small node objects.
+
+    Most account state leaves are a few hundred bytes and share field
+    codes, flags and common values that plain LZ4 can't find within a
+    single object. Preloading the compressor with a dictionary trained
+    on a sample of the store lets it refer back to these instead.
+
+    A database records the id of the dictionary its objects were
+    compressed with, and can only be read with the same dictionary.
+*/
+class CompressionDictionary
+{
+public:
+    /** The largest useful dictionary, the LZ4 window size. */
+    static constexpr std::size_t maxSize = 64 * 1024;
+
+    CompressionDictionary() = delete;
+    CompressionDictionary(CompressionDictionary const&) = delete;
+    CompressionDictionary& operator=(CompressionDictionary const&) = delete;
+
+    explicit
+    CompressionDictionary(Blob data);
+
+    /** Read a dictionary file.
+
+        @return The dictionary, or nullptr if the file can not be read.
+    */
+    static
+    std::shared_ptr<CompressionDictionary const>
+    load(boost::filesystem::path const& path);
+
+    /** Write the dictionary to a file.
+
+        @return `true` if the dictionary was saved.
+    */
+    bool
+    save(boost::filesystem::path const& path) const;
+
+    /** A nonzero identifier derived from the dictionary contents. */
+    std::uint32_t
+    id() const
+    {
+        return id_;
+    }
+
+    Blob const&
+    data() const
+    {
+        return data_;
+    }
+
+    /** A compression stream with the dictionary loaded.
+        Copy it to compress with the dictionary without hashing
+        the dictionary again.
+    */
+    LZ4_stream_t const&
+    stream() const
+    {
+        return *stream_;
+    }
+
+private:
+    Blob const data_;
+    std::uint32_t id_;
+    std::unique_ptr<LZ4_stream_t> stream_;
+};
+
+/** Build a compression dictionary from sample data.
+
+    Picks the segments of the samples covering the byte sequences that
+    appear in the most samples, so the dictionary holds the content that
+    objects have in common rather than any one object.
+
+    @param samples Data representative of what will be compressed.
+    @param size The maximum size of the dictionary.
+    @return The dictionary contents, empty if the samples are too small.
+*/
+Blob
+trainDictionary(std::vector<Blob> const& samples, std::size_t size);
+
+} // NodeStore
+} // ripple
+
+#endif
@@ -18,10 +18,12 @@
 //==============================================================================
 
 #include <ripple/nodestore/Database.h>
+#include <ripple/nodestore/impl/IOBudget.h>
 #include <ripple/app/ledger/Ledger.h>
 #include <ripple/basics/chrono.h>
 #include <ripple/beast/core/CurrentThreadName.h>
 #include <ripple/protocol/HashPrefix.h>
+#include <algorithm>
 
 namespace ripple {
 namespace NodeStore {
@@ -44,6 +46,13 @@ Database::Database(
     if (earliestSeq_ < 1)
         Throw<std::runtime_error>("Invalid earliest_seq");
 
+    std::string traceFile;
+    if (get_if_exists(config, "trace_file", traceFile) && !traceFile.empty())
+    {
+        trace_ = std::make_unique<TraceWriter>(traceFile);
+        JLOG(j_.warn()) << "Recording node store trace to " << traceFile;
+    }
+
     while (readThreads-- > 0)
         readThreads_.emplace_back(&Database::threadEntry, this);
 }
@@ -77,6 +86,14 @@ Database::waitReads()
         readGenCondVar_.wait(lock);
 }
 
+void
+Database::waitReads(std::size_t count)
+{
+    std::unique_lock<std::mutex> lock(readLock_);
+    while (! readShut_ && read_.size() + readActive_ > count)
+        readGenCondVar_.wait(lock);
+}
+
 void
 Database::onStop()
 {
@@ -105,7 +122,7 @@ Database::stopThreads()
 
 void
 Database::asyncFetch(uint256 const& hash, std::uint32_t seq,
-    std::shared_ptr<TaggedCache<uint256, NodeObject>> const& pCache,
+    std::shared_ptr<ShardedTaggedCache<uint256, NodeObject>> const& pCache,
         std::shared_ptr<KeyCache<uint256>> const& nCache)
 {
     // Post a read
@@ -152,6 +169,50 @@ Database::fetchInternal(uint256 const& hash, Backend& srcBackend)
     return nObj;
 }
 
+std::vector<std::shared_ptr<NodeObject>>
+Database::fetchBatchInternal(std::vector<uint256> const& hashes,
+    Backend& srcBackend)
+{
+    std::vector<void const*> keys;
+    keys.reserve(hashes.size());
+    for (auto const& hash : hashes)
+        keys.push_back(hash.begin());
+
+    std::vector<std::shared_ptr<NodeObject>> nObjs;
+    try
+    {
+        nObjs = srcBackend.fetchBatch(keys.size(), keys.data());
+    }
+    catch (std::exception const& e)
+    {
+        JLOG(j_.fatal()) <<
+            "Exception, " << e.what();
+        Rethrow();
+    }
+    assert(nObjs.size() == hashes.size());
+
+    for (auto const& nObj : nObjs)
+    {
+        if (nObj)
+        {
+            ++fetchHitCount_;
+            fetchSz_ += nObj->getData().size();
+        }
+    }
+    return nObjs;
+}
+
+std::vector<std::shared_ptr<NodeObject>>
+Database::fetchBatchFrom(std::vector<uint256> const& hashes,
+    std::uint32_t seq)
+{
+    std::vector<std::shared_ptr<NodeObject>> nObjs;
+    nObjs.reserve(hashes.size());
+    for (auto const& hash : hashes)
+        nObjs.push_back(fetchFrom(hash, seq));
+    return nObjs;
+}
+
 void
 Database::importInternal(Backend& dstBackend, Database& srcDB)
 {
@@ -182,7 +243,7 @@ Database::importInternal(Backend& dstBackend, Database& srcDB)
 // Perform a fetch and report the time it took
 std::shared_ptr<NodeObject>
 Database::doFetch(uint256 const& hash, std::uint32_t seq,
-    TaggedCache<uint256, NodeObject>& pCache,
+    ShardedTaggedCache<uint256, NodeObject>& pCache,
         KeyCache<uint256>& nCache, bool isAsync)
 {
     FetchReport report;
@@ -196,40 +257,215 @@ Database::doFetch(uint256 const& hash, std::uint32_t seq,
     auto nObj = pCache.fetch(hash);
     if (! nObj && ! nCache.touch_if_exists(hash))
     {
-        // Try the database(s)
+        // Try the database(s), unless another thread is already
+        // reading this object in which case we share its result
         report.wentToDisk = true;
-        nObj = fetchFrom(hash, seq);
-        ++fetchTotalCount_;
-        if (! nObj)
+        FetchPromise promise;
+        if (auto future = startFetch(hash, pCache, promise))
         {
-            // Just in case a write occurred
-            nObj = pCache.fetch(hash);
-            if (! nObj)
-                // We give up
-                nCache.insert(hash);
+            ++fetchSharedCount_;
+            nObj = future->get();
         }
         else
         {
-            // Ensure all threads get the same object
-            pCache.canonicalize(hash, nObj);
+            try
+            {
+                nObj = fetchAndCache(hash, seq, pCache, nCache);
+            }
+            catch (std::exception const&)
+            {
+                finishFetch(hash, pCache);
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+            finishFetch(hash, pCache);
+            promise.set_value(nObj);
+        }
+    }
+    report.wasFound = static_cast<bool>(nObj);
+    report.elapsed = duration_cast<milliseconds>(
+        steady_clock::now() - before);
+    scheduler_.onFetch(report);
+    if (trace_)
+    {
+        trace_->record(TraceRecord::Op::fetch, hash, seq,
+            nObj ? nObj->getData().size() : 0, before);
+    }
+    return nObj;
+}
+
+// Perform a batch fetch and report the time it took
+std::vector<std::shared_ptr<NodeObject>>
+Database::doFetchBatch(std::vector<uint256> const& hashes, std::uint32_t seq,
+    ShardedTaggedCache<uint256, NodeObject>& pCache,
+        KeyCache<uint256>& nCache, bool isAsync)
+{
+    using namespace std::chrono;
+    auto const before = steady_clock::now();
+
+    std::vector<std::shared_ptr<NodeObject>> nObjs;
+    nObjs.reserve(hashes.size());
+
+    // Satisfy what we can from the caches and
+    // gather the remaining keys for the database(s)
+    std::vector<uint256> misses;
+    std::vector<std::size_t> missIndexes;
+    for (std::size_t i = 0; i < hashes.size(); ++i)
+    {
+        auto nObj = pCache.fetch(hashes[i]);
+        if (! nObj && ! nCache.touch_if_exists(hashes[i]))
+        {
+            misses.push_back(hashes[i]);
+            missIndexes.push_back(i);
+        }
+        nObjs.push_back(std::move(nObj));
+    }
+
+    if (! misses.empty())
+    {
+        // Read the objects no other thread is reading
+        // and wait for the others to arrive
+        std::vector<FetchPromise> promises(misses.size());
+        std::vector<std::pair<std::size_t, FetchFuture>> shared;
+        std::vector<uint256> reads;
+        std::vector<std::size_t> readIndexes;
+        for (std::size_t i = 0; i < misses.size(); ++i)
+        {
+            if (auto future = startFetch(misses[i], pCache, promises[i]))
+                shared.emplace_back(missIndexes[i], std::move(*future));
+            else
+            {
+                reads.push_back(misses[i]);
+                readIndexes.push_back(i);
+            }
+        }
+
+        if (! reads.empty())
+        {
+            std::vector<std::shared_ptr<NodeObject>> fetched;
+            try
+            {
+                // Try the database(s)
+                fetched = fetchBatchFrom(reads, seq);
+                assert(fetched.size() == reads.size());
+            }
+            catch (std::exception const&)
+            {
+                for (std::size_t i = 0; i < reads.size(); ++i)
+                {
+                    finishFetch(reads[i], pCache);
+                    promises[readIndexes[i]].set_exception(
+                        std::current_exception());
+                }
+                throw;
+            }
+
+            fetchTotalCount_ += reads.size();
+            for (std::size_t i = 0; i < reads.size(); ++i)
+            {
+                auto& nObj = fetched[i];
+                if (! nObj)
+                {
+                    // Just in case a write occurred
+                    nObj = pCache.fetch(reads[i]);
+                    if (! nObj)
+                        // We give up
+                        nCache.insert(reads[i]);
+                }
+                else
+                {
+                    // Ensure all threads get the same object
+                    pCache.canonicalize(reads[i], nObj);
+                }
+                finishFetch(reads[i], pCache);
+                promises[readIndexes[i]].set_value(nObj);
+                nObjs[missIndexes[readIndexes[i]]] = std::move(nObj);
+            }
 
-            // Since this was a 'hard' fetch, we will log it.
             JLOG(j_.trace()) <<
-                "HOS: " << hash << " fetch: in db";
+                "HOS: batch fetch of " << reads.size() << " in db";
         }
+
+        fetchSharedCount_ += shared.size();
+        for (auto& [index, future] : shared)
+            nObjs[index] = future.get();
     }
-    report.wasFound = static_cast<bool>(nObj);
+
+    // The batch is reported once, as the objects that went to disk
+    FetchReport report;
+    report.isAsync = isAsync;
+    report.wentToDisk = ! missIndexes.empty();
+    report.wasFound = std::any_of(nObjs.begin(), nObjs.end(),
+        [](auto const& nObj) { return static_cast<bool>(nObj); });
     report.elapsed = duration_cast<milliseconds>(
         steady_clock::now() - before);
+    report.fetchCount = report.wentToDisk ?
+        static_cast<int>(missIndexes.size()) : static_cast<int>(nObjs.size());
     scheduler_.onFetch(report);
+
+    if (trace_)
+    {
+        for (std::size_t i = 0; i < nObjs.size(); ++i)
+        {
+            trace_->record(TraceRecord::Op::fetch, hashes[i], seq,
+                nObjs[i] ? nObjs[i]->getData().size() : 0, before);
+        }
+    }
+    return nObjs;
+}
+
+boost::optional<Database::FetchFuture>
+Database::startFetch(uint256 const& hash,
+    ShardedTaggedCache<uint256, NodeObject> const& pCache, FetchPromise& promise)
+{
+    std::lock_guard lock(inFlightLock_);
+    auto const [it, inserted] = inFlight_.emplace(
+        std::make_pair(&pCache, hash), promise.get_future().share());
+    if (! inserted)
+        return it->second;
+    return boost::none;
+}
+
+void
+Database::finishFetch(uint256 const& hash,
+    ShardedTaggedCache<uint256, NodeObject> const& pCache)
+{
+    std::lock_guard lock(inFlightLock_);
+    inFlight_.erase(std::make_pair(&pCache, hash));
+}
+
+std::shared_ptr<NodeObject>
+Database::fetchAndCache(uint256 const& hash, std::uint32_t seq,
+    ShardedTaggedCache<uint256, NodeObject>& pCache, KeyCache<uint256>& nCache)
+{
+    auto nObj = fetchFrom(hash, seq);
+    ++fetchTotalCount_;
+    if (! nObj)
+    {
+        // Just in case a write occurred
+        nObj = pCache.fetch(hash);
+        if (! nObj)
+            // We give up
+            nCache.insert(hash);
+    }
+    else
+    {
+        // Ensure all threads get the same object
+        pCache.canonicalize(hash, nObj);
+
+        // Since this was a 'hard' fetch, we will log it.
+        JLOG(j_.trace()) <<
+            "HOS: " << hash << " fetch: in db";
+    }
     return nObj;
 }
 
 bool
 Database::copyLedger(Backend& dstBackend, Ledger const& srcLedger,
-    std::shared_ptr<TaggedCache<uint256, NodeObject>> const& pCache,
+    std::shared_ptr<ShardedTaggedCache<uint256, NodeObject>> const& pCache,
         std::shared_ptr<KeyCache<uint256>> const& nCache,
-            std::shared_ptr<Ledger const> const& srcNext)
+            std::shared_ptr<Ledger const> const& srcNext,
+                IOBudget* budget)
 {
     assert(static_cast<bool>(pCache) == static_cast<bool>(nCache));
     if (srcLedger.info().hash.isZero() ||
@@ -263,7 +499,7 @@ Database::copyLedger(Backend& dstBackend, Ledger const& srcLedger,
             {
                 pCache->canonicalize(nObj->getHash(), nObj, true);
                 nCache->erase(nObj->getHash());
-                storeStats(nObj->getData().size());
+                storeStats(*nObj, srcLedger.info().seq);
             }
         }
 #else
@@ -272,10 +508,17 @@ Database::copyLedger(Backend& dstBackend, Ledger const& srcLedger,
             {
                 pCache->canonicalize(nObj->getHash(), nObj, true);
                 nCache->erase(nObj->getHash());
-                storeStats(nObj->getData().size());
+                storeStats(*nObj, srcLedger.info().seq);
             }
 #endif
         dstBackend.storeBatch(batch);
+        if (budget)
+        {
+            std::uint64_t bytes {0};
+            for (auto const& nObj : batch)
+                bytes += nObj->getData().size();
+            budget->charge(bytes);
+        }
         batch.clear();
         batch.reserve(batchWritePreallocationSize);
     };
@@ -350,14 +593,22 @@ void
 Database::threadEntry()
 {
     beast::setCurrentThreadName("prefetch");
+    std::size_t done = 0;
     while (true)
     {
-        uint256 lastHash;
+        std::vector<uint256> hashes;
         std::uint32_t lastSeq;
-        std::shared_ptr<TaggedCache<uint256, NodeObject>> lastPcache;
+        std::shared_ptr<ShardedTaggedCache<uint256, NodeObject>> lastPcache;
         std::shared_ptr<KeyCache<uint256>> lastNcache;
         {
             std::unique_lock<std::mutex> lock(readLock_);
+            if (done != 0)
+            {
+                // Wake callers waiting for reads to drain
+                readActive_ -= done;
+                done = 0;
+                readGenCondVar_.notify_all();
+            }
             while (! readShut_ && read_.empty())
             {
                 // All work is done
@@ -376,17 +627,38 @@ Database::threadEntry()
                 ++readGen_;
                 readGenCondVar_.notify_all();
             }
-            lastHash = it->first;
             lastSeq = std::get<0>(it->second);
             lastPcache = std::get<1>(it->second).lock();
             lastNcache = std::get<2>(it->second).lock();
-            read_.erase(it);
-            readLastHash_ = lastHash;
+
+            // Gather the following reads that share a sequence and
+            // caches into one batch, leaving a share of the queue
+            // for each of the other threads
+            auto const batchSize = std::max<std::size_t>(1, std::min<
+                std::size_t>(asyncBatchSize,
+                    read_.size() / readThreads_.size()));
+            do
+            {
+                hashes.push_back(it->first);
+                it = read_.erase(it);
+            } while (it != read_.end() &&
+                hashes.size() < batchSize &&
+                std::get<0>(it->second) == lastSeq &&
+                std::get<1>(it->second).lock() == lastPcache &&
+                std::get<2>(it->second).lock() == lastNcache);
+            readLastHash_ = hashes.back();
+            readActive_ += hashes.size();
         }
 
         // Perform the read
-        if (lastPcache && lastPcache)
-            doFetch(lastHash, lastSeq, *lastPcache, *lastNcache, true);
+        if (lastPcache && lastNcache)
+        {
+            if (hashes.size() == 1)
+                doFetch(hashes.front(), lastSeq, *lastPcache, *lastNcache, true);
+            else
+                doFetchBatch(hashes, lastSeq, *lastPcache, *lastNcache, true);
+        }
+        done = hashes.size();
     }
 }
 
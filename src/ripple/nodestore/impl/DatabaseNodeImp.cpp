@@ -35,22 +35,28 @@ DatabaseNodeImp::store(NodeObjectType type, Blob&& data,
     pCache_->canonicalize(hash, nObj, true);
     backend_->store(nObj);
     nCache_->erase(hash);
-    storeStats(nObj->getData().size());
+    storeStats(*nObj, seq);
 }
 
 bool
 DatabaseNodeImp::asyncFetch(uint256 const& hash,
     std::uint32_t seq, std::shared_ptr<NodeObject>& object)
 {
-    // See if the object is in cache
-    object = pCache_->fetch(hash);
-    if (object || nCache_->touch_if_exists(hash))
+    if (fetchCached(hash, seq, object))
         return true;
     // Otherwise post a read
     Database::asyncFetch(hash, seq, pCache_, nCache_);
     return false;
 }
 
+bool
+DatabaseNodeImp::fetchCached(uint256 const& hash,
+    std::uint32_t, std::shared_ptr<NodeObject>& object)
+{
+    object = pCache_->fetch(hash);
+    return object || nCache_->touch_if_exists(hash);
+}
+
 void
 DatabaseNodeImp::tune(int size, std::chrono::seconds age)
 {
@@ -42,7 +42,7 @@ public:
         Section const& config,
         beast::Journal j)
         : Database(name, parent, scheduler, readThreads, config, j)
-        , pCache_(std::make_shared<TaggedCache<uint256, NodeObject>>(
+        , pCache_(std::make_shared<ShardedTaggedCache<uint256, NodeObject>>(
             name, cacheTargetSize, cacheTargetAge, stopwatch(), j))
         , nCache_(std::make_shared<KeyCache<uint256>>(
             name, stopwatch(), cacheTargetSize, cacheTargetAge))
@@ -86,10 +86,21 @@ public:
         return doFetch(hash, seq, *pCache_, *nCache_, false);
     }
 
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch(std::vector<uint256> const& hashes,
+        std::uint32_t seq) override
+    {
+        return doFetchBatch(hashes, seq, *pCache_, *nCache_, false);
+    }
+
     bool
     asyncFetch(uint256 const& hash, std::uint32_t seq,
         std::shared_ptr<NodeObject>& object) override;
 
+    bool
+    fetchCached(uint256 const& hash, std::uint32_t seq,
+        std::shared_ptr<NodeObject>& object) override;
+
     bool
     copyLedger(std::shared_ptr<Ledger const> const& ledger) override
     {
@@ -109,6 +120,9 @@ public:
     float
     getCacheHitRate() override {return pCache_->getHitRate();}
 
+    FilterCounts
+    getFilterCounts() override {return backend_->getFilterCounts();}
+
     void
     tune(int size, std::chrono::seconds age) override;
 
@@ -117,7 +131,7 @@ public:
 
 private:
     // Positive cache
-    std::shared_ptr<TaggedCache<uint256, NodeObject>> pCache_;
+    std::shared_ptr<ShardedTaggedCache<uint256, NodeObject>> pCache_;
 
     // Negative cache
     std::shared_ptr<KeyCache<uint256>> nCache_;
@@ -131,6 +145,13 @@ private:
         return fetchInternal(hash, *backend_);
     }
 
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchFrom(std::vector<uint256> const& hashes,
+        std::uint32_t seq) override
+    {
+        return fetchBatchInternal(hashes, *backend_);
+    }
+
     void
     for_each(std::function<void(std::shared_ptr<NodeObject>)> f) override
     {
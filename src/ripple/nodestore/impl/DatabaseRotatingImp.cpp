@@ -34,7 +34,7 @@ DatabaseRotatingImp::DatabaseRotatingImp(
     Section const& config,
     beast::Journal j)
     : DatabaseRotating(name, parent, scheduler, readThreads, config, j)
-    , pCache_(std::make_shared<TaggedCache<uint256, NodeObject>>(
+    , pCache_(std::make_shared<ShardedTaggedCache<uint256, NodeObject>>(
         name, cacheTargetSize, cacheTargetAge, stopwatch(), j))
     , nCache_(std::make_shared<KeyCache<uint256>>(
         name, stopwatch(), cacheTargetSize, cacheTargetAge))
@@ -70,22 +70,37 @@ DatabaseRotatingImp::store(NodeObjectType type, Blob&& data,
     pCache_->canonicalize(hash, nObj, true);
     getWritableBackend()->store(nObj);
     nCache_->erase(hash);
-    storeStats(nObj->getData().size());
+    storeStats(*nObj, seq);
 }
 
 bool
 DatabaseRotatingImp::asyncFetch(uint256 const& hash,
     std::uint32_t seq, std::shared_ptr<NodeObject>& object)
 {
-    // See if the object is in cache
-    object = pCache_->fetch(hash);
-    if (object || nCache_->touch_if_exists(hash))
+    if (fetchCached(hash, seq, object))
         return true;
     // Otherwise post a read
     Database::asyncFetch(hash, seq, pCache_, nCache_);
     return false;
 }
 
+bool
+DatabaseRotatingImp::fetchCached(uint256 const& hash,
+    std::uint32_t, std::shared_ptr<NodeObject>& object)
+{
+    object = pCache_->fetch(hash);
+    return object || nCache_->touch_if_exists(hash);
+}
+
+FilterCounts
+DatabaseRotatingImp::getFilterCounts()
+{
+    Backends b = getBackends();
+    auto counts = b.writableBackend->getFilterCounts();
+    counts += b.archiveBackend->getFilterCounts();
+    return counts;
+}
+
 void
 DatabaseRotatingImp::tune(int size, std::chrono::seconds age)
 {
@@ -104,7 +119,49 @@ DatabaseRotatingImp::sweep()
 
 std::shared_ptr<NodeObject>
 DatabaseRotatingImp::fetchFrom(uint256 const& hash, std::uint32_t seq)
+{
+    bool copied;
+    return fetchToWritable(hash, copied);
+}
+
+std::vector<std::shared_ptr<NodeObject>>
+DatabaseRotatingImp::fetchBatchFrom(std::vector<uint256> const& hashes,
+    std::uint32_t seq)
 {
+    Backends b = getBackends();
+    auto nObjs = fetchBatchInternal(hashes, *b.writableBackend);
+
+    // Look for the objects missing from the writable
+    // backend in the archive backend
+    std::vector<uint256> misses;
+    std::vector<std::size_t> missIndexes;
+    for (std::size_t i = 0; i < nObjs.size(); ++i)
+    {
+        if (! nObjs[i])
+        {
+            misses.push_back(hashes[i]);
+            missIndexes.push_back(i);
+        }
+    }
+    if (misses.empty())
+        return nObjs;
+
+    auto archived = fetchBatchInternal(misses, *b.archiveBackend);
+    for (std::size_t i = 0; i < archived.size(); ++i)
+    {
+        if (archived[i])
+        {
+            copyToWritable(archived[i]);
+            nObjs[missIndexes[i]] = std::move(archived[i]);
+        }
+    }
+    return nObjs;
+}
+
+std::shared_ptr<NodeObject>
+DatabaseRotatingImp::fetchToWritable(uint256 const& hash, bool& copied)
+{
+    copied = false;
     Backends b = getBackends();
     auto nObj = fetchInternal(hash, *b.writableBackend);
     if (! nObj)
@@ -112,12 +169,21 @@ DatabaseRotatingImp::fetchFrom(uint256 const& hash, std::uint32_t seq)
         nObj = fetchInternal(hash, *b.archiveBackend);
         if (nObj)
         {
-            getWritableBackend()->store(nObj);
-            nCache_->erase(hash);
+            copyToWritable(nObj);
+            copied = true;
         }
     }
     return nObj;
 }
 
+void
+DatabaseRotatingImp::copyToWritable(std::shared_ptr<NodeObject> const& nObj)
+{
+    getWritableBackend()->store(nObj);
+    nCache_->erase(nObj->getHash());
+    ++copyCount_;
+    copySz_ += nObj->getData().size();
+}
+
 } // NodeStore
 } // ripple
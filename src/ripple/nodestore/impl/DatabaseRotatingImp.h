@@ -22,6 +22,8 @@
 
 #include <ripple/nodestore/DatabaseRotating.h>
 
+#include <atomic>
+
 namespace ripple {
 namespace NodeStore {
 
@@ -87,10 +89,21 @@ public:
         return doFetch(hash, seq, *pCache_, *nCache_, false);
     }
 
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch(std::vector<uint256> const& hashes,
+        std::uint32_t seq) override
+    {
+        return doFetchBatch(hashes, seq, *pCache_, *nCache_, false);
+    }
+
     bool
     asyncFetch(uint256 const& hash, std::uint32_t seq,
         std::shared_ptr<NodeObject>& object) override;
 
+    bool
+    fetchCached(uint256 const& hash, std::uint32_t seq,
+        std::shared_ptr<NodeObject>& object) override;
+
     bool
     copyLedger(std::shared_ptr<Ledger const> const& ledger) override
     {
@@ -110,18 +123,30 @@ public:
     float
     getCacheHitRate() override {return pCache_->getHitRate();}
 
+    FilterCounts
+    getFilterCounts() override;
+
     void
     tune(int size, std::chrono::seconds age) override;
 
     void
     sweep() override;
 
-    TaggedCache<uint256, NodeObject> const&
+    ShardedTaggedCache<uint256, NodeObject> const&
     getPositiveCache() override {return *pCache_;}
 
+    std::shared_ptr<NodeObject>
+    fetchToWritable(uint256 const& hash, bool& copied) override;
+
+    std::uint64_t
+    getCopyCount() const override {return copyCount_;}
+
+    std::uint64_t
+    getCopySize() const override {return copySz_;}
+
 private:
     // Positive cache
-    std::shared_ptr<TaggedCache<uint256, NodeObject>> pCache_;
+    std::shared_ptr<ShardedTaggedCache<uint256, NodeObject>> pCache_;
 
     // Negative cache
     std::shared_ptr<KeyCache<uint256>> nCache_;
@@ -130,6 +155,10 @@ private:
     std::unique_ptr<Backend> archiveBackend_;
     mutable std::mutex rotateMutex_;
 
+    // Objects promoted from the archive to the writable backend
+    std::atomic<std::uint64_t> copyCount_ {0};
+    std::atomic<std::uint64_t> copySz_ {0};
+
     struct Backends {
         std::unique_ptr<Backend> const& writableBackend;
         std::unique_ptr<Backend> const& archiveBackend;
@@ -144,6 +173,13 @@ private:
     std::shared_ptr<NodeObject> fetchFrom(
         uint256 const& hash, std::uint32_t seq) override;
 
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchFrom(std::vector<uint256> const& hashes,
+        std::uint32_t seq) override;
+
+    void
+    copyToWritable(std::shared_ptr<NodeObject> const& nObj);
+
     void
     for_each(std::function <void(std::shared_ptr<NodeObject>)> f) override
     {
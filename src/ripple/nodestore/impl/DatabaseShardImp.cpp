@@ -23,15 +23,19 @@
 #include <ripple/basics/ByteUtilities.h>
 #include <ripple/basics/chrono.h>
 #include <ripple/basics/random.h>
+#include <ripple/beast/core/CurrentThreadName.h>
 #include <ripple/core/ConfigSections.h>
 #include <ripple/nodestore/DummyScheduler.h>
 #include <ripple/nodestore/Manager.h>
 #include <ripple/overlay/Overlay.h>
 #include <ripple/overlay/predicates.h>
 #include <ripple/protocol/HashPrefix.h>
+#include <ripple/protocol/jss.h>
 
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <thread>
+
 namespace ripple {
 namespace NodeStore {
 
@@ -147,6 +151,11 @@ DatabaseShardImp::init()
             return fail("'ledgers_per_shard' must be a multiple of 256");
     }
 
+    importThreads_ = std::max<std::uint32_t>(
+        get<std::uint32_t>(section, "import_threads", 1), 1);
+    importBudget_ = megabytes(
+        get<std::uint64_t>(section, "import_mb_per_sec", 0));
+
     // NuDB is the default and only supported permanent storage backend
     // "Memory" and "none" types are supported for tests
     backendName_ = get<std::string>(section, "type", "nudb");
@@ -473,7 +482,9 @@ DatabaseShardImp::importShard(std::uint32_t shardIndex,
         // so the database can fetch data from it
         it->second = shard.get();
         lock.unlock();
-        auto const valid {shard->validate()};
+        auto const valid {shard->validate(
+            startProgress(shardIndex, "validate").get())};
+        finishProgress(shardIndex, valid);
         lock.lock();
         if (!valid)
         {
@@ -639,12 +650,46 @@ DatabaseShardImp::validate()
     }
 
     // Verify each complete stored shard
-    for (auto const& shard : completeShards)
-        shard->validate();
+    parallelFor(completeShards.size(), [&](std::size_t i)
+    {
+        auto const& shard {completeShards[i]};
+        finishProgress(shard->index(), shard->validate(
+            startProgress(shard->index(), "validate").get()));
+    });
 
     app_.shardFamily()->reset();
 }
 
+Json::Value
+DatabaseShardImp::getShardProgress() const
+{
+    Json::Value ret {Json::objectValue};
+    ret[jss::threads] = importThreads_;
+
+    std::lock_guard lock(progressMutex_);
+    Json::Value& inProgress {ret[jss::in_progress] = Json::arrayValue};
+    std::uint64_t bytes {progressBytes_};
+    std::uint64_t bytesPerSecond {0};
+    for (auto const& e : progress_)
+    {
+        Json::Value& jv {inProgress.append(Json::objectValue)};
+        jv[jss::index] = e.first;
+        jv[jss::action] = e.second.action;
+        if (e.second.ledgers != 0)
+            jv[jss::ledgers] = e.second.ledgers;
+        jv[jss::bytes] = std::to_string(e.second.budget->bytes());
+        jv[jss::bytes_per_second] =
+            std::to_string(e.second.budget->bytesPerSecond());
+        bytes += e.second.budget->bytes();
+        bytesPerSecond += e.second.budget->bytesPerSecond();
+    }
+    ret[jss::complete] = progressComplete_;
+    ret[jss::failed] = progressFailed_;
+    ret[jss::bytes] = std::to_string(bytes);
+    ret[jss::bytes_per_second] = std::to_string(bytesPerSecond);
+    return ret;
+}
+
 void
 DatabaseShardImp::import(Database& source)
 {
@@ -711,23 +756,11 @@ DatabaseShardImp::import(Database& source)
             }
         }
 
-        // Import the shards
+        // Find the shards to import
+        std::vector<std::uint32_t> shardIndexes;
         for (std::uint32_t shardIndex = earliestIndex;
             shardIndex <= latestIndex; ++shardIndex)
         {
-            if (fileSz_ + avgShardFileSz_ > maxFileSz_)
-            {
-                JLOG(j_.error()) << "maximum storage size reached";
-                canAdd_ = false;
-                break;
-            }
-            if (avgShardFileSz_ > available())
-            {
-                JLOG(j_.error()) << "insufficient storage space available";
-                canAdd_ = false;
-                break;
-            }
-
             // Skip if already stored
             if (complete_.find(shardIndex) != complete_.end() ||
                 (incomplete_ && incomplete_->index() == shardIndex))
@@ -735,88 +768,49 @@ DatabaseShardImp::import(Database& source)
                 JLOG(j_.debug()) << "shard " << shardIndex << " already exists";
                 continue;
             }
+            shardIndexes.push_back(shardIndex);
+        }
 
-            // Verify SQLite ledgers are in the node store
+        JLOG(j_.info()) <<
+            "importing " << shardIndexes.size() << " shards using " <<
+            std::min<std::size_t>(importThreads_, shardIndexes.size()) <<
+            " threads";
+
+        // Import the shards, reserving storage for those in progress
+        app_.shardFamily()->reset();
+        std::mutex mutex;
+        std::uint64_t importedSz {0};
+        std::uint32_t importing {0};
+        parallelFor(shardIndexes.size(), [&](std::size_t i)
+        {
             {
-                auto const firstSeq {firstLedgerSeq(shardIndex)};
-                auto const lastSeq {
-                    std::max(firstSeq, lastLedgerSeq(shardIndex))};
-                auto const numLedgers {shardIndex == earliestShardIndex()
-                    ? lastSeq - firstSeq + 1 : ledgersPerShard_};
-                auto ledgerHashes{getHashesByIndex(firstSeq, lastSeq, app_)};
-                if (ledgerHashes.size() != numLedgers)
-                    continue;
-
-                bool valid {true};
-                for (std::uint32_t n = firstSeq; n <= lastSeq; n += 256)
+                std::lock_guard lockg(mutex);
+                if (!canAdd_)
+                    return;
+
+                auto const reserveSz {avgShardFileSz_ * (importing + 1)};
+                if (fileSz_ + importedSz + reserveSz > maxFileSz_)
                 {
-                    if (!source.fetch(ledgerHashes[n].first, n))
-                    {
-                        JLOG(j_.warn()) <<
-                            "SQLite ledger sequence " << n <<
-                            " mismatches node store";
-                        valid = false;
-                        break;
-                    }
+                    JLOG(j_.error()) << "maximum storage size reached";
+                    canAdd_ = false;
+                    return;
                 }
-                if (!valid)
-                    continue;
-            }
-
-            // Create the new shard
-            app_.shardFamily()->reset();
-            auto const shardDir {dir_ / std::to_string(shardIndex)};
-            auto shard {std::make_unique<Shard>(app_, *this, shardIndex, j_)};
-            if (!shard->open(scheduler_, *ctx_))
-            {
-                shard.reset();
-                continue;
-            }
-
-            // Create a marker file to signify an import in progress
-            auto const markerFile {shardDir / importMarker_};
-            std::ofstream ofs {markerFile.string()};
-            if (!ofs.is_open())
-            {
-                JLOG(j_.error()) <<
-                    "shard " << shardIndex <<
-                    " is unable to create temp marker file";
-                shard.reset();
-                removeAll(shardDir, j_);
-                continue;
-            }
-            ofs.close();
-
-            // Copy the ledgers from node store
-            while (auto seq = shard->prepare())
-            {
-                auto ledger = loadByIndex(*seq, app_, false);
-                if (!ledger || ledger->info().seq != seq ||
-                    !Database::copyLedger(*shard->getBackend(), *ledger,
-                        nullptr, nullptr, shard->lastStored()))
-                    break;
-
-                if (!shard->setStored(ledger))
-                    break;
-                if (shard->complete())
+                if (reserveSz > available())
                 {
-                    JLOG(j_.debug()) <<
-                        "shard " << shardIndex << " was successfully imported";
-                    removeAll(markerFile, j_);
-                    break;
+                    JLOG(j_.error()) <<
+                        "insufficient storage space available";
+                    canAdd_ = false;
+                    return;
                 }
+                ++importing;
             }
 
-            if (!shard->complete())
-            {
-                JLOG(j_.error()) <<
-                    "shard " << shardIndex << " failed to import";
-                shard.reset();
-                removeAll(shardDir, j_);
-            }
-            else
-                setFileStats(lock);
-        }
+            auto const sz {importFromNode(source, shardIndexes[i])};
+
+            std::lock_guard lockg(mutex);
+            --importing;
+            importedSz += sz;
+        });
 
         // Re initialize the shard store
         init_ = false;
@@ -871,7 +865,7 @@ DatabaseShardImp::store(NodeObjectType type,
         incomplete_->getBackend()->store(nObj);
         incomplete_->nCache()->erase(hash);
     }
-    storeStats(nObj->getData().size());
+    storeStats(*nObj, seq);
 }
 
 std::shared_ptr<NodeObject>
@@ -883,6 +877,16 @@ DatabaseShardImp::fetch(uint256 const& hash, std::uint32_t seq)
     return {};
 }
 
+std::vector<std::shared_ptr<NodeObject>>
+DatabaseShardImp::fetchBatch(std::vector<uint256> const& hashes,
+    std::uint32_t seq)
+{
+    auto cache {selectCache(seq)};
+    if (cache.first)
+        return doFetchBatch(hashes, seq, *cache.first, *cache.second, false);
+    return std::vector<std::shared_ptr<NodeObject>>(hashes.size());
+}
+
 bool
 DatabaseShardImp::asyncFetch(uint256 const& hash,
     std::uint32_t seq, std::shared_ptr<NodeObject>& object)
@@ -900,6 +904,17 @@ DatabaseShardImp::asyncFetch(uint256 const& hash,
     return false;
 }
 
+bool
+DatabaseShardImp::fetchCached(uint256 const& hash,
+    std::uint32_t seq, std::shared_ptr<NodeObject>& object)
+{
+    auto cache {selectCache(seq)};
+    if (! cache.first)
+        return false;
+    object = cache.first->fetch(hash);
+    return object || cache.second->touch_if_exists(hash);
+}
+
 bool
 DatabaseShardImp::copyLedger(std::shared_ptr<Ledger const> const& ledger)
 {
@@ -973,6 +988,20 @@ DatabaseShardImp::getCacheHitRate()
     return f / std::max(1.0f, sz);
 }
 
+FilterCounts
+DatabaseShardImp::getFilterCounts()
+{
+    FilterCounts counts;
+    std::lock_guard lock(m_);
+    assert(init_);
+
+    for (auto const& e : complete_)
+        counts += e.second->getBackend()->getFilterCounts();
+    if (incomplete_)
+        counts += incomplete_->getBackend()->getFilterCounts();
+    return counts;
+}
+
 void
 DatabaseShardImp::sweep()
 {
@@ -988,31 +1017,39 @@ DatabaseShardImp::sweep()
 
 std::shared_ptr<NodeObject>
 DatabaseShardImp::fetchFrom(uint256 const& hash, std::uint32_t seq)
+{
+    if (auto backend = findBackend(seq))
+        return fetchInternal(hash, *backend);
+    return {};
+}
+
+std::vector<std::shared_ptr<NodeObject>>
+DatabaseShardImp::fetchBatchFrom(std::vector<uint256> const& hashes,
+    std::uint32_t seq)
+{
+    if (auto backend = findBackend(seq))
+        return fetchBatchInternal(hashes, *backend);
+    return std::vector<std::shared_ptr<NodeObject>>(hashes.size());
+}
+
+std::shared_ptr<Backend>
+DatabaseShardImp::findBackend(std::uint32_t seq)
 {
     auto const shardIndex {seqToShardIndex(seq)};
-    std::unique_lock<std::mutex> lock(m_);
+    std::lock_guard lock(m_);
     assert(init_);
     {
         auto it = complete_.find(shardIndex);
         if (it != complete_.end())
-        {
-            lock.unlock();
-            return fetchInternal(hash, *it->second->getBackend());
-        }
+            return it->second->getBackend();
     }
     if (incomplete_ && incomplete_->index() == shardIndex)
-    {
-        lock.unlock();
-        return fetchInternal(hash, *incomplete_->getBackend());
-    }
+        return incomplete_->getBackend();
 
     // Used to validate import shards
     auto it = preShards_.find(shardIndex);
     if (it != preShards_.end() && it->second)
-    {
-        lock.unlock();
-        return fetchInternal(hash, *it->second->getBackend());
-    }
+        return it->second->getBackend();
     return {};
 }
 
@@ -1181,6 +1218,152 @@ DatabaseShardImp::available() const
     }
 }
 
+std::uint64_t
+DatabaseShardImp::importFromNode(Database& source, std::uint32_t shardIndex)
+{
+    // Verify SQLite ledgers are in the node store
+    {
+        auto const firstSeq {firstLedgerSeq(shardIndex)};
+        auto const lastSeq {
+            std::max(firstSeq, lastLedgerSeq(shardIndex))};
+        auto const numLedgers {shardIndex == earliestShardIndex()
+            ? lastSeq - firstSeq + 1 : ledgersPerShard_};
+        auto ledgerHashes{getHashesByIndex(firstSeq, lastSeq, app_)};
+        if (ledgerHashes.size() != numLedgers)
+            return 0;
+
+        for (std::uint32_t n = firstSeq; n <= lastSeq; n += 256)
+        {
+            if (!source.fetch(ledgerHashes[n].first, n))
+            {
+                JLOG(j_.warn()) <<
+                    "SQLite ledger sequence " << n <<
+                    " mismatches node store";
+                return 0;
+            }
+        }
+    }
+
+    // Create the new shard
+    auto const shardDir {dir_ / std::to_string(shardIndex)};
+    auto shard {std::make_unique<Shard>(app_, *this, shardIndex, j_)};
+    if (!shard->open(scheduler_, *ctx_))
+        return 0;
+
+    // Create a marker file to signify an import in progress
+    auto const markerFile {shardDir / importMarker_};
+    std::ofstream ofs {markerFile.string()};
+    if (!ofs.is_open())
+    {
+        JLOG(j_.error()) <<
+            "shard " << shardIndex <<
+            " is unable to create temp marker file";
+        shard.reset();
+        removeAll(shardDir, j_);
+        return 0;
+    }
+    ofs.close();
+
+    // Copy the ledgers from node store
+    auto const budget {startProgress(shardIndex, "import")};
+    try
+    {
+        while (auto seq = shard->prepare())
+        {
+            auto ledger = loadByIndex(*seq, app_, false);
+            if (!ledger || ledger->info().seq != seq ||
+                !Database::copyLedger(*shard->getBackend(), *ledger,
+                    nullptr, nullptr, shard->lastStored(), budget.get()))
+                break;
+
+            if (!shard->setStored(ledger))
+                break;
+            {
+                std::lock_guard lock(progressMutex_);
+                ++progress_[shardIndex].ledgers;
+            }
+            if (shard->complete())
+            {
+                JLOG(j_.info()) <<
+                    "shard " << shardIndex << " was successfully imported, " <<
+                    budget->bytes() << " bytes at " <<
+                    budget->bytesPerSecond() << " bytes per second";
+                removeAll(markerFile, j_);
+                break;
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        JLOG(j_.error()) <<
+            "shard " << shardIndex << " exception " << e.what() <<
+            " in function " << __func__;
+    }
+
+    auto const complete {shard->complete()};
+    finishProgress(shardIndex, complete);
+    if (!complete)
+    {
+        JLOG(j_.error()) <<
+            "shard " << shardIndex << " failed to import";
+        shard.reset();
+        removeAll(shardDir, j_);
+        return 0;
+    }
+    return shard->fileSize();
+}
+
+void
+DatabaseShardImp::parallelFor(std::size_t n,
+    std::function<void(std::size_t)> const& f)
+{
+    std::atomic<std::size_t> next {0};
+    auto work = [&]()
+    {
+        for (auto i = next++; i < n; i = next++)
+            f(i);
+    };
+
+    std::vector<std::thread> threads;
+    auto const numThreads {std::min<std::size_t>(importThreads_, n)};
+    for (std::size_t i = 1; i < numThreads; ++i)
+    {
+        threads.emplace_back([&work, i]()
+        {
+            beast::setCurrentThreadName("ShardImport #" + std::to_string(i));
+            work();
+        });
+    }
+    work();
+    for (auto& t : threads)
+        t.join();
+}
+
+std::shared_ptr<IOBudget>
+DatabaseShardImp::startProgress(std::uint32_t shardIndex, char const* action)
+{
+    auto budget {std::make_shared<IOBudget>(importBudget_)};
+    std::lock_guard lock(progressMutex_);
+    progress_[shardIndex] = {action, budget};
+    return budget;
+}
+
+void
+DatabaseShardImp::finishProgress(std::uint32_t shardIndex, bool success)
+{
+    std::lock_guard lock(progressMutex_);
+    auto it {progress_.find(shardIndex)};
+    if (it == progress_.end())
+        return;
+
+    if (success)
+        ++progressComplete_;
+    else
+        ++progressFailed_;
+    progressBytes_ += it->second.budget->bytes();
+    progress_.erase(it);
+}
+
 //------------------------------------------------------------------------------
 
 std::unique_ptr<DatabaseShard>
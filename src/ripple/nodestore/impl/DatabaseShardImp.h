@@ -79,6 +79,9 @@ public:
     void
     validate() override;
 
+    Json::Value
+    getShardProgress() const override;
+
     std::uint32_t
     ledgersPerShard() const override
     {
@@ -143,10 +146,18 @@ public:
     std::shared_ptr<NodeObject>
     fetch(uint256 const& hash, std::uint32_t seq) override;
 
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch(std::vector<uint256> const& hashes,
+        std::uint32_t seq) override;
+
     bool
     asyncFetch(uint256 const& hash, std::uint32_t seq,
         std::shared_ptr<NodeObject>& object) override;
 
+    bool
+    fetchCached(uint256 const& hash, std::uint32_t seq,
+        std::shared_ptr<NodeObject>& object) override;
+
     bool
     copyLedger(std::shared_ptr<Ledger const> const& ledger) override;
 
@@ -156,6 +167,9 @@ public:
     float
     getCacheHitRate() override;
 
+    FilterCounts
+    getFilterCounts() override;
+
     void
     tune(int size, std::chrono::seconds age) override {};
 
@@ -214,9 +228,40 @@ private:
     // File name used to mark shards being imported from node store
     static constexpr auto importMarker_ = "import";
 
+    // The number of shards imported or validated at the same time
+    std::uint32_t importThreads_ {1};
+
+    // Bytes per second each shard being imported or validated may
+    // read and write, zero for no limit
+    std::uint64_t importBudget_ {0};
+
+    // A shard being imported or validated
+    struct Progress
+    {
+        char const* action;
+        std::shared_ptr<IOBudget> budget;
+        std::uint32_t ledgers {0};
+    };
+
+    mutable std::mutex progressMutex_;
+    std::map<std::uint32_t, Progress> progress_;
+
+    // Shards that finished import or validation
+    std::uint32_t progressComplete_ {0};
+    std::uint32_t progressFailed_ {0};
+    std::uint64_t progressBytes_ {0};
+
     std::shared_ptr<NodeObject>
     fetchFrom(uint256 const& hash, std::uint32_t seq) override;
 
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchFrom(std::vector<uint256> const& hashes,
+        std::uint32_t seq) override;
+
+    // Returns the backend of the shard that stores a ledger sequence
+    std::shared_ptr<Backend>
+    findBackend(std::uint32_t seq);
+
     void
     for_each(std::function <void(std::shared_ptr<NodeObject>)> f) override
     {
@@ -246,6 +291,23 @@ private:
     // Returns available storage space
     std::uint64_t
     available() const;
+
+    // Copy a shard's ledgers from the node store
+    // Returns the storage space used by the shard, zero on failure
+    std::uint64_t
+    importFromNode(Database& source, std::uint32_t shardIndex);
+
+    // Calls f with every value in [0, n), on up to importThreads_ threads
+    void
+    parallelFor(std::size_t n, std::function<void(std::size_t)> const& f);
+
+    // Start reporting progress of a shard being imported or validated
+    std::shared_ptr<IOBudget>
+    startProgress(std::uint32_t shardIndex, char const* action);
+
+    // Stop reporting progress of a shard
+    void
+    finishProgress(std::uint32_t shardIndex, bool success);
 };
 
 } // NodeStore
@@ -0,0 +1,720 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/nodestore/impl/DatabaseTieredImp.h>
+#include <ripple/app/ledger/Ledger.h>
+#include <ripple/basics/contract.h>
+#include <ripple/beast/core/CurrentThreadName.h>
+#include <ripple/beast/core/LexicalCast.h>
+#include <ripple/nodestore/Manager.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <fstream>
+#include <functional>
+
+namespace ripple {
+namespace NodeStore {
+
+// A generation of the hot tier. Forwards to its backend and
+// logs the key of every object stored, for demotion.
+class DatabaseTieredImp::Generation : public Backend
+{
+public:
+    Generation(
+        std::unique_ptr<Backend> backend,
+        boost::filesystem::path const& keysPath,
+        std::uint32_t number)
+        : backend_(std::move(backend))
+        , keysPath_(keysPath)
+        , number_(number)
+    {
+        assert(backend_);
+    }
+
+    ~Generation() override
+    {
+        close();
+    }
+
+    std::uint32_t
+    number() const
+    {
+        return number_;
+    }
+
+    boost::filesystem::path const&
+    keysPath() const
+    {
+        return keysPath_;
+    }
+
+    // Count a write begun on the generation while it was current
+    void
+    beginWrite()
+    {
+        ++writers_;
+    }
+
+    void
+    endWrite()
+    {
+        if (--writers_ == 0)
+        {
+            std::lock_guard lock(writeMutex_);
+            writeCond_.notify_all();
+        }
+    }
+
+    // Wait for the writes begun while the generation was current,
+    // and those its backend queued, to land. Returns false if
+    // cancelled first.
+    bool
+    waitForWriters()
+    {
+        {
+            std::unique_lock lock(writeMutex_);
+            writeCond_.wait(lock, [this]
+            {
+                return writers_ == 0 || cancelled_;
+            });
+            if (cancelled_)
+                return false;
+        }
+        backend_->sync();
+        return true;
+    }
+
+    // Wake a call to waitForWriters, which then gives up
+    void
+    cancel()
+    {
+        std::lock_guard lock(writeMutex_);
+        cancelled_ = true;
+        writeCond_.notify_all();
+    }
+
+    // Make the logged keys visible to readers of the file
+    void
+    flushKeys()
+    {
+        std::lock_guard lock(mutex_);
+        keys_.flush();
+    }
+
+    std::string
+    getName() override
+    {
+        return backend_->getName();
+    }
+
+    void
+    open(bool createIfMissing) override
+    {
+        backend_->open(createIfMissing);
+        keys_.open(keysPath_.string(),
+            std::ios::out | std::ios::binary | std::ios::app);
+        if (!keys_)
+            Throw<std::runtime_error>(
+                "nodestore: Unable to open " + keysPath_.string());
+    }
+
+    void
+    close() override
+    {
+        {
+            std::lock_guard lock(mutex_);
+            if (keys_.is_open())
+                keys_.close();
+        }
+        backend_->close();
+        if (deletePath_)
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove(keysPath_, ec);
+        }
+    }
+
+    Status
+    fetch(void const* key, std::shared_ptr<NodeObject>* pObject) override
+    {
+        return backend_->fetch(key, pObject);
+    }
+
+    bool
+    canFetchBatch() override
+    {
+        return backend_->canFetchBatch();
+    }
+
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch(std::size_t n, void const* const* keys) override
+    {
+        return backend_->fetchBatch(n, keys);
+    }
+
+    void
+    store(std::shared_ptr<NodeObject> const& object) override
+    {
+        backend_->store(object);
+        std::lock_guard lock(mutex_);
+        keys_.write(reinterpret_cast<char const*>(
+            object->getHash().data()), uint256::size());
+    }
+
+    void
+    storeBatch(Batch const& batch) override
+    {
+        backend_->storeBatch(batch);
+        std::lock_guard lock(mutex_);
+        for (auto const& object : batch)
+            keys_.write(reinterpret_cast<char const*>(
+                object->getHash().data()), uint256::size());
+    }
+
+    void
+    for_each(std::function<void(std::shared_ptr<NodeObject>)> f) override
+    {
+        backend_->for_each(f);
+    }
+
+    int
+    getWriteLoad() override
+    {
+        return backend_->getWriteLoad();
+    }
+
+    void
+    sync() override
+    {
+        backend_->sync();
+    }
+
+    void
+    setDeletePath() override
+    {
+        deletePath_ = true;
+        backend_->setDeletePath();
+    }
+
+    void
+    verify() override
+    {
+        backend_->verify();
+    }
+
+    int
+    fdRequired() const override
+    {
+        return backend_->fdRequired() + 1;
+    }
+
+    FilterCounts
+    getFilterCounts() const override
+    {
+        return backend_->getFilterCounts();
+    }
+
+private:
+    std::unique_ptr<Backend> backend_;
+    boost::filesystem::path const keysPath_;
+    std::uint32_t const number_;
+    std::mutex mutex_;
+    std::ofstream keys_;
+    std::atomic<bool> deletePath_ {false};
+    std::atomic<int> writers_ {0};
+    std::mutex writeMutex_;
+    std::condition_variable writeCond_;
+    bool cancelled_ {false};
+};
+
+template <class F>
+void
+DatabaseTieredImp::writeCurrent(F&& f)
+{
+    std::shared_ptr<Generation> current;
+    {
+        std::lock_guard lock(mutex_);
+        current = tiers_.current;
+        current->beginWrite();
+    }
+    try
+    {
+        f(*current);
+    }
+    catch (...)
+    {
+        current->endWrite();
+        throw;
+    }
+    current->endWrite();
+}
+
+//------------------------------------------------------------------------------
+
+DatabaseTieredImp::DatabaseTieredImp(
+    std::string const& name,
+    Scheduler& scheduler,
+    int readThreads,
+    Stoppable& parent,
+    std::unique_ptr<Backend> coldBackend,
+    Section const& config,
+    beast::Journal j)
+    : Database(name, parent, scheduler, readThreads, config, j)
+    , pCache_(std::make_shared<ShardedTaggedCache<uint256, NodeObject>>(
+        name, cacheTargetSize, cacheTargetAge, stopwatch(), j))
+    , nCache_(std::make_shared<KeyCache<uint256>>(
+        name, stopwatch(), cacheTargetSize, cacheTargetAge))
+    , coldReads_(name, stopwatch(), cacheTargetSize, coldReadAge)
+    , hotConfig_(config)
+    , hotPath_(get<std::string>(config, "path"))
+    , coldAfter_(get<std::uint32_t>(config, "cold_after", 8192))
+    , coldBackend_(std::move(coldBackend))
+{
+    assert(coldBackend_);
+    if (hotPath_.empty())
+        Throw<std::runtime_error>(
+            "nodestore: Missing path in tiered database");
+    if (coldAfter_ < 256)
+        Throw<std::runtime_error>(
+            "nodestore: cold_after must be at least 256");
+
+    // Pick up the generations left by a previous run, the
+    // newest is current and the rest are still to be demoted.
+    boost::filesystem::create_directories(hotPath_);
+    std::vector<std::uint32_t> numbers;
+    for (auto const& entry :
+        boost::filesystem::directory_iterator(hotPath_))
+    {
+        std::uint32_t number;
+        if (boost::filesystem::is_directory(entry) &&
+            beast::lexicalCastChecked(
+                number, entry.path().filename().string()) &&
+            number > 0)
+        {
+            numbers.push_back(number);
+        }
+    }
+    std::sort(numbers.begin(), numbers.end(), std::greater<>());
+    if (numbers.empty())
+        numbers.push_back(1);
+
+    tiers_.current = makeGeneration(numbers.front());
+    for (auto it = std::next(numbers.begin()); it != numbers.end(); ++it)
+        tiers_.previous.push_back(makeGeneration(*it));
+
+    // Room for the current generation, the next one
+    // while rotating, and the cold backend
+    fdRequired_ += 2 * tiers_.current->fdRequired() +
+        coldBackend_->fdRequired();
+    setParent(parent);
+
+    thread_ = std::thread(&DatabaseTieredImp::run, this);
+}
+
+DatabaseTieredImp::~DatabaseTieredImp()
+{
+    stopDemotion();
+
+    // Stop threads before data members are destroyed.
+    stopThreads();
+}
+
+std::int32_t
+DatabaseTieredImp::getWriteLoad() const
+{
+    return getTiers().current->getWriteLoad() +
+        coldBackend_->getWriteLoad();
+}
+
+void
+DatabaseTieredImp::import(Database& source)
+{
+    writeCurrent([&](Backend& current)
+    {
+        importInternal(current, source);
+    });
+}
+
+void
+DatabaseTieredImp::store(NodeObjectType type, Blob&& data,
+    uint256 const& hash, std::uint32_t seq)
+{
+#if RIPPLE_VERIFY_NODEOBJECT_KEYS
+    assert(hash == sha512Hash(makeSlice(data)));
+#endif
+    auto nObj = NodeObject::createObject(type, std::move(data), hash);
+    pCache_->canonicalize(hash, nObj, true);
+    writeCurrent([&](Backend& current)
+    {
+        current.store(nObj);
+    });
+    nCache_->erase(hash);
+    storeStats(*nObj, seq);
+    checkAge(seq);
+}
+
+bool
+DatabaseTieredImp::asyncFetch(uint256 const& hash,
+    std::uint32_t seq, std::shared_ptr<NodeObject>& object)
+{
+    if (fetchCached(hash, seq, object))
+        return true;
+    // Otherwise post a read
+    Database::asyncFetch(hash, seq, pCache_, nCache_);
+    return false;
+}
+
+bool
+DatabaseTieredImp::fetchCached(uint256 const& hash,
+    std::uint32_t, std::shared_ptr<NodeObject>& object)
+{
+    object = pCache_->fetch(hash);
+    return object || nCache_->touch_if_exists(hash);
+}
+
+bool
+DatabaseTieredImp::copyLedger(std::shared_ptr<Ledger const> const& ledger)
+{
+    bool copied {false};
+    writeCurrent([&](Backend& current)
+    {
+        copied = Database::copyLedger(
+            current, *ledger, pCache_, nCache_, nullptr);
+    });
+    if (!copied)
+        return false;
+    checkAge(ledger->info().seq);
+    return true;
+}
+
+FilterCounts
+DatabaseTieredImp::getFilterCounts()
+{
+    auto const tiers = getTiers();
+    auto counts = tiers.current->getFilterCounts();
+    for (auto const& g : tiers.previous)
+        counts += g->getFilterCounts();
+    counts += coldBackend_->getFilterCounts();
+    return counts;
+}
+
+void
+DatabaseTieredImp::tune(int size, std::chrono::seconds age)
+{
+    pCache_->setTargetSize(size);
+    pCache_->setTargetAge(age);
+    nCache_->setTargetSize(size);
+    nCache_->setTargetAge(age);
+}
+
+void
+DatabaseTieredImp::sweep()
+{
+    pCache_->sweep();
+    nCache_->sweep();
+    coldReads_.sweep();
+}
+
+void
+DatabaseTieredImp::onStop()
+{
+    stopDemotion();
+    Database::onStop();
+}
+
+std::shared_ptr<DatabaseTieredImp::Generation>
+DatabaseTieredImp::makeGeneration(std::uint32_t number)
+{
+    auto const n = std::to_string(number);
+    Section section(hotConfig_);
+    section.set("path", (hotPath_ / n).string());
+    auto generation = std::make_shared<Generation>(
+        Manager::instance().make_Backend(section, scheduler_, j_),
+        hotPath_ / (n + ".keys"),
+        number);
+    generation->open(true);
+    return generation;
+}
+
+void
+DatabaseTieredImp::checkAge(std::uint32_t seq)
+{
+    std::lock_guard lock(mutex_);
+    if (currentSeq_ == 0)
+    {
+        currentSeq_ = seq;
+    }
+    else if (!rotate_ && seq > currentSeq_ &&
+        seq - currentSeq_ >= coldAfter_)
+    {
+        // Older ledgers, stored by backfill or a fetch pack, are
+        // ignored. The ledger that ends this generation starts the
+        // next, so they cannot age it either.
+        currentSeq_ = seq;
+        rotate_ = true;
+        cond_.notify_all();
+    }
+}
+
+void
+DatabaseTieredImp::run()
+{
+    beast::setCurrentThreadName("tiered demote");
+
+    std::unique_lock lock(mutex_);
+    while (!stop_)
+    {
+        try
+        {
+            if (rotate_)
+            {
+                auto const number = tiers_.current->number() + 1;
+                lock.unlock();
+                auto next = makeGeneration(number);
+                lock.lock();
+
+                JLOG(j_.info()) <<
+                    "Starting hot generation " << next->getName();
+                tiers_.previous.insert(
+                    tiers_.previous.begin(), std::move(tiers_.current));
+                tiers_.current = std::move(next);
+                rotate_ = false;
+            }
+            else if (!tiers_.previous.empty())
+            {
+                auto oldest = tiers_.previous.back();
+                lock.unlock();
+                auto const demoted = demote(*oldest);
+                lock.lock();
+
+                if (demoted)
+                {
+                    // Readers still holding the generation finish
+                    // with it before its files are removed
+                    tiers_.previous.pop_back();
+                    oldest->setDeletePath();
+                    oldest.reset();
+                    cond_.notify_all();
+                }
+            }
+            else
+            {
+                cond_.wait(lock);
+            }
+        }
+        catch (std::exception const& e)
+        {
+            if (!lock.owns_lock())
+                lock.lock();
+            JLOG(j_.error()) <<
+                "Tiered database exception: " << e.what();
+            rotate_ = false;
+            cond_.wait_for(lock, std::chrono::minutes{1});
+        }
+    }
+}
+
+bool
+DatabaseTieredImp::demote(Generation& generation)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    // Let stores that picked the generation before it was replaced,
+    // and writes its backend still has queued, land. The keys they
+    // logged would otherwise be missed, or their objects not found.
+    if (!generation.waitForWriters())
+        return false;
+    generation.flushKeys();
+    std::ifstream keys(generation.keysPath().string(),
+        std::ios::in | std::ios::binary);
+
+    std::uint64_t count {0};
+    std::vector<uint256> hashes;
+    std::vector<void const*> ptrs;
+    while (keys && !stop_)
+    {
+        hashes.resize(batchWritePreallocationSize);
+        std::size_t n {0};
+        while (n < hashes.size() && keys.read(
+            reinterpret_cast<char*>(hashes[n].data()), uint256::size()))
+        {
+            ++n;
+        }
+        if (n == 0)
+            break;
+
+        ptrs.clear();
+        for (std::size_t i = 0; i < n; ++i)
+            ptrs.push_back(hashes[i].data());
+        auto const objects = generation.fetchBatch(n, ptrs.data());
+
+        // Every logged key was stored, so a missing object
+        // means the generation cannot be safely removed
+        for (std::size_t i = 0; i < objects.size(); ++i)
+        {
+            if (!objects[i])
+                Throw<std::runtime_error>("nodestore: " +
+                    to_string(hashes[i]) + " is missing from " +
+                    generation.getName());
+        }
+
+        // Written synchronously, so the objects can be
+        // read from the cold backend once this returns
+        coldBackend_->storeBatch(objects);
+        count += objects.size();
+    }
+    if (stop_)
+        return false;
+
+    demoteCount_ += count;
+    JLOG(j_.info()) <<
+        "Demoted " << count << " objects from " << generation.getName() <<
+        " in " << std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - start).count() << "s";
+    return true;
+}
+
+void
+DatabaseTieredImp::waitForDemotion()
+{
+    std::unique_lock lock(mutex_);
+    cond_.wait(lock, [this]
+    {
+        return stop_ || (!rotate_ && tiers_.previous.empty());
+    });
+}
+
+void
+DatabaseTieredImp::stopDemotion()
+{
+    {
+        std::lock_guard lock(mutex_);
+        if (stop_)
+            return;
+        stop_ = true;
+        for (auto const& g : tiers_.previous)
+            g->cancel();
+        cond_.notify_all();
+    }
+    thread_.join();
+}
+
+std::shared_ptr<NodeObject>
+DatabaseTieredImp::fetchFrom(uint256 const& hash, std::uint32_t seq)
+{
+    auto const tiers = getTiers();
+    auto nObj = fetchInternal(hash, *tiers.current);
+    if (nObj)
+        return nObj;
+
+    // Objects still read from an older generation stay hot
+    for (auto const& g : tiers.previous)
+    {
+        nObj = fetchInternal(hash, *g);
+        if (nObj)
+        {
+            promote(nObj);
+            ++promoteCount_;
+            return nObj;
+        }
+    }
+
+    nObj = fetchInternal(hash, *coldBackend_);
+    if (nObj && !coldReads_.insert(hash))
+    {
+        coldReads_.erase(hash);
+        promote(nObj);
+        ++promoteCount_;
+    }
+    return nObj;
+}
+
+std::vector<std::shared_ptr<NodeObject>>
+DatabaseTieredImp::fetchBatchFrom(std::vector<uint256> const& hashes,
+    std::uint32_t seq)
+{
+    auto const tiers = getTiers();
+    auto nObjs = fetchBatchInternal(hashes, *tiers.current);
+
+    // Look for the objects missing from each tier in the next
+    std::vector<uint256> misses;
+    std::vector<std::size_t> missIndexes;
+    auto const nextTier = [&](Backend& backend, bool cold)
+    {
+        misses.clear();
+        missIndexes.clear();
+        for (std::size_t i = 0; i < nObjs.size(); ++i)
+        {
+            if (!nObjs[i])
+            {
+                misses.push_back(hashes[i]);
+                missIndexes.push_back(i);
+            }
+        }
+        if (misses.empty())
+            return false;
+
+        auto found = fetchBatchInternal(misses, backend);
+        for (std::size_t i = 0; i < found.size(); ++i)
+        {
+            if (!found[i])
+                continue;
+            if (!cold || !coldReads_.insert(misses[i]))
+            {
+                if (cold)
+                    coldReads_.erase(misses[i]);
+                promote(found[i]);
+                ++promoteCount_;
+            }
+            nObjs[missIndexes[i]] = std::move(found[i]);
+        }
+        return true;
+    };
+
+    for (auto const& g : tiers.previous)
+    {
+        if (!nextTier(*g, false))
+            return nObjs;
+    }
+    nextTier(*coldBackend_, true);
+    return nObjs;
+}
+
+void
+DatabaseTieredImp::promote(std::shared_ptr<NodeObject> const& object)
+{
+    writeCurrent([&](Backend& current)
+    {
+        current.store(object);
+    });
+}
+
+void
+DatabaseTieredImp::for_each(
+    std::function <void(std::shared_ptr<NodeObject>)> f)
+{
+    auto const tiers = getTiers();
+    coldBackend_->for_each(f);
+    for (auto const& g : tiers.previous)
+        g->for_each(f);
+    tiers.current->for_each(f);
+}
+
+} // NodeStore
+} // ripple
@@ -0,0 +1,231 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_DATABASETIEREDIMP_H_INCLUDED
+#define RIPPLE_NODESTORE_DATABASETIEREDIMP_H_INCLUDED
+
+#include <ripple/nodestore/Database.h>
+#include <ripple/basics/chrono.h>
+#include <boost/filesystem/path.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+
+namespace ripple {
+namespace NodeStore {
+
+/** A database keeping recent objects on a fast backend.
+
+    New objects are written to the hot tier, a generation of the backend
+    configured in [node_db] kept in a numbered directory under its path.
+    Once a generation has been written to for `cold_after` ledgers a new
+    one is started, and a background thread copies the objects of the old
+    one to the cold backend configured in [node_db_cold] before removing
+    it. Each generation logs the keys written to it so that it can be
+    demoted without iterating the backend while it is still being read.
+
+    Objects read from an old generation, or read more than once from the
+    cold backend, are written to the current generation again.
+*/
+class DatabaseTieredImp : public Database
+{
+public:
+    DatabaseTieredImp() = delete;
+    DatabaseTieredImp(DatabaseTieredImp const&) = delete;
+    DatabaseTieredImp& operator=(DatabaseTieredImp const&) = delete;
+
+    DatabaseTieredImp(
+        std::string const& name,
+        Scheduler& scheduler,
+        int readThreads,
+        Stoppable& parent,
+        std::unique_ptr<Backend> coldBackend,
+        Section const& config,
+        beast::Journal j);
+
+    ~DatabaseTieredImp() override;
+
+    std::string
+    getName() const override
+    {
+        return hotPath_.string();
+    }
+
+    std::int32_t
+    getWriteLoad() const override;
+
+    void
+    import(Database& source) override;
+
+    void
+    store(NodeObjectType type, Blob&& data,
+        uint256 const& hash, std::uint32_t seq) override;
+
+    std::shared_ptr<NodeObject>
+    fetch(uint256 const& hash, std::uint32_t seq) override
+    {
+        return doFetch(hash, seq, *pCache_, *nCache_, false);
+    }
+
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch(std::vector<uint256> const& hashes,
+        std::uint32_t seq) override
+    {
+        return doFetchBatch(hashes, seq, *pCache_, *nCache_, false);
+    }
+
+    bool
+    asyncFetch(uint256 const& hash, std::uint32_t seq,
+        std::shared_ptr<NodeObject>& object) override;
+
+    bool
+    fetchCached(uint256 const& hash, std::uint32_t seq,
+        std::shared_ptr<NodeObject>& object) override;
+
+    bool
+    copyLedger(std::shared_ptr<Ledger const> const& ledger) override;
+
+    int
+    getDesiredAsyncReadCount(std::uint32_t seq) override
+    {
+        // We prefer a client not fill our cache
+        // We don't want to push data out of the cache
+        // before it's retrieved
+        return pCache_->getTargetSize() / asyncDivider;
+    }
+
+    float
+    getCacheHitRate() override {return pCache_->getHitRate();}
+
+    FilterCounts
+    getFilterCounts() override;
+
+    void
+    tune(int size, std::chrono::seconds age) override;
+
+    void
+    sweep() override;
+
+    void
+    onStop() override;
+
+    /** Number of objects copied to the cold backend. */
+    std::uint64_t
+    getDemoteCount() const {return demoteCount_;}
+
+    /** Number of objects copied back to the hot tier. */
+    std::uint64_t
+    getPromoteCount() const {return promoteCount_;}
+
+    /** Blocks until every earlier generation has been demoted. */
+    void
+    waitForDemotion();
+
+private:
+    class Generation;
+
+    struct Tiers
+    {
+        std::shared_ptr<Generation> current;
+
+        // Generations waiting to be demoted, newest first
+        std::vector<std::shared_ptr<Generation>> previous;
+    };
+
+    // Positive cache
+    std::shared_ptr<ShardedTaggedCache<uint256, NodeObject>> pCache_;
+
+    // Negative cache
+    std::shared_ptr<KeyCache<uint256>> nCache_;
+
+    // Objects read once from the cold backend
+    KeyCache<uint256> coldReads_;
+
+    Section const hotConfig_;
+    boost::filesystem::path const hotPath_;
+
+    // Ledgers written to a generation before it is demoted
+    std::uint32_t coldAfter_;
+
+    std::unique_ptr<Backend> coldBackend_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    Tiers tiers_;
+
+    // Ledger the current generation is aged from, the first
+    // stored after startup or the one that started it
+    std::uint32_t currentSeq_ {0};
+    bool rotate_ {false};
+    std::atomic<bool> stop_ {false};
+    std::thread thread_;
+
+    std::atomic<std::uint64_t> demoteCount_ {0};
+    std::atomic<std::uint64_t> promoteCount_ {0};
+
+    Tiers
+    getTiers() const
+    {
+        std::lock_guard lock(mutex_);
+        return tiers_;
+    }
+
+    std::shared_ptr<Generation>
+    makeGeneration(std::uint32_t number);
+
+    // Calls f with the current generation, which is not
+    // demoted until every such call on it has returned
+    template <class F>
+    void
+    writeCurrent(F&& f);
+
+    // Writes an object read from an older tier to the current one
+    void
+    promote(std::shared_ptr<NodeObject> const& object);
+
+    // Start a new generation once the current one
+    // has been written to for enough ledgers
+    void
+    checkAge(std::uint32_t seq);
+
+    // Rotates and demotes generations
+    void
+    run();
+
+    bool
+    demote(Generation& generation);
+
+    void
+    stopDemotion();
+
+    std::shared_ptr<NodeObject>
+    fetchFrom(uint256 const& hash, std::uint32_t seq) override;
+
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchFrom(std::vector<uint256> const& hashes,
+        std::uint32_t seq) override;
+
+    void
+    for_each(std::function <void(std::shared_ptr<NodeObject>)> f) override;
+};
+
+}
+}
+
+#endif
@@ -34,6 +34,8 @@ namespace NodeStore {
     to eliminate false negatives.
 
     @note This defines the database format of a NodeObject!
+
+    The value is the flattened object after the codec has been undone.
 */
 class DecodedBlob
 {
@@ -47,6 +49,14 @@ public:
     /** Create a NodeObject from this data. */
     std::shared_ptr<NodeObject> createObject ();
 
+    /** Create a NodeObject that takes over the buffer holding the value.
+
+        The header is dropped in place, so the data is not copied into
+        a new allocation. The buffer must hold exactly the value this
+        blob was constructed from, as when a backend decompresses into it.
+    */
+    std::shared_ptr<NodeObject> createObject (Blob&& value);
+
 private:
     bool m_success;
 
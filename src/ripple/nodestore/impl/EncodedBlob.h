@@ -29,6 +29,9 @@ namespace NodeStore {
 
 /** Utility for producing flattened node objects.
     @note This defines the database format of a NodeObject!
+
+    Backends that compress store the flattened object behind a codec type
+    prefix, which versions the format; see nodeobject_compress.
 */
 // VFALCO TODO Make allocator aware and use short_alloc
 struct EncodedBlob
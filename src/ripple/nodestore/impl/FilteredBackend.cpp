@@ -0,0 +1,267 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/nodestore/impl/FilteredBackend.h>
+#include <ripple/nodestore/impl/BloomFilter.h>
+#include <ripple/basics/contract.h>
+#include <ripple/basics/Log.h>
+#include <boost/filesystem.hpp>
+#include <atomic>
+
+namespace ripple {
+namespace NodeStore {
+
+class FilteredBackend : public Backend
+{
+public:
+    FilteredBackend(
+        std::unique_ptr<Backend> backend,
+        std::uint64_t keys,
+        std::uint32_t bitsPerKey,
+        boost::filesystem::path const& filterPath,
+        beast::Journal journal)
+        : backend_(std::move(backend))
+        , keys_(keys)
+        , bitsPerKey_(bitsPerKey)
+        , filterPath_(filterPath)
+        , j_(journal)
+    {
+        assert(backend_);
+    }
+
+    ~FilteredBackend() override
+    {
+        close();
+    }
+
+    std::string
+    getName() override
+    {
+        return backend_->getName();
+    }
+
+    void
+    open(bool createIfMissing) override
+    {
+        backend_->open(createIfMissing);
+
+        if (!filterPath_.empty())
+        {
+            filter_ = BloomFilter::load(filterPath_);
+
+            // The file no longer reflects the contents of the
+            // backend once we store to it
+            boost::system::error_code ec;
+            boost::filesystem::remove(filterPath_, ec);
+        }
+        if (!filter_)
+        {
+            filter_ = std::make_unique<BloomFilter>(keys_, bitsPerKey_);
+            std::uint64_t count {0};
+            backend_->for_each(
+                [&](std::shared_ptr<NodeObject> nObj)
+                {
+                    filter_->insert(nObj->getHash().begin());
+                    ++count;
+                });
+            JLOG(j_.debug()) <<
+                backend_->getName() << " built lookup filter of " <<
+                filter_->size() << " bits for " << count << " objects";
+            if (count > keys_)
+            {
+                JLOG(j_.warn()) <<
+                    backend_->getName() << " holds " << count <<
+                    " objects, more than filter_keys " << keys_;
+            }
+        }
+    }
+
+    void
+    close() override
+    {
+        if (filter_ && !filterPath_.empty() && !deletePath_)
+        {
+            if (!filter_->save(filterPath_))
+            {
+                JLOG(j_.warn()) <<
+                    "Unable to save lookup filter " << filterPath_.string();
+            }
+        }
+        filter_.reset();
+        backend_->close();
+    }
+
+    Status
+    fetch(void const* key, std::shared_ptr<NodeObject>* pObject) override
+    {
+        if (!filter_->mayContain(key))
+        {
+            ++rejected_;
+            pObject->reset();
+            return notFound;
+        }
+        auto const status = backend_->fetch(key, pObject);
+        if (status == notFound)
+            ++falsePositives_;
+        return status;
+    }
+
+    bool
+    canFetchBatch() override
+    {
+        return backend_->canFetchBatch();
+    }
+
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch(std::size_t n, void const* const* keys) override
+    {
+        std::vector<void const*> maybe;
+        std::vector<std::size_t> indexes;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (filter_->mayContain(keys[i]))
+            {
+                maybe.push_back(keys[i]);
+                indexes.push_back(i);
+            }
+        }
+        rejected_ += n - maybe.size();
+
+        std::vector<std::shared_ptr<NodeObject>> results(n);
+        if (maybe.empty())
+            return results;
+
+        auto fetched = backend_->fetchBatch(maybe.size(), maybe.data());
+        for (std::size_t i = 0; i < fetched.size(); ++i)
+        {
+            if (!fetched[i])
+                ++falsePositives_;
+            results[indexes[i]] = std::move(fetched[i]);
+        }
+        return results;
+    }
+
+    void
+    store(std::shared_ptr<NodeObject> const& object) override
+    {
+        // Update the filter first so a fetch that follows
+        // the store can not be rejected
+        filter_->insert(object->getHash().begin());
+        backend_->store(object);
+    }
+
+    void
+    storeBatch(Batch const& batch) override
+    {
+        for (auto const& e : batch)
+            filter_->insert(e->getHash().begin());
+        backend_->storeBatch(batch);
+    }
+
+    void
+    for_each(std::function<void(std::shared_ptr<NodeObject>)> f) override
+    {
+        backend_->for_each(f);
+    }
+
+    int
+    getWriteLoad() override
+    {
+        return backend_->getWriteLoad();
+    }
+
+    void
+    sync() override
+    {
+        backend_->sync();
+    }
+
+    void
+    setDeletePath() override
+    {
+        deletePath_ = true;
+        backend_->setDeletePath();
+    }
+
+    void
+    verify() override
+    {
+        backend_->verify();
+    }
+
+    int
+    fdRequired() const override
+    {
+        return backend_->fdRequired();
+    }
+
+    FilterCounts
+    getFilterCounts() const override
+    {
+        FilterCounts counts;
+        counts.enabled = true;
+        counts.rejected = rejected_;
+        counts.falsePositives = falsePositives_;
+        return counts;
+    }
+
+private:
+    std::unique_ptr<Backend> backend_;
+    std::uint64_t const keys_;
+    std::uint32_t const bitsPerKey_;
+    boost::filesystem::path const filterPath_;
+    beast::Journal const j_;
+    std::unique_ptr<BloomFilter> filter_;
+    bool deletePath_ {false};
+    std::atomic<std::uint64_t> rejected_ {0};
+    std::atomic<std::uint64_t> falsePositives_ {0};
+};
+
+//------------------------------------------------------------------------------
+
+std::unique_ptr<Backend>
+makeFilteredBackend(
+    std::unique_ptr<Backend> backend,
+    Section const& config,
+    beast::Journal journal)
+{
+    auto const keys {get<std::uint64_t>(config, "filter_keys", 0)};
+    if (keys == 0)
+        return backend;
+
+    auto const bitsPerKey {
+        get<std::uint32_t>(config, "filter_bits_per_key", 10)};
+    if (bitsPerKey == 0 || bitsPerKey > 64)
+        Throw<std::runtime_error>("Invalid filter_bits_per_key");
+
+    // Only backends using permanent storage persist their filter
+    boost::filesystem::path filterPath;
+    if (backend->backed())
+    {
+        auto const path {get<std::string>(config, "path")};
+        if (!path.empty())
+            filterPath = boost::filesystem::path(path) / "filter";
+    }
+
+    return std::make_unique<FilteredBackend>(
+        std::move(backend), keys, bitsPerKey, filterPath, journal);
+}
+
+} // NodeStore
+} // ripple
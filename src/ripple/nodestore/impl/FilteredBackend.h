@@ -0,0 +1,58 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_FILTEREDBACKEND_H_INCLUDED
+#define RIPPLE_NODESTORE_FILTEREDBACKEND_H_INCLUDED
+
+#include <ripple/nodestore/Backend.h>
+#include <ripple/basics/BasicConfig.h>
+#include <ripple/beast/utility/Journal.h>
+#include <memory>
+
+namespace ripple {
+namespace NodeStore {
+
+/** Put a negative lookup filter in front of a backend.
+
+    The filter is enabled with the `filter_keys` option, the number of
+    keys the backend is expected to hold. The optional `filter_bits_per_key`
+    option trades memory for a lower false positive rate and defaults
+    to 10, or about one percent.
+
+    When the backend opens, the filter is read from the `filter` file in
+    the backend's directory or else rebuilt from the backend's contents.
+    The file is removed once read and written again on a clean close, so
+    a crash can never leave behind a filter missing recent stores.
+
+    @param backend The backend to wrap.
+    @param config The backend configuration.
+    @param journal Destination for logging output.
+    @return The wrapped backend, or the backend itself if the
+            configuration doesn't enable a filter.
+*/
+std::unique_ptr<Backend>
+makeFilteredBackend(
+    std::unique_ptr<Backend> backend,
+    Section const& config,
+    beast::Journal journal);
+
+} // NodeStore
+} // ripple
+
+#endif
@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_IOBUDGET_H_INCLUDED
+#define RIPPLE_NODESTORE_IOBUDGET_H_INCLUDED
+
+#include <ripple/basics/chrono.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace ripple {
+namespace NodeStore {
+
+/** Limits the rate at which a long running task reads and writes.
+
+    Each shard being imported or validated is given its own budget, so
+    that shards processed at the same time share the disk evenly and
+    leave bandwidth for the rest of the server.
+
+    Thread safe.
+*/
+class IOBudget
+{
+public:
+    using clock_type = Stopwatch;
+    using wait_type = std::function<void(clock_type::duration)>;
+
+    /** Create a budget.
+
+        @param bytesPerSecond The most bytes per second, zero for no limit.
+        @param clock The clock measuring the rate.
+        @param wait Called to wait while over budget, sleeps by default.
+    */
+    explicit
+    IOBudget(std::uint64_t bytesPerSecond,
+        clock_type& clock = stopwatch(), wait_type wait = {})
+        : rate_(bytesPerSecond)
+        , clock_(clock)
+        , wait_(wait ? std::move(wait) : [](clock_type::duration d)
+            {
+                std::this_thread::sleep_for(d);
+            })
+        , start_(clock_.now())
+    {
+    }
+
+    IOBudget(IOBudget const&) = delete;
+    IOBudget& operator=(IOBudget const&) = delete;
+
+    /** Account for bytes read or written, waiting while over budget. */
+    void
+    charge(std::uint64_t bytes)
+    {
+        auto const total = bytes_ += bytes;
+        if (rate_ == 0)
+            return;
+
+        using namespace std::chrono;
+        auto const due = start_ + duration_cast<clock_type::duration>(
+            duration<double>(static_cast<double>(total) / rate_));
+        auto const now = clock_.now();
+        if (due > now)
+            wait_(due - now);
+    }
+
+    /** The number of bytes charged. */
+    std::uint64_t
+    bytes() const
+    {
+        return bytes_;
+    }
+
+    /** The time since the budget was created. */
+    clock_type::duration
+    elapsed() const
+    {
+        return clock_.now() - start_;
+    }
+
+    /** The average number of bytes charged per second. */
+    std::uint64_t
+    bytesPerSecond() const
+    {
+        auto const secs = std::chrono::duration<double>(elapsed()).count();
+        return secs > 0 ? static_cast<std::uint64_t>(bytes_ / secs) : 0;
+    }
+
+private:
+    std::uint64_t const rate_;
+    clock_type& clock_;
+    wait_type const wait_;
+    clock_type::time_point const start_;
+    std::atomic<std::uint64_t> bytes_ {0};
+};
+
+} // NodeStore
+} // ripple
+
+#endif
@@ -19,6 +19,7 @@
 
 #include <ripple/nodestore/impl/ManagerImp.h>
 #include <ripple/nodestore/impl/DatabaseNodeImp.h>
+#include <ripple/nodestore/impl/FilteredBackend.h>
 
 #include <boost/algorithm/string/predicate.hpp>
 
@@ -55,8 +56,11 @@ ManagerImp::make_Backend (
     if(!factory)
         missing_backend();
 
-    return factory->createInstance(
-        NodeObject::keyBytes, parameters, scheduler, journal);
+    return makeFilteredBackend(
+        factory->createInstance(
+            NodeObject::keyBytes, parameters, scheduler, journal),
+        parameters,
+        journal);
 }
 
 std::unique_ptr <Database>
@@ -23,7 +23,9 @@
 #include <ripple/basics/StringUtilities.h>
 #include <ripple/core/ConfigSections.h>
 #include <ripple/nodestore/impl/DatabaseShardImp.h>
+#include <ripple/nodestore/impl/FilteredBackend.h>
 #include <ripple/nodestore/Manager.h>
+#include <ripple/protocol/digest.h>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/archive/text_iarchive.hpp>
@@ -74,8 +76,11 @@ Shard::open(Scheduler& scheduler, nudb::context& ctx)
     }
 
     section.set("path", dir_.string());
-    backend_ = factory->createInstance(
-        NodeObject::keyBytes, section, scheduler, ctx, j_);
+    backend_ = makeFilteredBackend(
+        factory->createInstance(
+            NodeObject::keyBytes, section, scheduler, ctx, j_),
+        section,
+        j_);
 
     auto const preexist {exists(dir_)};
     auto fail = [this, preexist](std::string const& msg)
@@ -291,7 +296,7 @@ Shard::lastStored() const
 }
 
 bool
-Shard::validate() const
+Shard::validate(IOBudget* budget) const
 {
     uint256 hash;
     std::uint32_t seq {0};
@@ -339,7 +344,7 @@ Shard::validate() const
     std::shared_ptr<Ledger const> next;
     while (seq >= firstSeq_)
     {
-        auto nObj = valFetch(hash);
+        auto nObj = valFetch(hash, budget);
         if (!nObj)
             return fail("Invalid ledger");
 
@@ -368,7 +373,7 @@ Shard::validate() const
             return fail("Missing root TXN node");
         }
 
-        if (!valLedger(ledger, next))
+        if (!valLedger(ledger, next, budget))
             return false;
 
         hash = ledger->info().parentHash;
@@ -726,7 +731,8 @@ Shard::saveControl(std::lock_guard<std::mutex> const&)
 bool
 Shard::valLedger(
     std::shared_ptr<Ledger const> const& ledger,
-    std::shared_ptr<Ledger const> const& next) const
+    std::shared_ptr<Ledger const> const& next,
+    IOBudget* budget) const
 {
     auto fail = [j = j_, index = index_, &ledger](std::string const& msg)
     {
@@ -747,9 +753,17 @@ Shard::valLedger(
         return fail("Invalid ledger header account hash");
 
     bool error {false};
-    auto visit = [this, &error](SHAMapAbstractNode& node)
+    std::vector<std::shared_ptr<NodeObject>> fetched;
+    fetched.reserve(valBatchSize);
+    auto visit = [this, &error, &fetched, budget](SHAMapAbstractNode& node)
     {
-        if (!valFetch(node.getNodeHash().as_uint256()))
+        if (auto nObj = valFetch(node.getNodeHash().as_uint256(), budget))
+        {
+            fetched.push_back(std::move(nObj));
+            if (fetched.size() >= valBatchSize && !valHashes(fetched))
+                error = true;
+        }
+        else
             error = true;
         return !error;
     };
@@ -772,7 +786,7 @@ Shard::valLedger(
             return fail(std::string("exception ") +
                 e.what() + " in function " + __func__);
         }
-        if (error)
+        if (error || !valHashes(fetched))
             return fail("Invalid state map");
     }
 
@@ -791,14 +805,14 @@ Shard::valLedger(
             return fail(std::string("exception ") +
                 e.what() + " in function " + __func__);
         }
-        if (error)
+        if (error || !valHashes(fetched))
             return fail("Invalid transaction map");
     }
     return true;
 };
 
 std::shared_ptr<NodeObject>
-Shard::valFetch(uint256 const& hash) const
+Shard::valFetch(uint256 const& hash, IOBudget* budget) const
 {
     std::shared_ptr<NodeObject> nObj;
     auto fail = [j = j_, index = index_, &hash, &nObj](std::string const& msg)
@@ -821,6 +835,8 @@ Shard::valFetch(uint256 const& hash) const
         switch (status)
         {
         case ok:
+            if (budget)
+                budget->charge(nObj->getData().size());
             break;
         case notFound:
             return fail("Missing node object");
@@ -838,5 +854,32 @@ Shard::valFetch(uint256 const& hash) const
     return nObj;
 }
 
+bool
+Shard::valHashes(std::vector<std::shared_ptr<NodeObject>>& nObjs) const
+{
+    std::vector<Slice> data;
+    data.reserve(nObjs.size());
+    for (auto const& nObj : nObjs)
+        data.push_back(makeSlice(nObj->getData()));
+
+    std::vector<uint256> digests(nObjs.size());
+    sha512HalfMany(data.data(), digests.data(), data.size());
+
+    bool result {true};
+    for (std::size_t i = 0; i < nObjs.size(); ++i)
+    {
+        if (digests[i] != nObjs[i]->getHash())
+        {
+            JLOG(j_.error()) <<
+                "shard " << index_ << ". Node object hash mismatch" <<
+                ". Node object hash " << to_string(nObjs[i]->getHash());
+            result = false;
+            break;
+        }
+    }
+    nObjs.clear();
+    return result;
+}
+
 } // NodeStore
 } // ripple
@@ -26,6 +26,7 @@
 #include <ripple/core/DatabaseCon.h>
 #include <ripple/nodestore/NodeObject.h>
 #include <ripple/nodestore/Scheduler.h>
+#include <ripple/nodestore/impl/IOBudget.h>
 
 #include <boost/filesystem.hpp>
 #include <nudb/nudb.hpp>
@@ -51,7 +52,7 @@ removeAll(boost::filesystem::path const& path, beast::Journal& j)
     return true;
 }
 
-using PCache = TaggedCache<uint256, NodeObject>;
+using PCache = ShardedTaggedCache<uint256, NodeObject>;
 using NCache = KeyCache<uint256>;
 class DatabaseShard;
 
@@ -114,8 +115,12 @@ public:
     std::shared_ptr<Ledger const>
     lastStored() const;
 
+    /** Verify every ledger stored in this shard.
+
+        @param budget If not null, limits the rate the shard is read.
+    */
     bool
-    validate() const;
+    validate(IOBudget* budget = nullptr) const;
 
 private:
     static constexpr auto controlFileName = "control.txt";
@@ -212,12 +217,21 @@ private:
     bool
     valLedger(
         std::shared_ptr<Ledger const> const& ledger,
-        std::shared_ptr<Ledger const> const& next) const;
+        std::shared_ptr<Ledger const> const& next,
+        IOBudget* budget) const;
 
     // Fetches from the backend and will log
     // errors based on status codes
     std::shared_ptr<NodeObject>
-    valFetch(uint256 const& hash) const;
+    valFetch(uint256 const& hash, IOBudget* budget) const;
+
+    // Verifies that each node object hashes to its key,
+    // hashing the objects together, then clears them
+    bool
+    valHashes(std::vector<std::shared_ptr<NodeObject>>& nObjs) const;
+
+    // Node objects whose hashes are verified together
+    static constexpr std::size_t valBatchSize = 256;
 };
 
 }  // namespace NodeStore
@@ -0,0 +1,121 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/nodestore/Trace.h>
+#include <ripple/basics/contract.h>
+#include <array>
+#include <cstring>
+
+namespace ripple {
+namespace NodeStore {
+
+namespace {
+
+// File header
+constexpr std::array<char, 4> traceMagic {{'R', 'T', 'R', 'C'}};
+constexpr std::uint32_t traceVersion = 1;
+
+// Record layout
+constexpr std::size_t recordSize =
+    32 +                        // hash
+    sizeof(std::uint32_t) +     // seq
+    sizeof(std::uint8_t) +      // op
+    sizeof(std::uint64_t) +     // time
+    sizeof(std::uint32_t);      // size
+
+} // namespace
+
+TraceWriter::TraceWriter(boost::filesystem::path const& path)
+    : start_(clock_type::now())
+    , out_(path.string(),
+        std::ios::out | std::ios::binary | std::ios::trunc)
+{
+    out_.write(traceMagic.data(), traceMagic.size());
+    out_.write(reinterpret_cast<char const*>(&traceVersion),
+        sizeof(traceVersion));
+    if (!out_)
+        Throw<std::runtime_error>(
+            "nodestore: Unable to write trace " + path.string());
+}
+
+void
+TraceWriter::record(TraceRecord::Op op, uint256 const& hash,
+    std::uint32_t seq, std::uint32_t size, clock_type::time_point start)
+{
+    std::uint64_t const time = std::chrono::duration_cast<
+        std::chrono::microseconds>(start - start_).count();
+    auto const o = static_cast<std::uint8_t>(op);
+
+    std::array<char, recordSize> buf;
+    auto p = buf.data();
+    auto const put = [&p](void const* data, std::size_t n)
+    {
+        std::memcpy(p, data, n);
+        p += n;
+    };
+    put(hash.data(), hash.size());
+    put(&seq, sizeof(seq));
+    put(&o, sizeof(o));
+    put(&time, sizeof(time));
+    put(&size, sizeof(size));
+
+    std::lock_guard lock(mutex_);
+    out_.write(buf.data(), buf.size());
+}
+
+std::vector<TraceRecord>
+readTrace(boost::filesystem::path const& path)
+{
+    std::ifstream in(path.string(), std::ios::in | std::ios::binary);
+    std::array<char, 4> magic;
+    std::uint32_t version;
+    in.read(magic.data(), magic.size());
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!in || magic != traceMagic || version != traceVersion)
+        Throw<std::runtime_error>(
+            "nodestore: " + path.string() + " is not a trace");
+
+    std::vector<TraceRecord> records;
+    std::array<char, recordSize> buf;
+    while (in.read(buf.data(), buf.size()))
+    {
+        TraceRecord r;
+        auto p = buf.data();
+        auto const get = [&p](void* data, std::size_t n)
+        {
+            std::memcpy(data, p, n);
+            p += n;
+        };
+        std::uint8_t op;
+        get(r.hash.data(), r.hash.size());
+        get(&r.seq, sizeof(r.seq));
+        get(&op, sizeof(op));
+        get(&r.time, sizeof(r.time));
+        get(&r.size, sizeof(r.size));
+        if (op > static_cast<std::uint8_t>(TraceRecord::Op::store))
+            Throw<std::runtime_error>(
+                "nodestore: bad record in trace " + path.string());
+        r.op = static_cast<TraceRecord::Op>(op);
+        records.push_back(r);
+    }
+    return records;
+}
+
+} // NodeStore
+} // ripple
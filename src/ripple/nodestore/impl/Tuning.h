@@ -25,16 +25,23 @@ namespace NodeStore {
 
 enum
 {
-    // Target cache size of the TaggedCache used to hold nodes
+    // Target cache size of the ShardedTaggedCache used to hold nodes
     cacheTargetSize     = 16384
 
     // Fraction of the cache one query source can take
     ,asyncDivider = 8
+
+    // Maximum number of queued async reads issued as one batch
+    ,asyncBatchSize = 256
 };
 
 // Expiration time for cached nodes
 std::chrono::seconds constexpr cacheTargetAge = std::chrono::minutes{5};
 
+// How long a read from a cold backend is remembered, a
+// second read within this time promotes the object
+std::chrono::seconds constexpr coldReadAge = std::chrono::minutes{30};
+
 }
 }
 
@@ -25,6 +25,7 @@
 
 #include <ripple/basics/contract.h>
 #include <nudb/detail/field.hpp>
+#include <ripple/nodestore/impl/CompressionDictionary.h>
 #include <ripple/nodestore/impl/varint.h>
 #include <ripple/nodestore/NodeObject.h>
 #include <ripple/protocol/HashPrefix.h>
@@ -92,6 +93,68 @@ lz4_compress (void const* in,
     return result;
 }
 
+template <class BufferFactory>
+std::pair<void const*, std::size_t>
+lz4_dict_decompress (void const* in,
+    std::size_t in_size, CompressionDictionary const& dict,
+        BufferFactory&& bf)
+{
+    using namespace nudb::detail;
+    std::pair<void const*, std::size_t> result;
+    std::uint8_t const* p = reinterpret_cast<
+        std::uint8_t const*>(in);
+    auto const n = read_varint(
+        p, in_size, result.second);
+    if (n == 0)
+        Throw<std::runtime_error> (
+            "lz4 dict decompress: n == 0");
+    void* const out = bf(result.second);
+    result.first = out;
+    auto const& d = dict.data();
+    if (LZ4_decompress_safe_usingDict(
+        reinterpret_cast<char const*>(in) + n,
+            reinterpret_cast<char*>(out),
+                in_size - n, result.second,
+                    reinterpret_cast<char const*>(d.data()),
+                        d.size()) != result.second)
+        Throw<std::runtime_error> (
+            "lz4 dict decompress: LZ4_decompress_safe_usingDict");
+    return result;
+}
+
+template <class BufferFactory>
+std::pair<void const*, std::size_t>
+lz4_dict_compress (void const* in,
+    std::size_t in_size, CompressionDictionary const& dict,
+        BufferFactory&& bf)
+{
+    using namespace nudb::detail;
+    std::pair<void const*, std::size_t> result;
+    std::array<std::uint8_t, varint_traits<
+        std::size_t>::max> vi;
+    auto const n = write_varint(
+        vi.data(), in_size);
+    auto const out_max =
+        LZ4_compressBound(in_size);
+    std::uint8_t* out = reinterpret_cast<
+        std::uint8_t*>(bf(n + out_max));
+    result.first = out;
+    std::memcpy(out, vi.data(), n);
+    // Start from a copy of the stream with the dictionary
+    // already loaded instead of loading it every time.
+    LZ4_stream_t stream;
+    std::memcpy(&stream, &dict.stream(), sizeof(stream));
+    auto const out_size = LZ4_compress_fast_continue(&stream,
+        reinterpret_cast<char const*>(in),
+            reinterpret_cast<char*>(out + n),
+                in_size, out_max, 1);
+    if (out_size == 0)
+        Throw<std::runtime_error> (
+            "lz4 dict compress");
+    result.second = n + out_size;
+    return result;
+}
+
 //------------------------------------------------------------------------------
 
 /*
@@ -101,12 +164,17 @@ lz4_compress (void const* in,
     1 = lz4 compressed
     2 = inner node compressed
     3 = full inner node
+    4 = lz4 compressed with a dictionary
+
+    The type prefix is the format version of a stored object: a new
+    encoding gets a new type, and every type remains readable.
 */
 
 template <class BufferFactory>
 std::pair<void const*, std::size_t>
 nodeobject_decompress (void const* in,
-    std::size_t in_size, BufferFactory&& bf)
+    std::size_t in_size, BufferFactory&& bf,
+        CompressionDictionary const* dict = nullptr)
 {
     using namespace nudb::detail;
 
@@ -204,6 +272,15 @@ nodeobject_decompress (void const* in,
         write(os, is(512), 512);
         break;
     }
+    case 4: // lz4 with dictionary
+    {
+        if (! dict)
+            Throw<std::runtime_error> (
+                "nodeobject codec: no compression dictionary");
+        result = lz4_dict_decompress(
+            p, in_size, *dict, bf);
+        break;
+    }
     default:
         Throw<std::runtime_error> (
             "nodeobject codec: bad type=" +
@@ -223,7 +300,8 @@ zero32()
 template <class BufferFactory>
 std::pair<void const*, std::size_t>
 nodeobject_compress (void const* in,
-    std::size_t in_size, BufferFactory&& bf)
+    std::size_t in_size, BufferFactory&& bf,
+        CompressionDictionary const* dict = nullptr)
 {
     using std::runtime_error;
     using namespace nudb::detail;
@@ -297,7 +375,7 @@ nodeobject_compress (void const* in,
     std::array<std::uint8_t, varint_traits<
         std::size_t>::max> vi;
 
-    constexpr std::size_t codecType = 1;
+    std::size_t const codecType = dict ? 4 : 1;
     auto const vn = write_varint(
         vi.data(), codecType);
     std::pair<void const*, std::size_t> result;
@@ -321,6 +399,23 @@ nodeobject_compress (void const* in,
         result.second = vn + lzr.second;
         break;
     }
+    case 4: // lz4 with dictionary
+    {
+        std::uint8_t* p;
+        auto const lzr = NodeStore::lz4_dict_compress(
+                in, in_size, *dict, [&p, &vn, &bf]
+            (std::size_t n)
+            {
+                p = reinterpret_cast<
+                    std::uint8_t*>(
+                        bf(vn + n));
+                return p + vn;
+            });
+        std::memcpy(p, vi.data(), vn);
+        result.first = p;
+        result.second = vn + lzr.second;
+        break;
+    }
     default:
         Throw<std::logic_error> (
             "nodeobject codec: unknown=" +
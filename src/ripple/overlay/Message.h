@@ -27,6 +27,7 @@
 #include <cstdint>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 
 namespace ripple {
@@ -43,6 +44,10 @@ namespace ripple {
 // a string prepended by a header specifying the message length.
 // MessageType should be a Message class generated by the protobuf compiler.
 //
+// A Message never changes once built. A broadcast builds one and every peer
+// writes its buffer straight to the socket, so the wire form is serialized,
+// and compressed, once however many peers it goes to.
+//
 
 class Message : public std::enable_shared_from_this <Message>
 {
@@ -65,6 +70,17 @@ public:
      */
     static std::size_t constexpr kMaxMessageSize = 64 * 1024 * 1024;
 
+    /** Set in the first header byte when the payload is compressed.
+
+        The size in the header is then that of the compressed payload,
+        which starts with the uncompressed size in four bytes followed
+        by an LZ4 block. Message sizes never reach this bit.
+    */
+    static std::uint8_t constexpr kCompressedFlag = 0x80;
+
+    /** Payloads smaller than this are never compressed. */
+    static std::size_t constexpr kMinCompressBytes = 128;
+
     Message (::google::protobuf::Message const& message, int type);
 
     /** Retrieve the packed message data. */
@@ -74,6 +90,16 @@ public:
         return mBuffer;
     }
 
+    /** Retrieve the packed message data, compressed if requested.
+
+        The message is compressed the first time a compressed buffer is
+        requested and the result is kept for every later request. If the
+        message type is not worth compressing, or the payload does not
+        shrink, the uncompressed data is returned.
+    */
+    std::vector <uint8_t> const&
+    getBuffer (bool compressed) const;
+
     /** Get the traffic category */
     std::size_t
     getCategory () const
@@ -98,7 +124,7 @@ public:
                 Message::kHeaderBytes)
             return 0;
         std::size_t n;
-        n  = std::size_t{*first++} << 24;
+        n  = (std::size_t{*first++} & ~std::size_t{kCompressedFlag}) << 24;
         n += std::size_t{*first++} << 16;
         n += std::size_t{*first++} <<  8;
         n += std::size_t{*first};
@@ -115,6 +141,34 @@ public:
     }
     /** @} */
 
+    /** Determine whether a packed message is compressed. */
+    /** @{ */
+    template <class FwdIter>
+    static
+    std::enable_if_t<std::is_same<typename
+        FwdIter::value_type, std::uint8_t>::value, bool>
+    compressed (FwdIter first, FwdIter last)
+    {
+        if (std::distance(first, last) <
+                Message::kHeaderBytes)
+            return false;
+        return (*first & kCompressedFlag) != 0;
+    }
+
+    template <class BufferSequence>
+    static
+    bool
+    compressed (BufferSequence const& buffers)
+    {
+        return compressed(buffers_begin(buffers),
+            buffers_end(buffers));
+    }
+    /** @} */
+
+    /** Encode a header for a payload of the given size and type. */
+    static void encodeHeader (std::uint8_t* header,
+        std::size_t size, int type, bool compressed = false);
+
     /** Determine the type of a packed message. */
     /** @{ */
     static int getType (std::vector <uint8_t> const& buf);
@@ -161,12 +215,15 @@ private:
             BufferSequence, Value>::end (buffers);
     }
 
-        // Encodes the size and type into a header at the beginning of buf
-    //
-    void encodeHeader (unsigned size, int type);
+    // Compresses mBuffer into mBufferCompressed if that pays
+    void compress () const;
 
     std::vector <uint8_t> mBuffer;
 
+    // Filled at most once, by the first peer that accepts compression
+    mutable std::vector <uint8_t> mBufferCompressed;
+    mutable std::once_flag mCompressOnce;
+
     std::size_t mCategory;
 };
 
@@ -33,6 +33,8 @@
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <functional>
+#include <set>
+#include <vector>
 
 namespace boost { namespace asio { namespace ssl { class context; } } }
 
@@ -71,6 +73,8 @@ public:
         beast::IP::Address public_ip;
         int ipLimit = 0;
         std::uint32_t crawlOptions = 0;
+        bool compression = false;
+        bool squelch = false;
     };
 
     using PeerSequence = std::vector <std::shared_ptr<Peer>>;
@@ -152,17 +156,35 @@ public:
     void
     send (protocol::TMValidation& m) = 0;
 
-    /** Relay a proposal. */
+    /** Relay a proposal.
+
+        Peers that squelched the validator are skipped.
+    */
     virtual
     void
     relay (protocol::TMProposeSet& m,
-        uint256 const& uid) = 0;
+        uint256 const& uid, PublicKey const& validator) = 0;
+
+    /** Relay a validation.
 
-    /** Relay a validation. */
+        Peers that squelched the validator are skipped.
+    */
     virtual
     void
     relay (protocol::TMValidation& m,
-        uint256 const& uid) = 0;
+        uint256 const& uid, PublicKey const& validator) = 0;
+
+    /** Relay transactions.
+
+        Peers that accept batches get the transactions they lack in
+        as few messages as possible, the rest get one message each.
+
+        @param txs Each transaction with the peers that already have it.
+    */
+    virtual
+    void
+    relay (std::vector<std::pair<protocol::TMTransaction,
+        std::set<Peer::id_t>>> const& txs) = 0;
 
     /** Visit every active peer and return a value
         The functor must:
@@ -209,7 +209,7 @@ ConnectAttempt::onHandshake (error_code ec)
         return close(); // makeSharedValue logs
 
     req_ = makeRequest(! overlay_.peerFinder().config().peerPrivate,
-        remote_endpoint_.address());
+        overlay_.setup().compression, remote_endpoint_.address());
     auto const hello = buildHello (
         *sharedValue,
         overlay_.setup().public_ip,
@@ -279,7 +279,7 @@ ConnectAttempt::onShutdown (error_code ec)
 //--------------------------------------------------------------------------
 
 auto
-ConnectAttempt::makeRequest (bool crawl,
+ConnectAttempt::makeRequest (bool crawl, bool compression,
     boost::asio::ip::address const& remote_address) ->
         request_type
 {
@@ -293,6 +293,9 @@ ConnectAttempt::makeRequest (bool crawl,
     m.insert ("Connection", "Upgrade");
     m.insert ("Connect-As", "Peer");
     m.insert ("Crawl", crawl ? "public" : "private");
+    if (compression)
+        m.insert ("Compression", "lz4");
+    m.insert ("Tx-Batch", "1");
     return m;
 }
 
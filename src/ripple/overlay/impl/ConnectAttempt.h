@@ -89,7 +89,7 @@ private:
 
     static
     request_type
-    makeRequest (bool crawl,
+    makeRequest (bool crawl, bool compression,
         boost::asio::ip::address const& remote_address);
 
     void processResponse();
@@ -17,9 +17,13 @@
 */
 //==============================================================================
 
+// Disable lz4 deprecation warning due to incompatibility with clang attributes
+#define LZ4_DISABLE_DEPRECATE_WARNINGS
+
 #include <ripple/basics/safe_cast.h>
 #include <ripple/overlay/Message.h>
 #include <ripple/overlay/impl/TrafficCount.h>
+#include <lz4.h>
 #include <cstdint>
 
 namespace ripple {
@@ -32,7 +36,7 @@ Message::Message (::google::protobuf::Message const& message, int type)
 
     mBuffer.resize (kHeaderBytes + messageBytes);
 
-    encodeHeader (messageBytes, type);
+    encodeHeader (mBuffer.data (), messageBytes, type);
 
     if (messageBytes != 0)
     {
@@ -42,6 +46,61 @@ Message::Message (::google::protobuf::Message const& message, int type)
     mCategory = TrafficCount::categorize(message, type, false);
 }
 
+// Only the large message types that compress well are compressed
+static bool
+isCompressible (int type)
+{
+    switch (type)
+    {
+    case protocol::mtMANIFESTS:
+    case protocol::mtENDPOINTS:
+    case protocol::mtLEDGER_DATA:
+    case protocol::mtGET_OBJECTS:
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+std::vector <uint8_t> const&
+Message::getBuffer (bool compressed) const
+{
+    if (! compressed)
+        return mBuffer;
+
+    std::call_once (mCompressOnce, &Message::compress, this);
+    return mBufferCompressed.empty () ? mBuffer : mBufferCompressed;
+}
+
+void Message::compress () const
+{
+    auto const messageBytes = mBuffer.size () - kHeaderBytes;
+    if (messageBytes < kMinCompressBytes ||
+            ! isCompressible (getType (mBuffer)))
+        return;
+
+    auto const bound = LZ4_compressBound (messageBytes);
+    std::vector <uint8_t> buffer (kHeaderBytes + 4 + bound);
+    auto const compressedBytes = LZ4_compress_default (
+        reinterpret_cast<char const*>(&mBuffer [kHeaderBytes]),
+        reinterpret_cast<char*>(&buffer [kHeaderBytes + 4]),
+        messageBytes, bound);
+
+    // Keep the original unless compressing saves something
+    if (compressedBytes <= 0 || 4 + compressedBytes >= messageBytes)
+        return;
+
+    buffer.resize (kHeaderBytes + 4 + compressedBytes);
+    encodeHeader (buffer.data (), 4 + compressedBytes,
+        getType (mBuffer), true);
+    buffer[6] = static_cast<std::uint8_t> ((messageBytes >> 24) & 0xFF);
+    buffer[7] = static_cast<std::uint8_t> ((messageBytes >> 16) & 0xFF);
+    buffer[8] = static_cast<std::uint8_t> ((messageBytes >> 8) & 0xFF);
+    buffer[9] = static_cast<std::uint8_t> (messageBytes & 0xFF);
+    mBufferCompressed = std::move (buffer);
+}
+
 bool Message::operator== (Message const& other) const
 {
     return mBuffer == other.mBuffer;
@@ -53,7 +112,7 @@ unsigned Message::getLength (std::vector <uint8_t> const& buf)
 
     if (buf.size () >= Message::kHeaderBytes)
     {
-        result = buf [0];
+        result = buf [0] & ~kCompressedFlag & 0xFF;
         result <<= 8;
         result |= buf [1];
         result <<= 8;
@@ -80,15 +139,17 @@ int Message::getType (std::vector<uint8_t> const& buf)
     return ret;
 }
 
-void Message::encodeHeader (unsigned size, int type)
+void Message::encodeHeader (std::uint8_t* header,
+    std::size_t size, int type, bool compressed)
 {
-    assert (mBuffer.size () >= Message::kHeaderBytes);
-    mBuffer[0] = static_cast<std::uint8_t> ((size >> 24) & 0xFF);
-    mBuffer[1] = static_cast<std::uint8_t> ((size >> 16) & 0xFF);
-    mBuffer[2] = static_cast<std::uint8_t> ((size >> 8) & 0xFF);
-    mBuffer[3] = static_cast<std::uint8_t> (size & 0xFF);
-    mBuffer[4] = static_cast<std::uint8_t> ((type >> 8) & 0xFF);
-    mBuffer[5] = static_cast<std::uint8_t> (type & 0xFF);
+    header[0] = static_cast<std::uint8_t> ((size >> 24) & 0xFF);
+    header[1] = static_cast<std::uint8_t> ((size >> 16) & 0xFF);
+    header[2] = static_cast<std::uint8_t> ((size >> 8) & 0xFF);
+    header[3] = static_cast<std::uint8_t> (size & 0xFF);
+    header[4] = static_cast<std::uint8_t> ((type >> 8) & 0xFF);
+    header[5] = static_cast<std::uint8_t> (type & 0xFF);
+    if (compressed)
+        header[0] |= kCompressedFlag;
 }
 
 }
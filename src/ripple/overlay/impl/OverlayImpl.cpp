@@ -31,6 +31,7 @@
 #include <ripple/overlay/predicates.h>
 #include <ripple/overlay/impl/ConnectAttempt.h>
 #include <ripple/overlay/impl/PeerImp.h>
+#include <ripple/overlay/impl/TransactionRelay.h>
 #include <ripple/peerfinder/make_Manager.h>
 #include <ripple/rpc/json_body.h>
 #include <ripple/rpc/handlers/GetCounts.h>
@@ -124,6 +125,8 @@ OverlayImpl::Timer::on_timer (error_code ec)
     overlay_.m_peerFinder->once_per_second();
     overlay_.sendEndpoints();
     overlay_.autoConnect();
+    if (overlay_.setup_.squelch)
+        overlay_.sendSquelches (overlay_.slots_.expire ());
 
     if ((++overlay_.timer_count_ % Tuning::checkSeconds) == 0)
         overlay_.check();
@@ -615,6 +618,8 @@ OverlayImpl::onWrite (beast::PropertyStream::Map& stream)
             item["messages_in"] = std::to_string(i.messagesIn.load());
             item["bytes_out"] = std::to_string(i.bytesOut.load());
             item["messages_out"] = std::to_string(i.messagesOut.load());
+            item["bytes_saved_in"] = std::to_string(i.bytesSavedIn.load());
+            item["bytes_saved_out"] = std::to_string(i.bytesSavedOut.load());
         }
     }
 }
@@ -653,8 +658,12 @@ OverlayImpl::activate (std::shared_ptr<PeerImp> const& peer)
 void
 OverlayImpl::onPeerDeactivate (Peer::id_t id)
 {
-    std::lock_guard lock (mutex_);
-    ids_.erase(id);
+    {
+        std::lock_guard lock (mutex_);
+        ids_.erase(id);
+    }
+    if (setup_.squelch)
+        sendSquelches (slots_.remove (id));
 }
 
 void
@@ -736,9 +745,10 @@ void
 OverlayImpl::reportTraffic (
     TrafficCount::category cat,
     bool isInbound,
-    int number)
+    int number,
+    int saved)
 {
-    m_traffic.addCount (cat, isInbound, number);
+    m_traffic.addCount (cat, isInbound, number, saved);
 }
 
 Json::Value
@@ -1135,37 +1145,88 @@ OverlayImpl::send (protocol::TMValidation& m)
 }
 
 void
-OverlayImpl::relay (protocol::TMProposeSet& m, uint256 const& uid)
+OverlayImpl::relay (protocol::TMProposeSet& m, uint256 const& uid,
+    PublicKey const& validator)
 {
     if (m.has_hops() && m.hops() >= maxTTL)
         return;
+    if (setup_.squelch)
+        sendSquelches (slots_.verified (validator, uid));
     if (auto const toSkip = app_.getHashRouter().shouldRelay(uid))
     {
         auto const sm = std::make_shared<Message>(m, protocol::mtPROPOSE_LEDGER);
         for_each([&](std::shared_ptr<PeerImp>&& p)
         {
-            if (toSkip->find(p->id()) == toSkip->end())
+            if (toSkip->find(p->id()) == toSkip->end() &&
+                    ! p->isSquelched(validator))
                 p->send(sm);
         });
     }
 }
 
 void
-OverlayImpl::relay (protocol::TMValidation& m, uint256 const& uid)
+OverlayImpl::relay (protocol::TMValidation& m, uint256 const& uid,
+    PublicKey const& validator)
 {
     if (m.has_hops() && m.hops() >= maxTTL)
         return;
+    if (setup_.squelch)
+        sendSquelches (slots_.verified (validator, uid));
     if (auto const toSkip = app_.getHashRouter().shouldRelay(uid))
     {
         auto const sm = std::make_shared<Message>(m, protocol::mtVALIDATION);
         for_each([&](std::shared_ptr<PeerImp>&& p)
         {
-            if (toSkip->find(p->id()) == toSkip->end())
+            if (toSkip->find(p->id()) == toSkip->end() &&
+                    ! p->isSquelched(validator))
                 p->send(sm);
         });
     }
 }
 
+void
+OverlayImpl::relay (std::vector<std::pair<protocol::TMTransaction,
+    std::set<Peer::id_t>>> const& txs)
+{
+    TransactionRelay relay (txs);
+    for_each([&](std::shared_ptr<PeerImp>&& p)
+    {
+        for (auto const& sm : relay.messages (p->id(), p->txBatchEnabled()))
+            p->send(sm);
+    });
+}
+
+void
+OverlayImpl::updateSlots (PublicKey const& validator, uint256 const& key,
+    Peer::id_t id)
+{
+    if (setup_.squelch)
+        sendSquelches (slots_.update (validator, key, id));
+}
+
+void
+OverlayImpl::sendSquelches (std::vector<SquelchSlots::Action> const& actions)
+{
+    for (auto const& action : actions)
+    {
+        auto const peer = findPeerByShortID (action.peer);
+        if (! peer)
+            continue;
+
+        protocol::TMSquelch m;
+        m.set_squelch (action.squelch);
+        m.set_validatorpubkey (action.validator.data (),
+            action.validator.size ());
+        if (action.squelch)
+            m.set_squelchduration (action.duration.count ());
+        peer->send (std::make_shared<Message> (m, protocol::mtSQUELCH));
+
+        JLOG(journal_.debug()) << (action.squelch ? "Squelch " : "Unsquelch ")
+            << toBase58 (TokenType::NodePublic, action.validator)
+            << " at peer " << action.peer;
+    }
+}
+
 //------------------------------------------------------------------------------
 
 void
@@ -1260,6 +1321,8 @@ setup_Overlay (BasicConfig const& config)
         auto const& section = config.section("overlay");
         setup.context = make_SSLContext("");
         setup.expire = get<bool>(section, "expire", false);
+        setup.compression = get<bool>(section, "compression", false);
+        setup.squelch = get<bool>(section, "squelch", false);
 
         set(setup.ipLimit, "ip_limit", section);
         if (setup.ipLimit < 0)
@@ -23,6 +23,9 @@
 #include <ripple/app/main/Application.h>
 #include <ripple/core/Job.h>
 #include <ripple/overlay/Overlay.h>
+#include <ripple/overlay/impl/ReceivedTransactions.h>
+#include <ripple/overlay/impl/Squelch.h>
+#include <ripple/overlay/impl/Tuning.h>
 #include <ripple/overlay/impl/TrafficCount.h>
 #include <ripple/server/Handoff.h>
 #include <ripple/rpc/ServerHandler.h>
@@ -111,6 +114,7 @@ private:
     Resource::Manager& m_resourceManager;
     std::unique_ptr <PeerFinder::Manager> m_peerFinder;
     TrafficCount m_traffic;
+    SquelchSlots slots_;
     hash_map <PeerFinder::Slot::ptr,
         std::weak_ptr <PeerImp>> m_peers;
     hash_map<Peer::id_t, std::weak_ptr<PeerImp>> ids_;
@@ -118,6 +122,8 @@ private:
     std::atomic <Peer::id_t> next_id_;
     int timer_count_;
     std::atomic <uint64_t> jqTransOverflow_ {0};
+    ReceivedTransactions receivedTransactions_ {
+        Tuning::maxPendingTransactions};
     std::atomic <uint64_t> peerDisconnects_ {0};
     std::atomic <uint64_t> peerDisconnectsCharges_ {0};
 
@@ -205,11 +211,15 @@ public:
 
     void
     relay (protocol::TMProposeSet& m,
-        uint256 const& uid) override;
+        uint256 const& uid, PublicKey const& validator) override;
 
     void
     relay (protocol::TMValidation& m,
-        uint256 const& uid) override;
+        uint256 const& uid, PublicKey const& validator) override;
+
+    void
+    relay (std::vector<std::pair<protocol::TMTransaction,
+        std::set<Peer::id_t>>> const& txs) override;
 
     //--------------------------------------------------------------------------
     //
@@ -324,7 +334,8 @@ public:
     reportTraffic (
         TrafficCount::category cat,
         bool isInbound,
-        int bytes);
+        int bytes,
+        int saved = 0);
 
     void
     incJqTransOverflow() override
@@ -338,6 +349,13 @@ public:
         return jqTransOverflow_;
     }
 
+    /** Transactions received from peers and waiting to be checked. */
+    ReceivedTransactions&
+    receivedTransactions ()
+    {
+        return receivedTransactions_;
+    }
+
     void
     incPeerDisconnect() override
     {
@@ -373,7 +391,21 @@ public:
     void
     lastLink(std::uint32_t id);
 
+    /** Called when a peer relays a trusted validator's message.
+
+        The peer is counted once the message is verified and relayed.
+        Does nothing unless squelching is configured.
+
+        @param key The message's suppression hash.
+    */
+    void
+    updateSlots (PublicKey const& validator, uint256 const& key,
+        Peer::id_t id);
+
 private:
+    void
+    sendSquelches (std::vector<SquelchSlots::Action> const& actions);
+
     std::shared_ptr<Writer>
     makeRedirectResponse (PeerFinder::Slot::ptr const& slot,
         http_request_type const& request, address_type remote_address);
@@ -86,6 +86,10 @@ PeerImp::PeerImp (Application& app, id_t id, endpoint_type remote_endpoint,
     , slot_ (slot)
     , request_(std::move(request))
     , headers_(request_)
+    , compressionEnabled_ (overlay_.setup().compression &&
+        isCompressionOffered (headers_))
+    , txBatchEnabled_ (isTxBatchOffered (headers_))
+    , send_queue_ (Tuning::sendQueueLimit)
 {
 }
 
@@ -195,20 +199,10 @@ PeerImp::send (Message::pointer const& m)
     if(detaching_)
         return;
 
-    overlay_.reportTraffic (
-        safe_cast<TrafficCount::category>(m->getCategory()),
-        false, static_cast<int>(m->getBuffer().size()));
-
     auto sendq_size = send_queue_.size();
 
-    if (sendq_size < Tuning::targetSendQueue)
-    {
-        // To detect a peer that does not read from their
-        // side of the connection, we expect a peer to have
-        // a small senq periodically
-        large_sendq_ = 0;
-    }
-    else if (journal_.active (beast::severities::kDebug) &&
+    if (sendq_size >= Tuning::targetSendQueue &&
+        journal_.active (beast::severities::kDebug) &&
         (sendq_size % Tuning::sendQueueLogFreq) == 0)
     {
         std::string const name {getName()};
@@ -217,14 +211,18 @@ PeerImp::send (Message::pointer const& m)
                 " sendq: " << sendq_size;
     }
 
-    send_queue_.push(m);
+    // A full queue drops its least important
+    // messages rather than failing the peer
+    if (! send_queue_.push(m))
+        return;
 
-    if(sendq_size != 0)
+    if (send_queue_.writing())
         return;
 
     boost::asio::async_write(
         stream_,
-        boost::asio::buffer(send_queue_.front()->getBuffer()),
+        boost::asio::buffer(send_queue_.next()->getBuffer(
+            compressionEnabled_)),
         bind_executor(
             strand_,
             std::bind(
@@ -312,6 +310,8 @@ PeerImp::json()
             ret[jss::latency] = static_cast<Json::UInt> (latency_->count());
     }
 
+    ret[jss::send_queue] = send_queue_.json();
+
     ret[jss::uptime] = static_cast<Json::UInt>(
         std::chrono::duration_cast<std::chrono::seconds>(uptime()).count());
 
@@ -609,9 +609,13 @@ PeerImp::onTimer (error_code const& ec)
         return close();
     }
 
-    if (large_sendq_++ >= Tuning::sendqIntervals)
+    // To detect a peer that does not read from their side of the
+    // connection, we expect writes to complete while messages wait
+    if (send_queue_.empty())
+        large_sendq_ = 0;
+    else if (large_sendq_++ >= Tuning::sendqIntervals)
     {
-        fail ("Large send queue");
+        fail ("Stalled send queue");
         return;
     }
 
@@ -756,6 +760,10 @@ PeerImp::makeResponse (bool crawl,
     resp.insert("Connect-As", "Peer");
     resp.insert("Server", BuildInfo::getFullVersionString());
     resp.insert("Crawl", crawl ? "public" : "private");
+    if (overlay_.setup().compression && isCompressionOffered(req))
+        resp.insert("Compression", "lz4");
+    if (isTxBatchOffered(req))
+        resp.insert("Tx-Batch", "1");
     protocol::TMHello hello = buildHello(sharedValue,
         overlay_.setup().public_ip, remote, app_);
     appendHello(resp, hello);
@@ -863,7 +871,7 @@ PeerImp::onReadMessage (error_code ec, std::size_t bytes_transferred)
     {
         std::size_t bytes_consumed;
         std::tie(bytes_consumed, ec) = invokeProtocolMessage(
-            read_buffer_.data(), *this);
+            read_buffer_.data(), *this, compressionEnabled_);
         if (ec)
             return fail("onReadMessage", ec);
         if (! stream_.next_layer().is_open())
@@ -906,14 +914,27 @@ PeerImp::onWriteMessage (error_code ec, std::size_t bytes_transferred)
 
     metrics_.sent.add_message(bytes_transferred);
 
-    assert(! send_queue_.empty());
-    send_queue_.pop();
+    assert(send_queue_.writing());
+    auto const m = send_queue_.pop();
+
+    // Counted once written, so messages the queue
+    // dropped to make room are not
+    auto const& buffer = m->getBuffer (compressionEnabled_);
+    overlay_.reportTraffic (
+        safe_cast<TrafficCount::category>(m->getCategory()),
+        false, static_cast<int>(buffer.size()),
+        static_cast<int>(m->getBuffer().size() - buffer.size()));
+
+    // The peer is reading from their side of the connection
+    large_sendq_ = 0;
+
     if (! send_queue_.empty())
     {
         // Timeout on writes only
         return boost::asio::async_write(
             stream_,
-            boost::asio::buffer(send_queue_.front()->getBuffer()),
+            boost::asio::buffer(send_queue_.next()->getBuffer(
+                compressionEnabled_)),
             bind_executor(
                 strand_,
                 std::bind(
@@ -951,13 +972,14 @@ PeerImp::onMessageUnknown (std::uint16_t type)
 PeerImp::error_code
 PeerImp::onMessageBegin (std::uint16_t type,
     std::shared_ptr <::google::protobuf::Message> const& m,
-    std::size_t size)
+    std::size_t size, std::size_t uncompressedSize)
 {
     load_event_ = app_.getJobQueue ().makeLoadEvent (
         jtPEER, protocolMessageName(type));
     fee_ = Resource::feeLightPeer;
     overlay_.reportTraffic (TrafficCount::categorize (*m, type, true),
-        true, static_cast<int>(size));
+        true, static_cast<int>(size),
+        static_cast<int>(uncompressedSize - size));
     return error_code{};
 }
 
@@ -1469,7 +1491,14 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMEndpoints> const& m)
 void
 PeerImp::onMessage (std::shared_ptr <protocol::TMTransaction> const& m)
 {
+    auto batch = std::make_shared<protocol::TMTransactions> ();
+    batch->add_transactions ()->Swap (m.get ());
+    onMessage (batch);
+}
 
+void
+PeerImp::onMessage (std::shared_ptr <protocol::TMTransactions> const& m)
+{
     if (sanity_.load() == Sanity::insane)
         return;
 
@@ -1482,77 +1511,106 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMTransaction> const& m)
         return;
     }
 
-    SerialIter sit (makeSlice(m->rawtransaction()));
+    if (! ReceivedTransactions::acceptable (m->transactions_size ()))
+    {
+        JLOG(p_journal_.warn()) << "Transactions: batch too large";
+        fee_ = Resource::feeInvalidRequest;
+        return;
+    }
+    fee_ = ReceivedTransactions::fee (m->transactions_size ());
+
+    std::vector<std::shared_ptr<STTx const>> stxs;
+    std::vector<uint256> txIDs;
+    std::vector<bool> deferred;
+    stxs.reserve (m->transactions_size ());
+    txIDs.reserve (m->transactions_size ());
+    deferred.reserve (m->transactions_size ());
 
-    try
+    for (auto const& t : m->transactions ())
     {
-        auto stx = std::make_shared<STTx const>(sit);
-        uint256 txID = stx->getTransactionID ();
+        try
+        {
+            SerialIter sit (makeSlice(t.rawtransaction()));
+            auto stx = std::make_shared<STTx const>(sit);
+            txIDs.push_back (stx->getTransactionID ());
+            stxs.push_back (std::move (stx));
+            deferred.push_back (t.has_deferred () && t.deferred ());
+        }
+        catch (std::exception const&)
+        {
+            JLOG(p_journal_.warn()) << "Transaction invalid: " <<
+                strHex(t.rawtransaction ());
+        }
+    }
 
-        int flags;
-        constexpr std::chrono::seconds tx_interval = 10s;
+    // Check the whole batch against the router at once
+    constexpr std::chrono::seconds tx_interval = 10s;
+    std::vector<int> flags;
+    auto const process = app_.getHashRouter ().shouldProcess (
+        txIDs, id_, flags, tx_interval);
 
-        if (! app_.getHashRouter ().shouldProcess (txID, id_, flags,
-            tx_interval))
+    std::vector<std::pair<int, std::shared_ptr<STTx const>>> batch;
+    batch.reserve (stxs.size ());
+    for (std::size_t i = 0; i < stxs.size (); ++i)
+    {
+        if (! process[i])
         {
             // we have seen this transaction recently
-            if (flags & SF_BAD)
+            if (flags[i] & SF_BAD)
             {
                 fee_ = Resource::feeInvalidSignature;
                 JLOG(p_journal_.debug()) << "Ignoring known bad tx " <<
-                    txID;
+                    txIDs[i];
             }
-
-            return;
+            continue;
         }
 
-        JLOG(p_journal_.debug()) << "Got tx " << txID;
+        JLOG(p_journal_.debug()) << "Got tx " << txIDs[i];
 
-        bool checkSignature = true;
-        if (cluster())
-        {
-            if (! m->has_deferred () || ! m->deferred ())
-            {
-                // Skip local checks if a server we trust
-                // put the transaction in its open ledger
-                flags |= SF_TRUSTED;
-            }
+        // Skip local checks if a server we trust
+        // put the transaction in its open ledger
+        if (cluster() && ! deferred[i])
+            flags[i] |= SF_TRUSTED;
 
-            if (app_.getValidationPublicKey().empty())
-            {
-                // For now, be paranoid and have each validator
-                // check each transaction, regardless of source
-                checkSignature = false;
-            }
-        }
+        batch.emplace_back (flags[i], std::move (stxs[i]));
+    }
 
-        // The maximum number of transactions to have in the job queue.
-        constexpr int max_transactions = 250;
-        if (app_.getJobQueue().getJobCount(jtTRANSACTION) > max_transactions)
-        {
-            overlay_.incJqTransOverflow();
-            JLOG(p_journal_.info()) << "Transaction queue is full";
-        }
-        else if (app_.getLedgerMaster().getValidatedLedgerAge() > 4min)
-        {
-            JLOG(p_journal_.trace()) << "No new transactions until synchronized";
-        }
-        else
-        {
-            app_.getJobQueue ().addJob (
-                jtTRANSACTION, "recvTransaction->checkTransaction",
-                [weak = std::weak_ptr<PeerImp>(shared_from_this()),
-                flags, checkSignature, stx] (Job&) {
-                    if (auto peer = weak.lock())
+    if (batch.empty ())
+        return;
+
+    // For now, be paranoid and have each validator
+    // check each transaction, regardless of source
+    bool const checkSignature = ! cluster() ||
+        ! app_.getValidationPublicKey().empty();
+
+    // Bound the transactions waiting in the job queue, however
+    // they were batched
+    if (app_.getLedgerMaster().getValidatedLedgerAge() > 4min)
+    {
+        JLOG(p_journal_.trace()) << "No new transactions until synchronized";
+    }
+    else if (auto hold = overlay_.receivedTransactions ().hold (batch.size ()))
+    {
+        // One job checks the batch and hands it to NetworkOPs. The
+        // batch stops counting when the job is gone, even if the
+        // queue did not take it.
+        app_.getJobQueue ().addJob (
+            jtTRANSACTION, "recvTransaction->checkTransaction",
+            [weak = std::weak_ptr<PeerImp>(shared_from_this()),
+            hold = std::move (hold), checkSignature,
+            batch = std::move (batch)] (Job&) {
+                if (auto peer = weak.lock())
+                {
+                    for (auto const& [flags, stx] : batch)
                         peer->checkTransaction(flags,
                             checkSignature, stx);
-                });
-        }
+                }
+            });
     }
-    catch (std::exception const&)
+    else
     {
-        JLOG(p_journal_.warn()) << "Transaction invalid: " <<
-            strHex(m->rawtransaction ());
+        overlay_.incJqTransOverflow();
+        JLOG(p_journal_.info()) << "Transaction queue is full";
     }
 }
 
@@ -1666,14 +1724,17 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMProposeSet> const& m)
         proposeHash, prevLedger, set.proposeseq(),
         closeTime, publicKey.slice(), sig);
 
+    auto const isTrusted = app_.validators().trusted (publicKey);
+
+    if (isTrusted)
+        overlay_.updateSlots (publicKey, suppression, id_);
+
     if (! app_.getHashRouter ().addSuppressionPeer (suppression, id_))
     {
         JLOG(p_journal_.trace()) << "Proposal: duplicate";
         return;
     }
 
-    auto const isTrusted = app_.validators().trusted (publicKey);
-
     if (!isTrusted)
     {
         if (sanity_.load() == Sanity::insane)
@@ -2037,16 +2098,20 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMValidation> const& m)
             return;
         }
 
-        if (! app_.getHashRouter ().addSuppressionPeer(
-            sha512Half(makeSlice(m->validation())), id_))
+        auto const isTrusted =
+            app_.validators().trusted(val->getSignerPublic ());
+
+        auto const suppression = sha512Half(makeSlice(m->validation()));
+
+        if (isTrusted)
+            overlay_.updateSlots (val->getSignerPublic (), suppression, id_);
+
+        if (! app_.getHashRouter ().addSuppressionPeer(suppression, id_))
         {
             JLOG(p_journal_.trace()) << "Validation: duplicate";
             return;
         }
 
-        auto const isTrusted =
-            app_.validators().trusted(val->getSignerPublic ());
-
         if (!isTrusted && (sanity_.load () == Sanity::insane))
         {
             JLOG(p_journal_.debug()) <<
@@ -2157,9 +2222,17 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMGetObjectByHash> const& m)
     else
     {
         // this is a reply
+
+        // Fetch pack objects go straight to the node store, so only
+        // replies to our own outstanding request are taken
+        if (packet.type () == protocol::TMGetObjectByHash::otFETCH_PACK)
+        {
+            fee_ = app_.getLedgerMaster ().receiveFetchPack (id_, packet);
+            return;
+        }
+
         std::uint32_t pLSeq = 0;
         bool pLDo = true;
-        bool progress = false;
 
         for (int i = 0; i < packet.objects_size(); ++i)
         {
@@ -2184,8 +2257,6 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMGetObjectByHash> const& m)
                             JLOG(p_journal_.debug()) <<
                                 "GetObj: Late fetch pack for " << pLSeq;
                         }
-                        else
-                            progress = true;
                     }
                 }
 
@@ -2207,8 +2278,34 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMGetObjectByHash> const& m)
             JLOG(p_journal_.debug()) <<
                 "GetObj: Partial fetch pack for " << pLSeq;
         }
-        if (packet.type () == protocol::TMGetObjectByHash::otFETCH_PACK)
-            app_.getLedgerMaster ().gotFetchPack (progress, pLSeq);
+    }
+}
+
+void
+PeerImp::onMessage (std::shared_ptr <protocol::TMSquelch> const& m)
+{
+    auto const& key = m->validatorpubkey ();
+    if (! publicKeyType (makeSlice (key)))
+    {
+        JLOG(p_journal_.warn()) << "Squelch: malformed";
+        fee_ = Resource::feeInvalidRequest;
+        return;
+    }
+    PublicKey const validator {makeSlice (key)};
+
+    if (! m->squelch ())
+    {
+        squelch_.unsquelch (validator);
+        return;
+    }
+
+    auto const duration = m->has_squelchduration ()
+        ? std::chrono::seconds {m->squelchduration ()}
+        : Tuning::squelchMinDuration;
+    if (! squelch_.squelch (validator, duration))
+    {
+        JLOG(p_journal_.warn()) << "Squelch: invalid duration";
+        fee_ = Resource::feeInvalidRequest;
     }
 }
 
@@ -2377,7 +2474,8 @@ PeerImp::checkPropose (Job& job,
             // relay untrusted proposal
             JLOG(p_journal_.trace()) <<
                 "relaying UNTRUSTED proposal";
-            overlay_.relay(set, peerPos.suppressionID());
+            overlay_.relay(set, peerPos.suppressionID(),
+                peerPos.publicKey());
         }
         else
         {
@@ -2407,7 +2505,7 @@ PeerImp::checkValidation (STValidation::pointer val,
         {
             auto const suppression = sha512Half(
                 makeSlice(val->getSerialized()));
-            overlay_.relay(*packet, suppression);
+            overlay_.relay(*packet, suppression, val->getSignerPublic ());
         }
     }
     catch (std::exception const&)
@@ -27,6 +27,9 @@
 #include <ripple/beast/utility/WrappedSink.h>
 #include <ripple/overlay/impl/ProtocolMessage.h>
 #include <ripple/overlay/impl/OverlayImpl.h>
+#include <ripple/overlay/impl/SendQueue.h>
+#include <ripple/overlay/impl/Squelch.h>
+#include <ripple/overlay/impl/Tuning.h>
 #include <ripple/peerfinder/PeerfinderManager.h>
 #include <ripple/protocol/Protocol.h>
 #include <ripple/protocol/STTx.h>
@@ -38,7 +41,6 @@
 #include <boost/optional.hpp>
 #include <cstdint>
 #include <deque>
-#include <queue>
 #include <shared_mutex>
 
 namespace ripple {
@@ -187,8 +189,11 @@ private:
     http_request_type request_;
     http_response_type response_;
     boost::beast::http::fields const& headers_;
+    bool const compressionEnabled_;
+    bool const txBatchEnabled_;
     boost::beast::multi_buffer write_buffer_;
-    std::queue<Message::pointer> send_queue_;
+    SendQueue send_queue_;
+    Squelch squelch_;
     bool gracefulClose_ = false;
     int large_sendq_ = 0;
     int no_ping_ = 0;
@@ -364,6 +369,20 @@ public:
     bool
     hasTxSet (uint256 const& hash) const override;
 
+    /** Returns `true` if this peer accepts batches of transactions. */
+    bool
+    txBatchEnabled () const
+    {
+        return txBatchEnabled_;
+    }
+
+    /** Returns `true` if this peer asked us not to relay a validator. */
+    bool
+    isSquelched (PublicKey const& validator)
+    {
+        return squelch_.isSquelched (validator);
+    }
+
     void
     cycleStatus () override;
 
@@ -471,7 +490,7 @@ public:
     error_code
     onMessageBegin (std::uint16_t type,
         std::shared_ptr <::google::protobuf::Message> const& m,
-        std::size_t size);
+        std::size_t size, std::size_t uncompressedSize);
 
     void
     onMessageEnd (std::uint16_t type,
@@ -489,6 +508,7 @@ public:
     void onMessage (std::shared_ptr <protocol::TMPeers> const& m);
     void onMessage (std::shared_ptr <protocol::TMEndpoints> const& m);
     void onMessage (std::shared_ptr <protocol::TMTransaction> const& m);
+    void onMessage (std::shared_ptr <protocol::TMTransactions> const& m);
     void onMessage (std::shared_ptr <protocol::TMGetLedger> const& m);
     void onMessage (std::shared_ptr <protocol::TMLedgerData> const& m);
     void onMessage (std::shared_ptr <protocol::TMProposeSet> const& m);
@@ -496,6 +516,7 @@ public:
     void onMessage (std::shared_ptr <protocol::TMHaveTransactionSet> const& m);
     void onMessage (std::shared_ptr <protocol::TMValidation> const& m);
     void onMessage (std::shared_ptr <protocol::TMGetObjectByHash> const& m);
+    void onMessage (std::shared_ptr <protocol::TMSquelch> const& m);
 
 private:
     State state() const
@@ -578,6 +599,10 @@ PeerImp::PeerImp (Application& app, std::unique_ptr<beast::asio::ssl_bundle>&& s
     , slot_ (std::move(slot))
     , response_(std::move(response))
     , headers_(response_)
+    , compressionEnabled_ (overlay_.setup().compression &&
+        isCompressionOffered (headers_))
+    , txBatchEnabled_ (isTxBatchOffered (headers_))
+    , send_queue_ (Tuning::sendQueueLimit)
 {
     read_buffer_.commit (boost::asio::buffer_copy(read_buffer_.prepare(
         boost::asio::buffer_size(buffers)), buffers));
@@ -20,12 +20,17 @@
 #ifndef RIPPLE_OVERLAY_PROTOCOLMESSAGE_H_INCLUDED
 #define RIPPLE_OVERLAY_PROTOCOLMESSAGE_H_INCLUDED
 
+// Disable lz4 deprecation warning due to incompatibility with clang attributes
+#define LZ4_DISABLE_DEPRECATE_WARNINGS
+
 #include <ripple/protocol/messages.h>
 #include <ripple/overlay/Message.h>
 #include <ripple/overlay/impl/ZeroCopyStream.h>
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/buffers_iterator.hpp>
 #include <boost/system/error_code.hpp>
+#include <lz4.h>
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <memory>
@@ -61,6 +66,8 @@ protocolMessageName (int type)
     case protocol::mtHAVE_SET:              return "have_set";
     case protocol::mtVALIDATION:            return "validation";
     case protocol::mtGET_OBJECTS:           return "get_objects";
+    case protocol::mtSQUELCH:               return "squelch";
+    case protocol::mtTRANSACTIONS:          return "txs";
     default:
         break;
     };
@@ -74,7 +81,7 @@ std::enable_if_t<std::is_base_of<
     ::google::protobuf::Message, T>::value,
         boost::system::error_code>
 invoke (int type, Buffers const& buffers,
-    Handler& handler)
+    std::size_t size, Handler& handler)
 {
     ZeroCopyInputStream<Buffers> stream(buffers);
     stream.Skip(Message::kHeaderBytes);
@@ -82,7 +89,7 @@ invoke (int type, Buffers const& buffers,
     if (! m->ParseFromZeroCopyStream(&stream))
         return boost::system::errc::make_error_code(
             boost::system::errc::invalid_argument);
-    auto ec = handler.onMessageBegin (type, m,
+    auto ec = handler.onMessageBegin (type, m, size,
        Message::kHeaderBytes + Message::size (buffers));
     if (! ec)
     {
@@ -92,6 +99,81 @@ invoke (int type, Buffers const& buffers,
     return ec;
 }
 
+/** Decompress a compressed protocol message.
+
+    @return The message with its payload decompressed and an
+            uncompressed header, or nothing if it is malformed.
+*/
+template <class Buffers>
+std::vector<std::uint8_t>
+decompress (Buffers const& buffers, std::size_t size)
+{
+    std::vector<std::uint8_t> in (size);
+    boost::asio::buffer_copy(boost::asio::buffer(in), buffers);
+
+    std::vector<std::uint8_t> out;
+    if (size < Message::kHeaderBytes + 4)
+        return out;
+
+    auto const p = &in[Message::kHeaderBytes];
+    std::size_t const n =
+        (std::size_t{p[0]} << 24) | (std::size_t{p[1]} << 16) |
+        (std::size_t{p[2]} <<  8) |  std::size_t{p[3]};
+    // An LZ4 block expands at most 255 times
+    if (n == 0 || n > Message::kMaxMessageSize ||
+            n / 255 > size - Message::kHeaderBytes - 4)
+        return out;
+
+    out.resize (Message::kHeaderBytes + n);
+    if (LZ4_decompress_safe(
+            reinterpret_cast<char const*>(p + 4),
+            reinterpret_cast<char*>(&out[Message::kHeaderBytes]),
+            size - Message::kHeaderBytes - 4, n) != static_cast<int>(n))
+    {
+        out.clear();
+        return out;
+    }
+    Message::encodeHeader(out.data(), n, Message::type(buffers));
+    return out;
+}
+
+/** Calls the handler for the protocol message of the given type. */
+template <class Buffers, class Handler>
+boost::system::error_code
+dispatch (int type, Buffers const& buffers,
+    std::size_t size, Handler& handler)
+{
+    boost::system::error_code ec;
+    switch (type)
+    {
+    case protocol::mtHELLO:                 ec = invoke<protocol::TMHello> (type, buffers, size, handler); break;
+    case protocol::mtMANIFESTS:             ec = invoke<protocol::TMManifests> (type, buffers, size, handler); break;
+    case protocol::mtPING:                  ec = invoke<protocol::TMPing> (type, buffers, size, handler); break;
+    case protocol::mtCLUSTER:               ec = invoke<protocol::TMCluster> (type, buffers, size, handler); break;
+    case protocol::mtGET_SHARD_INFO:        ec = invoke<protocol::TMGetShardInfo> (type, buffers, size, handler); break;
+    case protocol::mtSHARD_INFO:            ec = invoke<protocol::TMShardInfo>(type, buffers, size, handler); break;
+    case protocol::mtGET_PEER_SHARD_INFO:   ec = invoke<protocol::TMGetPeerShardInfo> (type, buffers, size, handler); break;
+    case protocol::mtPEER_SHARD_INFO:       ec = invoke<protocol::TMPeerShardInfo>(type, buffers, size, handler); break;
+    case protocol::mtGET_PEERS:             ec = invoke<protocol::TMGetPeers> (type, buffers, size, handler); break;
+    case protocol::mtPEERS:                 ec = invoke<protocol::TMPeers> (type, buffers, size, handler); break;
+    case protocol::mtENDPOINTS:             ec = invoke<protocol::TMEndpoints> (type, buffers, size, handler); break;
+    case protocol::mtTRANSACTION:           ec = invoke<protocol::TMTransaction> (type, buffers, size, handler); break;
+    case protocol::mtGET_LEDGER:            ec = invoke<protocol::TMGetLedger> (type, buffers, size, handler); break;
+    case protocol::mtLEDGER_DATA:           ec = invoke<protocol::TMLedgerData> (type, buffers, size, handler); break;
+    case protocol::mtPROPOSE_LEDGER:        ec = invoke<protocol::TMProposeSet> (type, buffers, size, handler); break;
+    case protocol::mtSTATUS_CHANGE:         ec = invoke<protocol::TMStatusChange> (type, buffers, size, handler); break;
+    case protocol::mtHAVE_SET:              ec = invoke<protocol::TMHaveTransactionSet> (type, buffers, size, handler); break;
+    case protocol::mtVALIDATION:            ec = invoke<protocol::TMValidation> (type, buffers, size, handler); break;
+    case protocol::mtGET_OBJECTS:           ec = invoke<protocol::TMGetObjectByHash> (type, buffers, size, handler); break;
+    case protocol::mtSQUELCH:               ec = invoke<protocol::TMSquelch> (type, buffers, size, handler); break;
+    case protocol::mtTRANSACTIONS:          ec = invoke<protocol::TMTransactions> (type, buffers, size, handler); break;
+    default:
+        ec = handler.onMessageUnknown (type);
+        break;
+    }
+    return ec;
+}
+
 }
 
 /** Calls the handler for up to one protocol message in the passed buffers.
@@ -99,11 +181,15 @@ invoke (int type, Buffers const& buffers,
     If there is insufficient data to produce a complete protocol
     message, zero is returned for the number of bytes consumed.
 
+    @param compressionEnabled Whether compression was negotiated with
+                              the peer. If not, compressed messages are
+                              rejected.
     @return The number of bytes consumed, or the error code if any.
 */
 template <class Buffers, class Handler>
 std::pair <std::size_t, boost::system::error_code>
-invokeProtocolMessage (Buffers const& buffers, Handler& handler)
+invokeProtocolMessage (Buffers const& buffers, Handler& handler,
+    bool compressionEnabled)
 {
     std::pair<std::size_t,boost::system::error_code> result = { 0, {} };
     boost::system::error_code& ec = result.second;
@@ -128,31 +214,29 @@ invokeProtocolMessage (Buffers const& buffers, Handler& handler)
 
     auto const type = Message::type(buffers);
 
-    switch (type)
+    if (Message::compressed(buffers))
     {
-    case protocol::mtHELLO:                 ec = detail::invoke<protocol::TMHello> (type, buffers, handler); break;
-    case protocol::mtMANIFESTS:             ec = detail::invoke<protocol::TMManifests> (type, buffers, handler); break;
-    case protocol::mtPING:                  ec = detail::invoke<protocol::TMPing> (type, buffers, handler); break;
-    case protocol::mtCLUSTER:               ec = detail::invoke<protocol::TMCluster> (type, buffers, handler); break;
-    case protocol::mtGET_SHARD_INFO:        ec = detail::invoke<protocol::TMGetShardInfo> (type, buffers, handler); break;
-    case protocol::mtSHARD_INFO:            ec = detail::invoke<protocol::TMShardInfo>(type, buffers, handler); break;
-    case protocol::mtGET_PEER_SHARD_INFO:   ec = detail::invoke<protocol::TMGetPeerShardInfo> (type, buffers, handler); break;
-    case protocol::mtPEER_SHARD_INFO:       ec = detail::invoke<protocol::TMPeerShardInfo>(type, buffers, handler); break;
-    case protocol::mtGET_PEERS:             ec = detail::invoke<protocol::TMGetPeers> (type, buffers, handler); break;
-    case protocol::mtPEERS:                 ec = detail::invoke<protocol::TMPeers> (type, buffers, handler); break;
-    case protocol::mtENDPOINTS:             ec = detail::invoke<protocol::TMEndpoints> (type, buffers, handler); break;
-    case protocol::mtTRANSACTION:           ec = detail::invoke<protocol::TMTransaction> (type, buffers, handler); break;
-    case protocol::mtGET_LEDGER:            ec = detail::invoke<protocol::TMGetLedger> (type, buffers, handler); break;
-    case protocol::mtLEDGER_DATA:           ec = detail::invoke<protocol::TMLedgerData> (type, buffers, handler); break;
-    case protocol::mtPROPOSE_LEDGER:        ec = detail::invoke<protocol::TMProposeSet> (type, buffers, handler); break;
-    case protocol::mtSTATUS_CHANGE:         ec = detail::invoke<protocol::TMStatusChange> (type, buffers, handler); break;
-    case protocol::mtHAVE_SET:              ec = detail::invoke<protocol::TMHaveTransactionSet> (type, buffers, handler); break;
-    case protocol::mtVALIDATION:            ec = detail::invoke<protocol::TMValidation> (type, buffers, handler); break;
-    case protocol::mtGET_OBJECTS:           ec = detail::invoke<protocol::TMGetObjectByHash> (type, buffers, handler); break;
-    default:
-        ec = handler.onMessageUnknown (type);
-        break;
+        if (! compressionEnabled)
+        {
+            ec = boost::system::errc::make_error_code(
+                boost::system::errc::invalid_argument);
+            return result;
+        }
+
+        auto const message = detail::decompress(buffers, size);
+        if (message.empty())
+            ec = boost::system::errc::make_error_code(
+                boost::system::errc::invalid_argument);
+        else
+            ec = detail::dispatch(type, std::array<
+                boost::asio::const_buffer, 1>{{boost::asio::buffer(
+                    message)}}, size, handler);
     }
+    else
+    {
+        ec = detail::dispatch(type, buffers, size, handler);
+    }
+
     if (! ec)
         result.first = size;
 
@@ -0,0 +1,68 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/overlay/impl/ReceivedTransactions.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <ripple/resource/Fees.h>
+
+namespace ripple {
+
+ReceivedTransactions::Hold::Hold (ReceivedTransactions& owner, int count)
+    : owner_ (owner)
+    , count_ (count)
+{
+}
+
+ReceivedTransactions::Hold::~Hold ()
+{
+    owner_.pending_ -= count_;
+}
+
+ReceivedTransactions::ReceivedTransactions (int limit)
+    : limit_ (limit)
+{
+}
+
+bool
+ReceivedTransactions::acceptable (int count)
+{
+    return count <= Tuning::maxTransactionBatch;
+}
+
+Resource::Charge
+ReceivedTransactions::fee (int count)
+{
+    if (count <= 1)
+        return Resource::feeLightPeer;
+    return Resource::Charge (Resource::feeLightPeer.cost () * count,
+        Resource::feeLightPeer.label ());
+}
+
+std::shared_ptr<ReceivedTransactions::Hold>
+ReceivedTransactions::hold (int count)
+{
+    if ((pending_ += count) > limit_)
+    {
+        pending_ -= count;
+        return nullptr;
+    }
+    return std::make_shared<Hold> (*this, count);
+}
+
+}
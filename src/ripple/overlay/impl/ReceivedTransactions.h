@@ -0,0 +1,93 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_OVERLAY_RECEIVEDTRANSACTIONS_H_INCLUDED
+#define RIPPLE_OVERLAY_RECEIVEDTRANSACTIONS_H_INCLUDED
+
+#include <ripple/resource/Charge.h>
+#include <atomic>
+#include <memory>
+
+namespace ripple {
+
+/** Bounds and charges the transactions received from peers.
+
+    Transactions are counted however they were batched. A batch is
+    taken whole or not at all, and counts as waiting until the last
+    copy of its hold is destroyed, whether or not its job ran.
+*/
+class ReceivedTransactions
+{
+public:
+    /** Keeps a batch counted as waiting to be checked. */
+    class Hold
+    {
+    public:
+        Hold (ReceivedTransactions& owner, int count);
+        ~Hold ();
+
+        Hold (Hold const&) = delete;
+        Hold& operator= (Hold const&) = delete;
+
+    private:
+        ReceivedTransactions& owner_;
+        int const count_;
+    };
+
+    explicit
+    ReceivedTransactions (int limit);
+
+    ReceivedTransactions (ReceivedTransactions const&) = delete;
+    ReceivedTransactions& operator= (ReceivedTransactions const&) = delete;
+
+    /** Returns `true` if a peer may send this many in one message. */
+    static
+    bool
+    acceptable (int count);
+
+    /** Returns the fee for a message carrying this many.
+
+        Each transaction costs what a message of its own would.
+    */
+    static
+    Resource::Charge
+    fee (int count);
+
+    /** Make room for a batch waiting to be checked.
+
+        @return The hold, or `nullptr` if too many are waiting already.
+    */
+    std::shared_ptr<Hold>
+    hold (int count);
+
+    /** Returns the transactions waiting to be checked. */
+    int
+    pending () const
+    {
+        return pending_;
+    }
+
+private:
+    int const limit_;
+    std::atomic<int> pending_ {0};
+};
+
+}
+
+#endif
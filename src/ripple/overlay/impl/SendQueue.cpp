@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/overlay/impl/SendQueue.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <ripple/protocol/jss.h>
+#include <cassert>
+
+namespace ripple {
+
+static char const* const priorityNames[SendQueue::classes] =
+{
+    "consensus",    // SendQueue::consensus
+    "normal",       // SendQueue::normal
+    "bulk"          // SendQueue::bulk
+};
+
+SendQueue::Priority
+SendQueue::classify (Message const& m)
+{
+    switch (Message::getType (m.getBuffer ()))
+    {
+    case protocol::mtPROPOSE_LEDGER:
+    case protocol::mtVALIDATION:
+    case protocol::mtSTATUS_CHANGE:
+    case protocol::mtHAVE_SET:
+    case protocol::mtPING:
+    case protocol::mtSQUELCH:
+        return consensus;
+
+    case protocol::mtLEDGER_DATA:
+    case protocol::mtGET_OBJECTS:
+    case protocol::mtSHARD_INFO:
+    case protocol::mtPEER_SHARD_INFO:
+        return bulk;
+
+    default:
+        break;
+    }
+    return normal;
+}
+
+SendQueue::SendQueue (std::size_t limit)
+    : limit_ (limit)
+{
+    assert (limit_ != 0);
+}
+
+bool
+SendQueue::push (Message::pointer const& m)
+{
+    auto const priority = classify (*m);
+
+    if (queued_ >= limit_)
+    {
+        // Drop the stalest message that does not outrank this one
+        auto c = static_cast<std::size_t>(bulk);
+        while (c > priority && queues_[c].empty ())
+            --c;
+
+        auto& victims = queues_[c];
+        if (victims.empty ())
+        {
+            ++stats_[priority].dropped;
+            return false;
+        }
+
+        victims.pop_front ();
+        --queued_;
+        --stats_[c].depth;
+        ++stats_[c].dropped;
+    }
+
+    queues_[priority].push_back ({m, clock_type::now ()});
+    ++queued_;
+    ++stats_[priority].depth;
+    return true;
+}
+
+Message::pointer const&
+SendQueue::next ()
+{
+    assert (! writing ());
+    assert (queued_ != 0);
+
+    // Consensus messages go first. Otherwise bulk gets a turn after
+    // every few normal messages, or whenever there are none.
+    Priority c;
+    if (! queues_[consensus].empty ())
+        c = consensus;
+    else if (! queues_[normal].empty () && (queues_[bulk].empty () ||
+            normalRun_ < Tuning::sendNormalWeight))
+        c = normal;
+    else
+        c = bulk;
+
+    if (c == normal)
+        ++normalRun_;
+    else if (c == bulk)
+        normalRun_ = 0;
+
+    current_ = std::move (queues_[c].front ());
+    queues_[c].pop_front ();
+    --queued_;
+    writing_ = c;
+    return current_.message;
+}
+
+Message::pointer
+SendQueue::pop ()
+{
+    assert (writing ());
+
+    using namespace std::chrono;
+    auto const elapsed = duration_cast<milliseconds> (
+        clock_type::now () - current_.queued).count ();
+
+    auto& stats = stats_[writing_];
+    stats.latencyMs = (stats.latencyMs.load () * 7 + elapsed) / 8;
+    --stats.depth;
+
+    auto written = std::move (current_.message);
+    current_ = {};
+    writing_ = classes;
+    return written;
+}
+
+Json::Value
+SendQueue::json () const
+{
+    Json::Value ret (Json::objectValue);
+    for (std::size_t c = 0; c < classes; ++c)
+    {
+        auto& item = ret[priorityNames[c]] = Json::objectValue;
+        item[jss::depth] = stats_[c].depth.load ();
+        item[jss::latency] =
+            static_cast<Json::UInt> (stats_[c].latencyMs.load ());
+        item[jss::dropped] =
+            static_cast<Json::UInt> (stats_[c].dropped.load ());
+    }
+    return ret;
+}
+
+}
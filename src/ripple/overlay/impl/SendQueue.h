@@ -0,0 +1,158 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_OVERLAY_SENDQUEUE_H_INCLUDED
+#define RIPPLE_OVERLAY_SENDQUEUE_H_INCLUDED
+
+#include <ripple/json/json_value.h>
+#include <ripple/overlay/Message.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
+namespace ripple {
+
+/** The messages waiting to be written to a peer.
+
+    Messages are queued by priority class. Consensus messages are always
+    written first. The other classes share what is left by weight, so
+    bulk data cannot starve transactions nor the other way around.
+
+    When the queue is full, the oldest message of the lowest class that
+    is not above the new message's class is dropped to make room. If
+    every queued message outranks the new one, the new one is dropped.
+
+    Except for json, member functions must be called from the peer's
+    strand.
+*/
+class SendQueue
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    enum Priority : std::size_t
+    {
+        consensus,      // proposals, validations and status, first
+        normal,         // transactions and overlay management
+        bulk,           // ledger data, objects and shards
+
+        classes         // must be last
+    };
+
+    /** Returns the priority class of a message. */
+    static
+    Priority
+    classify (Message const& m);
+
+    /** Create a queue.
+
+        @param limit The most messages queued, not counting the one
+                     being written.
+    */
+    explicit
+    SendQueue (std::size_t limit);
+
+    SendQueue (SendQueue const&) = delete;
+    SendQueue& operator= (SendQueue const&) = delete;
+
+    /** Queue a message.
+
+        @return `false` if the message was dropped.
+    */
+    bool
+    push (Message::pointer const& m);
+
+    /** Start writing the next message.
+
+        Requires that nothing is being written and the queue is not
+        empty.
+
+        @return The message, which the queue keeps until pop.
+    */
+    Message::pointer const&
+    next ();
+
+    /** Finish writing the message returned by next.
+
+        @return The message written. Messages dropped by push are
+                never returned.
+    */
+    Message::pointer
+    pop ();
+
+    /** Returns `true` if a message is being written. */
+    bool
+    writing () const
+    {
+        return writing_ != classes;
+    }
+
+    /** Returns the messages queued or being written. */
+    std::size_t
+    size () const
+    {
+        return queued_ + (writing () ? 1 : 0);
+    }
+
+    bool
+    empty () const
+    {
+        return size () == 0;
+    }
+
+    /** Returns depth, latency and drops for each class. Thread safe. */
+    Json::Value
+    json () const;
+
+private:
+    struct Entry
+    {
+        Message::pointer message;
+        clock_type::time_point queued;
+    };
+
+    struct Stats
+    {
+        std::atomic<std::uint32_t> depth {0};
+
+        // Decaying average of the time from queueing to written
+        std::atomic<std::uint64_t> latencyMs {0};
+
+        std::atomic<std::uint64_t> dropped {0};
+    };
+
+    std::size_t const limit_;
+    std::array<std::deque<Entry>, classes> queues_;
+    std::size_t queued_ = 0;
+
+    // The class of the message being written, or classes
+    Priority writing_ = classes;
+    Entry current_;
+
+    // Normal messages written since the last bulk one
+    std::size_t normalRun_ = 0;
+
+    std::array<Stats, classes> stats_;
+};
+
+}
+
+#endif
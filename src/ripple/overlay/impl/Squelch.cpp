@@ -0,0 +1,258 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/overlay/impl/Squelch.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <ripple/basics/random.h>
+#include <algorithm>
+
+namespace ripple {
+
+bool
+Squelch::squelch (PublicKey const& validator, std::chrono::seconds duration)
+{
+    if (duration <= std::chrono::seconds{0} ||
+            duration > Tuning::squelchMaxDuration)
+        return false;
+
+    std::lock_guard lock (mutex_);
+    expires_[validator] = clock_type::now () + duration;
+    return true;
+}
+
+void
+Squelch::unsquelch (PublicKey const& validator)
+{
+    std::lock_guard lock (mutex_);
+    expires_.erase (validator);
+}
+
+bool
+Squelch::isSquelched (PublicKey const& validator)
+{
+    std::lock_guard lock (mutex_);
+    auto const iter = expires_.find (validator);
+    if (iter == expires_.end ())
+        return false;
+    if (iter->second > clock_type::now ())
+        return true;
+    expires_.erase (iter);
+    return false;
+}
+
+//------------------------------------------------------------------------------
+
+void
+SquelchSlots::reset (PublicKey const& validator, Slot& slot,
+    bool unsquelch, std::vector<Action>& actions)
+{
+    for (auto& [id, source] : slot.sources)
+    {
+        if (unsquelch && source.squelched)
+            actions.push_back ({id, validator, false, {}});
+        source.count = 0;
+        source.squelched = false;
+    }
+    slot.selected.clear ();
+}
+
+void
+SquelchSlots::count (PublicKey const& validator, Peer::id_t peer,
+    clock_type::time_point now, std::vector<Action>& actions)
+{
+    using namespace std::chrono;
+
+    auto& slot = slots_[validator];
+    auto& source = slot.sources[peer];
+    source.last = now;
+
+    if (! slot.selected.empty ())
+    {
+        // A source that appeared after the selection is
+        // squelched until the others lapse
+        if (! source.squelched && slot.selected.count (peer) == 0)
+        {
+            source.squelched = true;
+            actions.push_back ({peer, validator, true, std::max (
+                duration_cast<seconds> (slot.expires - now), seconds{1})});
+        }
+        return;
+    }
+
+    if (++source.count != Tuning::squelchMessageThreshold)
+        return;
+
+    // Select once enough sources reached the threshold
+    std::vector<std::pair<std::uint32_t, Peer::id_t>> ready;
+    for (auto const& [id, s] : slot.sources)
+    {
+        if (s.count >= Tuning::squelchMessageThreshold)
+            ready.emplace_back (s.count, id);
+    }
+    if (ready.size () < Tuning::squelchSelectedPeers)
+        return;
+
+    // Keep the sources that relayed the most
+    std::partial_sort (ready.begin (),
+        ready.begin () + Tuning::squelchSelectedPeers, ready.end (),
+        std::greater<> ());
+    for (std::size_t i = 0; i < Tuning::squelchSelectedPeers; ++i)
+        slot.selected.insert (ready[i].second);
+
+    seconds const duration {rand_int (
+        Tuning::squelchMinDuration.count (),
+        Tuning::squelchMaxDuration.count ())};
+    slot.expires = now + duration;
+
+    for (auto& [id, s] : slot.sources)
+    {
+        s.count = 0;
+        if (slot.selected.count (id) == 0)
+        {
+            s.squelched = true;
+            actions.push_back ({id, validator, true, duration});
+        }
+    }
+}
+
+std::vector<SquelchSlots::Action>
+SquelchSlots::update (PublicKey const& validator, uint256 const& key,
+    Peer::id_t peer)
+{
+    std::vector<Action> actions;
+    auto const now = clock_type::now ();
+
+    std::lock_guard lock (mutex_);
+    auto [iter, inserted] = messages_.try_emplace (key);
+    auto& message = iter->second;
+    if (inserted)
+        message.first = now;
+
+    // Each peer counts once per message
+    if (message.peers.insert (peer).second && message.verified)
+        count (validator, peer, now, actions);
+    return actions;
+}
+
+std::vector<SquelchSlots::Action>
+SquelchSlots::verified (PublicKey const& validator, uint256 const& key)
+{
+    std::vector<Action> actions;
+    auto const now = clock_type::now ();
+
+    std::lock_guard lock (mutex_);
+    auto const iter = messages_.find (key);
+    if (iter == messages_.end () || iter->second.verified)
+        return actions;
+
+    iter->second.verified = true;
+    for (auto const peer : iter->second.peers)
+        count (validator, peer, now, actions);
+    return actions;
+}
+
+std::vector<SquelchSlots::Action>
+SquelchSlots::remove (Peer::id_t peer)
+{
+    std::vector<Action> actions;
+
+    std::lock_guard lock (mutex_);
+    for (auto& [key, message] : messages_)
+        message.peers.erase (peer);
+
+    for (auto& [validator, slot] : slots_)
+    {
+        if (slot.sources.erase (peer) == 0)
+            continue;
+
+        // Without a selected source we have too few
+        if (slot.selected.erase (peer) != 0)
+            reset (validator, slot, true, actions);
+    }
+    return actions;
+}
+
+std::vector<SquelchSlots::Action>
+SquelchSlots::expire ()
+{
+    std::vector<Action> actions;
+    auto const now = clock_type::now ();
+
+    std::lock_guard lock (mutex_);
+    for (auto iter = messages_.begin (); iter != messages_.end ();)
+    {
+        if (now - iter->second.first > Tuning::squelchMessageAge)
+            iter = messages_.erase (iter);
+        else
+            ++iter;
+    }
+
+    for (auto iter = slots_.begin (); iter != slots_.end ();)
+    {
+        auto const& validator = iter->first;
+        auto& slot = iter->second;
+
+        if (! slot.selected.empty ())
+        {
+            // The squelches lapse on their own at the peers
+            if (now >= slot.expires)
+            {
+                reset (validator, slot, false, actions);
+            }
+            else if (std::any_of (slot.selected.begin (),
+                slot.selected.end (), [&](Peer::id_t id)
+                {
+                    return now - slot.sources[id].last >
+                        Tuning::squelchIdle;
+                }))
+            {
+                reset (validator, slot, true, actions);
+            }
+        }
+        else
+        {
+            // Forget sources that stopped relaying
+            for (auto s = slot.sources.begin (); s != slot.sources.end ();)
+            {
+                if (now - s->second.last > Tuning::squelchIdle)
+                    s = slot.sources.erase (s);
+                else
+                    ++s;
+            }
+        }
+
+        if (slot.sources.empty ())
+            iter = slots_.erase (iter);
+        else
+            ++iter;
+    }
+    return actions;
+}
+
+std::vector<Peer::id_t>
+SquelchSlots::selected (PublicKey const& validator)
+{
+    std::lock_guard lock (mutex_);
+    auto const iter = slots_.find (validator);
+    if (iter == slots_.end ())
+        return {};
+    return {iter->second.selected.begin (), iter->second.selected.end ()};
+}
+
+}
@@ -0,0 +1,174 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_OVERLAY_SQUELCH_H_INCLUDED
+#define RIPPLE_OVERLAY_SQUELCH_H_INCLUDED
+
+#include <ripple/basics/base_uint.h>
+#include <ripple/basics/UnorderedContainers.h>
+#include <ripple/overlay/Peer.h>
+#include <ripple/protocol/PublicKey.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace ripple {
+
+/** The validators a peer asked us to stop relaying.
+
+    Each squelch lapses on its own once its duration passes.
+    Thread safe.
+*/
+class Squelch
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    /** Stop relaying a validator's messages for a while.
+
+        @return `false` if the duration is out of range.
+    */
+    bool
+    squelch (PublicKey const& validator, std::chrono::seconds duration);
+
+    /** Resume relaying a validator's messages. */
+    void
+    unsquelch (PublicKey const& validator);
+
+    /** Returns `true` if a validator's messages are not to be relayed. */
+    bool
+    isSquelched (PublicKey const& validator);
+
+private:
+    std::mutex mutex_;
+    hash_map<PublicKey, clock_type::time_point> expires_;
+};
+
+//------------------------------------------------------------------------------
+
+/** Chooses which peers relay each trusted validator's messages to us.
+
+    Every peer that relays a message from a validator, first or as a
+    duplicate, is counted once as a source of that validator, but only
+    after the message was verified and relayed by us. Once enough
+    sources have relayed enough messages, a few are selected and the
+    rest are squelched, for a random time. If a selected source goes
+    silent or disconnects, the others are unsquelched and counting
+    starts over. Thread safe.
+*/
+class SquelchSlots
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    /** A squelch message to send to a peer. */
+    struct Action
+    {
+        Peer::id_t peer;
+        PublicKey validator;
+        bool squelch;
+        std::chrono::seconds duration;
+    };
+
+    /** Note a copy of a validator's message relayed by a peer.
+
+        The peer is counted once the message is verified.
+
+        @param key The message's suppression hash.
+        @return The squelch messages to send.
+    */
+    std::vector<Action>
+    update (PublicKey const& validator, uint256 const& key, Peer::id_t peer);
+
+    /** Note that a validator's message was verified and relayed.
+
+        Every peer that relayed it so far is counted.
+
+        @param key The message's suppression hash.
+        @return The squelch messages to send.
+    */
+    std::vector<Action>
+    verified (PublicKey const& validator, uint256 const& key);
+
+    /** Forget a peer that disconnected.
+
+        @return The squelch messages to send.
+    */
+    std::vector<Action>
+    remove (Peer::id_t peer);
+
+    /** Start over where squelches lapsed or selected sources went idle.
+
+        Called about once a second.
+
+        @return The squelch messages to send.
+    */
+    std::vector<Action>
+    expire ();
+
+    /** Returns the peers selected as sources of a validator. */
+    std::vector<Peer::id_t>
+    selected (PublicKey const& validator);
+
+private:
+    struct Source
+    {
+        std::uint32_t count = 0;
+        clock_type::time_point last;
+        bool squelched = false;
+    };
+
+    struct Slot
+    {
+        hash_map<Peer::id_t, Source> sources;
+
+        // Empty while counting
+        hash_set<Peer::id_t> selected;
+
+        // When the squelches lapse
+        clock_type::time_point expires;
+    };
+
+    // The peers that relayed one message
+    struct Relayed
+    {
+        hash_set<Peer::id_t> peers;
+        clock_type::time_point first;
+        bool verified = false;
+    };
+
+    // Count a verified message relayed by a source
+    void
+    count (PublicKey const& validator, Peer::id_t peer,
+        clock_type::time_point now, std::vector<Action>& actions);
+
+    // Go back to counting, unsquelching the squelched sources if asked
+    static
+    void
+    reset (PublicKey const& validator, Slot& slot,
+        bool unsquelch, std::vector<Action>& actions);
+
+    std::mutex mutex_;
+    hash_map<PublicKey, Slot> slots_;
+    hash_map<uint256, Relayed> messages_;
+};
+
+}
+
+#endif
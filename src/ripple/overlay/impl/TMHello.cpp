@@ -25,6 +25,7 @@
 #include <ripple/beast/rfc2616.h>
 #include <ripple/beast/core/LexicalCast.h>
 #include <ripple/protocol/digest.h>
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/regex.hpp>
 #include <algorithm>
 
@@ -177,6 +178,27 @@ appendHello (boost::beast::http::fields& h,
         h.insert ("Remote-IP", hello.remote_ip_str());
 }
 
+bool
+isCompressionOffered (boost::beast::http::fields const& h)
+{
+    auto const iter = h.find ("Compression");
+    if (iter == h.end())
+        return false;
+    auto const list = beast::rfc2616::split_commas(iter->value());
+    return std::any_of (list.begin(), list.end(),
+        [](std::string const& s)
+        {
+            return boost::iequals (s, "lz4");
+        });
+}
+
+bool
+isTxBatchOffered (boost::beast::http::fields const& h)
+{
+    auto const iter = h.find ("Tx-Batch");
+    return iter != h.end() && iter->value() == "1";
+}
+
 std::vector<ProtocolVersion>
 parse_ProtocolVersions(boost::beast::string_view const& value)
 {
@@ -76,6 +76,18 @@ verifyHello (protocol::TMHello const& h, uint256 const& sharedValue,
     beast::IP::Endpoint remote,
     beast::Journal journal, Application& app);
 
+/** Returns `true` if the handshake headers offer LZ4 compression
+    of protocol messages.
+*/
+bool
+isCompressionOffered (boost::beast::http::fields const& h);
+
+/** Returns `true` if the handshake headers offer to accept
+    batches of transactions in one message.
+*/
+bool
+isTxBatchOffered (boost::beast::http::fields const& h);
+
 /** Parse a set of protocol versions.
     The returned list contains no duplicates and is sorted ascending.
     Any strings that are not parseable as RTXP protocol strings are
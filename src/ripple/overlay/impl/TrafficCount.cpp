@@ -38,7 +38,8 @@ TrafficCount::category TrafficCount::categorize (
 
     if ((type == protocol::mtENDPOINTS) ||
             (type == protocol::mtPEERS) ||
-            (type == protocol::mtGET_PEERS))
+            (type == protocol::mtGET_PEERS) ||
+            (type == protocol::mtSQUELCH))
         return TrafficCount::category::overlay;
 
     if ((type == protocol::mtGET_SHARD_INFO) ||
@@ -50,6 +51,9 @@ TrafficCount::category TrafficCount::categorize (
     if (type == protocol::mtTRANSACTION)
         return TrafficCount::category::transaction;
 
+    if (type == protocol::mtTRANSACTIONS)
+        return TrafficCount::category::transaction_batch;
+
     if (type == protocol::mtVALIDATION)
         return TrafficCount::category::validation;
 
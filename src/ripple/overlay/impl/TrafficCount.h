@@ -42,6 +42,10 @@ public:
         std::atomic<std::uint64_t> messagesIn {0};
         std::atomic<std::uint64_t> messagesOut {0};
 
+        // Bytes compression kept off the wire
+        std::atomic<std::uint64_t> bytesSavedIn {0};
+        std::atomic<std::uint64_t> bytesSavedOut {0};
+
         TrafficStats(char const* n)
             : name (n)
         {
@@ -53,6 +57,8 @@ public:
             , bytesOut (ts.bytesOut.load())
             , messagesIn (ts.messagesIn.load())
             , messagesOut (ts.messagesOut.load())
+            , bytesSavedIn (ts.bytesSavedIn.load())
+            , bytesSavedOut (ts.bytesSavedOut.load())
         {
         }
 
@@ -73,6 +79,7 @@ public:
         overlay,        // overlay management
         manifests,      // manifest management
         transaction,
+        transaction_batch,  // TMTransactions, one per batch
         proposal,
         validation,
         shards,         // shard-related traffic
@@ -149,19 +156,24 @@ public:
         ::google::protobuf::Message const& message,
         int type, bool inbound);
 
-    /** Account for traffic associated with the given category */
-    void addCount (category cat, bool inbound, int bytes)
+    /** Account for traffic associated with the given category
+
+        @param saved The bytes compression kept off the wire.
+    */
+    void addCount (category cat, bool inbound, int bytes, int saved = 0)
     {
         assert (cat <= category::unknown);
 
         if (inbound)
         {
             counts_[cat].bytesIn += bytes;
+            counts_[cat].bytesSavedIn += saved;
             ++counts_[cat].messagesIn;
         }
         else
         {
             counts_[cat].bytesOut += bytes;
+            counts_[cat].bytesSavedOut += saved;
             ++counts_[cat].messagesOut;
         }
     }
@@ -186,6 +198,7 @@ protected:
         { "overhead: overlay" },                                  // category::overlay
         { "overhead: manifest" },                                 // category::manifests
         { "transactions" },                                       // category::transaction
+        { "transactions: batched" },                              // category::transaction_batch
         { "proposals" },                                          // category::proposal
         { "validations" },                                        // category::validation
         { "shards" },                                             // category::shards
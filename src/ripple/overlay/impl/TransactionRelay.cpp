@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/overlay/impl/TransactionRelay.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <algorithm>
+
+namespace ripple {
+
+TransactionRelay::TransactionRelay (Transactions const& txs)
+    : txs_ (txs)
+    , singles_ (txs.size ())
+{
+}
+
+std::vector<std::shared_ptr<Message>>
+TransactionRelay::messages (Peer::id_t peer, bool batch)
+{
+    std::vector<std::size_t> wanted;
+    for (std::size_t i = 0; i < txs_.size (); ++i)
+    {
+        if (txs_[i].second.count (peer) == 0)
+            wanted.push_back (i);
+    }
+
+    std::vector<std::shared_ptr<Message>> result;
+    if (batch && wanted.size () > 1)
+    {
+        for (std::size_t i = 0; i < wanted.size ();
+            i += Tuning::maxTransactionBatch)
+        {
+            std::vector<std::size_t> chunk (wanted.begin () + i,
+                wanted.begin () + std::min<std::size_t> (wanted.size (),
+                    i + Tuning::maxTransactionBatch));
+            auto& sm = batches_[chunk];
+            if (! sm)
+            {
+                protocol::TMTransactions m;
+                for (auto const j : chunk)
+                    *m.add_transactions () = txs_[j].first;
+                sm = std::make_shared<Message> (
+                    m, protocol::mtTRANSACTIONS);
+            }
+            result.push_back (sm);
+        }
+        return result;
+    }
+
+    for (auto const i : wanted)
+    {
+        if (! singles_[i])
+            singles_[i] = std::make_shared<Message> (
+                txs_[i].first, protocol::mtTRANSACTION);
+        result.push_back (singles_[i]);
+    }
+    return result;
+}
+
+}
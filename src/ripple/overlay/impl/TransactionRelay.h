@@ -0,0 +1,67 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_OVERLAY_TRANSACTIONRELAY_H_INCLUDED
+#define RIPPLE_OVERLAY_TRANSACTIONRELAY_H_INCLUDED
+
+#include <ripple/overlay/Message.h>
+#include <ripple/overlay/Peer.h>
+#include <ripple/protocol/messages.h>
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace ripple {
+
+/** Builds the messages that relay transactions to each peer.
+
+    Peers that accept batches get the transactions they lack in as few
+    TMTransactions messages as possible, the rest get one TMTransaction
+    each. Peers mostly lack the same transactions, so each distinct
+    selection is serialized once and shared.
+*/
+class TransactionRelay
+{
+public:
+    using Transactions = std::vector<std::pair<
+        protocol::TMTransaction, std::set<Peer::id_t>>>;
+
+    /** Create the relay.
+
+        @param txs Each transaction with the peers that already have it.
+                   Must outlive the relay.
+    */
+    explicit
+    TransactionRelay (Transactions const& txs);
+
+    /** Returns the messages to send a peer. */
+    std::vector<std::shared_ptr<Message>>
+    messages (Peer::id_t peer, bool batch);
+
+private:
+    Transactions const& txs_;
+    std::vector<std::shared_ptr<Message>> singles_;
+    std::map<std::vector<std::size_t>, std::shared_ptr<Message>> batches_;
+};
+
+}
+
+#endif
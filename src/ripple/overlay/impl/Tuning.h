@@ -72,11 +72,43 @@ enum
 
     /** How often to log send queue size */
     sendQueueLogFreq    =    64,
+
+    /** How many messages a send queue holds before dropping
+        the least important */
+    sendQueueLimit      =   256,
+
+    /** How many normal messages we send for each bulk
+        message when both are waiting */
+    sendNormalWeight    =     4,
+
+    /** How many messages from a validator a peer must relay
+        before it can be selected as a source of them */
+    squelchMessageThreshold = 20,
+
+    /** How many peers we keep relaying each validator's messages */
+    squelchSelectedPeers =    5,
+
+    /** The most transactions relayed in one message */
+    maxTransactionBatch =   100,
+
+    /** The most received transactions waiting to be checked */
+    maxPendingTransactions = 250,
 };
 
 /** The threshold above which we treat a peer connection as high latency */
 std::chrono::milliseconds constexpr peerHighLatency{300};
 
+/** The shortest and longest time a squelch lasts */
+std::chrono::seconds constexpr squelchMinDuration{300};
+std::chrono::seconds constexpr squelchMaxDuration{600};
+
+/** How long a selected source can be silent before the
+    squelched peers are asked to relay again */
+std::chrono::seconds constexpr squelchIdle{8};
+
+/** How long copies of a validator's message are counted */
+std::chrono::seconds constexpr squelchMessageAge{30};
+
 } // Tuning
 
 } // ripple
@@ -18,7 +18,11 @@
 //==============================================================================
 
 #include <ripple/protocol/digest.h>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
 #include <type_traits>
+#include <vector>
 #include <openssl/ripemd.h>
 #include <openssl/sha.h>
 
@@ -112,4 +116,296 @@ openssl_sha256_hasher::operator result_type() noexcept
     return digest;
 }
 
+//------------------------------------------------------------------------------
+
+namespace detail {
+
+// Multi-buffer SHA-512: each 64-bit word of a vector register holds
+// the state of a different message, so one pass through the rounds
+// advances as many messages as there are lanes. Every message in a
+// pass must have the same number of padded blocks.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RIPPLE_SHA512_LANES 1
+#else
+#define RIPPLE_SHA512_LANES 0
+#endif
+
+static std::size_t constexpr sha512BlockSize = 128;
+
+static std::uint64_t const sha512K[80] =
+{
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL,
+    0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+    0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL,
+    0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
+    0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+    0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL, 0x2de92c6f592b0275ULL,
+    0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL,
+    0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+    0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL,
+    0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL,
+    0x92722c851482353bULL, 0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+    0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
+    0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL,
+    0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+    0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL,
+    0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL,
+    0xc67178f2e372532bULL, 0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+    0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL,
+    0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
+    0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+    0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+static std::uint64_t const sha512IV[8] =
+{
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL,
+    0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+// Number of blocks in a message after SHA-512 padding
+static
+std::size_t
+sha512Blocks (std::size_t size)
+{
+    return (size + 17 + sha512BlockSize - 1) / sha512BlockSize;
+}
+
+// Copies a message into out with SHA-512 padding applied
+static
+void
+sha512Pad (Slice const& message, std::uint8_t* out, std::size_t blocks)
+{
+    auto const total = blocks * sha512BlockSize;
+    if (! message.empty())
+        std::memcpy (out, message.data(), message.size());
+    out[message.size()] = 0x80;
+    std::memset (out + message.size() + 1, 0,
+        total - message.size() - 1);
+    std::uint64_t const bits = message.size() * 8;
+    for (int i = 0; i < 8; ++i)
+        out[total - 1 - i] = static_cast<std::uint8_t>(bits >> (8 * i));
+}
+
+#if RIPPLE_SHA512_LANES
+
+typedef std::uint64_t sha512x4 __attribute__ ((vector_size (32)));
+typedef std::uint64_t sha512x8 __attribute__ ((vector_size (64)));
+
+#define RIPPLE_SHA512_ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+// Hashes N padded messages of the given number of blocks. This is
+// only ever inlined into the target specific wrappers below, so the
+// vector code is generated for the instruction set they enable.
+template <class V, std::size_t N>
+static inline __attribute__ ((always_inline))
+void
+sha512Lanes (std::uint8_t const* const* data,
+    std::size_t blocks, uint256* const* digests)
+{
+    V state[8];
+    for (int i = 0; i < 8; ++i)
+        state[i] = V{} + sha512IV[i];
+
+    for (std::size_t b = 0; b < blocks; ++b)
+    {
+        V w[80];
+        for (int t = 0; t < 16; ++t)
+        {
+            for (std::size_t lane = 0; lane < N; ++lane)
+            {
+                std::uint64_t word;
+                std::memcpy (&word,
+                    data[lane] + b * sha512BlockSize + t * 8, sizeof(word));
+                w[t][lane] = __builtin_bswap64 (word);
+            }
+        }
+        for (int t = 16; t < 80; ++t)
+        {
+            V const s0 = RIPPLE_SHA512_ROTR(w[t - 15], 1) ^
+                RIPPLE_SHA512_ROTR(w[t - 15], 8) ^ (w[t - 15] >> 7);
+            V const s1 = RIPPLE_SHA512_ROTR(w[t - 2], 19) ^
+                RIPPLE_SHA512_ROTR(w[t - 2], 61) ^ (w[t - 2] >> 6);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        V a = state[0], b0 = state[1], c = state[2], d = state[3];
+        V e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int t = 0; t < 80; ++t)
+        {
+            V const s1 = RIPPLE_SHA512_ROTR(e, 14) ^
+                RIPPLE_SHA512_ROTR(e, 18) ^ RIPPLE_SHA512_ROTR(e, 41);
+            V const ch = (e & f) ^ (~e & g);
+            V const t1 = h + s1 + ch + sha512K[t] + w[t];
+            V const s0 = RIPPLE_SHA512_ROTR(a, 28) ^
+                RIPPLE_SHA512_ROTR(a, 34) ^ RIPPLE_SHA512_ROTR(a, 39);
+            V const maj = (a & b0) ^ (a & c) ^ (b0 & c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b0;
+            b0 = a;
+            a = t1 + s0 + maj;
+        }
+
+        state[0] += a;
+        state[1] += b0;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    // SHA512-Half keeps the first four words of the state
+    for (std::size_t lane = 0; lane < N; ++lane)
+    {
+        auto out = digests[lane]->data();
+        for (int i = 0; i < 4; ++i)
+        {
+            std::uint64_t const word = state[i][lane];
+            for (int j = 0; j < 8; ++j)
+                *out++ = static_cast<std::uint8_t>(word >> (56 - 8 * j));
+        }
+    }
+}
+
+#undef RIPPLE_SHA512_ROTR
+
+__attribute__ ((target ("avx2")))
+static
+void
+sha512Avx2 (std::uint8_t const* const* data,
+    std::size_t blocks, uint256* const* digests)
+{
+    sha512Lanes<sha512x4, 4> (data, blocks, digests);
+}
+
+__attribute__ ((target ("avx512f")))
+static
+void
+sha512Avx512 (std::uint8_t const* const* data,
+    std::size_t blocks, uint256* const* digests)
+{
+    sha512Lanes<sha512x8, 8> (data, blocks, digests);
+}
+
+#endif
+
+std::vector<sha512Kernel> const&
+sha512Kernels()
+{
+    static std::vector<sha512Kernel> const kernels = []
+    {
+        std::vector<sha512Kernel> result;
+#if RIPPLE_SHA512_LANES
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports ("avx512f"))
+            result.push_back ({"avx512f", 8, &sha512Avx512});
+        if (__builtin_cpu_supports ("avx2"))
+            result.push_back ({"avx2", 4, &sha512Avx2});
+#endif
+        return result;
+    }();
+    return kernels;
+}
+
+void
+sha512HalfMany (Slice const* messages, uint256* digests,
+    std::size_t count, sha512Kernel const* kernel)
+{
+    auto const lanes = kernel ? kernel->lanes : 1;
+    if (lanes < 2 || count < lanes / 2)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            digests[i] = sha512Half (messages[i]);
+        return;
+    }
+
+    // Group the messages by padded length, since every lane of
+    // a pass must process the same number of blocks.
+    std::vector<std::size_t> order (count);
+    std::iota (order.begin(), order.end(), 0);
+    std::stable_sort (order.begin(), order.end(),
+        [messages](std::size_t lhs, std::size_t rhs)
+        {
+            return sha512Blocks (messages[lhs].size()) <
+                sha512Blocks (messages[rhs].size());
+        });
+
+    std::vector<std::uint8_t> scratch;
+    std::vector<std::uint8_t const*> data (lanes);
+    std::vector<uint256*> out (lanes);
+    uint256 unused;
+
+    std::size_t i = 0;
+    while (i < count)
+    {
+        auto const blocks = sha512Blocks (messages[order[i]].size());
+        std::size_t n = 1;
+        while (n < lanes && i + n < count &&
+            sha512Blocks (messages[order[i + n]].size()) == blocks)
+        {
+            ++n;
+        }
+
+        // A mostly empty pass costs more than hashing the few
+        // messages in it one at a time.
+        if (n < lanes / 2)
+        {
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                digests[order[i + j]] =
+                    sha512Half (messages[order[i + j]]);
+            }
+            i += n;
+            continue;
+        }
+
+        auto const size = blocks * sha512BlockSize;
+        scratch.resize (n * size);
+        for (std::size_t j = 0; j < lanes; ++j)
+        {
+            if (j < n)
+            {
+                sha512Pad (messages[order[i + j]],
+                    scratch.data() + j * size, blocks);
+                data[j] = scratch.data() + j * size;
+                out[j] = &digests[order[i + j]];
+            }
+            else
+            {
+                // Idle lanes repeat the first message
+                data[j] = scratch.data();
+                out[j] = &unused;
+            }
+        }
+        kernel->hash (data.data(), blocks, out.data());
+        i += n;
+    }
+}
+
+} // detail
+
+void
+sha512HalfMany (Slice const* messages,
+    uint256* digests, std::size_t count)
+{
+    auto const& kernels = detail::sha512Kernels();
+    detail::sha512HalfMany (messages, digests, count,
+        kernels.empty() ? nullptr : &kernels.front());
+}
+
 } // ripple
@@ -142,6 +142,8 @@ JSS ( both );                       // in: Subscribe, Unsubscribe
 JSS ( both_sides );                 // in: Subscribe, Unsubscribe
 JSS ( build_path );                 // in: TransactionSign
 JSS ( build_version );              // out: NetworkOPs
+JSS ( bytes );                      // out: GetCounts, CrawlShards
+JSS ( bytes_per_second );           // out: GetCounts, CrawlShards
 JSS ( cancel_after );               // out: AccountChannels
 JSS ( can_delete );                 // out: CanDelete
 JSS ( channel_id );                 // out: AccountChannels
@@ -188,6 +190,7 @@ JSS ( delivered_amount );           // out: insertDeliveredAmount
 JSS ( deposit_authorized );         // out: deposit_authorized
 JSS ( deposit_preauth );            // in: AccountObjects, LedgerData
 JSS ( deprecated );                 // out
+JSS ( depth );                      // out: PeerImp
 JSS ( descending );                 // in: AccountTx*
 JSS ( description );                // in/out: Reservations
 JSS ( destination_account );        // in: PathRequest, RipplePathFind, account_lines
@@ -200,6 +203,7 @@ JSS ( dir_entry );                  // out: DirectoryEntryIterator
 JSS ( dir_index );                  // out: DirectoryEntryIterator
 JSS ( dir_root );                   // out: DirectoryEntryIterator
 JSS ( directory );                  // in: LedgerEntry
+JSS ( dropped );                    // out: PeerImp
 JSS ( drops );                      // out: TxQ
 JSS ( duration_us );                // out: NetworkOPs
 JSS ( enabled );                    // out: AmendmentTable
@@ -221,12 +225,15 @@ JSS ( failed );                     // out: InboundLedger
 JSS ( feature );                    // in: Feature
 JSS ( features );                   // out: Feature
 JSS ( fee );                        // out: NetworkOPs, Peers
+JSS ( false_positive_rate );        // out: NetworkOPs
+JSS ( false_positives );            // out: NetworkOPs
 JSS ( fee_base );                   // out: NetworkOPs
 JSS ( fee_div_max );                // in: TransactionSign
 JSS ( fee_level );                  // out: AccountInfo
 JSS ( fee_mult_max );               // in: TransactionSign
 JSS ( fee_ref );                    // out: NetworkOPs
 JSS ( fetch_pack );                 // out: NetworkOPs
+JSS ( fetch_pack_perminute );       // out: GetCounts
 JSS ( first );                      // out: rpc/Version
 JSS ( finished );
 JSS ( fix_txns );                   // in: LedgerCleaner
@@ -253,8 +260,10 @@ JSS ( hotwallet );                  // in: GatewayBalances
 JSS ( id );                         // websocket.
 JSS ( ident );                      // in: AccountCurrencies, AccountInfo,
                                     //     OwnerInfo
+JSS ( in_progress );                // out: GetCounts, CrawlShards
 JSS ( inLedger );                   // out: tx/Transaction
 JSS ( inbound );                    // out: PeerImp
+JSS ( incremental );                // out: GetCounts
 JSS ( index );                      // in: LedgerEntry, DownloadShard
                                     // out: PathState, STLedgerEntry,
                                     //      LedgerEntry, TxHistory, LedgerData
@@ -299,6 +308,7 @@ JSS ( ledger_index_min );           // in, out: AccountTx*
 JSS ( ledger_max );                 // in, out: AccountTx*
 JSS ( ledger_min );                 // in, out: AccountTx*
 JSS ( ledger_time );                // out: NetworkOPs
+JSS ( ledgers );                    // out: GetCounts, CrawlShards
 JSS ( levels );                     // LogLevels
 JSS ( limit );                      // in/out: AccountTx*, AccountOffers,
                                     //         AccountLines, AccountObjects
@@ -357,9 +367,11 @@ JSS ( no_ripple );                  // out: AccountLines
 JSS ( no_ripple_peer );             // out: AccountLines
 JSS ( node );                       // out: LedgerEntry
 JSS ( node_binary );                // out: LedgerEntry
+JSS ( node_filter );                // out: NetworkOPs
 JSS ( node_hit_rate );              // out: GetCounts
 JSS ( node_read_bytes );            // out: GetCounts
 JSS ( node_reads_hit );             // out: GetCounts
+JSS ( node_reads_shared );          // out: GetCounts
 JSS ( node_reads_total );           // out: GetCounts
 JSS ( node_writes );                // out: GetCounts
 JSS ( node_written_bytes );         // out: GetCounts
@@ -369,6 +381,7 @@ JSS ( offer );                      // in: LedgerEntry
 JSS ( offers );                     // out: NetworkOPs, AccountOffers, Subscribe
 JSS ( offline );                    // in: TransactionSign
 JSS ( offset );                     // in/out: AccountTxOld
+JSS ( online_delete );              // out: GetCounts
 JSS ( open );                       // out: handlers/Ledger
 JSS ( open_ledger_fee );            // out: TxQ
 JSS ( open_ledger_level );          // out: TxQ
@@ -377,6 +390,8 @@ JSS ( owner_funds );                // in/out: Ledger, NetworkOPs, AcceptedLedge
 JSS ( params );                     // RPC
 JSS ( parent_close_time );          // out: LedgerToJson
 JSS ( parent_hash );                // out: LedgerToJson
+JSS ( parsed_SLE_hit_rate );        // out: GetCounts.
+JSS ( parsed_SLE_size );            // out: GetCounts.
 JSS ( partition );                  // in: LogLevel
 JSS ( passphrase );                 // in: WalletPropose
 JSS ( password );                   // in: Subscribe
@@ -419,6 +434,7 @@ JSS ( receive_currencies );         // out: AccountCurrencies
 JSS ( reference_level );            // out: TxQ
 JSS ( refresh_interval_min );       // out: ValidatorSites
 JSS ( regular_seed );               // in/out: LedgerEntry
+JSS ( rejected );                   // out: NetworkOPs
 JSS ( remote );                     // out: Logic.h
 JSS ( request );                    // RPC
 JSS ( reservations );               // out: Reservations
@@ -444,6 +460,7 @@ JSS ( seed );                       //
 JSS ( seed_hex );                   // in: WalletPropose, TransactionSign
 JSS ( send_currencies );            // out: AccountCurrencies
 JSS ( send_max );                   // in: PathRequest, RipplePathFind
+JSS ( send_queue );                 // out: PeerImp
 JSS ( seq );                        // in: LedgerEntry;
                                     // out: NetworkOPs, RPCSub, AccountOffers,
                                     //      ValidatorList
@@ -454,6 +471,7 @@ JSS ( server_status );              // out: NetworkOPs
 JSS ( settle_delay );               // out: AccountChannels
 JSS ( severity );                   // in: LogLevel
 JSS ( shards );                     // in/out: GetCounts, DownloadShard
+JSS ( shard_progress );             // out: GetCounts, CrawlShards
 JSS ( signature );                  // out: NetworkOPs, ChannelAuthorize
 JSS ( signature_verified );         // out: ChannelVerify
 JSS ( signing_key );                // out: NetworkOPs
@@ -487,6 +505,7 @@ JSS ( taker_gets );                 // in: Subscribe, Unsubscribe, BookOffers
 JSS ( taker_gets_funded );          // out: NetworkOPs
 JSS ( taker_pays );                 // in: Subscribe, Unsubscribe, BookOffers
 JSS ( taker_pays_funded );          // out: NetworkOPs
+JSS ( threads );                    // out: GetCounts, CrawlShards
 JSS ( threshold );                  // in: Blacklist
 JSS ( ticket );                     // in: AccountObjects
 JSS ( time );
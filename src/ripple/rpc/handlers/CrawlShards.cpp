@@ -70,6 +70,7 @@ doCrawlShards(RPC::Context& context)
             jvResult[jss::public_key] = toBase58(
                 TokenType::NodePublic, context.app.nodeIdentity().first);
         jvResult[jss::complete_shards] = shardStore->getCompleteShards();
+        jvResult[jss::shard_progress] = shardStore->getShardProgress();
     }
 
     if (hops == 0)
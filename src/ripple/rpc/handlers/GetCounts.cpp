@@ -20,8 +20,10 @@
 #include <ripple/app/ledger/AcceptedLedger.h>
 #include <ripple/app/ledger/InboundLedgers.h>
 #include <ripple/app/ledger/LedgerMaster.h>
+#include <ripple/app/ledger/ParsedSLECache.h>
 #include <ripple/app/main/Application.h>
 #include <ripple/app/misc/NetworkOPs.h>
+#include <ripple/app/misc/SHAMapStore.h>
 #include <ripple/basics/UptimeClock.h>
 #include <ripple/core/DatabaseCon.h>
 #include <ripple/json/json_value.h>
@@ -94,7 +96,12 @@ Json::Value getCountsJson(Application& app, int minObjectCount)
 
     ret[jss::historical_perminute] = static_cast<int>(
         app.getInboundLedgers().fetchRate());
+    ret[jss::fetch_pack_perminute] = static_cast<int>(
+        app.getLedgerMaster().getFetchPackRate());
     ret[jss::SLE_hit_rate] = app.cachedSLEs().rate();
+    ret[jss::parsed_SLE_hit_rate] = app.parsedSLEs().rate();
+    ret[jss::parsed_SLE_size] = static_cast<Json::UInt>(
+        app.parsedSLEs().size());
     ret[jss::node_hit_rate] = app.getNodeStore ().getCacheHitRate ();
     ret[jss::ledger_hit_rate] = app.getLedgerMaster ().getCacheHitRate ();
     ret[jss::AL_hit_rate] = app.getAcceptedLedgerCache ().getHitRate ();
@@ -116,9 +123,14 @@ Json::Value getCountsJson(Application& app, int minObjectCount)
     ret[jss::node_writes] = app.getNodeStore().getStoreCount();
     ret[jss::node_reads_total] = app.getNodeStore().getFetchTotalCount();
     ret[jss::node_reads_hit] = app.getNodeStore().getFetchHitCount();
+    ret[jss::node_reads_shared] = app.getNodeStore().getFetchSharedCount();
     ret[jss::node_written_bytes] = app.getNodeStore().getStoreSize();
     ret[jss::node_read_bytes] = app.getNodeStore().getFetchSize();
 
+    auto rotation = app.getSHAMapStore().getRotationStats();
+    if (! rotation.isNull())
+        ret[jss::online_delete] = std::move(rotation);
+
     if (auto shardStore = app.getShardStore())
     {
         Json::Value& jv = (ret[jss::shards] = Json::objectValue);
@@ -133,8 +145,10 @@ Json::Value getCountsJson(Application& app, int minObjectCount)
         jv[jss::node_writes] = shardStore->getStoreCount();
         jv[jss::node_reads_total] = shardStore->getFetchTotalCount();
         jv[jss::node_reads_hit] = shardStore->getFetchHitCount();
+        jv[jss::node_reads_shared] = shardStore->getFetchSharedCount();
         jv[jss::node_written_bytes] = shardStore->getStoreSize();
         jv[jss::node_read_bytes] = shardStore->getFetchSize();
+        jv[jss::shard_progress] = shardStore->getShardProgress();
     }
 
     return ret;
@@ -22,6 +22,7 @@
 
 #include <ripple/basics/Log.h>
 #include <ripple/shamap/FullBelowCache.h>
+#include <ripple/shamap/SHAMapWorkers.h>
 #include <ripple/shamap/TreeNodeCache.h>
 #include <ripple/nodestore/Database.h>
 #include <ripple/beast/utility/Journal.h>
@@ -29,6 +30,8 @@
 
 namespace ripple {
 
+class ParsedSLECache;
+
 class Family
 {
 public:
@@ -66,6 +69,16 @@ public:
     bool
     isShardBacked() const = 0;
 
+    /** Returns the threads the family's maps walk and flush with. */
+    virtual
+    SHAMapWorkers&
+    workers() = 0;
+
+    /** Returns the cache of parsed ledger entries, if any. */
+    virtual
+    ParsedSLECache*
+    parsedSLEs() = 0;
+
     virtual
     void
     missing_node (std::uint32_t refNum) = 0;
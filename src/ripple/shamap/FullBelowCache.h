@@ -23,7 +23,9 @@
 #include <ripple/basics/base_uint.h>
 #include <ripple/basics/KeyCache.h>
 #include <ripple/beast/insight/Collector.h>
+#include <array>
 #include <atomic>
+#include <memory>
 #include <string>
 
 namespace ripple {
@@ -32,6 +34,9 @@ namespace detail {
 
 /** Remembers which tree keys have all descendants resident.
     This optimizes the process of acquiring a complete tree.
+
+    Keys are spread over several independently locked caches so that
+    concurrent lookups during sync rarely contend.
 */
 template <class Key>
 class BasicFullBelowCache
@@ -45,6 +50,9 @@ public:
          defaultCacheTargetSize = 0
     };
 
+    /** The number of independently locked stripes. */
+    static std::size_t constexpr stripeCount = 16;
+
     using key_type   = Key;
     using size_type  = typename CacheType::size_type;
     using clock_type = typename CacheType::clock_type;
@@ -61,16 +69,20 @@ public:
             beast::insight::NullCollector::New (),
         std::size_t target_size = defaultCacheTargetSize,
         std::chrono::seconds expiration = std::chrono::minutes{2})
-        : m_cache (name, clock, collector, target_size,
-            expiration)
+        : m_stats (name,
+            std::bind (&BasicFullBelowCache::collect_metrics, this),
+                collector)
         , m_gen (1)
     {
+        for (auto& cache : m_caches)
+            cache = std::make_unique <CacheType> (name, clock,
+                (target_size + stripeCount - 1) / stripeCount, expiration);
     }
 
     /** Return the clock associated with the cache. */
     clock_type& clock()
     {
-        return m_cache.clock ();
+        return m_caches.front()->clock ();
     }
 
     /** Return the number of elements in the cache.
@@ -79,7 +91,10 @@ public:
     */
     size_type size () const
     {
-        return m_cache.size ();
+        size_type size = 0;
+        for (auto const& cache : m_caches)
+            size += cache->size ();
+        return size;
     }
 
     /** Remove expired cache items.
@@ -88,7 +103,9 @@ public:
     */
     void sweep ()
     {
-        m_cache.sweep ();
+        // One stripe at a time, so lookups in the others proceed
+        for (auto& cache : m_caches)
+            cache->sweep ();
     }
 
     /** Refresh the last access time of an item, if it exists.
@@ -99,7 +116,13 @@ public:
     */
     bool touch_if_exists (key_type const& key)
     {
-        return m_cache.touch_if_exists (key);
+        if (stripeFor (key).touch_if_exists (key))
+        {
+            m_hits.fetch_add (1, std::memory_order_relaxed);
+            return true;
+        }
+        m_misses.fetch_add (1, std::memory_order_relaxed);
+        return false;
     }
 
     /** Insert a key into the cache.
@@ -111,7 +134,7 @@ public:
     */
     void insert (key_type const& key)
     {
-        m_cache.insert (key);
+        stripeFor (key).insert (key);
     }
 
     /** generation determines whether cached entry is valid */
@@ -122,19 +145,58 @@ public:
 
     void clear ()
     {
-        m_cache.clear ();
+        for (auto& cache : m_caches)
+            cache->clear ();
         ++m_gen;
     }
 
     void reset ()
     {
-        m_cache.clear();
+        for (auto& cache : m_caches)
+            cache->clear ();
         m_gen  = 1;
     }
 
 private:
-    KeyCache <Key> m_cache;
+    CacheType& stripeFor (key_type const& key)
+    {
+        // Tree node hashes are uniformly distributed
+        return *m_caches[static_cast<std::size_t> (
+            *key.begin()) % stripeCount];
+    }
+
+    void collect_metrics ()
+    {
+        m_stats.size.set (size ());
+
+        beast::insight::Gauge::value_type hit_rate (0);
+        auto const hits = m_hits.load (std::memory_order_relaxed);
+        auto const total = hits + m_misses.load (std::memory_order_relaxed);
+        if (total != 0)
+            hit_rate = (hits * 100) / total;
+        m_stats.hit_rate.set (hit_rate);
+    }
+
+    struct Stats
+    {
+        template <class Handler>
+        Stats (std::string const& prefix, Handler const& handler,
+            beast::insight::Collector::ptr const& collector)
+            : hook (collector->make_hook (handler))
+            , size (collector->make_gauge (prefix, "size"))
+            , hit_rate (collector->make_gauge (prefix, "hit_rate"))
+            { }
+
+        beast::insight::Hook hook;
+        beast::insight::Gauge size;
+        beast::insight::Gauge hit_rate;
+    };
+
+    Stats m_stats;
+    std::array <std::unique_ptr <CacheType>, stripeCount> m_caches;
     std::atomic <std::uint32_t> m_gen;
+    std::atomic <std::uint64_t> m_hits {0};
+    std::atomic <std::uint64_t> m_misses {0};
 };
 
 } // detail
@@ -36,7 +36,9 @@
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/shared_lock_guard.hpp>
 #include <boost/thread/shared_mutex.hpp>
+#include <atomic>
 #include <cassert>
+#include <functional>
 #include <stack>
 #include <vector>
 
@@ -94,6 +96,9 @@ public:
                                 std::shared_ptr<SHAMapItem const>>;
     using Delta     = std::map<uint256, DeltaItem>;
 
+    /** Receives one difference between two maps, keyed by item. */
+    using DeltaSink = std::function<void (uint256 const&, DeltaItem&&)>;
+
     ~SHAMap ();
     SHAMap(SHAMap const&) = delete;
     SHAMap& operator=(SHAMap const&) = delete;
@@ -188,6 +193,20 @@ public:
     void visitDifferences(SHAMap const* have,
         std::function<bool (SHAMapAbstractNode&)>) const;
 
+    /**  Visit every node in this SHAMap that is not present in the
+         specified SHAMap, descending differing branches on several
+         threads.
+
+         Every node is visited before its children, but otherwise in
+         no particular order. function may be called from any of the
+         threads, but is never called concurrently.
+
+         @param function called with every node visited.
+         If function returns false, visitDifferencesParallel exits.
+    */
+    void visitDifferencesParallel(SHAMap const* have,
+        std::function<bool (SHAMapAbstractNode&)> const& function) const;
+
     /**  Visit every leaf node in this SHAMap
 
          @param function called with every non inner node visited.
@@ -222,6 +241,17 @@ public:
     SHAMapAddNode addKnownNode (SHAMapNodeID const& nodeID, Slice const& rawNode,
                                 SHAMapSyncFilter * filter);
 
+    /** Add several non-root nodes received from a peer.
+
+        Behaves like calling addKnownNode on each node in order, except
+        that the nodes are decoded up front and their hashes computed
+        together. Stops at the first invalid node. If a node cannot be
+        decoded, the nodes before it are added and the error rethrown.
+    */
+    SHAMapAddNode addKnownNodes (
+        std::vector<std::pair<SHAMapNodeID, Slice>> const& nodes,
+            SHAMapSyncFilter * filter);
+
 
     // status functions
     void setImmutable ();
@@ -235,7 +265,52 @@ public:
     bool compare (SHAMap const& otherMap,
                   Delta& differences, int maxCount) const;
 
+    /** Compare two maps, passing each difference to sink.
+
+        Differing branches below the top two levels are descended on
+        several threads when there are enough of them. sink may be
+        called from any of the threads, but is never called
+        concurrently. Stops after maxCount differences.
+
+        @return true if every difference was passed to sink.
+    */
+    bool compare (SHAMap const& otherMap,
+                  DeltaSink const& sink, int maxCount) const;
+
     int flushDirty (NodeObjectType t, std::uint32_t seq);
+
+    /** Set the most threads flushing the dirty nodes of one map.
+
+        Subtrees below the top two levels are hashed and written in
+        parallel. The default is the number of hardware threads, up
+        to four. Returns the previous setting.
+    */
+    static std::size_t setFlushThreads (std::size_t threads);
+
+    /** Set the most threads walking one map.
+
+        walkMap and deepCompare split the tree below its top two levels
+        into as many as 256 subtrees and walk them in parallel. Walks
+        mostly wait on the node store, so the default is the number of
+        hardware threads, at least four and at most sixteen. Returns the
+        previous setting.
+    */
+    static std::size_t setWalkThreads (std::size_t threads);
+    static std::size_t getWalkThreads ();
+
+    /** Set the most node store reads getMissingNodes keeps in flight.
+
+        The traversal posts reads for absent nodes and carries on
+        elsewhere in the tree, processing reads as they finish. Zero,
+        the default, uses the number the node store prefers. Returns
+        the previous setting.
+    */
+    static std::size_t setMissingReads (std::size_t reads);
+
+    /** Walk the whole map, collecting the nodes missing from it.
+
+        Stops once maxMissing nodes are found.
+    */
     void walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissing) const;
     bool deepCompare (SHAMap & other) const;  // Intended for debug/test only
 
@@ -256,6 +331,9 @@ private:
     using DeltaRef = std::pair<std::shared_ptr<SHAMapItem const> const&,
                                std::shared_ptr<SHAMapItem const> const&>;
 
+    // Records a difference, returning false once no more are wanted
+    using DeltaReport = std::function<bool (DeltaRef)>;
+
      // tree node cache operations
     std::shared_ptr<SHAMapAbstractNode> getCache (SHAMapHash const& hash) const;
     void canonicalize (SHAMapHash const& hash, std::shared_ptr<SHAMapAbstractNode>&) const;
@@ -297,6 +375,17 @@ private:
         writeNode(NodeObjectType t, std::uint32_t seq,
                   std::shared_ptr<SHAMapAbstractNode> node) const;
 
+    /** write and canonicalize a node whose snfPREFIX form is raw */
+    std::shared_ptr<SHAMapAbstractNode>
+        writeNode(NodeObjectType t, std::uint32_t seq,
+                  std::shared_ptr<SHAMapAbstractNode> node, Blob&& raw) const;
+
+    /** hook a decoded node received from a peer into the map; raw is
+        its snfPREFIX form, or empty if it has not been serialized */
+    SHAMapAddNode addKnownNode (SHAMapNodeID const& nodeID,
+        std::shared_ptr<SHAMapAbstractNode> newNode, Blob&& raw,
+            SHAMapSyncFilter * filter);
+
     SHAMapTreeNode* firstBelow (std::shared_ptr<SHAMapAbstractNode>,
                                 SharedPtrNodeStack& stack, int branch = 0) const;
 
@@ -315,6 +404,10 @@ private:
         descend (SHAMapInnerNode* parent, SHAMapNodeID const& parentID,
         int branch, SHAMapSyncFilter* filter) const;
 
+    // Fetch the absent children of an inner node from the database
+    // in one batch and hook them to the parent
+    void descendBatch (SHAMapInnerNode* parent) const;
+
     // Non-storing
     // Does not hook the returned node to its parent
     std::shared_ptr<SHAMapAbstractNode>
@@ -330,8 +423,56 @@ private:
     SHAMapTreeNode const* peekNextItem(uint256 const& id, SharedPtrNodeStack& stack) const;
     bool walkBranch (SHAMapAbstractNode* node,
                      std::shared_ptr<SHAMapItem const> const& otherMapItem,
-                     bool isFirstMap, Delta & differences, int & maxCount) const;
+                     bool isFirstMap, DeltaReport const& report) const;
     int walkSubTree (bool doWrite, NodeObjectType t, std::uint32_t seq);
+    std::shared_ptr<SHAMapInnerNode>
+        flushSubTree (std::shared_ptr<SHAMapInnerNode> node, bool doWrite,
+            NodeObjectType t, std::uint32_t seq, int& flushed) const;
+    std::shared_ptr<SHAMapInnerNode>
+        flushParallel (std::shared_ptr<SHAMapInnerNode> root,
+            std::size_t threads, bool doWrite, NodeObjectType t,
+                std::uint32_t seq, int& flushed) const;
+
+    // Subtrees to flush per helper thread
+    static constexpr std::size_t minFlushTasks = 32;
+
+    // Run task(0) through task(count - 1) on this thread and up to
+    // helpers threads of the family. A task returns false to stop the
+    // tasks not yet started. Rethrows the first exception a task throws.
+    void runParallel (std::size_t count, std::size_t helpers,
+        std::function<bool(std::size_t)> const& task) const;
+
+    // Walk the subtree below node, collecting missing nodes while
+    // the shared budget lasts
+    void walkSubMap (std::shared_ptr<SHAMapInnerNode> const& node,
+        std::vector<SHAMapMissingNode>& missingNodes,
+            std::atomic<int>& budget) const;
+
+    // Compare a node of this map with the same node of other,
+    // adding their children to compare to nodes
+    using NodePair = std::pair<SHAMapAbstractNode*, SHAMapAbstractNode*>;
+    bool compareNodes (SHAMapAbstractNode* node, SHAMapAbstractNode* otherNode,
+        SHAMap& other, std::vector<NodePair>& nodes) const;
+
+    // Report the differences between a node of this map and the node
+    // in the same position of otherMap, adding the differing inner
+    // children still to compare to nodes
+    bool compareBranch (SHAMapAbstractNode* ourNode, SHAMapAbstractNode* otherNode,
+        SHAMap const& otherMap, DeltaReport const& report,
+            std::vector<NodePair>& nodes) const;
+
+    // Visit an inner node not present in have and its children not
+    // present in have, adding the inner children to visit to nodes
+    using VisitEntry = std::pair<SHAMapInnerNode*, SHAMapNodeID>;
+    bool visitDifferent (SHAMapInnerNode* node, SHAMapNodeID const& nodeID,
+        SHAMap const* have, std::function<bool (SHAMapAbstractNode&)> const& function,
+            std::vector<VisitEntry>& nodes) const;
+
+    // Differing subtrees to compare per helper thread
+    static constexpr std::size_t minWalkTasks = 16;
+
+    // Inner nodes of a level hashed together while flushing
+    static constexpr std::size_t flushBatchSize = 256;
 
     // Structure to track information about call to
     // getMissingNodes while it's in progress
@@ -366,8 +507,10 @@ private:
         // std::vector, can't be used here.
         std::stack <StackEntry, std::deque<StackEntry>> stack_;
 
-        // nodes we may acquire from deferred reads
+        // nodes we may acquire from deferred reads, which
+        // are processed as they finish
         std::vector <std::tuple <SHAMapInnerNode*, SHAMapNodeID, int>> deferredReads_;
+        std::set <SHAMapHash>                                          deferredHashes_;
 
         // nodes we need to resume after we get their children from deferred reads
         std::map<SHAMapInnerNode*, SHAMapNodeID> resumes_;
@@ -22,34 +22,64 @@
 
 #include <ripple/basics/base_uint.h>
 #include <ripple/basics/Blob.h>
+#include <ripple/basics/SlabAllocator.h>
 #include <ripple/basics/Slice.h>
 #include <ripple/protocol/Serializer.h>
 #include <ripple/beast/utility/Journal.h>
 
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
 
 namespace ripple {
 
+class STLedgerEntry;
+
 // an item stored in a SHAMap
 class SHAMapItem
 {
 private:
     uint256    tag_;
-    Blob       data_;
+
+    // The payload is drawn from the SlabPool, like the items and
+    // nodes of the map, rather than held in a vector
+    std::uint8_t* data_;
+    std::uint32_t size_;
+
+    // The item parsed as a ledger entry, kept alongside the
+    // immutable data it was parsed from. Accessed atomically.
+    mutable std::shared_ptr<STLedgerEntry const> sle_;
 
 public:
     SHAMapItem (uint256 const& tag, Blob const & data);
+    SHAMapItem (uint256 const& tag, Slice data);
     SHAMapItem (uint256 const& tag, Serializer const& s);
     SHAMapItem (uint256 const& tag, Serializer&& s);
 
+    SHAMapItem (SHAMapItem const& other);
+    SHAMapItem (SHAMapItem&& other) noexcept;
+    SHAMapItem& operator= (SHAMapItem const& other);
+    SHAMapItem& operator= (SHAMapItem&& other) noexcept;
+
+    ~SHAMapItem();
+
     Slice slice() const;
 
     uint256 const& key() const;
 
-    Blob const& peekData() const;
-
     std::size_t size() const;
     void const* data() const;
+
+    /** Returns the parsed form of this item, if one is attached. */
+    std::shared_ptr<STLedgerEntry const> getSLE() const;
+
+    /** Attach the parsed form of this item, or detach it with nullptr.
+
+        The parsed form is a cache: the item's data does not change,
+        so any thread may attach or detach it at any time.
+    */
+    void setSLE (std::shared_ptr<STLedgerEntry const> sle) const;
 };
 
 //------------------------------------------------------------------------------
@@ -58,21 +88,21 @@ inline
 Slice
 SHAMapItem::slice() const
 {
-    return {data_.data(), data_.size()};
+    return {data_, size_};
 }
 
 inline
 std::size_t
 SHAMapItem::size() const
 {
-    return data_.size();
+    return size_;
 }
 
 inline
 void const*
 SHAMapItem::data() const
 {
-    return data_.data();
+    return data_;
 }
 
 inline
@@ -82,11 +112,13 @@ SHAMapItem::key() const
     return tag_;
 }
 
-inline
-Blob const&
-SHAMapItem::peekData() const
+/** Create an item in memory drawn from the SlabPool. */
+template <class... Args>
+std::shared_ptr<SHAMapItem const>
+makeSHAMapItem (Args&&... args)
 {
-    return data_;
+    return std::allocate_shared<SHAMapItem const>(
+        SlabAllocator<SHAMapItem>{}, std::forward<Args>(args)...);
 }
 
 } // ripple
@@ -22,13 +22,17 @@
 
 #include <ripple/shamap/SHAMapItem.h>
 #include <ripple/shamap/SHAMapNodeID.h>
+#include <ripple/basics/SlabAllocator.h>
 #include <ripple/basics/TaggedCache.h>
 #include <ripple/beast/utility/Journal.h>
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace ripple {
 
@@ -135,24 +139,61 @@ public:
         make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat format,
              SHAMapHash const& hash, bool hashValid, beast::Journal j,
              SHAMapNodeID const& id = SHAMapNodeID{});
+
+    /** Recompute the hashes of several nodes together.
+
+        Has the same effect as calling updateHash on each node, but
+        hashes the nodes on parallel SIMD lanes. On return raw[i] holds
+        the snfPREFIX form of nodes[i], which is what the hash covers,
+        or is empty if the node is an empty inner node. Null and invalid
+        nodes are skipped.
+    */
+    static void
+        updateHashes(std::vector<SHAMapAbstractNode*> const& nodes,
+            std::vector<Blob>& raw);
 };
 
 class SHAMapInnerNode
     : public SHAMapAbstractNode
 {
-    std::array<SHAMapHash, 16>          mHashes;
-    std::shared_ptr<SHAMapAbstractNode> mChildren[16];
-    int                             mIsBranch = 0;
+    struct Branch
+    {
+        SHAMapHash                          hash;
+        std::shared_ptr<SHAMapAbstractNode> child;
+    };
+
+    // Most inner nodes below the first few levels have only a handful
+    // of branches. Unless the node is dense, only the branches present
+    // are stored, in branch order, and the array grows and shrinks as
+    // children are added and removed. A dense node stores all 16
+    // branches indexed by branch number. The array is drawn from the
+    // SlabPool.
+    Branch*                         mBranches = nullptr;
+    std::uint16_t                   mIsBranch = 0;
+    std::uint8_t                    mCapacity = 0;
     std::uint32_t                   mFullBelowGen = 0;
 
     static std::mutex               childLock;
+    static SHAMapHash const         emptyHash;
+    static std::atomic<bool>        sparse;
+
 public:
     SHAMapInnerNode(std::uint32_t seq);
+    ~SHAMapInnerNode();
     std::shared_ptr<SHAMapAbstractNode> clone(std::uint32_t seq) const override;
 
+    /** Select the layout of inner nodes allocated from now on.
+
+        Sparse nodes, the default, allocate space only for the branches
+        present. Dense nodes always allocate all 16.
+    */
+    static void setSparse (bool sparse);
+
     bool isEmpty () const;
     bool isEmptyBranch (int m) const;
     int getBranchCount () const;
+    /** Number of branches space is allocated for. */
+    int getCapacity () const;
     SHAMapHash const& getChildHash (int m) const;
 
     void setChild(int m, std::shared_ptr<SHAMapAbstractNode> const& child);
@@ -168,6 +209,8 @@ public:
 
     bool updateHash () override;
     void updateHashDeep();
+    /** Copy the hashes of the children present into this node. */
+    void updateChildHashes();
     void addRaw (Serializer&, SHANodeFormat format) const override;
     std::string getString (SHAMapNodeID const&) const override;
     uint256 const& key() const override;
@@ -177,6 +220,16 @@ public:
         SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq,
              SHANodeFormat format, SHAMapHash const& hash, bool hashValid,
                  beast::Journal j, SHAMapNodeID const& id);
+
+private:
+    // Index into mBranches of a branch that is present
+    int getIndex (int m) const;
+    // Reallocate mBranches for a new set of branches, keeping the
+    // hashes and children of the branches in both sets
+    void resize (std::uint16_t isBranch);
+
+    static Branch* allocateBranches (int capacity);
+    static void freeBranches (Branch* branches, int capacity);
 };
 
 // SHAMapTreeNode represents a leaf, and may eventually be renamed to reflect that.
@@ -214,6 +267,15 @@ public:  // public only to SHAMap
     bool updateHash () override;
 };
 
+/** Create a node in memory drawn from the SlabPool. */
+template <class Node, class... Args>
+std::shared_ptr<Node>
+makeSHAMapNode (Args&&... args)
+{
+    return std::allocate_shared<Node>(
+        SlabAllocator<Node>{}, std::forward<Args>(args)...);
+}
+
 // SHAMapAbstractNode
 
 inline
@@ -305,12 +367,37 @@ SHAMapInnerNode::isEmptyBranch (int m) const
     return (mIsBranch & (1 << m)) == 0;
 }
 
+inline
+int
+SHAMapInnerNode::getCapacity () const
+{
+    return mCapacity;
+}
+
+inline
+int
+SHAMapInnerNode::getIndex (int m) const
+{
+    assert (!isEmptyBranch (m));
+    if (mCapacity == 16)
+        return m;
+
+    // Count the branches present below m
+    std::uint32_t v = mIsBranch & ((1u << m) - 1);
+    v = v - ((v >> 1) & 0x5555);
+    v = (v & 0x3333) + ((v >> 2) & 0x3333);
+    v = (v + (v >> 4)) & 0x0f0f;
+    return (v + (v >> 8)) & 0x1f;
+}
+
 inline
 SHAMapHash const&
 SHAMapInnerNode::getChildHash (int m) const
 {
     assert ((m >= 0) && (m < 16) && (getType() == tnINNER));
-    return mHashes[m];
+    if (isEmptyBranch (m))
+        return emptyHash;
+    return mBranches[getIndex (m)].hash;
 }
 
 inline
@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_SHAMAP_SHAMAPWORKERS_H_INCLUDED
+#define RIPPLE_SHAMAP_SHAMAPWORKERS_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+
+/** Threads the maps of a family share to walk and flush in parallel.
+
+    The thread calling run works through the tasks itself, and asks for
+    idle threads of the pool to help it. Threads are started when a call
+    asks for more helpers than the pool has, and kept for later calls,
+    so the pool never holds more threads than the most helpers any one
+    call asked for, however many calls run at once. Help a call asked
+    for that no thread picked up by the time the caller ran out of tasks
+    is withdrawn, so a call never waits on the work of another.
+*/
+class SHAMapWorkers
+{
+public:
+    SHAMapWorkers () = default;
+    SHAMapWorkers (SHAMapWorkers const&) = delete;
+    SHAMapWorkers& operator= (SHAMapWorkers const&) = delete;
+
+    ~SHAMapWorkers ();
+
+    /** Run task(0) through task(count - 1).
+
+        The tasks run on this thread and up to helpers threads of the
+        pool. A task returns false to stop the tasks not yet started.
+        Rethrows the first exception a task throws.
+    */
+    void run (std::size_t count, std::size_t helpers,
+        std::function<bool(std::size_t)> const& task);
+
+    /** Returns the number of threads the pool has started. */
+    std::size_t size () const;
+
+private:
+    // The state of one call to run
+    struct Call
+    {
+        Call (std::size_t count_,
+            std::function<bool(std::size_t)> const& task_)
+            : count (count_)
+            , task (task_)
+        {
+        }
+
+        // Run tasks until there are none left
+        void work ();
+
+        std::size_t const count;
+        std::function<bool(std::size_t)> const& task;
+        std::atomic<std::size_t> next {0};
+
+        // Pool threads working on the call
+        std::atomic<int> running {0};
+
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+
+    void worker ();
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+
+    // One entry for each helper a call is waiting for
+    std::deque<Call*> queue_;
+    std::vector<std::thread> threads_;
+    bool stop_ = false;
+};
+
+} // ripple
+
+#endif
@@ -19,9 +19,20 @@
 
 #include <ripple/basics/contract.h>
 #include <ripple/shamap/SHAMap.h>
+#include <atomic>
+#include <thread>
 
 namespace ripple {
 
+// Threads used to flush the dirty nodes of a map
+static std::atomic<std::size_t> flushThreads {std::min<std::size_t> (4,
+    std::max (std::thread::hardware_concurrency(), 1u))};
+
+// Threads used to walk a whole map. Walks mostly wait on the node
+// store, so they use more threads than there are cores.
+static std::atomic<std::size_t> walkThreads {std::min<std::size_t> (16,
+    std::max (std::thread::hardware_concurrency(), 4u))};
+
 SHAMap::SHAMap (
     SHAMapType t,
     Family& f)
@@ -31,7 +42,7 @@ SHAMap::SHAMap (
     , state_ (SHAMapState::Modifying)
     , type_ (t)
 {
-    root_ = std::make_shared<SHAMapInnerNode>(seq_);
+    root_ = makeSHAMapNode<SHAMapInnerNode>(seq_);
 }
 
 SHAMap::SHAMap (
@@ -44,7 +55,7 @@ SHAMap::SHAMap (
     , state_ (SHAMapState::Synching)
     , type_ (t)
 {
-    root_ = std::make_shared<SHAMapInnerNode>(seq_);
+    root_ = makeSHAMapNode<SHAMapInnerNode>(seq_);
 }
 
 SHAMap::~SHAMap ()
@@ -369,6 +380,59 @@ SHAMap::descendAsync (SHAMapInnerNode* parent, int branch,
     return ptr.get ();
 }
 
+void
+SHAMap::descendBatch (SHAMapInnerNode* parent) const
+{
+    if (!backed_)
+        return;
+
+    std::vector<uint256> hashes;
+    std::vector<int> branches;
+    for (int branch = 0; branch < 16; ++branch)
+    {
+        if (parent->isEmptyBranch (branch) ||
+                parent->getChildPointer (branch))
+            continue;
+
+        auto const& hash = parent->getChildHash (branch);
+        if (auto ptr = getCache (hash))
+        {
+            parent->canonicalizeChild (branch, std::move(ptr));
+            continue;
+        }
+        hashes.push_back (hash.as_uint256());
+        branches.push_back (branch);
+    }
+
+    // A single child is left to the regular descent
+    if (hashes.size () < 2)
+        return;
+
+    auto const objs = f_.db().fetchBatch (hashes, ledgerSeq_);
+    for (std::size_t i = 0; i < objs.size (); ++i)
+    {
+        if (!objs[i])
+            continue;
+
+        SHAMapHash const hash {hashes[i]};
+        try
+        {
+            auto ptr = SHAMapAbstractNode::make(makeSlice(objs[i]->getData()),
+                0, snfPREFIX, hash, true, f_.journal());
+            if (ptr)
+            {
+                canonicalize (hash, ptr);
+                parent->canonicalizeChild (branches[i], std::move(ptr));
+            }
+        }
+        catch (std::exception const&)
+        {
+            JLOG(journal_.warn()) <<
+                "Invalid DB node " << hash;
+        }
+    }
+}
+
 template <class Node>
 std::shared_ptr<Node>
 SHAMap::unshareNode (std::shared_ptr<Node> node, SHAMapNodeID const& nodeID)
@@ -647,7 +711,7 @@ bool SHAMap::delItem (uint256 const& id)
                             break;
                         }
                     }
-                    prevNode = std::make_shared<SHAMapTreeNode>(item, type, node->getSeq());
+                    prevNode = makeSHAMapNode<SHAMapTreeNode>(item, type, node->getSeq());
                 }
                 else
                 {
@@ -698,7 +762,7 @@ SHAMap::addGiveItem (std::shared_ptr<SHAMapItem const> const& item,
         auto inner = std::static_pointer_cast<SHAMapInnerNode>(node);
         int branch = nodeID.selectBranch (tag);
         assert (inner->isEmptyBranch (branch));
-        auto newNode = std::make_shared<SHAMapTreeNode> (item, type, seq_);
+        auto newNode = makeSHAMapNode<SHAMapTreeNode> (item, type, seq_);
         inner->setChild (branch, newNode);
     }
     else
@@ -708,7 +772,7 @@ SHAMap::addGiveItem (std::shared_ptr<SHAMapItem const> const& item,
         std::shared_ptr<SHAMapItem const> otherItem = leaf->peekItem ();
         assert (otherItem && (tag != otherItem->key()));
 
-        node = std::make_shared<SHAMapInnerNode>(node->getSeq());
+        node = makeSHAMapNode<SHAMapInnerNode>(node->getSeq());
 
         int b1, b2;
 
@@ -719,19 +783,19 @@ SHAMap::addGiveItem (std::shared_ptr<SHAMapItem const> const& item,
 
             // we need a new inner node, since both go on same branch at this level
             nodeID = nodeID.getChildNodeID (b1);
-            node = std::make_shared<SHAMapInnerNode> (seq_);
+            node = makeSHAMapNode<SHAMapInnerNode> (seq_);
         }
 
         // we can add the two leaf nodes here
         assert (node->isInner ());
 
         std::shared_ptr<SHAMapTreeNode> newNode =
-            std::make_shared<SHAMapTreeNode> (item, type, seq_);
+            makeSHAMapNode<SHAMapTreeNode> (item, type, seq_);
         assert (newNode->isValid () && newNode->isLeaf ());
         auto inner = std::static_pointer_cast<SHAMapInnerNode>(node);
         inner->setChild (b1, newNode);
 
-        newNode = std::make_shared<SHAMapTreeNode> (otherItem, type, seq_);
+        newNode = makeSHAMapNode<SHAMapTreeNode> (otherItem, type, seq_);
         assert (newNode->isValid () && newNode->isLeaf ());
         inner->setChild (b2, newNode);
     }
@@ -743,7 +807,7 @@ SHAMap::addGiveItem (std::shared_ptr<SHAMapItem const> const& item,
 bool
 SHAMap::addItem(SHAMapItem&& i, bool isTransaction, bool hasMetaData)
 {
-    return addGiveItem(std::make_shared<SHAMapItem const>(std::move(i)),
+    return addGiveItem(makeSHAMapItem(std::move(i)),
                                                           isTransaction, hasMetaData);
 }
 
@@ -846,6 +910,15 @@ bool SHAMap::fetchRoot (SHAMapHash const& hash, SHAMapSyncFilter* filter)
 std::shared_ptr<SHAMapAbstractNode>
 SHAMap::writeNode (
     NodeObjectType t, std::uint32_t seq, std::shared_ptr<SHAMapAbstractNode> node) const
+{
+    Serializer s;
+    node->addRaw (s, snfPREFIX);
+    return writeNode (t, seq, std::move (node), std::move (s.modData ()));
+}
+
+std::shared_ptr<SHAMapAbstractNode>
+SHAMap::writeNode (NodeObjectType t, std::uint32_t seq,
+    std::shared_ptr<SHAMapAbstractNode> node, Blob&& raw) const
 {
     // Node is ours, so we can just make it shareable
     assert (node->getSeq() == seq_);
@@ -854,9 +927,7 @@ SHAMap::writeNode (
 
     canonicalize (node->getNodeHash(), node);
 
-    Serializer s;
-    node->addRaw (s, snfPREFIX);
-    f_.db().store (t, std::move (s.modData ()),
+    f_.db().store (t, std::move (raw),
         node->getNodeHash ().as_uint256(), ledgerSeq_);
     return node;
 }
@@ -887,6 +958,31 @@ int SHAMap::unshare ()
     return walkSubTree (false, hotUNKNOWN, 0);
 }
 
+std::size_t
+SHAMap::setFlushThreads (std::size_t threads)
+{
+    return flushThreads.exchange (std::max<std::size_t> (threads, 1));
+}
+
+std::size_t
+SHAMap::setWalkThreads (std::size_t threads)
+{
+    return walkThreads.exchange (std::max<std::size_t> (threads, 1));
+}
+
+std::size_t
+SHAMap::getWalkThreads ()
+{
+    return walkThreads.load();
+}
+
+void
+SHAMap::runParallel (std::size_t count, std::size_t helpers,
+    std::function<bool(std::size_t)> const& task) const
+{
+    f_.workers().run (count, helpers, task);
+}
+
 /** Convert all modified nodes to shared nodes */
 // If requested, write them to the node store
 int SHAMap::flushDirty (NodeObjectType t, std::uint32_t seq)
@@ -918,103 +1014,231 @@ SHAMap::walkSubTree (bool doWrite, NodeObjectType t, std::uint32_t seq)
 
     if (node->isEmpty ())
     { // replace empty root with a new empty root
-        root_ = std::make_shared<SHAMapInnerNode>(0);
+        root_ = makeSHAMapNode<SHAMapInnerNode>(0);
         return 1;
     }
 
-    // Stack of {parent,index,child} pointers representing
-    // inner nodes we are in the process of flushing
-    using StackEntry = std::pair <std::shared_ptr<SHAMapInnerNode>, int>;
-    std::stack <StackEntry, std::vector<StackEntry>> stack;
-
     node = preFlushNode(std::move(node));
 
-    int pos = 0;
+    auto const threads = flushThreads.load();
+    if (threads > 1)
+        root_ = flushParallel (std::move(node), threads, doWrite, t, seq, flushed);
+    else
+        root_ = flushSubTree (std::move(node), doWrite, t, seq, flushed);
+
+    return flushed;
+}
 
-    // We can't flush an inner node until we flush its children
-    while (1)
+// Flush the top two levels of the tree on this thread and the
+// subtrees below them on up to `threads` threads. The subtrees are
+// independent, so the hashes do not depend on which thread flushes
+// which subtree, or in what order.
+std::shared_ptr<SHAMapInnerNode>
+SHAMap::flushParallel (std::shared_ptr<SHAMapInnerNode> root,
+    std::size_t threads, bool doWrite, NodeObjectType t,
+        std::uint32_t seq, int& flushed) const
+{
+    struct Task
     {
-        while (pos < 16)
+        std::shared_ptr<SHAMapInnerNode> parent;
+        int branch;
+        std::shared_ptr<SHAMapInnerNode> node;
+        int flushed = 0;
+    };
+
+    // Unshare the dirty children of parent, flushing the leaves
+    // and collecting the inner nodes
+    auto const split = [&](std::shared_ptr<SHAMapInnerNode> const& parent,
+        std::vector<Task>& inner)
+    {
+        for (int branch = 0; branch < 16; ++branch)
         {
-            if (node->isEmptyBranch (pos))
+            if (parent->isEmptyBranch (branch))
+                continue;
+
+            auto child = parent->getChild (branch);
+            if (!child || (child->getSeq() == 0))
+                continue;
+
+            child = preFlushNode (std::move (child));
+            if (child->isInner ())
             {
-                ++pos;
+                inner.push_back ({parent, branch,
+                    std::static_pointer_cast<SHAMapInnerNode>(
+                        std::move (child))});
             }
             else
             {
-                // No need to do I/O. If the node isn't linked,
-                // it can't need to be flushed
-                int branch = pos;
-                auto child = node->getChild(pos++);
+                ++flushed;
+                child->updateHash();
+                if (doWrite && backed_)
+                    child = writeNode (t, seq, std::move (child));
+                else
+                    child->setSeq (0);
+                parent->shareChild (branch, child);
+            }
+        }
+    };
 
-                if (child && (child->getSeq() != 0))
-                {
-                    // This is a node that needs to be flushed
+    // Hash an inner node whose children are flushed
+    auto const finish = [&](std::shared_ptr<SHAMapInnerNode> node)
+    {
+        node->updateHashDeep();
+        if (doWrite && backed_)
+            node = std::static_pointer_cast<SHAMapInnerNode>(
+                writeNode (t, seq, std::move (node)));
+        else
+            node->setSeq (0);
+        ++flushed;
+        return node;
+    };
 
-                    child = preFlushNode(std::move(child));
+    std::vector<Task> upper;
+    std::vector<Task> tasks;
+    split (root, upper);
+    for (auto const& u : upper)
+        split (u.node, tasks);
 
-                    if (child->isInner ())
-                    {
-                        // save our place and work on this node
+    // Waking a helper costs about as much as flushing a few dozen
+    // nodes, so only use helpers when there is enough work.
+    std::size_t const helpers = std::min (threads - 1,
+        tasks.size() / minFlushTasks);
 
-                        stack.emplace (std::move (node), branch);
+    runParallel (tasks.size(), helpers, [&](std::size_t i)
+        {
+            tasks[i].node = flushSubTree (std::move (tasks[i].node),
+                doWrite, t, seq, tasks[i].flushed);
+            return true;
+        });
 
-                        node = std::static_pointer_cast<SHAMapInnerNode>(std::move(child));
-                        pos = 0;
-                    }
-                    else
-                    {
-                        // flush this leaf
-                        ++flushed;
+    for (auto& task : tasks)
+    {
+        flushed += task.flushed;
+        task.parent->shareChild (task.branch, task.node);
+    }
+    for (auto& u : upper)
+        root->shareChild (u.branch, finish (std::move (u.node)));
+    return finish (std::move (root));
+}
 
-                        assert (node->getSeq() == seq_);
-                        child->updateHash();
+// Flush an unshared inner node and the dirty nodes below it,
+// returning the node to hook up in its place.
+//
+// We can't hash an inner node until we hash its children, so the
+// dirty inner nodes are gathered level by level going down and then
+// hashed a level at a time coming back up, which lets the nodes of
+// a level be hashed together on parallel SIMD lanes.
+std::shared_ptr<SHAMapInnerNode>
+SHAMap::flushSubTree (std::shared_ptr<SHAMapInnerNode> node,
+    bool doWrite, NodeObjectType t, std::uint32_t seq, int& flushed) const
+{
+    struct Dirty
+    {
+        std::shared_ptr<SHAMapInnerNode> node;
+        std::size_t parent;             // index in the level above
+        int branch;
+    };
 
-                        if (doWrite && backed_)
-                            child = writeNode(t, seq, std::move(child));
-                        else
-                            child->setSeq (0);
+    std::vector<std::vector<Dirty>> levels;
+    levels.push_back ({{std::move (node), 0, 0}});
 
-                        node->shareChild (branch, child);
-                    }
+    for (std::size_t depth = 0; depth < levels.size(); ++depth)
+    {
+        std::vector<Dirty> below;
+        for (std::size_t i = 0; i < levels[depth].size(); ++i)
+        {
+            auto const& parent = levels[depth][i].node;
+            for (int branch = 0; branch < 16; ++branch)
+            {
+                if (parent->isEmptyBranch (branch))
+                    continue;
+
+                // No need to do I/O. If the node isn't linked,
+                // it can't need to be flushed
+                auto child = parent->getChild (branch);
+                if (!child || (child->getSeq() == 0))
+                    continue;
+
+                child = preFlushNode (std::move (child));
+
+                if (child->isInner ())
+                {
+                    below.push_back ({std::static_pointer_cast<
+                        SHAMapInnerNode>(std::move (child)), i, branch});
+                }
+                else
+                {
+                    // flush this leaf
+                    ++flushed;
+
+                    assert (parent->getSeq() == seq_);
+                    child->updateHash();
+
+                    if (doWrite && backed_)
+                        child = writeNode (t, seq, std::move (child));
+                    else
+                        child->setSeq (0);
+
+                    parent->shareChild (branch, child);
                 }
             }
         }
+        if (!below.empty())
+            levels.push_back (std::move (below));
+    }
 
-        // update the hash of this inner node
-        node->updateHashDeep();
-
-        // This inner node can now be shared
-        if (doWrite && backed_)
-            node = std::static_pointer_cast<SHAMapInnerNode>(writeNode(t, seq,
-                                                                       std::move(node)));
-        else
-            node->setSeq (0);
+    std::vector<SHAMapAbstractNode*> batch;
+    std::vector<Blob> raw;
+    for (auto depth = levels.size(); depth-- > 0;)
+    {
+        auto& level = levels[depth];
+        for (std::size_t first = 0; first < level.size();
+            first += flushBatchSize)
+        {
+            auto const last = std::min (level.size(),
+                first + flushBatchSize);
 
-        ++flushed;
+            batch.clear();
+            for (auto i = first; i < last; ++i)
+            {
+                level[i].node->updateChildHashes();
+                batch.push_back (level[i].node.get());
+            }
+            SHAMapAbstractNode::updateHashes (batch, raw);
 
-        if (stack.empty ())
-           break;
+            for (auto i = first; i < last; ++i)
+            {
+                auto& dirty = level[i];
 
-        auto parent = std::move (stack.top().first);
-        pos = stack.top().second;
-        stack.pop();
+                // This inner node can now be shared
+                if (doWrite && backed_ && !raw[i - first].empty())
+                {
+                    dirty.node = std::static_pointer_cast<SHAMapInnerNode>(
+                        writeNode (t, seq, std::move (dirty.node),
+                            std::move (raw[i - first])));
+                }
+                else
+                {
+                    dirty.node->setSeq (0);
+                }
 
-        // Hook this inner node to its parent
-        assert (parent->getSeq() == seq_);
-        parent->shareChild (pos, node);
+                ++flushed;
 
-        // Continue with parent's next child, if any
-        node = std::move (parent);
-        ++pos;
+                if (depth != 0)
+                {
+                    // Hook this inner node to its parent
+                    auto const& parent = levels[depth - 1][dirty.parent].node;
+                    assert (parent->getSeq() == seq_);
+                    parent->shareChild (dirty.branch, dirty.node);
+                }
+            }
+        }
     }
 
-    // Last inner node is the new root_
-    root_ = std::move (node);
-
-    return flushed;
+    return std::move (levels.front().front().node);
 }
 
+
 void SHAMap::dump (bool hash) const
 {
     int leafCount = 0;
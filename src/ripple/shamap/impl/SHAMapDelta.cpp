@@ -32,7 +32,7 @@ namespace ripple {
 
 bool SHAMap::walkBranch (SHAMapAbstractNode* node,
                          std::shared_ptr<SHAMapItem const> const& otherMapItem,
-                         bool isFirstMap,Delta& differences, int& maxCount) const
+                         bool isFirstMap, DeltaReport const& report) const
 {
     // Walk a branch of a SHAMap that's matched by an empty branch or single item in the other map
     std::stack <SHAMapAbstractNode*, std::vector<SHAMapAbstractNode*>> nodeStack;
@@ -62,27 +62,29 @@ bool SHAMap::walkBranch (SHAMapAbstractNode* node,
             {
                 // unmatched
                 if (isFirstMap)
-                    differences.insert (std::make_pair (item->key(),
-                        DeltaRef (item, std::shared_ptr<SHAMapItem const> ())));
+                {
+                    if (!report (DeltaRef (item, std::shared_ptr<SHAMapItem const> ())))
+                        return false;
+                }
                 else
-                    differences.insert (std::make_pair (item->key(),
-                        DeltaRef (std::shared_ptr<SHAMapItem const> (), item)));
-
-                if (--maxCount <= 0)
-                    return false;
+                {
+                    if (!report (DeltaRef (std::shared_ptr<SHAMapItem const> (), item)))
+                        return false;
+                }
             }
-            else if (item->peekData () != otherMapItem->peekData ())
+            else if (item->slice () != otherMapItem->slice ())
             {
                 // non-matching items with same tag
                 if (isFirstMap)
-                    differences.insert (std::make_pair (item->key(),
-                                                DeltaRef (item, otherMapItem)));
+                {
+                    if (!report (DeltaRef (item, otherMapItem)))
+                        return false;
+                }
                 else
-                    differences.insert (std::make_pair (item->key(),
-                                                DeltaRef (otherMapItem, item)));
-
-                if (--maxCount <= 0)
-                    return false;
+                {
+                    if (!report (DeltaRef (otherMapItem, item)))
+                        return false;
+                }
 
                 emptyBranch = true;
             }
@@ -98,15 +100,11 @@ bool SHAMap::walkBranch (SHAMapAbstractNode* node,
     {
         // otherMapItem was unmatched, must add
         if (isFirstMap) // this is first map, so other item is from second
-            differences.insert(std::make_pair(otherMapItem->key(),
-                                              DeltaRef(std::shared_ptr<SHAMapItem const>(),
-                                                       otherMapItem)));
+            return report (DeltaRef (std::shared_ptr<SHAMapItem const>(),
+                                     otherMapItem));
         else
-            differences.insert(std::make_pair(otherMapItem->key(),
-                DeltaRef(otherMapItem, std::shared_ptr<SHAMapItem const>())));
-
-        if (--maxCount <= 0)
-            return false;
+            return report (DeltaRef (otherMapItem,
+                                     std::shared_ptr<SHAMapItem const>()));
     }
 
     return true;
@@ -120,107 +118,155 @@ SHAMap::compare (SHAMap const& otherMap,
     // return value: true=complete table of differences given, false=too many differences
     // throws on corrupt tables or missing nodes
     // CAUTION: otherMap is not locked and must be immutable
+    return compare (otherMap,
+        [&differences](uint256 const& key, DeltaItem&& item)
+        {
+            differences.emplace (key, std::move (item));
+        }, maxCount);
+}
 
+bool
+SHAMap::compare (SHAMap const& otherMap,
+                 DeltaSink const& sink, int maxCount) const
+{
     assert (isValid () && otherMap.isValid ());
 
     if (getHash () == otherMap.getHash ())
         return true;
 
-    using StackEntry = std::pair <SHAMapAbstractNode*, SHAMapAbstractNode*>;
-    std::stack <StackEntry, std::vector<StackEntry>> nodeStack; // track nodes we've pushed
-
-    nodeStack.push ({root_.get(), otherMap.root_.get()});
-    while (!nodeStack.empty ())
+    // Differences are found on several threads, but are passed
+    // to the sink one at a time
+    std::mutex mutex;
+    bool done = false;
+    DeltaReport const report = [&](DeltaRef delta)
     {
-        auto [ourNode, otherNode] = nodeStack.top();
-        nodeStack.pop ();
-
-        if (!ourNode || !otherNode)
+        std::lock_guard lock (mutex);
+        if (done)
+            return false;
+        auto const& key = delta.first ?
+            delta.first->key() : delta.second->key();
+        sink (key, DeltaItem (delta.first, delta.second));
+        if (--maxCount <= 0)
+            done = true;
+        return !done;
+    };
+
+    // Compare the top two levels here, then descend the
+    // differing branches below them in parallel
+    std::vector<NodePair> level {{root_.get(), otherMap.root_.get()}};
+    for (int depth = 0; depth < 2 && !level.empty (); ++depth)
+    {
+        std::vector<NodePair> below;
+        for (auto const& [ourNode, otherNode] : level)
         {
-            assert (false);
-            Throw<SHAMapMissingNode> (type_, uint256 ());
+            if (!compareBranch (ourNode, otherNode, otherMap, report, below))
+                return false;
         }
+        level = std::move (below);
+    }
 
-        if (ourNode->isLeaf () && otherNode->isLeaf ())
+    std::atomic<bool> complete {true};
+    auto const helpers = std::min (getWalkThreads () - 1,
+        level.size () / minWalkTasks);
+    runParallel (level.size (), helpers, [&](std::size_t i)
         {
-            // two leaves
-            auto ours = static_cast<SHAMapTreeNode*>(ourNode);
-            auto other = static_cast<SHAMapTreeNode*>(otherNode);
-            if (ours->peekItem()->key() == other->peekItem()->key())
+            std::vector<NodePair> stack {level[i]};
+            while (!stack.empty () && complete)
             {
-                if (ours->peekItem()->peekData () != other->peekItem()->peekData ())
-                {
-                    differences.insert (std::make_pair (ours->peekItem()->key(),
-                                                 DeltaRef (ours->peekItem (),
-                                                 other->peekItem ())));
-                    if (--maxCount <= 0)
-                        return false;
-                }
+                auto const [ourNode, otherNode] = stack.back ();
+                stack.pop_back ();
+
+                if (!compareBranch (ourNode, otherNode, otherMap, report, stack))
+                    complete = false;
             }
-            else
-            {
-                differences.insert (std::make_pair(ours->peekItem()->key(),
-                                                   DeltaRef(ours->peekItem(),
-                                                   std::shared_ptr<SHAMapItem const>())));
-                if (--maxCount <= 0)
-                    return false;
+            return complete.load ();
+        });
+
+    return complete;
+}
 
-                differences.insert(std::make_pair(other->peekItem()->key(),
-                    DeltaRef(std::shared_ptr<SHAMapItem const>(), other->peekItem ())));
-                if (--maxCount <= 0)
+bool
+SHAMap::compareBranch (SHAMapAbstractNode* ourNode, SHAMapAbstractNode* otherNode,
+    SHAMap const& otherMap, DeltaReport const& report,
+        std::vector<NodePair>& nodes) const
+{
+    if (!ourNode || !otherNode)
+    {
+        assert (false);
+        Throw<SHAMapMissingNode> (type_, uint256 ());
+    }
+
+    if (ourNode->isLeaf () && otherNode->isLeaf ())
+    {
+        // two leaves
+        auto ours = static_cast<SHAMapTreeNode*>(ourNode);
+        auto other = static_cast<SHAMapTreeNode*>(otherNode);
+        if (ours->peekItem()->key() == other->peekItem()->key())
+        {
+            if (ours->peekItem()->slice () != other->peekItem()->slice ())
+            {
+                if (!report (DeltaRef (ours->peekItem (), other->peekItem ())))
                     return false;
             }
         }
-        else if (ourNode->isInner () && otherNode->isLeaf ())
+        else
         {
-            auto ours = static_cast<SHAMapInnerNode*>(ourNode);
-            auto other = static_cast<SHAMapTreeNode*>(otherNode);
-            if (!walkBranch (ours, other->peekItem (),
-                    true, differences, maxCount))
+            if (!report (DeltaRef (ours->peekItem(),
+                    std::shared_ptr<SHAMapItem const>())))
                 return false;
-        }
-        else if (ourNode->isLeaf () && otherNode->isInner ())
-        {
-            auto ours = static_cast<SHAMapTreeNode*>(ourNode);
-            auto other = static_cast<SHAMapInnerNode*>(otherNode);
-            if (!otherMap.walkBranch (other, ours->peekItem (),
-                                       false, differences, maxCount))
+
+            if (!report (DeltaRef (std::shared_ptr<SHAMapItem const>(),
+                    other->peekItem ())))
                 return false;
         }
-        else if (ourNode->isInner () && otherNode->isInner ())
-        {
-            auto ours = static_cast<SHAMapInnerNode*>(ourNode);
-            auto other = static_cast<SHAMapInnerNode*>(otherNode);
-            for (int i = 0; i < 16; ++i)
-                if (ours->getChildHash (i) != other->getChildHash (i))
+    }
+    else if (ourNode->isInner () && otherNode->isLeaf ())
+    {
+        auto ours = static_cast<SHAMapInnerNode*>(ourNode);
+        auto other = static_cast<SHAMapTreeNode*>(otherNode);
+        if (!walkBranch (ours, other->peekItem (), true, report))
+            return false;
+    }
+    else if (ourNode->isLeaf () && otherNode->isInner ())
+    {
+        auto ours = static_cast<SHAMapTreeNode*>(ourNode);
+        auto other = static_cast<SHAMapInnerNode*>(otherNode);
+        if (!otherMap.walkBranch (other, ours->peekItem (), false, report))
+            return false;
+    }
+    else if (ourNode->isInner () && otherNode->isInner ())
+    {
+        auto ours = static_cast<SHAMapInnerNode*>(ourNode);
+        auto other = static_cast<SHAMapInnerNode*>(otherNode);
+        for (int i = 0; i < 16; ++i)
+            if (ours->getChildHash (i) != other->getChildHash (i))
+            {
+                if (other->isEmptyBranch (i))
                 {
-                    if (other->isEmptyBranch (i))
-                    {
-                        // We have a branch, the other tree does not
-                        SHAMapAbstractNode* iNode = descendThrow (ours, i);
-                        if (!walkBranch (iNode,
-                                         std::shared_ptr<SHAMapItem const> (), true,
-                                         differences, maxCount))
-                            return false;
-                    }
-                    else if (ours->isEmptyBranch (i))
-                    {
-                        // The other tree has a branch, we do not
-                        SHAMapAbstractNode* iNode =
-                            otherMap.descendThrow(other, i);
-                        if (!otherMap.walkBranch (iNode,
-                                                   std::shared_ptr<SHAMapItem const>(),
-                                                   false, differences, maxCount))
-                            return false;
-                    }
-                    else // The two trees have different non-empty branches
-                        nodeStack.push ({descendThrow (ours, i),
-                                        otherMap.descendThrow (other, i)});
+                    // We have a branch, the other tree does not
+                    SHAMapAbstractNode* iNode = descendThrow (ours, i);
+                    if (!walkBranch (iNode,
+                                     std::shared_ptr<SHAMapItem const> (),
+                                     true, report))
+                        return false;
                 }
-        }
-        else
-            assert (false);
+                else if (ours->isEmptyBranch (i))
+                {
+                    // The other tree has a branch, we do not
+                    SHAMapAbstractNode* iNode =
+                        otherMap.descendThrow(other, i);
+                    if (!otherMap.walkBranch (iNode,
+                                              std::shared_ptr<SHAMapItem const>(),
+                                              false, report))
+                        return false;
+                }
+                else // The two trees have different non-empty branches
+                    nodes.emplace_back (descendThrow (ours, i),
+                                        otherMap.descendThrow (other, i));
+            }
     }
+    else
+        assert (false);
 
     return true;
 }
@@ -230,12 +276,68 @@ void SHAMap::walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissi
     if (!root_->isInner ())  // root_ is only node, and we have it
         return;
 
+    std::atomic<int> budget {std::max (maxMissing, 1)};
+    auto const missing = [&](SHAMapInnerNode const& node, int branch)
+    {
+        missingNodes.emplace_back (type_, node.getChildHash (branch));
+        return --budget > 0;
+    };
+
+    // Descend the top two levels here, then walk the subtrees
+    // below them in parallel
+    std::vector<std::shared_ptr<SHAMapInnerNode>> level {
+        std::static_pointer_cast<SHAMapInnerNode>(root_)};
+    for (int depth = 0; depth < 2 && !level.empty (); ++depth)
+    {
+        std::vector<std::shared_ptr<SHAMapInnerNode>> below;
+        for (auto const& node : level)
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                if (node->isEmptyBranch (i))
+                    continue;
+
+                auto nextNode = descendNoStore (node, i);
+                if (!nextNode)
+                {
+                    if (!missing (*node, i))
+                        return;
+                }
+                else if (nextNode->isInner ())
+                {
+                    below.push_back (
+                        std::static_pointer_cast<SHAMapInnerNode>(
+                            std::move (nextNode)));
+                }
+            }
+        }
+        level = std::move (below);
+    }
+
+    std::vector<std::vector<SHAMapMissingNode>> found (level.size ());
+    auto const helpers = std::min (getWalkThreads () - 1,
+        std::max<std::size_t> (level.size (), 1) - 1);
+    runParallel (level.size (), helpers, [&](std::size_t i)
+        {
+            walkSubMap (level[i], found[i], budget);
+            return budget > 0;
+        });
+
+    for (auto& f : found)
+        missingNodes.insert (missingNodes.end (), f.begin (), f.end ());
+}
+
+void
+SHAMap::walkSubMap (std::shared_ptr<SHAMapInnerNode> const& root,
+    std::vector<SHAMapMissingNode>& missingNodes,
+        std::atomic<int>& budget) const
+{
     using StackEntry = std::shared_ptr<SHAMapInnerNode>;
     std::stack <StackEntry, std::vector <StackEntry>> nodeStack;
 
-    nodeStack.push (std::static_pointer_cast<SHAMapInnerNode>(root_));
+    nodeStack.push (root);
 
-    while (!nodeStack.empty ())
+    while (!nodeStack.empty () && budget > 0)
     {
         std::shared_ptr<SHAMapInnerNode> node = std::move (nodeStack.top());
         nodeStack.pop ();
@@ -254,8 +356,11 @@ void SHAMap::walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissi
                 }
                 else
                 {
+                    // Another walker may have used up the budget
+                    if (budget-- <= 0)
+                        return;
                     missingNodes.emplace_back (type_, node->getChildHash (i));
-                    if (--maxMissing <= 0)
+                    if (budget <= 0)
                         return;
                 }
             }
@@ -19,27 +19,96 @@
 
 #include <ripple/protocol/Serializer.h>
 #include <ripple/shamap/SHAMapItem.h>
+#include <cstring>
 
 namespace ripple {
 
 class SHAMap;
 
+static
+std::uint8_t*
+copyData (Slice data)
+{
+    auto const p = static_cast<std::uint8_t*>(
+        SlabPool::allocate (data.size()));
+    if (! data.empty())
+        std::memcpy (p, data.data(), data.size());
+    return p;
+}
+
 SHAMapItem::SHAMapItem (uint256 const& tag, Blob const& data)
-    : tag_(tag)
-    , data_(data)
+    : SHAMapItem (tag, makeSlice (data))
 {
 }
 
-SHAMapItem::SHAMapItem (uint256 const& tag, const Serializer& data)
+SHAMapItem::SHAMapItem (uint256 const& tag, Slice data)
     : tag_ (tag)
-    , data_(data.peekData())
+    , data_ (copyData (data))
+    , size_ (static_cast<std::uint32_t>(data.size()))
+{
+}
+
+SHAMapItem::SHAMapItem (uint256 const& tag, const Serializer& data)
+    : SHAMapItem (tag, data.slice())
 {
 }
 
 SHAMapItem::SHAMapItem (uint256 const& tag, Serializer&& data)
-    : tag_ (tag)
-    , data_(std::move(data.modData()))
+    : SHAMapItem (tag, data.slice())
+{
+}
+
+SHAMapItem::SHAMapItem (SHAMapItem const& other)
+    : tag_ (other.tag_)
+    , data_ (copyData (other.slice()))
+    , size_ (other.size_)
+    , sle_ (other.getSLE())
+{
+}
+
+SHAMapItem::SHAMapItem (SHAMapItem&& other) noexcept
+    : tag_ (other.tag_)
+    , data_ (other.data_)
+    , size_ (other.size_)
+    , sle_ (other.getSLE())
+{
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+SHAMapItem&
+SHAMapItem::operator= (SHAMapItem const& other)
+{
+    if (this != &other)
+        *this = SHAMapItem (other);
+    return *this;
+}
+
+SHAMapItem&
+SHAMapItem::operator= (SHAMapItem&& other) noexcept
+{
+    tag_ = other.tag_;
+    std::swap (data_, other.data_);
+    std::swap (size_, other.size_);
+    setSLE (other.getSLE());
+    return *this;
+}
+
+SHAMapItem::~SHAMapItem()
+{
+    SlabPool::deallocate (data_, size_);
+}
+
+std::shared_ptr<STLedgerEntry const>
+SHAMapItem::getSLE() const
+{
+    return std::atomic_load (&sle_);
+}
+
+void
+SHAMapItem::setSLE (std::shared_ptr<STLedgerEntry const> sle) const
 {
+    std::atomic_store (&sle_, std::move (sle));
 }
 
 } // ripple
@@ -20,9 +20,15 @@
 #include <ripple/basics/random.h>
 #include <ripple/shamap/SHAMap.h>
 #include <ripple/nodestore/Database.h>
+#include <atomic>
+#include <exception>
 
 namespace ripple {
 
+// The most reads getMissingNodes keeps in flight, zero to
+// use the number the node store prefers
+static std::atomic<std::size_t> missingReads {0};
+
 void
 SHAMap::visitLeaves(std::function<void (
     std::shared_ptr<SHAMapItem const> const& item)> const& leafFunction) const
@@ -126,44 +132,114 @@ SHAMap::visitDifferences(SHAMap const* have,
         return;
     }
     // contains unexplored non-matching inner node entries
-    using StackEntry = std::pair <SHAMapInnerNode*, SHAMapNodeID>;
-    std::stack <StackEntry, std::vector<StackEntry>> stack;
-
-    stack.push ({static_cast<SHAMapInnerNode*>(root_.get()), SHAMapNodeID{}});
+    std::vector<VisitEntry> stack;
+    stack.emplace_back (static_cast<SHAMapInnerNode*>(root_.get()), SHAMapNodeID{});
 
     while (! stack.empty())
     {
-        auto const [node, nodeID] = stack.top ();
-        stack.pop ();
+        auto const [node, nodeID] = stack.back ();
+        stack.pop_back ();
 
-        // 1) Add this node to the pack
-        if (! function (*node))
+        if (! visitDifferent (node, nodeID, have, function, stack))
             return;
+    }
+}
 
-        // 2) push non-matching child inner nodes
-        for (int i = 0; i < 16; ++i)
+void
+SHAMap::visitDifferencesParallel(SHAMap const* have,
+    std::function<bool (SHAMapAbstractNode&)> const& function) const
+{
+    assert (root_->isValid ());
+
+    if (! root_ || ! root_->isInner () ||
+        (have && (root_->getNodeHash () == have->root_->getNodeHash ())))
+    {
+        return visitDifferences (have, function);
+    }
+
+    if (root_->getNodeHash ().isZero ())
+        return;
+
+    // Nodes are found on several threads, but are passed
+    // to function one at a time
+    std::mutex mutex;
+    bool done = false;
+    std::function<bool (SHAMapAbstractNode&)> const visit =
+        [&](SHAMapAbstractNode& node)
+        {
+            std::lock_guard lock (mutex);
+            if (! done && ! function (node))
+                done = true;
+            return ! done;
+        };
+
+    // Visit the top two levels here, then the differing
+    // subtrees below them in parallel
+    std::vector<VisitEntry> level;
+    level.emplace_back (static_cast<SHAMapInnerNode*>(root_.get()), SHAMapNodeID{});
+    for (int depth = 0; depth < 2 && ! level.empty (); ++depth)
+    {
+        std::vector<VisitEntry> below;
+        for (auto const& [node, nodeID] : level)
         {
-            if (! node->isEmptyBranch (i))
+            if (! visitDifferent (node, nodeID, have, visit, below))
+                return;
+        }
+        level = std::move (below);
+    }
+
+    auto const helpers = std::min (getWalkThreads () - 1,
+        level.size () / minWalkTasks);
+    runParallel (level.size (), helpers, [&](std::size_t i)
+        {
+            std::vector<VisitEntry> stack {level[i]};
+            while (! stack.empty ())
             {
-                auto const& childHash = node->getChildHash (i);
-                SHAMapNodeID childID = nodeID.getChildNodeID (i);
-                auto next = descendThrow(node, i);
+                auto const [node, nodeID] = stack.back ();
+                stack.pop_back ();
 
-                if (next->isInner ())
-                {
-                    if (! have || ! have->hasInnerNode(childID, childHash))
-                        stack.push ({static_cast<SHAMapInnerNode*>(next), childID});
-                }
-                else if (! have || ! have->hasLeafNode(
-                         static_cast<SHAMapTreeNode*>(next)->peekItem()->key(),
-                         childHash))
-                {
-                    if (! function (*next))
-                        return;
-                }
+                if (! visitDifferent (node, nodeID, have, visit, stack))
+                    return false;
+            }
+            return true;
+        });
+}
+
+bool
+SHAMap::visitDifferent (SHAMapInnerNode* node, SHAMapNodeID const& nodeID,
+    SHAMap const* have, std::function<bool (SHAMapAbstractNode&)> const& function,
+        std::vector<VisitEntry>& nodes) const
+{
+    // 1) Add this node to the pack
+    if (! function (*node))
+        return false;
+
+    // 2) push non-matching child inner nodes,
+    //    reading the absent children in one batch
+    descendBatch (node);
+    for (int i = 0; i < 16; ++i)
+    {
+        if (! node->isEmptyBranch (i))
+        {
+            auto const& childHash = node->getChildHash (i);
+            SHAMapNodeID childID = nodeID.getChildNodeID (i);
+            auto next = descendThrow(node, i);
+
+            if (next->isInner ())
+            {
+                if (! have || ! have->hasInnerNode(childID, childHash))
+                    nodes.emplace_back (static_cast<SHAMapInnerNode*>(next), childID);
+            }
+            else if (! have || ! have->hasLeafNode(
+                     static_cast<SHAMapTreeNode*>(next)->peekItem()->key(),
+                     childHash))
+            {
+                if (! function (*next))
+                    return false;
             }
         }
     }
+    return true;
 }
 
 // Starting at the position referred to by the specfied
@@ -186,9 +262,11 @@ void SHAMap::gmn_ProcessNodes (MissingNodes& mn, MissingNodes::StackEntry& se)
 
         auto const& childHash = node->getChildHash (branch);
 
-        if (mn.missingHashes_.count (childHash) != 0)
+        if (mn.missingHashes_.count (childHash) != 0 ||
+            mn.deferredHashes_.count (childHash) != 0)
         {
-            // we already know this child node is missing
+            // we already know this child node is missing,
+            // or are already reading it
             fullBelow = false;
         }
         else if (! backed_ || ! f_.fullbelow().touch_if_exists (childHash.as_uint256()))
@@ -211,7 +289,10 @@ void SHAMap::gmn_ProcessNodes (MissingNodes& mn, MissingNodes::StackEntry& se)
                         return;
                 }
                 else
+                {
+                    mn.deferredHashes_.insert (childHash);
                     mn.deferredReads_.emplace_back (node, nodeID, branch);
+                }
             }
             else if (d->isInner() &&
                  ! static_cast<SHAMapInnerNode*>(d)->isFullBelow(mn.generation_))
@@ -241,27 +322,26 @@ void SHAMap::gmn_ProcessNodes (MissingNodes& mn, MissingNodes::StackEntry& se)
     node = nullptr;
 }
 
-// Wait for deferred reads to finish and
-// process their results
+// Wait for some deferred reads to finish and process
+// their results, leaving the rest in flight
 void SHAMap::gmn_ProcessDeferredReads (MissingNodes& mn)
 {
-    // Wait for our deferred reads to finish
+    // Half the reads stay in flight while the traversal
+    // resumes below those that finished and posts more
     auto const before = std::chrono::steady_clock::now();
-    f_.db().waitReads();
+    f_.db().waitReads(mn.deferredReads_.size () / 2);
     auto const after = std::chrono::steady_clock::now();
 
     auto const elapsed = std::chrono::duration_cast
         <std::chrono::milliseconds> (after - before);
     auto const count = mn.deferredReads_.size ();
 
-    // Process all deferred reads
     int hits = 0;
-    for (auto const& deferredNode : mn.deferredReads_)
+    auto const process = [&](SHAMapInnerNode* parent,
+        SHAMapNodeID const& parentID, int branch)
     {
-        auto parent = std::get<0>(deferredNode);
-        auto const& parentID = std::get<1>(deferredNode);
-        auto branch = std::get<2>(deferredNode);
         auto const& nodeHash = parent->getChildHash (branch);
+        mn.deferredHashes_.erase (nodeHash);
 
         auto nodePtr = fetchNodeNT(nodeHash, mn.filter_);
         if (nodePtr)
@@ -284,8 +364,30 @@ void SHAMap::gmn_ProcessDeferredReads (MissingNodes& mn)
 
             --mn.max_;
         }
+    };
+
+    // Process the reads that finished, which left their results in the
+    // node store's caches. Those still running are not posted again.
+    decltype(mn.deferredReads_) pending;
+    for (auto const& [parent, parentID, branch] : mn.deferredReads_)
+    {
+        std::shared_ptr<NodeObject> obj;
+        if (f_.db().fetchCached (parent->getChildHash (branch).as_uint256(),
+                ledgerSeq_, obj))
+            process (parent, parentID, branch);
+        else
+            pending.emplace_back (parent, parentID, branch);
     }
-    mn.deferredReads_.clear();
+
+    // If none finished the node store is not keeping up, or is
+    // stopping. Read the rest directly so the traversal progresses.
+    if (pending.size () == count)
+    {
+        for (auto const& [parent, parentID, branch] : pending)
+            process (parent, parentID, branch);
+        pending.clear ();
+    }
+    mn.deferredReads_ = std::move (pending);
 
     auto const process_time = std::chrono::duration_cast
         <std::chrono::milliseconds> (std::chrono::steady_clock::now() - after);
@@ -294,8 +396,9 @@ void SHAMap::gmn_ProcessDeferredReads (MissingNodes& mn)
     if ((count > 50) || (elapsed > 50ms))
     {
         JLOG(journal_.debug()) << "getMissingNodes reads " <<
-            count << " nodes (" << hits << " hits) in "
-            << elapsed.count() << " + " << process_time.count()  << " ms";
+            count - mn.deferredReads_.size () << " of " << count <<
+            " nodes (" << hits << " hits) in " << elapsed.count() <<
+            " + " << process_time.count()  << " ms";
     }
 }
 
@@ -310,8 +413,10 @@ SHAMap::getMissingNodes(int max, SHAMapSyncFilter* filter)
     assert (root_->getNodeHash().isNonZero ());
     assert (max > 0);
 
-    MissingNodes mn (max, filter,
-        f_.db().getDesiredAsyncReadCount(ledgerSeq_),
+    auto maxDefer = f_.db().getDesiredAsyncReadCount(ledgerSeq_);
+    if (auto const reads = missingReads.load(); reads != 0)
+        maxDefer = std::min<int> (maxDefer, reads);
+    MissingNodes mn (max, filter, maxDefer,
         f_.fullbelow().getGeneration());
 
     if (! root_->isInner () ||
@@ -402,9 +507,10 @@ SHAMap::getMissingNodes(int max, SHAMapSyncFilter* filter)
 
         // node will only still be nullptr if
         // we finished the current node, the stack is empty
-        // and we have no nodes to resume
+        // and we have no nodes to resume. Reads may still
+        // be in flight.
 
-    } while (node != nullptr);
+    } while (node != nullptr || ! mn.deferredReads_.empty ());
 
     if (mn.missingNodes_.empty ())
         clearSynching ();
@@ -412,6 +518,12 @@ SHAMap::getMissingNodes(int max, SHAMapSyncFilter* filter)
     return std::move(mn.missingNodes_);
 }
 
+std::size_t
+SHAMap::setMissingReads (std::size_t reads)
+{
+    return missingReads.exchange (reads);
+}
+
 std::vector<uint256> SHAMap::getNeededHashes (int max, SHAMapSyncFilter* filter)
 {
     auto ret = getMissingNodes(max, filter);
@@ -571,9 +683,72 @@ SHAMap::addKnownNode (const SHAMapNodeID& node, Slice const& rawNode,
         return SHAMapAddNode::duplicate ();
     }
 
-    std::uint32_t generation = f_.fullbelow().getGeneration();
     auto newNode = SHAMapAbstractNode::make(rawNode, 0, snfWIRE,
                       SHAMapHash{}, false, f_.journal(), node);
+    return addKnownNode (node, std::move (newNode), Blob{}, filter);
+}
+
+SHAMapAddNode
+SHAMap::addKnownNodes (
+    std::vector<std::pair<SHAMapNodeID, Slice>> const& nodes,
+    SHAMapSyncFilter* filter)
+{
+    if (!isSynching ())
+    {
+        JLOG(journal_.trace()) << "AddKnownNodes while not synching";
+        return SHAMapAddNode::duplicate ();
+    }
+
+    // Decode the nodes first so that their hashes, which must
+    // be checked against the hashes in their parents, can be
+    // computed together. A node that fails to decode ends the
+    // batch, but the nodes before it are still added.
+    std::vector<std::shared_ptr<SHAMapAbstractNode>> newNodes;
+    std::vector<SHAMapAbstractNode*> batch;
+    std::exception_ptr error;
+    newNodes.reserve (nodes.size());
+    batch.reserve (nodes.size());
+    for (auto const& [nodeID, rawNode] : nodes)
+    {
+        assert (!nodeID.isRoot ());
+        try
+        {
+            newNodes.push_back (SHAMapAbstractNode::make (rawNode, 0,
+                snfWIRE, SHAMapHash{}, true, f_.journal(), nodeID));
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+            break;
+        }
+        batch.push_back (newNodes.back().get());
+    }
+
+    std::vector<Blob> raw;
+    SHAMapAbstractNode::updateHashes (batch, raw);
+
+    SHAMapAddNode result;
+    for (std::size_t i = 0; i < newNodes.size(); ++i)
+    {
+        auto const added = addKnownNode (nodes[i].first,
+            std::move (newNodes[i]), std::move (raw[i]), filter);
+        result += added;
+        if (added.isInvalid ())
+            return result;
+    }
+
+    // Fail the way adding the malformed node on its own would
+    if (error)
+        std::rethrow_exception (error);
+    return result;
+}
+
+SHAMapAddNode
+SHAMap::addKnownNode (SHAMapNodeID const& node,
+    std::shared_ptr<SHAMapAbstractNode> newNode, Blob&& raw,
+        SHAMapSyncFilter* filter)
+{
+    std::uint32_t generation = f_.fullbelow().getGeneration();
     SHAMapNodeID iNodeID;
     auto iNode = root_.get();
 
@@ -630,10 +805,14 @@ SHAMap::addKnownNode (const SHAMapNodeID& node, Slice const& rawNode,
 
             if (filter)
             {
-                Serializer s;
-                newNode->addRaw (s, snfPREFIX);
+                if (raw.empty ())
+                {
+                    Serializer s;
+                    newNode->addRaw (s, snfPREFIX);
+                    raw = std::move (s.modData ());
+                }
                 filter->gotNode (false, childHash, ledgerSeq_,
-                                 std::move(s.modData ()), newNode->getType ());
+                                 std::move(raw), newNode->getType ());
             }
 
             return SHAMapAddNode::useful ();
@@ -647,64 +826,93 @@ SHAMap::addKnownNode (const SHAMapNodeID& node, Slice const& rawNode,
 bool SHAMap::deepCompare (SHAMap& other) const
 {
     // Intended for debug/test only
-    std::stack <std::pair <SHAMapAbstractNode*, SHAMapAbstractNode*> > stack;
 
-    stack.push ({root_.get(), other.root_.get()});
-
-    while (!stack.empty ())
+    // Compare the top two levels here, then the subtrees
+    // below them in parallel
+    std::vector<NodePair> level {{root_.get(), other.root_.get()}};
+    for (int depth = 0; depth < 2 && !level.empty (); ++depth)
     {
-        auto const [node, otherNode] = stack.top ();
-        stack.pop ();
-
-        if (!node || !otherNode)
-        {
-            JLOG(journal_.info()) << "unable to fetch node";
-            return false;
-        }
-        else if (otherNode->getNodeHash () != node->getNodeHash ())
+        std::vector<NodePair> below;
+        for (auto const& [node, otherNode] : level)
         {
-            JLOG(journal_.warn()) << "node hash mismatch";
-            return false;
+            if (!compareNodes (node, otherNode, other, below))
+                return false;
         }
+        level = std::move (below);
+    }
 
-        if (node->isLeaf ())
+    std::atomic<bool> equal {true};
+    auto const helpers = std::min (getWalkThreads () - 1,
+        std::max<std::size_t> (level.size (), 1) - 1);
+    runParallel (level.size (), helpers, [&](std::size_t i)
         {
-            if (!otherNode->isLeaf ())
-                 return false;
-            auto& nodePeek = static_cast<SHAMapTreeNode*>(node)->peekItem();
-            auto& otherNodePeek = static_cast<SHAMapTreeNode*>(otherNode)->peekItem();
-            if (nodePeek->key() != otherNodePeek->key())
-                return false;
-            if (nodePeek->peekData() != otherNodePeek->peekData())
-                return false;
-        }
-        else if (node->isInner ())
+            std::vector<NodePair> stack {level[i]};
+            while (!stack.empty () && equal)
+            {
+                auto const [node, otherNode] = stack.back ();
+                stack.pop_back ();
+
+                if (!compareNodes (node, otherNode, other, stack))
+                    equal = false;
+            }
+            return equal.load ();
+        });
+
+    return equal;
+}
+
+bool
+SHAMap::compareNodes (SHAMapAbstractNode* node, SHAMapAbstractNode* otherNode,
+    SHAMap& other, std::vector<NodePair>& nodes) const
+{
+    if (!node || !otherNode)
+    {
+        JLOG(journal_.info()) << "unable to fetch node";
+        return false;
+    }
+    else if (otherNode->getNodeHash () != node->getNodeHash ())
+    {
+        JLOG(journal_.warn()) << "node hash mismatch";
+        return false;
+    }
+
+    if (node->isLeaf ())
+    {
+        if (!otherNode->isLeaf ())
+             return false;
+        auto& nodePeek = static_cast<SHAMapTreeNode*>(node)->peekItem();
+        auto& otherNodePeek = static_cast<SHAMapTreeNode*>(otherNode)->peekItem();
+        if (nodePeek->key() != otherNodePeek->key())
+            return false;
+        if (nodePeek->slice() != otherNodePeek->slice())
+            return false;
+    }
+    else if (node->isInner ())
+    {
+        if (!otherNode->isInner ())
+            return false;
+        auto node_inner = static_cast<SHAMapInnerNode*>(node);
+        auto other_inner = static_cast<SHAMapInnerNode*>(otherNode);
+        for (int i = 0; i < 16; ++i)
         {
-            if (!otherNode->isInner ())
-                return false;
-            auto node_inner = static_cast<SHAMapInnerNode*>(node);
-            auto other_inner = static_cast<SHAMapInnerNode*>(otherNode);
-            for (int i = 0; i < 16; ++i)
+            if (node_inner->isEmptyBranch (i))
             {
-                if (node_inner->isEmptyBranch (i))
-                {
-                    if (!other_inner->isEmptyBranch (i))
-                        return false;
-                }
-                else
-                {
-                    if (other_inner->isEmptyBranch (i))
-                       return false;
+                if (!other_inner->isEmptyBranch (i))
+                    return false;
+            }
+            else
+            {
+                if (other_inner->isEmptyBranch (i))
+                   return false;
 
-                    auto next = descend(node_inner, i);
-                    auto otherNext = other.descend(other_inner, i);
-                    if (!next || !otherNext)
-                    {
-                        JLOG(journal_.warn()) << "unable to fetch inner node";
-                        return false;
-                    }
-                    stack.push ({next, otherNext});
+                auto next = descend(node_inner, i);
+                auto otherNext = other.descend(other_inner, i);
+                if (!next || !otherNext)
+                {
+                    JLOG(journal_.warn()) << "unable to fetch inner node";
+                    return false;
                 }
+                nodes.emplace_back (next, otherNext);
             }
         }
     }
@@ -764,6 +972,9 @@ SHAMap::hasLeafNode (uint256 const& tag, SHAMapHash const& targetNodeHash) const
     return false; // If this was a matching leaf, we would have caught it already
 }
 
+// Set while a fetch pack is built in parallel
+static std::atomic<bool> parallelFetchPack {false};
+
 /**
 @param have A pointer to the map that the recipient already has (if any).
 @param includeLeaves True if leaf nodes should be included.
@@ -772,11 +983,15 @@ SHAMap::hasLeafNode (uint256 const& tag, SHAMapHash const& targetNodeHash) const
 
 Note: a caller should set includeLeaves to false for transaction trees.
 There's no point in including the leaves of transaction trees.
+
+Fetch packs are built at the request of peers, so only one at a time
+descends in parallel and the rest are built on the calling thread.
+Peers cannot then take the threads the family flushes maps with.
 */
 void SHAMap::getFetchPack (SHAMap const* have, bool includeLeaves, int max,
                            std::function<void (SHAMapHash const&, const Blob&)> func) const
 {
-    visitDifferences (have,
+    std::function<bool (SHAMapAbstractNode&)> const visit =
         [includeLeaves, &max, &func] (SHAMapAbstractNode& smn) -> bool
         {
             if (includeLeaves || smn.isInner ())
@@ -789,7 +1004,21 @@ void SHAMap::getFetchPack (SHAMap const* have, bool includeLeaves, int max,
                     return false;
             }
             return true;
-        });
+        };
+
+    if (parallelFetchPack.exchange (true))
+        return visitDifferences (have, visit);
+
+    try
+    {
+        visitDifferencesParallel (have, visit);
+    }
+    catch (...)
+    {
+        parallelFetchPack = false;
+        throw;
+    }
+    parallelFetchPack = false;
 }
 
 } // ripple
@@ -32,27 +32,111 @@
 namespace ripple {
 
 std::mutex SHAMapInnerNode::childLock;
+SHAMapHash const SHAMapInnerNode::emptyHash;
+std::atomic<bool> SHAMapInnerNode::sparse {true};
 
 SHAMapAbstractNode::~SHAMapAbstractNode() = default;
 
+SHAMapInnerNode::~SHAMapInnerNode()
+{
+    freeBranches (mBranches, mCapacity);
+}
+
+auto
+SHAMapInnerNode::allocateBranches (int capacity) -> Branch*
+{
+    if (capacity == 0)
+        return nullptr;
+    SlabAllocator<Branch> alloc;
+    auto const branches = alloc.allocate (capacity);
+    std::uninitialized_value_construct_n (branches, capacity);
+    return branches;
+}
+
+void
+SHAMapInnerNode::freeBranches (Branch* branches, int capacity)
+{
+    if (branches == nullptr)
+        return;
+    std::destroy_n (branches, capacity);
+    SlabAllocator<Branch>{}.deallocate (branches, capacity);
+}
+
 std::shared_ptr<SHAMapAbstractNode>
 SHAMapInnerNode::clone(std::uint32_t seq) const
 {
-    auto p = std::make_shared<SHAMapInnerNode>(seq);
+    auto p = makeSHAMapNode<SHAMapInnerNode>(seq);
     p->mHash = mHash;
     p->mIsBranch = mIsBranch;
+    p->mCapacity = mCapacity;
     p->mFullBelowGen = mFullBelowGen;
-    p->mHashes = mHashes;
+    p->mBranches = allocateBranches (mCapacity);
     std::lock_guard lock(childLock);
-    for (int i = 0; i < 16; ++i)
-        p->mChildren[i] = mChildren[i];
+    for (int i = 0; i < mCapacity; ++i)
+        p->mBranches[i] = mBranches[i];
     return p;
 }
 
+void
+SHAMapInnerNode::setSparse (bool s)
+{
+    sparse = s;
+}
+
+void
+SHAMapInnerNode::resize (std::uint16_t isBranch)
+{
+    int count = 0;
+    for (int m = 0; m < 16; ++m)
+    {
+        if (isBranch & (1 << m))
+            ++count;
+    }
+
+    int capacity = 16;
+    if (count == 0)
+        capacity = 0;
+    else if (sparse)
+    {
+        if (count <= 2)
+            capacity = 2;
+        else if (count <= 4)
+            capacity = 4;
+        else if (count <= 6)
+            capacity = 6;
+    }
+
+    if (capacity == 16 && mCapacity == 16)
+    {
+        // Dense nodes keep their array, only clear removed branches
+        for (int m = 0; m < 16; ++m)
+        {
+            if (! (isBranch & (1 << m)))
+                mBranches[m] = Branch{};
+        }
+        mIsBranch = isBranch;
+        return;
+    }
+
+    auto const branches = allocateBranches (capacity);
+    for (int m = 0, i = 0; m < 16; ++m)
+    {
+        if (! (isBranch & (1 << m)))
+            continue;
+        auto& branch = branches[capacity == 16 ? m : i++];
+        if (! isEmptyBranch (m))
+            branch = std::move(mBranches[getIndex (m)]);
+    }
+    freeBranches (mBranches, mCapacity);
+    mBranches = branches;
+    mCapacity = capacity;
+    mIsBranch = isBranch;
+}
+
 std::shared_ptr<SHAMapAbstractNode>
 SHAMapTreeNode::clone(std::uint32_t seq) const
 {
-    return std::make_shared<SHAMapTreeNode>(mItem, mType, seq, mHash);
+    return makeSHAMapNode<SHAMapTreeNode>(mItem, mType, seq, mHash);
 }
 
 SHAMapTreeNode::SHAMapTreeNode (std::shared_ptr<SHAMapItem const> const& item,
@@ -60,7 +144,7 @@ SHAMapTreeNode::SHAMapTreeNode (std::shared_ptr<SHAMapItem const> const& item,
     : SHAMapAbstractNode(type, seq)
     , mItem (item)
 {
-    assert (item->peekData ().size () >= 12);
+    assert (item->size () >= 12);
     updateHash();
 }
 
@@ -69,7 +153,7 @@ SHAMapTreeNode::SHAMapTreeNode (std::shared_ptr<SHAMapItem const> const& item,
     : SHAMapAbstractNode(type, seq, hash)
     , mItem (item)
 {
-    assert (item->peekData ().size () >= 12);
+    assert (item->size () >= 12);
 }
 
 std::shared_ptr<SHAMapAbstractNode>
@@ -77,27 +161,32 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
                          SHAMapHash const& hash, bool hashValid, beast::Journal j,
                          SHAMapNodeID const& id)
 {
+    // The node is parsed in place: leaf data is copied once, into its
+    // SHAMapItem, and inner node hashes straight into the node.
+    auto hashAt = [](Slice const& s, std::size_t offset)
+    {
+        return uint256::fromVoid(s.data() + offset);
+    };
+
     if (format == snfWIRE)
     {
         if (rawNode.empty ())
             return {};
 
-        Serializer s (rawNode.data(), rawNode.size() - 1);
+        Slice s (rawNode.data(), rawNode.size() - 1);
         int type = rawNode[rawNode.size() - 1];
-        int len = s.getLength ();
+        int len = s.size ();
 
         if ((type < 0) || (type > 6))
             return {};
         if (type == 0)
         {
             // transaction
-            auto item = std::make_shared<SHAMapItem const>(
-                sha512Half(HashPrefix::transactionID,
-                    Slice(s.data(), s.size())),
-                        s.peekData());
+            auto item = makeSHAMapItem(
+                sha512Half(HashPrefix::transactionID, s), s);
             if (hashValid)
-                return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq, hash);
-            return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq);
+                return makeSHAMapNode<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq, hash);
+            return makeSHAMapNode<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq);
         }
         else if (type == 1)
         {
@@ -105,16 +194,15 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
             if (len < (256 / 8))
                 Throw<std::runtime_error> ("short AS node");
 
-            uint256 u;
-            s.get256 (u, len - (256 / 8));
-            s.chop (256 / 8);
+            uint256 const u = hashAt (s, len - (256 / 8));
 
             if (u.isZero ()) Throw<std::runtime_error> ("invalid AS node");
 
-            auto item = std::make_shared<SHAMapItem const> (u, s.peekData ());
+            auto item = makeSHAMapItem (
+                u, Slice (s.data(), len - (256 / 8)));
             if (hashValid)
-                return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq, hash);
-            return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq);
+                return makeSHAMapNode<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq, hash);
+            return makeSHAMapNode<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq);
         }
         else if (type == 2)
         {
@@ -122,13 +210,20 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
             if (len != 512)
                 Throw<std::runtime_error> ("invalid FI node");
 
-            auto ret = std::make_shared<SHAMapInnerNode>(seq);
+            std::uint16_t isBranch = 0;
             for (int i = 0; i < 16; ++i)
             {
-                s.get256 (ret->mHashes[i].as_uint256(), i * 32);
+                if (hashAt (s, i * 32).isNonZero ())
+                    isBranch |= (1 << i);
+            }
 
-                if (ret->mHashes[i].isNonZero ())
-                    ret->mIsBranch |= (1 << i);
+            auto ret = makeSHAMapNode<SHAMapInnerNode>(seq);
+            ret->resize (isBranch);
+            for (int i = 0; i < 16; ++i)
+            {
+                if (! ret->isEmptyBranch (i))
+                    ret->mBranches[ret->getIndex (i)].hash.as_uint256() =
+                        hashAt (s, i * 32);
             }
             if (hashValid)
                 ret->mHash = hash;
@@ -138,18 +233,27 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
         }
         else if (type == 3)
         {
-            auto ret = std::make_shared<SHAMapInnerNode>(seq);
             // compressed inner
+            std::uint16_t isBranch = 0;
             for (int i = 0; i < (len / 33); ++i)
             {
-                int pos;
-                if (! s.get8 (pos, 32 + (i * 33)))
-                    Throw<std::runtime_error> ("short CI node");
-                if ((pos < 0) || (pos >= 16))
+                int const pos = s[32 + (i * 33)];
+                if (pos >= 16)
                     Throw<std::runtime_error> ("invalid CI node");
-                s.get256 (ret->mHashes[pos].as_uint256(), i * 33);
-                if (ret->mHashes[pos].isNonZero ())
-                    ret->mIsBranch |= (1 << pos);
+                if (hashAt (s, i * 33).isNonZero ())
+                    isBranch |= (1 << pos);
+                else
+                    isBranch &= ~(1 << pos);
+            }
+
+            auto ret = makeSHAMapNode<SHAMapInnerNode>(seq);
+            ret->resize (isBranch);
+            for (int i = 0; i < (len / 33); ++i)
+            {
+                int const pos = s[32 + (i * 33)];
+                if (! ret->isEmptyBranch (pos))
+                    ret->mBranches[ret->getIndex (pos)].hash.as_uint256() =
+                        hashAt (s, i * 33);
             }
             if (hashValid)
                 ret->mHash = hash;
@@ -163,17 +267,16 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
             if (len < (256 / 8))
                 Throw<std::runtime_error> ("short TM node");
 
-            uint256 u;
-            s.get256 (u, len - (256 / 8));
-            s.chop (256 / 8);
+            uint256 const u = hashAt (s, len - (256 / 8));
 
             if (u.isZero ())
                 Throw<std::runtime_error> ("invalid TM node");
 
-            auto item = std::make_shared<SHAMapItem const> (u, s.peekData ());
+            auto item = makeSHAMapItem (
+                u, Slice (s.data(), len - (256 / 8)));
             if (hashValid)
-                return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq, hash);
-            return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq);
+                return makeSHAMapNode<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq, hash);
+            return makeSHAMapNode<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq);
         }
     }
 
@@ -192,25 +295,22 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
         prefix |= rawNode[2];
         prefix <<= 8;
         prefix |= rawNode[3];
-        Serializer s (rawNode.data() + 4, rawNode.size() - 4);
+        Slice s (rawNode.data() + 4, rawNode.size() - 4);
 
         if (prefix == HashPrefix::transactionID)
         {
-            auto item = std::make_shared<SHAMapItem const>(
-                sha512Half(rawNode),
-                    s.peekData ());
+            auto item = makeSHAMapItem(
+                sha512Half(rawNode), s);
             if (hashValid)
-                return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq, hash);
-            return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq);
+                return makeSHAMapNode<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq, hash);
+            return makeSHAMapNode<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq);
         }
         else if (prefix == HashPrefix::leafNode)
         {
-            if (s.getLength () < 32)
+            if (s.size () < 32)
                 Throw<std::runtime_error> ("short PLN node");
 
-            uint256 u;
-            s.get256 (u, s.getLength () - 32);
-            s.chop (32);
+            uint256 const u = hashAt (s, s.size () - 32);
 
             if (u.isZero ())
             {
@@ -218,26 +318,31 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
                 Throw<std::runtime_error> ("invalid PLN node");
             }
 
-            auto item = std::make_shared<SHAMapItem const> (u, s.peekData ());
+            auto item = makeSHAMapItem (
+                u, Slice (s.data(), s.size () - 32));
             if (hashValid)
-                return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq, hash);
-            return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq);
+                return makeSHAMapNode<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq, hash);
+            return makeSHAMapNode<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq);
         }
         else if (prefix == HashPrefix::innerNode)
         {
-            auto len = s.getLength();
-
-            if (len != 512)
+            if (s.size () != 512)
                 Throw<std::runtime_error> ("invalid PIN node");
 
-            auto ret = std::make_shared<SHAMapInnerNode>(seq);
-
+            std::uint16_t isBranch = 0;
             for (int i = 0; i < 16; ++i)
             {
-                s.get256 (ret->mHashes[i].as_uint256(), i * 32);
+                if (hashAt (s, i * 32).isNonZero ())
+                    isBranch |= (1 << i);
+            }
 
-                if (ret->mHashes[i].isNonZero ())
-                    ret->mIsBranch |= (1 << i);
+            auto ret = makeSHAMapNode<SHAMapInnerNode>(seq);
+            ret->resize (isBranch);
+            for (int i = 0; i < 16; ++i)
+            {
+                if (! ret->isEmptyBranch (i))
+                    ret->mBranches[ret->getIndex (i)].hash.as_uint256() =
+                        hashAt (s, i * 32);
             }
 
             if (hashValid)
@@ -249,16 +354,15 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
         else if (prefix == HashPrefix::txNode)
         {
             // transaction with metadata
-            if (s.getLength () < 32)
+            if (s.size () < 32)
                 Throw<std::runtime_error> ("short TXN node");
 
-            uint256 txID;
-            s.get256 (txID, s.getLength () - 32);
-            s.chop (32);
-            auto item = std::make_shared<SHAMapItem const> (txID, s.peekData ());
+            uint256 const txID = hashAt (s, s.size () - 32);
+            auto item = makeSHAMapItem (
+                txID, Slice (s.data(), s.size () - 32));
             if (hashValid)
-                return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq, hash);
-            return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq);
+                return makeSHAMapNode<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq, hash);
+            return makeSHAMapNode<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq);
         }
         else
         {
@@ -280,8 +384,8 @@ SHAMapInnerNode::updateHash()
         sha512_half_hasher h;
         using beast::hash_append;
         hash_append(h, HashPrefix::innerNode);
-        for(auto const& hh : mHashes)
-            hash_append(h, hh);
+        for (int m = 0; m < 16; ++m)
+            hash_append(h, getChildHash (m));
         nh = static_cast<typename
             sha512_half_hasher::result_type>(h);
     }
@@ -294,12 +398,57 @@ SHAMapInnerNode::updateHash()
 void
 SHAMapInnerNode::updateHashDeep()
 {
-    for (auto pos = 0; pos < 16; ++pos)
+    updateChildHashes();
+    updateHash();
+}
+
+void
+SHAMapInnerNode::updateChildHashes()
+{
+    for (int i = 0; i < mCapacity; ++i)
     {
-        if (mChildren[pos] != nullptr)
-            mHashes[pos] = mChildren[pos]->getNodeHash();
+        if (mBranches[i].child != nullptr)
+            mBranches[i].hash = mBranches[i].child->getNodeHash();
     }
-    updateHash();
+}
+
+void
+SHAMapAbstractNode::updateHashes(
+    std::vector<SHAMapAbstractNode*> const& nodes, std::vector<Blob>& raw)
+{
+    raw.resize (nodes.size());
+
+    std::vector<Slice> messages;
+    std::vector<std::size_t> index;
+    messages.reserve (nodes.size());
+    index.reserve (nodes.size());
+
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+        auto const node = nodes[i];
+        raw[i].clear();
+        if (node == nullptr || !node->isValid())
+            continue;
+
+        if (node->isInner() &&
+            static_cast<SHAMapInnerNode*>(node)->isEmpty())
+        {
+            node->mHash = SHAMapHash{};
+            continue;
+        }
+
+        Serializer s;
+        node->addRaw (s, snfPREFIX);
+        raw[i] = std::move (s.modData());
+        messages.push_back (makeSlice (raw[i]));
+        index.push_back (i);
+    }
+
+    std::vector<uint256> digests (messages.size());
+    sha512HalfMany (messages.data(), digests.data(), messages.size());
+
+    for (std::size_t j = 0; j < index.size(); ++j)
+        nodes[index[j]]->mHash = SHAMapHash{digests[j]};
 }
 
 bool
@@ -309,18 +458,18 @@ SHAMapTreeNode::updateHash()
     if (mType == tnTRANSACTION_NM)
     {
         nh = sha512Half(HashPrefix::transactionID,
-            makeSlice(mItem->peekData()));
+            mItem->slice());
     }
     else if (mType == tnACCOUNT_STATE)
     {
         nh = sha512Half(HashPrefix::leafNode,
-            makeSlice(mItem->peekData()),
+            mItem->slice(),
                 mItem->key());
     }
     else if (mType == tnTRANSACTION_MD)
     {
         nh = sha512Half(HashPrefix::txNode,
-            makeSlice(mItem->peekData()),
+            mItem->slice(),
                 mItem->key());
     }
     else
@@ -353,18 +502,18 @@ SHAMapInnerNode::addRaw(Serializer& s, SHANodeFormat format) const
         {
             s.add32 (HashPrefix::innerNode);
 
-            for (auto const& hh : mHashes)
-                s.add256 (hh.as_uint256());
+            for (int i = 0; i < 16; ++i)
+                s.add256 (getChildHash (i).as_uint256());
         }
         else  // format == snfWIRE
         {
             if (getBranchCount () < 12)
             {
                 // compressed node
-                for (int i = 0; i < mHashes.size(); ++i)
+                for (int i = 0; i < 16; ++i)
                     if (!isEmptyBranch (i))
                     {
-                        s.add256 (mHashes[i].as_uint256());
+                        s.add256 (getChildHash (i).as_uint256());
                         s.add8 (i);
                     }
 
@@ -372,8 +521,8 @@ SHAMapInnerNode::addRaw(Serializer& s, SHANodeFormat format) const
             }
             else
             {
-                for (auto const& hh : mHashes)
-                    s.add256 (hh.as_uint256());
+                for (int i = 0; i < 16; ++i)
+                    s.add256 (getChildHash (i).as_uint256());
 
                 s.add8 (2);
             }
@@ -400,12 +549,12 @@ SHAMapTreeNode::addRaw(Serializer& s, SHANodeFormat format) const
         if (format == snfPREFIX)
         {
             s.add32 (HashPrefix::leafNode);
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
             s.add256 (mItem->key());
         }
         else
         {
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
             s.add256 (mItem->key());
             s.add8 (1);
         }
@@ -415,11 +564,11 @@ SHAMapTreeNode::addRaw(Serializer& s, SHANodeFormat format) const
         if (format == snfPREFIX)
         {
             s.add32 (HashPrefix::transactionID);
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
         }
         else
         {
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
             s.add8 (0);
         }
     }
@@ -428,12 +577,12 @@ SHAMapTreeNode::addRaw(Serializer& s, SHANodeFormat format) const
         if (format == snfPREFIX)
         {
             s.add32 (HashPrefix::txNode);
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
             s.add256 (mItem->key());
         }
         else
         {
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
             s.add256 (mItem->key());
             s.add8 (4);
         }
@@ -483,14 +632,14 @@ std::string
 SHAMapInnerNode::getString(const SHAMapNodeID & id) const
 {
     std::string ret = SHAMapAbstractNode::getString(id);
-    for (int i = 0; i < mHashes.size(); ++i)
+    for (int i = 0; i < 16; ++i)
     {
         if (!isEmptyBranch (i))
         {
             ret += "\nb";
             ret += beast::lexicalCastThrow <std::string> (i);
             ret += " = ";
-            ret += to_string (mHashes[i]);
+            ret += to_string (getChildHash (i));
         }
     }
     return ret;
@@ -526,13 +675,20 @@ SHAMapInnerNode::setChild(int m, std::shared_ptr<SHAMapAbstractNode> const& chil
     assert (mType == tnINNER);
     assert (mSeq != 0);
     assert (child.get() != this);
-    mHashes[m].zero();
     mHash.zero();
+
+    // Only unshared nodes are modified, so the branch array can be
+    // reallocated without holding childLock.
+    std::uint16_t const isBranch = child ?
+        (mIsBranch | (1 << m)) : (mIsBranch & ~ (1 << m));
+    if (isBranch != mIsBranch)
+        resize (isBranch);
     if (child)
-        mIsBranch |= (1 << m);
-    else
-        mIsBranch &= ~ (1 << m);
-    mChildren[m] = child;
+    {
+        auto& branch = mBranches[getIndex (m)];
+        branch.hash.zero();
+        branch.child = child;
+    }
 }
 
 // finished modifying, now make shareable
@@ -543,8 +699,9 @@ void SHAMapInnerNode::shareChild (int m, std::shared_ptr<SHAMapAbstractNode> con
     assert (mSeq != 0);
     assert (child);
     assert (child.get() != this);
+    assert (!isEmptyBranch (m));
 
-    mChildren[m] = child;
+    mBranches[getIndex (m)].child = child;
 }
 
 SHAMapAbstractNode*
@@ -553,8 +710,11 @@ SHAMapInnerNode::getChildPointer (int branch)
     assert (branch >= 0 && branch < 16);
     assert (isInner());
 
+    if (isEmptyBranch (branch))
+        return nullptr;
+
     std::lock_guard lock (childLock);
-    return mChildren[branch].get ();
+    return mBranches[getIndex (branch)].child.get ();
 }
 
 std::shared_ptr<SHAMapAbstractNode>
@@ -563,8 +723,11 @@ SHAMapInnerNode::getChild (int branch)
     assert (branch >= 0 && branch < 16);
     assert (isInner());
 
+    if (isEmptyBranch (branch))
+        return {};
+
     std::lock_guard lock (childLock);
-    return mChildren[branch];
+    return mBranches[getIndex (branch)].child;
 }
 
 std::shared_ptr<SHAMapAbstractNode>
@@ -573,18 +736,19 @@ SHAMapInnerNode::canonicalizeChild(int branch, std::shared_ptr<SHAMapAbstractNod
     assert (branch >= 0 && branch < 16);
     assert (isInner());
     assert (node);
-    assert (node->getNodeHash() == mHashes[branch]);
+    assert (node->getNodeHash() == getChildHash (branch));
 
     std::lock_guard lock (childLock);
-    if (mChildren[branch])
+    auto& child = mBranches[getIndex (branch)].child;
+    if (child)
     {
         // There is already a node hooked up, return it
-        node = mChildren[branch];
+        node = child;
     }
     else
     {
         // Hook this node up
-        mChildren[branch] = node;
+        child = node;
     }
     return node;
 }
@@ -610,11 +774,11 @@ SHAMapInnerNode::invariants(bool is_root) const
     unsigned count = 0;
     for (int i = 0; i < 16; ++i)
     {
-        if (mHashes[i].isNonZero())
+        if (getChildHash(i).isNonZero())
         {
             assert((mIsBranch & (1 << i)) != 0);
-            if (mChildren[i] != nullptr)
-                mChildren[i]->invariants();
+            if (auto const& child = mBranches[getIndex(i)].child)
+                child->invariants();
             ++count;
         }
         else
@@ -622,6 +786,7 @@ SHAMapInnerNode::invariants(bool is_root) const
             assert((mIsBranch & (1 << i)) == 0);
         }
     }
+    assert(count <= mCapacity);
     if (!is_root)
     {
         assert(mHash.isNonZero());
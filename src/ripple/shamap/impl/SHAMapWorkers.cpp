@@ -0,0 +1,129 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/shamap/SHAMapWorkers.h>
+#include <ripple/beast/core/CurrentThreadName.h>
+#include <algorithm>
+
+namespace ripple {
+
+void
+SHAMapWorkers::Call::work ()
+{
+    try
+    {
+        for (std::size_t i; (i = next++) < count;)
+        {
+            if (! task (i))
+                next = count;
+        }
+    }
+    catch (...)
+    {
+        std::lock_guard lock (mutex);
+        if (! error)
+            error = std::current_exception();
+        next = count;
+    }
+}
+
+SHAMapWorkers::~SHAMapWorkers ()
+{
+    {
+        std::lock_guard lock (mutex_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    for (auto& t : threads_)
+        t.join();
+}
+
+void
+SHAMapWorkers::run (std::size_t count, std::size_t helpers,
+    std::function<bool(std::size_t)> const& task)
+{
+    Call call (count, task);
+    helpers = std::min (helpers, count);
+    if (helpers == 0)
+    {
+        call.work();
+    }
+    else
+    {
+        {
+            std::lock_guard lock (mutex_);
+            while (threads_.size() < helpers)
+                threads_.emplace_back (&SHAMapWorkers::worker, this);
+            queue_.insert (queue_.end(), helpers, &call);
+        }
+        cond_.notify_all();
+
+        call.work();
+
+        // Withdraw the help no thread has picked up,
+        // and wait for the threads that did
+        {
+            std::lock_guard lock (mutex_);
+            queue_.erase (std::remove (queue_.begin(), queue_.end(), &call),
+                queue_.end());
+        }
+        std::unique_lock lock (call.mutex);
+        call.done.wait (lock, [&call] { return call.running == 0; });
+    }
+    if (call.error)
+        std::rethrow_exception (call.error);
+}
+
+std::size_t
+SHAMapWorkers::size () const
+{
+    std::lock_guard lock (mutex_);
+    return threads_.size();
+}
+
+void
+SHAMapWorkers::worker ()
+{
+    beast::setCurrentThreadName ("SHAMapWorker");
+
+    std::unique_lock lock (mutex_);
+    for (;;)
+    {
+        cond_.wait (lock, [this] { return stop_ || ! queue_.empty(); });
+        if (stop_)
+            return;
+        auto const call = queue_.front();
+        queue_.pop_front();
+        ++call->running;
+        lock.unlock();
+
+        call->work();
+
+        // The caller may return as soon as it sees the count
+        // drop, so the call is not touched after this.
+        {
+            std::lock_guard callLock (call->mutex);
+            --call->running;
+            call->done.notify_all();
+        }
+        lock.lock();
+    }
+}
+
+} // ripple
@@ -27,6 +27,7 @@
 #include <ripple/app/ledger/impl/LedgerReplay.cpp>
 #include <ripple/app/ledger/impl/LocalTxs.cpp>
 #include <ripple/app/ledger/impl/OpenLedger.cpp>
+#include <ripple/app/ledger/impl/ParsedSLECache.cpp>
 #include <ripple/app/ledger/impl/LedgerToJson.cpp>
 #include <ripple/app/ledger/impl/TransactionAcquire.cpp>
 #include <ripple/app/ledger/impl/TransactionMaster.cpp>
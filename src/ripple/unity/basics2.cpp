@@ -22,6 +22,7 @@
 #include <ripple/basics/impl/mulDiv.cpp>
 #include <ripple/basics/impl/PerfLogImp.cpp>
 #include <ripple/basics/impl/ResolverAsio.cpp>
+#include <ripple/basics/impl/SlabAllocator.cpp>
 #include <ripple/basics/impl/Sustain.cpp>
 #include <ripple/basics/impl/UptimeClock.cpp>
 #include <ripple/basics/impl/Archive.cpp>
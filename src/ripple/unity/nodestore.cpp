@@ -24,13 +24,18 @@
 #include <ripple/nodestore/backend/RocksDBFactory.cpp>
 
 #include <ripple/nodestore/impl/BatchWriter.cpp>
+#include <ripple/nodestore/impl/BloomFilter.cpp>
+#include <ripple/nodestore/impl/CompressionDictionary.cpp>
 #include <ripple/nodestore/impl/Database.cpp>
 #include <ripple/nodestore/impl/DatabaseNodeImp.cpp>
 #include <ripple/nodestore/impl/DatabaseRotatingImp.cpp>
 #include <ripple/nodestore/impl/DatabaseShardImp.cpp>
+#include <ripple/nodestore/impl/DatabaseTieredImp.cpp>
 #include <ripple/nodestore/impl/DummyScheduler.cpp>
 #include <ripple/nodestore/impl/DecodedBlob.cpp>
 #include <ripple/nodestore/impl/EncodedBlob.cpp>
+#include <ripple/nodestore/impl/FilteredBackend.cpp>
 #include <ripple/nodestore/impl/ManagerImp.cpp>
 #include <ripple/nodestore/impl/NodeObject.cpp>
 #include <ripple/nodestore/impl/Shard.cpp>
+#include <ripple/nodestore/impl/Trace.cpp>
@@ -21,8 +21,12 @@
 #include <ripple/overlay/impl/PeerImp.cpp>
 #include <ripple/overlay/impl/PeerReservationTable.cpp>
 #include <ripple/overlay/impl/PeerSet.cpp>
+#include <ripple/overlay/impl/ReceivedTransactions.cpp>
+#include <ripple/overlay/impl/SendQueue.cpp>
+#include <ripple/overlay/impl/Squelch.cpp>
 #include <ripple/overlay/impl/TMHello.cpp>
 #include <ripple/overlay/impl/TrafficCount.cpp>
+#include <ripple/overlay/impl/TransactionRelay.cpp>
 
 #if DOXYGEN
 #include <ripple/overlay/README.md>
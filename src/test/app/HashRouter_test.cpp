@@ -280,6 +280,70 @@ class HashRouter_test : public beast::unit_test::suite
         BEAST_EXPECT(router.shouldProcess(key, peer, flags, 1s));
     }
 
+    void
+    testProcessBatch()
+    {
+        using namespace std::chrono_literals;
+        TestStopwatch stopwatch;
+        HashRouter router(stopwatch, 5s, 5);
+        uint256 const key1(1);
+        uint256 const key2(2);
+        uint256 const key3(3);
+        HashRouter::PeerShortID peer = 1;
+        int flags;
+        std::vector<int> batchFlags;
+
+        BEAST_EXPECT(router.shouldProcess(key1, peer, flags, 1s));
+        router.setFlags(key2, 16);
+
+        auto const process = router.shouldProcess(
+            {key1, key2, key3}, peer, batchFlags, 1s);
+        BEAST_EXPECT(process.size() == 3 && batchFlags.size() == 3);
+        BEAST_EXPECT(! process[0] && process[1] && process[2]);
+        BEAST_EXPECT(batchFlags[1] == 16);
+
+        BEAST_EXPECT(! router.shouldProcess(key3, peer, flags, 1s));
+    }
+
+    void
+    testProcessBatchInterval()
+    {
+        using namespace std::chrono_literals;
+        TestStopwatch stopwatch;
+        HashRouter router(stopwatch, 5s, 5);
+        uint256 const key1(1);
+        uint256 const key2(2);
+        HashRouter::PeerShortID peer1 = 1;
+        HashRouter::PeerShortID peer2 = 2;
+        std::vector<int> flags{7};
+
+        // An empty batch clears the flags
+        BEAST_EXPECT(router.shouldProcess(
+            std::vector<uint256>{}, peer1, flags, 1s).empty());
+        BEAST_EXPECT(flags.empty());
+
+        // A key repeated within a batch is processed once
+        auto process = router.shouldProcess(
+            {key1, key2, key1}, peer1, flags, 1s);
+        BEAST_EXPECT(process.size() == 3 && flags.size() == 3);
+        BEAST_EXPECT(process[0] && process[1] && ! process[2]);
+
+        // Every sender is recorded, so relaying skips them
+        process = router.shouldProcess({key2}, peer2, flags, 1s);
+        BEAST_EXPECT(process.size() == 1 && ! process[0]);
+        auto const skip = router.shouldRelay(key2);
+        BEAST_EXPECT(skip && skip->size() == 2 &&
+            skip->count(peer1) && skip->count(peer2));
+
+        // Once the interval passes the keys are processed again,
+        // each on its own schedule
+        ++stopwatch;
+        ++stopwatch;
+        BEAST_EXPECT(router.shouldProcess(key1, peer1, flags.front(), 1s));
+        process = router.shouldProcess({key1, key2}, peer2, flags, 1s);
+        BEAST_EXPECT(process.size() == 2 && ! process[0] && process[1]);
+    }
+
 
 public:
 
@@ -293,6 +357,8 @@ public:
         testRelay();
         testRecover();
         testProcess();
+        testProcessBatch();
+        testProcessBatchInterval();
     }
 };
 
@@ -0,0 +1,208 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <test/jtx.h>
+#include <ripple/app/ledger/LedgerMaster.h>
+#include <ripple/core/JobQueue.h>
+#include <ripple/nodestore/Database.h>
+#include <ripple/protocol/digest.h>
+#include <ripple/protocol/HashPrefix.h>
+#include <ripple/protocol/Serializer.h>
+#include <ripple/resource/Fees.h>
+#include <future>
+
+namespace ripple {
+namespace test {
+
+class LedgerFetchPack_test : public beast::unit_test::suite
+{
+    // A leaf node the node store will take, or one whose hash is wrong
+    static LedgerMaster::FetchPackObject
+    makeObject (std::uint32_t i, std::uint32_t seq, bool valid = true)
+    {
+        Serializer s;
+        s.add32 (HashPrefix::leafNode);
+        s.add32 (i);
+        s.add32 (seq);
+        auto hash = sha512Half (s.slice ());
+        if (! valid)
+            hash = sha512Half (hash);
+        return {hash, seq, s.peekData ()};
+    }
+
+    static std::vector<LedgerMaster::FetchPackObject>
+    makeObjects (std::uint32_t count, std::uint32_t seq)
+    {
+        std::vector<LedgerMaster::FetchPackObject> objects;
+        for (std::uint32_t i = 0; i < count; ++i)
+            objects.push_back (makeObject (i, seq));
+        return objects;
+    }
+
+    bool
+    stored (jtx::Env& env, LedgerMaster::FetchPackObject const& object)
+    {
+        return env.app ().getNodeStore ().fetch (
+            object.hash, object.ledgerSeq) != nullptr;
+    }
+
+    // Holds the job queue's only worker until released
+    class Blocker
+    {
+        std::promise<void> started_;
+        std::promise<void> release_;
+
+    public:
+        explicit Blocker (JobQueue& jobQueue)
+        {
+            auto released = release_.get_future ().share ();
+            jobQueue.addJob (jtCLIENT, "blocker",
+                [this, released] (Job&)
+                {
+                    started_.set_value ();
+                    released.wait ();
+                });
+            started_.get_future ().wait ();
+        }
+
+        void
+        release ()
+        {
+            release_.set_value ();
+        }
+    };
+
+    void
+    testChunkedStore ()
+    {
+        testcase ("Chunked store");
+
+        using namespace jtx;
+        Env env {*this};
+        auto& lm = env.app ().getLedgerMaster ();
+
+        // Several verification batches, with bad objects at the edges
+        // of the first two
+        std::uint32_t const seq = 1000;
+        auto objects = makeObjects (600, seq);
+        for (auto const i : {255, 256, 599})
+            objects[i] = makeObject (i, seq, false);
+        auto const expected = objects;
+
+        BEAST_EXPECT(lm.storeFetchPack (std::move (objects), true, seq));
+        env.app ().getJobQueue ().rendezvous ();
+
+        for (std::size_t i = 0; i < expected.size (); ++i)
+        {
+            bool const valid = i != 255 && i != 256 && i != 599;
+            BEAST_EXPECT(stored (env, expected[i]) == valid);
+        }
+    }
+
+    void
+    testJobLimit ()
+    {
+        testcase ("Job limit");
+
+        using namespace jtx;
+        Env env {*this};
+        auto& lm = env.app ().getLedgerMaster ();
+        auto& jobQueue = env.app ().getJobQueue ();
+
+        // Stored chunks wait in the queue while the worker is busy
+        std::vector<std::vector<LedgerMaster::FetchPackObject>> chunks;
+        for (std::uint32_t seq = 2000; seq < 2010; ++seq)
+            chunks.push_back (makeObjects (4, seq));
+
+        Blocker blocker {jobQueue};
+        std::size_t taken = 0;
+        for (auto const& chunk : chunks)
+        {
+            if (! lm.storeFetchPack (chunk, true, chunk.front ().ledgerSeq))
+                break;
+            ++taken;
+        }
+        BEAST_EXPECT(taken == 8);
+
+        // Once the queue drains there is room again
+        blocker.release ();
+        jobQueue.rendezvous ();
+        BEAST_EXPECT(lm.storeFetchPack (
+            chunks.back (), true, chunks.back ().front ().ledgerSeq));
+        jobQueue.rendezvous ();
+
+        for (std::size_t i = 0; i < chunks.size (); ++i)
+        {
+            for (auto const& object : chunks[i])
+                BEAST_EXPECT(stored (env, object) == (i != taken));
+        }
+    }
+
+    void
+    testUnsolicited ()
+    {
+        testcase ("Unsolicited");
+
+        using namespace jtx;
+        Env env {*this};
+        auto& lm = env.app ().getLedgerMaster ();
+
+        std::uint32_t const seq = 3000;
+        auto const objects = makeObjects (4, seq);
+
+        protocol::TMGetObjectByHash packet;
+        packet.set_type (protocol::TMGetObjectByHash::otFETCH_PACK);
+        packet.set_query (false);
+        for (auto const& object : objects)
+        {
+            auto& obj = *packet.add_objects ();
+            obj.set_hash (object.hash.begin (), object.hash.size ());
+            obj.set_ledgerseq (object.ledgerSeq);
+            obj.set_data (object.data.data (), object.data.size ());
+        }
+
+        // No ledger named
+        BEAST_EXPECT(lm.receiveFetchPack (1, packet) ==
+            Resource::feeUnwantedData);
+
+        // A ledger, but no fetch pack was asked for
+        auto const hash = env.closed ()->info ().hash;
+        packet.set_ledgerhash (hash.begin (), hash.size ());
+        BEAST_EXPECT(lm.receiveFetchPack (1, packet) ==
+            Resource::feeUnwantedData);
+
+        env.app ().getJobQueue ().rendezvous ();
+        for (auto const& object : objects)
+            BEAST_EXPECT(! stored (env, object));
+    }
+
+public:
+    void
+    run () override
+    {
+        testChunkedStore ();
+        testJobLimit ();
+        testUnsolicited ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(LedgerFetchPack,app,ripple);
+
+} // test
+} // ripple
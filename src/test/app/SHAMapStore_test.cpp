@@ -17,12 +17,15 @@
 */
 //==============================================================================
 
+#include <ripple/app/ledger/LedgerMaster.h>
 #include <ripple/app/main/Application.h>
 #include <ripple/app/misc/SHAMapStore.h>
 #include <ripple/core/ConfigSections.h>
 #include <ripple/core/DatabaseCon.h>
 #include <ripple/core/SociDB.h>
+#include <ripple/nodestore/DatabaseRotating.h>
 #include <ripple/protocol/jss.h>
+#include <ripple/shamap/SHAMapTreeNode.h>
 #include <test/jtx.h>
 #include <test/jtx/envconfig.h>
 
@@ -53,6 +56,53 @@ class SHAMapStore_test : public beast::unit_test::suite
         return cfg;
     }
 
+    static
+    auto
+    incrementalCopy(std::unique_ptr<Config> cfg)
+    {
+        cfg = onlineDelete(std::move(cfg));
+        cfg->section(ConfigSection::nodeDatabase())
+            .set("incremental_copy", "1000");
+        return cfg;
+    }
+
+    // Count the state nodes of a ledger missing from both backends
+    static
+    std::size_t
+    missingState(NodeStore::DatabaseRotating& db, Ledger const& ledger)
+    {
+        std::size_t missing = 0;
+        std::vector<uint256> walk {ledger.info().accountHash};
+        while (! walk.empty())
+        {
+            auto const hash = walk.back();
+            walk.pop_back();
+
+            bool copied;
+            auto const obj = db.fetchToWritable(hash, copied);
+            if (! obj)
+            {
+                ++missing;
+                continue;
+            }
+
+            auto const node = SHAMapAbstractNode::make(
+                makeSlice(obj->getData()), 0, snfPREFIX, SHAMapHash{hash},
+                true, beast::Journal{beast::Journal::getNullSink()});
+            if (node && node->isInner())
+            {
+                auto const inner =
+                    std::static_pointer_cast<SHAMapInnerNode>(node);
+                for (int i = 0; i < 16; ++i)
+                {
+                    if (! inner->isEmptyBranch(i))
+                        walk.push_back(inner->getChildHash(i).as_uint256());
+                }
+            }
+        }
+        return missing;
+    }
+
     bool goodLedger(jtx::Env& env, Json::Value const& json,
         std::string ledgerID, bool checkDB = false)
     {
@@ -520,11 +570,72 @@ public:
         lastRotated = ledgerSeq - 1;
     }
 
+    void testIncremental()
+    {
+        testcase("online_delete with incremental_copy");
+        using namespace jtx;
+
+        Env env(*this, envconfig(incrementalCopy));
+        auto& store = env.app().getSHAMapStore();
+        env.fund(XRP(10000), noripple("alice"));
+
+        auto ledgerSeq = waitForReady(env);
+        auto lastRotated = ledgerSeq - 1;
+
+        auto counts = env.rpc("get_counts")[jss::result];
+        BEAST_EXPECT(counts.isMember(jss::online_delete));
+        BEAST_EXPECT(counts[jss::online_delete][jss::ledger_index] == 0);
+        BEAST_EXPECT(
+            counts[jss::online_delete].isMember(jss::incremental));
+
+        for (int rotation = 0; rotation < 2; ++rotation)
+        {
+            // The last iteration of this loop triggers a rotate
+            for (; ledgerSeq < lastRotated + deleteInterval + 1; ++ledgerSeq)
+            {
+                env.fund(XRP(10000),
+                    noripple("test" + to_string(ledgerSeq)));
+                env.close();
+
+                auto ledger = env.rpc("ledger", "validated");
+                BEAST_EXPECT(goodLedger(
+                    env, ledger, to_string(ledgerSeq), true));
+            }
+
+            store.rendezvous();
+
+            ledgerCheck(env, deleteInterval + 1, lastRotated);
+            BEAST_EXPECT(lastRotated != store.getLastRotated());
+            lastRotated = store.getLastRotated();
+
+            counts = env.rpc("get_counts")[jss::result];
+            BEAST_EXPECT(counts[jss::online_delete][jss::ledger_index] ==
+                lastRotated);
+        }
+
+        // The whole validated state survived both rotations in the
+        // node store, including nodes that were served from a cache
+        auto const validated =
+            env.app().getLedgerMaster().getValidatedLedger();
+        auto const db = dynamic_cast<NodeStore::DatabaseRotating*>(
+            &env.app().getNodeStore());
+        BEAST_EXPECT(validated && db);
+        if (validated && db)
+            BEAST_EXPECT(missingState(*db, *validated) == 0);
+
+        // Accounts funded before both rotations are still present
+        BEAST_EXPECT(env.balance(Account("alice")) == XRP(10000));
+        BEAST_EXPECT(env.rpc("account_info",
+            Account("alice").human())[jss::result].isMember(
+                jss::account_data));
+    }
+
     void run() override
     {
         testClear();
         testAutomatic();
         testCanDelete();
+        testIncremental();
     }
 };
 
@@ -0,0 +1,167 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/basics/SlabAllocator.h>
+#include <ripple/beast/unit_test.h>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+
+class SlabAllocator_test : public beast::unit_test::suite
+{
+    void
+    testSizes()
+    {
+        testcase ("sizes");
+
+        // Every size, including those past the largest class, is
+        // usable for its full length
+        std::vector<std::pair<std::uint8_t*, std::size_t>> blocks;
+        for (std::size_t n = 0; n <= SlabPool::maxSize + 64; ++n)
+        {
+            auto const p = static_cast<std::uint8_t*>(
+                SlabPool::allocate (n));
+            BEAST_EXPECT (p != nullptr);
+            BEAST_EXPECT (reinterpret_cast<std::uintptr_t>(p) %
+                SlabPool::alignment == 0);
+            std::memset (p, static_cast<int>(n & 0xff), n);
+            blocks.emplace_back (p, n);
+        }
+        for (auto const& b : blocks)
+        {
+            bool intact = true;
+            for (std::size_t i = 0; i < b.second; ++i)
+                intact = intact && b.first[i] == (b.second & 0xff);
+            BEAST_EXPECT (intact);
+            SlabPool::deallocate (b.first, b.second);
+        }
+        BEAST_EXPECT (SlabPool::used() <= SlabPool::reserved());
+    }
+
+    void
+    testReuse()
+    {
+        testcase ("reuse");
+
+        // Freed blocks are handed out again before new slabs are carved
+        std::vector<void*> blocks;
+        for (int i = 0; i < 10000; ++i)
+            blocks.push_back (SlabPool::allocate (48));
+        auto const reserved = SlabPool::reserved();
+        for (int round = 0; round < 10; ++round)
+        {
+            for (auto& p : blocks)
+                SlabPool::deallocate (p, 48);
+            for (auto& p : blocks)
+                p = SlabPool::allocate (40);
+        }
+        BEAST_EXPECT (SlabPool::reserved() == reserved);
+        for (auto p : blocks)
+            SlabPool::deallocate (p, 40);
+    }
+
+    void
+    testAllocator()
+    {
+        testcase ("allocator");
+
+        SlabAllocator<int> a;
+        SlabAllocator<double> b (a);
+        BEAST_EXPECT (a == b);
+        BEAST_EXPECT (! (a != b));
+
+        auto const p = std::allocate_shared<std::string>(
+            SlabAllocator<std::string>{}, "slab");
+        BEAST_EXPECT (*p == "slab");
+
+        std::list<int, SlabAllocator<int>> l;
+        for (int i = 0; i < 1000; ++i)
+            l.push_back (i);
+        BEAST_EXPECT (l.size() == 1000);
+        BEAST_EXPECT (l.back() == 999);
+    }
+
+    void
+    testThreads()
+    {
+        testcase ("threads");
+
+        // Blocks may be freed by a thread other than the one which
+        // allocated them, and outlive the allocating thread
+        std::size_t const count = 20000;
+        std::vector<std::vector<std::uint32_t*>> made (4);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < made.size(); ++t)
+        {
+            threads.emplace_back ([&made, t, count]
+                {
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        auto const p = static_cast<std::uint32_t*>(
+                            SlabPool::allocate (sizeof(std::uint32_t)));
+                        *p = static_cast<std::uint32_t>(t * count + i);
+                        made[t].push_back (p);
+                    }
+                });
+        }
+        for (auto& t : threads)
+            t.join();
+        threads.clear();
+
+        std::vector<bool> intact (made.size(), true);
+        for (std::size_t t = 0; t < made.size(); ++t)
+        {
+            threads.emplace_back ([&made, &intact, t, count]
+                {
+                    // Free another thread's blocks
+                    auto const& blocks = made[(t + 1) % made.size()];
+                    auto const base = ((t + 1) % made.size()) * count;
+                    for (std::size_t i = 0; i < blocks.size(); ++i)
+                    {
+                        if (*blocks[i] != base + i)
+                            intact[t] = false;
+                        SlabPool::deallocate (
+                            blocks[i], sizeof(std::uint32_t));
+                    }
+                });
+        }
+        for (auto& t : threads)
+            t.join();
+        for (bool ok : intact)
+            BEAST_EXPECT (ok);
+    }
+
+public:
+    void
+    run() override
+    {
+        testSizes();
+        testReuse();
+        testAllocator();
+        testThreads();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SlabAllocator,ripple_basics,ripple);
+
+} // ripple
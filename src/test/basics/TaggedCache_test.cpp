@@ -18,10 +18,13 @@
 //==============================================================================
 
 #include <ripple/basics/chrono.h>
+#include <ripple/basics/ShardedTaggedCache.h>
 #include <ripple/basics/TaggedCache.h>
 #include <ripple/beast/unit_test.h>
 #include <ripple/beast/clock/manual_clock.h>
 #include <test/unit_test/SuiteJournal.h>
+#include <atomic>
+#include <thread>
 
 namespace ripple {
 
@@ -37,9 +40,11 @@ original object.
 
 class TaggedCache_test : public beast::unit_test::suite
 {
-public:
-    void run () override
+    template <class Cache>
+    void testCache (std::string const& name)
     {
+        testcase (name);
+
         using namespace std::chrono_literals;
         using namespace beast::severities;
         test::SuiteJournal journal ("TaggedCache_test", *this);
@@ -47,9 +52,7 @@ public:
         TestStopwatch clock;
         clock.set (0);
 
-        using Key = int;
-        using Value = std::string;
-        using Cache = TaggedCache <Key, Value>;
+        using Value = typename Cache::mapped_type;
 
         Cache c ("test", 1, 1s, clock, journal);
 
@@ -81,7 +84,7 @@ public:
             BEAST_EXPECT(c.getTrackSize() == 1);
 
             {
-                Cache::mapped_ptr p (c.fetch (2));
+                typename Cache::mapped_ptr p (c.fetch (2));
                 BEAST_EXPECT(p != nullptr);
                 ++clock;
                 c.sweep ();
@@ -101,8 +104,8 @@ public:
             BEAST_EXPECT(! c.insert (3, "three"));
 
             {
-                Cache::mapped_ptr const p1 (c.fetch (3));
-                Cache::mapped_ptr p2 (std::make_shared <Value> ("three"));
+                typename Cache::mapped_ptr const p1 (c.fetch (3));
+                typename Cache::mapped_ptr p2 (std::make_shared <Value> ("three"));
                 c.canonicalize (3, p2);
                 BEAST_EXPECT(p1.get() == p2.get());
             }
@@ -123,7 +126,7 @@ public:
 
             {
                 // Keep a strong pointer to it
-                Cache::mapped_ptr p1 (c.fetch (4));
+                typename Cache::mapped_ptr p1 (c.fetch (4));
                 BEAST_EXPECT(p1 != nullptr);
                 BEAST_EXPECT(c.getCacheSize() == 1);
                 BEAST_EXPECT(c.getTrackSize() == 1);
@@ -133,7 +136,7 @@ public:
                 BEAST_EXPECT(c.getCacheSize() == 0);
                 BEAST_EXPECT(c.getTrackSize() == 1);
                 // Canonicalize a new object with the same key
-                Cache::mapped_ptr p2 (std::make_shared <std::string> ("four"));
+                typename Cache::mapped_ptr p2 (std::make_shared <std::string> ("four"));
                 BEAST_EXPECT(c.canonicalize (4, p2, false));
                 BEAST_EXPECT(c.getCacheSize() == 1);
                 BEAST_EXPECT(c.getTrackSize() == 1);
@@ -147,8 +150,175 @@ public:
             BEAST_EXPECT(c.getTrackSize() == 0);
         }
     }
+
+    // Threads canonicalizing the same keys must all end up
+    // holding the same objects.
+    template <class Cache>
+    void testConcurrent (std::string const& name)
+    {
+        testcase (name + " concurrent");
+
+        using namespace std::chrono_literals;
+        test::SuiteJournal journal ("TaggedCache_test", *this);
+
+        TestStopwatch clock;
+        clock.set (0);
+
+        Cache c ("test", 0, 1s, clock, journal);
+
+        int const keys = 1000;
+        int const threads = 4;
+        std::vector<std::vector<typename Cache::mapped_ptr>> held (threads);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back ([&c, &held, t, keys]
+            {
+                for (int k = 0; k < keys; ++k)
+                {
+                    auto p = std::make_shared<std::string> (
+                        std::to_string (k));
+                    c.canonicalize (k, p);
+                    held[t].push_back (p);
+                }
+            });
+        }
+        for (auto& w : workers)
+            w.join ();
+
+        BEAST_EXPECT(c.getCacheSize() == keys);
+        BEAST_EXPECT(c.getTrackSize() == keys);
+        BEAST_EXPECT(c.getKeys().size() == keys);
+        bool same = true;
+        for (int k = 0; k < keys; ++k)
+        {
+            for (int t = 1; t < threads; ++t)
+                same = same && held[t][k] == held[0][k];
+            same = same && c.fetch (k) == held[0][k];
+        }
+        BEAST_EXPECT(same);
+
+        // Entries with outside references remain tracked
+        ++clock;
+        c.sweep ();
+        BEAST_EXPECT(c.getCacheSize() == 0);
+        BEAST_EXPECT(c.getTrackSize() == keys);
+        held.clear ();
+        c.sweep ();
+        BEAST_EXPECT(c.getTrackSize() == 0);
+    }
+
+    // The target size applies to the whole cache, however small
+    template <class Cache>
+    void testTarget (std::string const& name)
+    {
+        testcase (name + " target");
+
+        using namespace std::chrono_literals;
+        test::SuiteJournal journal ("TaggedCache_test", *this);
+
+        TestStopwatch clock;
+        clock.set (1000);
+
+        Cache c ("test", 1, 64s, clock, journal);
+        int const keys = 16;
+        for (int k = 0; k < keys; ++k)
+            c.insert (k, std::to_string (k));
+
+        // Sixteen times the target ages sixteen times as fast
+        clock.advance (3s);
+        c.sweep ();
+        BEAST_EXPECT(c.getCacheSize() == keys);
+        clock.advance (2s);
+        c.sweep ();
+        BEAST_EXPECT(c.getCacheSize() == 0);
+    }
+
+public:
+    void run () override
+    {
+        using Key = int;
+        using Value = std::string;
+
+        testCache <TaggedCache <Key, Value>> ("TaggedCache");
+        testCache <ShardedTaggedCache <Key, Value>> ("ShardedTaggedCache");
+        testConcurrent <TaggedCache <Key, Value>> ("TaggedCache");
+        testConcurrent <ShardedTaggedCache <Key, Value>> ("ShardedTaggedCache");
+        testTarget <TaggedCache <Key, Value>> ("TaggedCache");
+        testTarget <ShardedTaggedCache <Key, Value>> ("ShardedTaggedCache");
+    }
+};
+
+//------------------------------------------------------------------------------
+
+// Measures lookups from several threads against one cache
+class TaggedCacheContention_test : public beast::unit_test::suite
+{
+    template <class Cache>
+    std::chrono::milliseconds
+    measure (int threads, int keys, int lookups)
+    {
+        using namespace std::chrono;
+        test::SuiteJournal journal ("TaggedCacheContention_test", *this);
+
+        Cache c ("bench", 0, minutes{1}, stopwatch(), journal);
+        for (int k = 0; k < keys; ++k)
+            c.insert (k, k);
+
+        std::atomic<bool> start {false};
+        std::atomic<int> found {0};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back ([&, t]
+            {
+                while (! start)
+                    std::this_thread::yield ();
+                int n = 0;
+                for (int i = 0; i < lookups; ++i)
+                {
+                    // Mostly hits, with some misses and inserts
+                    int const k = (i * 7919 + t * 104729) % (keys + keys / 8);
+                    if (c.fetch (k))
+                        ++n;
+                    else if (i % 4 == 0)
+                        c.insert (k, k);
+                }
+                found += n;
+            });
+        }
+
+        auto const begin = steady_clock::now ();
+        start = true;
+        for (auto& w : workers)
+            w.join ();
+        auto const elapsed = duration_cast<milliseconds> (
+            steady_clock::now () - begin);
+        BEAST_EXPECT(found > 0);
+        return elapsed;
+    }
+
+public:
+    void run () override
+    {
+        int const keys = 1 << 16;
+        int const lookups = 1 << 18;
+
+        for (int threads : {1, 2, 4, 8, 16})
+        {
+            auto const plain = measure <TaggedCache <int, int>> (
+                threads, keys, lookups);
+            auto const sharded = measure <ShardedTaggedCache <int, int>> (
+                threads, keys, lookups);
+            log << threads << " threads: TaggedCache " << plain.count () <<
+                "ms, ShardedTaggedCache " << sharded.count () << "ms" <<
+                std::endl;
+        }
+        pass ();
+    }
 };
 
 BEAST_DEFINE_TESTSUITE(TaggedCache,common,ripple);
+BEAST_DEFINE_TESTSUITE_MANUAL(TaggedCacheContention,common,ripple);
 
 }
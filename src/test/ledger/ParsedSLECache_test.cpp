@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <ripple/app/ledger/Ledger.h>
+#include <ripple/app/ledger/ParsedSLECache.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/protocol/Indexes.h>
+#include <test/jtx.h>
+
+namespace ripple {
+namespace test {
+
+class ParsedSLECache_test : public beast::unit_test::suite
+{
+    static
+    std::shared_ptr<SHAMapItem const>
+    makeItem (std::uint32_t seq)
+    {
+        AccountID const id {seq + 1};
+        SLE sle (keylet::account (id));
+        sle.setAccountID (sfAccount, id);
+        sle.setFieldU32 (sfSequence, seq);
+        sle.setFieldAmount (sfBalance, XRPAmount (1000000));
+        Serializer s;
+        sle.add (s);
+        return std::make_shared<SHAMapItem const> (sle.key(), s.slice());
+    }
+
+    void
+    testAttach()
+    {
+        testcase ("attach");
+
+        ParsedSLECache cache (1024 * 1024);
+        auto const item = makeItem (7);
+        BEAST_EXPECT (! item->getSLE());
+
+        auto const first = cache.fetch (item);
+        BEAST_EXPECT (first->key() == item->key());
+        BEAST_EXPECT (first->getFieldU32 (sfSequence) == 7);
+        BEAST_EXPECT (item->getSLE() == first);
+        BEAST_EXPECT (cache.count() == 1);
+
+        // Later reads return the attached entry
+        BEAST_EXPECT (cache.fetch (item) == first);
+        BEAST_EXPECT (cache.fetch (item) == first);
+        BEAST_EXPECT (cache.count() == 1);
+        BEAST_EXPECT (cache.rate() > 0.6 && cache.rate() < 0.7);
+
+        // A zero budget detaches everything and parses every read
+        cache.setBudget (0);
+        BEAST_EXPECT (cache.count() == 0);
+        BEAST_EXPECT (cache.size() == 0);
+        BEAST_EXPECT (! item->getSLE());
+        auto const second = cache.fetch (item);
+        BEAST_EXPECT (second != first);
+        BEAST_EXPECT (second->getFieldU32 (sfSequence) == 7);
+        BEAST_EXPECT (! item->getSLE());
+    }
+
+    void
+    testEvict()
+    {
+        testcase ("evict");
+
+        std::vector<std::shared_ptr<SHAMapItem const>> items;
+        for (std::uint32_t i = 0; i < 32; ++i)
+            items.push_back (makeItem (i));
+
+        // Every item parses to an entry of the same size
+        ParsedSLECache sizer (1024 * 1024);
+        auto const sample = makeItem (100);
+        sizer.fetch (sample);
+        auto const each = sizer.size();
+        BEAST_EXPECT (each > sample->size());
+
+        // Room for eight entries: the oldest are detached first
+        ParsedSLECache cache (8 * each);
+        for (auto const& item : items)
+            cache.fetch (item);
+        BEAST_EXPECT (cache.count() == 8);
+        BEAST_EXPECT (cache.size() <= 8 * each);
+        for (std::size_t i = 0; i < items.size(); ++i)
+            BEAST_EXPECT (bool (items[i]->getSLE()) == (i >= 24));
+
+        // Items destroyed while attached are eventually forgotten
+        items.resize (16);
+        for (auto const& item : items)
+            cache.fetch (item);
+        BEAST_EXPECT (cache.count() == 8);
+        for (std::size_t i = 0; i < items.size(); ++i)
+            BEAST_EXPECT (bool (items[i]->getSLE()) == (i >= 8));
+    }
+
+    void
+    testLedgerRead()
+    {
+        testcase ("ledger read");
+
+        using namespace jtx;
+        Env env (*this);
+        Account const alice ("alice");
+        env.fund (XRP (10000), alice);
+        env.close();
+
+        auto const ledger = env.closed();
+        auto const first = ledger->read (keylet::account (alice.id()));
+        BEAST_EXPECT (first);
+        BEAST_EXPECT (ledger->read (keylet::account (alice.id())) == first);
+
+        // The entry is shared with later ledgers holding the same item
+        env.close();
+        BEAST_EXPECT (env.closed()->read (
+            keylet::account (alice.id())) == first);
+
+        // A keylet of the wrong type still finds nothing
+        BEAST_EXPECT (! ledger->read (
+            Keylet (ltOFFER, keylet::account (alice.id()).key)));
+    }
+
+public:
+    void
+    run() override
+    {
+        testAttach();
+        testEvict();
+        testLedgerRead();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(ParsedSLECache,ledger,ripple);
+
+}  // test
+}  // ripple
@@ -20,6 +20,8 @@
 #include <ripple/unity/rocksdb.h>
 #include <ripple/nodestore/DummyScheduler.h>
 #include <ripple/nodestore/Manager.h>
+#include <ripple/nodestore/impl/CompressionDictionary.h>
+#include <ripple/nodestore/impl/EncodedBlob.h>
 #include <ripple/beast/utility/temp_dir.h>
 #include <test/nodestore/TestBase.h>
 #include <test/unit_test/SuiteJournal.h>
@@ -73,6 +75,13 @@ public:
                 BEAST_EXPECT(areBatchesEqual (batch, copy));
             }
 
+            {
+                // Read it back in with one batch fetch
+                Batch copy;
+                fetchBatchCopyOfBatch (*backend, &copy, batch);
+                BEAST_EXPECT(areBatchesEqual (batch, copy));
+            }
+
             {
                 // Reorder and read the copy again
                 std::shuffle (
@@ -103,12 +112,157 @@ public:
 
     //--------------------------------------------------------------------------
 
+    void testFilteredBackend (std::uint64_t const seedValue)
+    {
+        DummyScheduler scheduler;
+
+        testcase ("Backend with lookup filter");
+
+        Section params;
+        beast::temp_dir tempDir;
+        params.set ("type", "nudb");
+        params.set ("path", tempDir.path());
+        params.set ("filter_keys", std::to_string (numObjectsToTest));
+
+        beast::xor_shift_engine rng (seedValue);
+        auto batch = createPredictableBatch (numObjectsToTest, rng());
+        auto const missing = createPredictableBatch (numObjectsToTest, rng());
+
+        test::SuiteJournal journal ("Backend_test", *this);
+        boost::filesystem::path const filterPath =
+            boost::filesystem::path (tempDir.path()) / "filter";
+
+        {
+            std::unique_ptr <Backend> backend =
+                Manager::instance().make_Backend (
+                    params, scheduler, journal);
+            backend->open();
+            BEAST_EXPECT(backend->getFilterCounts().enabled);
+
+            storeBatch (*backend, batch);
+
+            Batch copy;
+            fetchCopyOfBatch (*backend, &copy, batch);
+            BEAST_EXPECT(areBatchesEqual (batch, copy));
+
+            // Objects never stored are mostly rejected by the filter
+            fetchCopyOfBatch (*backend, &copy, missing);
+            BEAST_EXPECT(copy.empty());
+            auto const counts = backend->getFilterCounts();
+            BEAST_EXPECT(counts.rejected + counts.falsePositives ==
+                missing.size());
+            BEAST_EXPECT(counts.falsePositiveRate() < 0.05);
+        }
+
+        // The filter is saved on close
+        BEAST_EXPECT(boost::filesystem::exists (filterPath));
+
+        {
+            std::unique_ptr <Backend> backend =
+                Manager::instance().make_Backend (
+                    params, scheduler, journal);
+            backend->open();
+
+            // and removed while the backend is open
+            BEAST_EXPECT(! boost::filesystem::exists (filterPath));
+
+            Batch copy;
+            fetchBatchCopyOfBatch (*backend, &copy, batch);
+            BEAST_EXPECT(areBatchesEqual (batch, copy));
+            fetchBatchCopyOfBatch (*backend, &copy, missing);
+            BEAST_EXPECT(copy.empty());
+        }
+    }
+
+    //--------------------------------------------------------------------------
+
+    void testDictionaryBackend (std::uint64_t const seedValue)
+    {
+        DummyScheduler scheduler;
+
+        testcase ("Backend with compression dictionary");
+
+        beast::xor_shift_engine rng (seedValue);
+        auto batch = createPredictableBatch (numObjectsToTest, rng());
+
+        std::vector<Blob> samples;
+        for (auto const& object : batch)
+        {
+            EncodedBlob e;
+            e.prepare (object);
+            auto const p = static_cast<std::uint8_t const*>(e.getData());
+            samples.emplace_back (p, p + e.getSize());
+        }
+        beast::temp_dir dictDir;
+        auto const dictPath =
+            boost::filesystem::path (dictDir.path()) / "dictionary";
+        auto const otherPath =
+            boost::filesystem::path (dictDir.path()) / "other";
+        CompressionDictionary const dict (trainDictionary (samples, 4096));
+        BEAST_EXPECT(dict.save (dictPath));
+        samples.resize (samples.size() / 2);
+        BEAST_EXPECT(CompressionDictionary (
+            trainDictionary (samples, 2048)).save (otherPath));
+
+        auto const loaded = CompressionDictionary::load (dictPath);
+        BEAST_EXPECT(loaded && loaded->id() == dict.id());
+
+        Section params;
+        beast::temp_dir tempDir;
+        params.set ("type", "nudb");
+        params.set ("path", tempDir.path());
+        params.set ("compression_dictionary", dictPath.string());
+
+        test::SuiteJournal journal ("Backend_test", *this);
+
+        {
+            std::unique_ptr <Backend> backend =
+                Manager::instance().make_Backend (
+                    params, scheduler, journal);
+            backend->open();
+            storeBatch (*backend, batch);
+
+            Batch copy;
+            fetchCopyOfBatch (*backend, &copy, batch);
+            BEAST_EXPECT(areBatchesEqual (batch, copy));
+        }
+
+        auto const openWith = [&](std::string const& file)
+        {
+            Section other (params);
+            other.set ("compression_dictionary", file);
+            try
+            {
+                Manager::instance().make_Backend (
+                    other, scheduler, journal)->open();
+                return true;
+            }
+            catch (std::exception const&)
+            {
+                return false;
+            }
+        };
+
+        // The database can only be opened with its own dictionary
+        BEAST_EXPECT(! openWith (""));
+        BEAST_EXPECT(! openWith (otherPath.string()));
+        BEAST_EXPECT(openWith (dictPath.string()));
+    }
+
+    //--------------------------------------------------------------------------
+
     void run () override
     {
         std::uint64_t const seedValue = 50;
 
         testBackend ("nudb", seedValue);
 
+        testBackend ("memory", seedValue);
+
+        testFilteredBackend (seedValue);
+
+        testDictionaryBackend (seedValue);
+
     #if RIPPLE_ROCKSDB_AVAILABLE
         testBackend ("rocksdb", seedValue);
     #endif
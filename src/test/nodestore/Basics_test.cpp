@@ -20,8 +20,13 @@
 #include <test/nodestore/TestBase.h>
 #include <ripple/nodestore/DummyScheduler.h>
 #include <ripple/nodestore/Manager.h>
+#include <ripple/nodestore/impl/BatchWriter.h>
+#include <ripple/nodestore/impl/codec.h>
 #include <ripple/nodestore/impl/DecodedBlob.h>
 #include <ripple/nodestore/impl/EncodedBlob.h>
+#include <ripple/nodestore/impl/IOBudget.h>
+#include <set>
+#include <thread>
 
 namespace ripple {
 namespace NodeStore {
@@ -73,6 +78,197 @@ public:
 
                 BEAST_EXPECT(isSame(batch[i], object));
             }
+
+            // Decode from a buffer the object takes over
+            auto const data = static_cast<std::uint8_t const*> (
+                encoded.getData ());
+            Blob value (data, data + encoded.getSize ());
+            DecodedBlob adopted (encoded.getKey (), value.data (), value.size ());
+
+            BEAST_EXPECT(adopted.wasOk ());
+
+            if (adopted.wasOk ())
+            {
+                std::shared_ptr<NodeObject> const object (
+                    adopted.createObject (std::move (value)));
+
+                BEAST_EXPECT(isSame(batch[i], object));
+            }
+        }
+    }
+
+    // Checks the codec with and without a trained dictionary
+    void testCodec (std::uint64_t const seedValue)
+    {
+        testcase ("dictionary codec");
+
+        // Objects sharing structure, as ledger entries of one type do
+        beast::xor_shift_engine rng (seedValue);
+        Blob common (96);
+        for (auto& b : common)
+            b = static_cast<std::uint8_t>(rng());
+        std::vector<Blob> samples;
+        for (int i = 0; i < 1000; ++i)
+        {
+            Blob s (common);
+            s[10] = static_cast<std::uint8_t>(i);
+            for (int j = 0; j < 32; ++j)
+                s.push_back (static_cast<std::uint8_t>(rng()));
+            s.insert (s.end(), common.begin(), common.begin() + 40);
+            samples.push_back (std::move (s));
+        }
+
+        CompressionDictionary const dict (
+            trainDictionary (samples, 1024));
+        BEAST_EXPECT(dict.id() != 0);
+        BEAST_EXPECT(dict.data().size() <= 1024);
+
+        std::size_t plain = 0;
+        std::size_t trained = 0;
+        for (auto const& s : samples)
+        {
+            nudb::detail::buffer bf1;
+            nudb::detail::buffer bf2;
+            auto const c1 = nodeobject_compress (
+                s.data(), s.size(), bf1);
+            auto const c2 = nodeobject_compress (
+                s.data(), s.size(), bf2, &dict);
+            plain += c1.second;
+            trained += c2.second;
+
+            nudb::detail::buffer out;
+            auto const d = nodeobject_decompress (
+                c2.first, c2.second, out, &dict);
+            BEAST_EXPECT(d.second == s.size() &&
+                std::memcmp (d.first, s.data(), s.size()) == 0);
+        }
+        BEAST_EXPECT(trained < plain / 2);
+
+        // A dictionary compressed object needs the dictionary
+        try
+        {
+            nudb::detail::buffer bf;
+            nudb::detail::buffer out;
+            auto const c = nodeobject_compress (
+                samples[0].data(), samples[0].size(), bf, &dict);
+            nodeobject_decompress (c.first, c.second, out);
+            fail();
+        }
+        catch (std::runtime_error const&)
+        {
+            pass();
+        }
+    }
+
+    // Checks that concurrently stored objects are all written once
+    void testBatchWriter (std::uint64_t const seedValue)
+    {
+        testcase ("batch writer");
+
+        // Runs each task on its own thread
+        struct ThreadScheduler : Scheduler
+        {
+            std::mutex mutex;
+            std::vector<std::thread> threads;
+            std::atomic<int> batches {0};
+
+            ~ThreadScheduler () override
+            {
+                for (auto& t : threads)
+                    t.join ();
+            }
+
+            void scheduleTask (Task& task) override
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                threads.emplace_back ([&task]
+                {
+                    task.performScheduledTask ();
+                });
+            }
+
+            void onFetch (FetchReport const&) override
+            {
+            }
+
+            void onBatchWrite (BatchWriteReport const& report) override
+            {
+                if (report.writeCount > 0)
+                    ++batches;
+            }
+        };
+
+        struct Writer : BatchWriter::Callback
+        {
+            std::mutex mutex;
+            std::multiset<uint256> written;
+
+            void writeBatch (Batch const& batch) override
+            {
+                std::lock_guard<std::mutex> lock (mutex);
+                for (auto const& object : batch)
+                    written.insert (object->getHash ());
+            }
+        };
+
+        auto const batch = createPredictableBatch (
+            numObjectsToTest, seedValue);
+
+        ThreadScheduler scheduler;
+        Writer writer;
+        {
+            BatchWriter bw (writer, scheduler, 4);
+            std::vector<std::thread> producers;
+            for (int i = 0; i < 4; ++i)
+            {
+                producers.emplace_back ([&, i]
+                {
+                    for (std::size_t j = i; j < batch.size (); j += 4)
+                        bw.store (batch[j]);
+                });
+            }
+            for (auto& t : producers)
+                t.join ();
+        }
+
+        BEAST_EXPECT(scheduler.batches > 0);
+        BEAST_EXPECT(writer.written.size () == batch.size ());
+        for (auto const& object : batch)
+            BEAST_EXPECT(writer.written.count (object->getHash ()) == 1);
+    }
+
+    void testIOBudget ()
+    {
+        testcase ("io budget");
+
+        using namespace std::chrono;
+        TestStopwatch clock;
+        IOBudget::clock_type::duration waited {0};
+        auto const wait = [&](IOBudget::clock_type::duration d)
+        {
+            waited += d;
+            clock.advance (d);
+        };
+        {
+            IOBudget unlimited (0, clock, wait);
+            unlimited.charge (megabytes (64));
+            BEAST_EXPECT(unlimited.bytes () == megabytes (64));
+            BEAST_EXPECT(waited == waited.zero ());
+        }
+        {
+            // A second's worth of budget takes a second to spend
+            IOBudget limited (megabytes (1), clock, wait);
+            for (int i = 0; i < 4; ++i)
+                limited.charge (kilobytes (256));
+            BEAST_EXPECT(limited.bytes () == megabytes (1));
+            BEAST_EXPECT(waited == seconds (1));
+            BEAST_EXPECT(limited.elapsed () == seconds (1));
+            BEAST_EXPECT(limited.bytesPerSecond () == megabytes (1));
+
+            // Time spent elsewhere is credited
+            clock.advance (seconds (1));
+            limited.charge (megabytes (1));
+            BEAST_EXPECT(waited == seconds (1));
         }
     }
 
@@ -83,6 +279,12 @@ public:
         testBatches (seedValue);
 
         testBlobs (seedValue);
+
+        testCodec (seedValue);
+
+        testBatchWriter (seedValue);
+
+        testIOBudget ();
     }
 };
 
@@ -20,8 +20,14 @@
 #include <test/nodestore/TestBase.h>
 #include <ripple/nodestore/DummyScheduler.h>
 #include <ripple/nodestore/Manager.h>
+#include <ripple/nodestore/impl/DatabaseNodeImp.h>
+#include <ripple/nodestore/impl/DatabaseTieredImp.h>
 #include <ripple/beast/utility/temp_dir.h>
+#include <boost/filesystem.hpp>
 #include <test/unit_test/SuiteJournal.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace ripple {
 namespace NodeStore {
@@ -91,6 +97,182 @@ public:
 
     //--------------------------------------------------------------------------
 
+    // Forwards to another backend, holding every read until released
+    class GatedBackend : public Backend
+    {
+        std::unique_ptr<Backend> backend_;
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        bool open_ = false;
+
+    public:
+        std::atomic<int> reads {0};
+
+        explicit
+        GatedBackend (std::unique_ptr<Backend> backend)
+            : backend_ (std::move (backend))
+        {
+        }
+
+        void
+        release ()
+        {
+            std::lock_guard lock (mutex_);
+            open_ = true;
+            cond_.notify_all ();
+        }
+
+        std::string getName () override { return backend_->getName (); }
+        void open (bool createIfMissing) override
+            { backend_->open (createIfMissing); }
+        void close () override { backend_->close (); }
+
+        Status
+        fetch (void const* key, std::shared_ptr<NodeObject>* pObject) override
+        {
+            ++reads;
+            std::unique_lock lock (mutex_);
+            cond_.wait (lock, [this]{ return open_; });
+            return backend_->fetch (key, pObject);
+        }
+
+        bool canFetchBatch () override { return false; }
+
+        std::vector<std::shared_ptr<NodeObject>>
+        fetchBatch (std::size_t n, void const* const* keys) override
+        {
+            std::vector<std::shared_ptr<NodeObject>> objects (n);
+            for (std::size_t i = 0; i < n; ++i)
+                fetch (keys[i], &objects[i]);
+            return objects;
+        }
+
+        void store (std::shared_ptr<NodeObject> const& object) override
+            { backend_->store (object); }
+        void storeBatch (Batch const& batch) override
+            { backend_->storeBatch (batch); }
+        void for_each (
+            std::function<void (std::shared_ptr<NodeObject>)> f) override
+            { backend_->for_each (f); }
+        int getWriteLoad () override { return backend_->getWriteLoad (); }
+        void setDeletePath () override { backend_->setDeletePath (); }
+        void verify () override { backend_->verify (); }
+        int fdRequired () const override { return backend_->fdRequired (); }
+    };
+
+    void testConcurrentFetch (std::int64_t seedValue)
+    {
+        DummyScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+
+        testcase ("concurrent fetch");
+
+        beast::temp_dir node_db;
+        Section nodeParams;
+        nodeParams.set ("type", "memory");
+        nodeParams.set ("path", node_db.path());
+
+        auto gated = std::make_unique<GatedBackend> (
+            Manager::instance().make_Backend (
+                nodeParams, scheduler, journal_));
+        auto& backend = *gated;
+        backend.open (true);
+
+        beast::xor_shift_engine rng (seedValue);
+        auto const batch = createPredictableBatch (1, rng());
+        backend.store (batch[0]);
+
+        DatabaseNodeImp db ("test", scheduler, 0, parent,
+            std::move (gated), nodeParams, journal_);
+
+        // Every thread misses the caches for the same object while
+        // the first read is held in the backend
+        int const numThreads = 8;
+        auto const& hash = batch[0]->getHash ();
+        std::vector<std::shared_ptr<NodeObject>> results (numThreads);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < numThreads; ++i)
+        {
+            threads.emplace_back (
+                [&db, &hash, &result = results[i]]
+                {
+                    result = db.fetch (hash, 0);
+                });
+        }
+
+        // Wait until each thread either shares the read or reads too
+        while (db.getFetchSharedCount () + backend.reads < numThreads)
+            std::this_thread::yield ();
+        backend.release ();
+        for (auto& t : threads)
+            t.join ();
+
+        for (auto const& result : results)
+            BEAST_EXPECT(result && isSame (result, batch[0]));
+
+        BEAST_EXPECT(backend.reads == 1);
+        BEAST_EXPECT(db.getFetchTotalCount () == 1);
+        BEAST_EXPECT(db.getFetchSharedCount () == numThreads - 1);
+    }
+
+    // Records the fetch reports
+    struct ReportScheduler : DummyScheduler
+    {
+        std::vector<FetchReport> fetches;
+
+        void onFetch (FetchReport const& report) override
+        {
+            fetches.push_back (report);
+        }
+    };
+
+    void testFetchBatchReport (std::int64_t seedValue)
+    {
+        ReportScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+
+        testcase ("fetch batch report");
+
+        beast::temp_dir node_db;
+        Section nodeParams;
+        nodeParams.set ("type", "memory");
+        nodeParams.set ("path", node_db.path());
+
+        auto backend = Manager::instance().make_Backend (
+            nodeParams, scheduler, journal_);
+        backend->open (true);
+
+        beast::xor_shift_engine rng (seedValue);
+        auto const batch = createPredictableBatch (64, rng());
+        backend->storeBatch (batch);
+
+        DatabaseNodeImp db ("test", scheduler, 0, parent,
+            std::move (backend), nodeParams, journal_);
+
+        std::vector<uint256> hashes;
+        for (auto const& object : batch)
+            hashes.push_back (object->getHash ());
+
+        // The time of a batch read is reported once, for all its objects
+        auto const objects = db.fetchBatch (hashes, 0);
+        BEAST_EXPECT(objects.size () == batch.size ());
+        if (BEAST_EXPECT(scheduler.fetches.size () == 1))
+        {
+            BEAST_EXPECT(scheduler.fetches[0].wentToDisk);
+            BEAST_EXPECT(scheduler.fetches[0].wasFound);
+            BEAST_EXPECT(scheduler.fetches[0].fetchCount ==
+                static_cast<int> (batch.size ()));
+        }
+
+        // Once cached nothing goes to disk
+        scheduler.fetches.clear ();
+        db.fetchBatch (hashes, 0);
+        if (BEAST_EXPECT(scheduler.fetches.size () == 1))
+            BEAST_EXPECT(! scheduler.fetches[0].wentToDisk);
+    }
+
+    //--------------------------------------------------------------------------
+
     void testNodeStore (std::string const& type,
                         bool const testPersistence,
                         std::int64_t const seedValue,
@@ -129,6 +311,13 @@ public:
                 BEAST_EXPECT(areBatchesEqual (batch, copy));
             }
 
+            {
+                // Read it back in with one batch fetch
+                Batch copy;
+                fetchBatchCopyOfBatch (*db, &copy, batch);
+                BEAST_EXPECT(areBatchesEqual (batch, copy));
+            }
+
             {
                 // Reorder and read the copy again
                 std::shuffle (
@@ -214,12 +403,235 @@ public:
 
     //--------------------------------------------------------------------------
 
+    void testTiered (std::int64_t seedValue)
+    {
+        DummyScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+
+        testcase ("tiered");
+
+        beast::temp_dir hotDir;
+        beast::temp_dir coldDir;
+        Section hotParams;
+        hotParams.set ("type", "nudb");
+        hotParams.set ("path", hotDir.path());
+        hotParams.set ("cold_after", "256");
+        Section coldParams;
+        coldParams.set ("type", "nudb");
+        coldParams.set ("path", coldDir.path());
+
+        beast::xor_shift_engine rng (seedValue);
+        auto const batch = createPredictableBatch (
+            numObjectsToTest, rng());
+        auto const recent = createPredictableBatch (16, rng());
+
+        auto const makeDatabase = [&]
+        {
+            auto cold = Manager::instance().make_Backend (
+                coldParams, scheduler, journal_);
+            cold->open ();
+            return std::make_unique<DatabaseTieredImp> ("test",
+                scheduler, 2, parent, std::move (cold), hotParams, journal_);
+        };
+        auto const generation = [&](int n)
+        {
+            return boost::filesystem::path (hotDir.path()) /
+                std::to_string (n);
+        };
+
+        {
+            auto db = makeDatabase ();
+            storeBatch (*db, batch);
+            BEAST_EXPECT(boost::filesystem::exists (generation (1)));
+
+            // Storing 256 ledgers later starts a new
+            // generation and demotes the first one
+            for (auto const& object : recent)
+            {
+                db->store (object->getType (), Blob (object->getData ()),
+                    object->getHash (), db->earliestSeq () + 256);
+            }
+            db->waitForDemotion ();
+            BEAST_EXPECT(! boost::filesystem::exists (generation (1)));
+            BEAST_EXPECT(boost::filesystem::exists (generation (2)));
+            BEAST_EXPECT(db->getDemoteCount () >= batch.size ());
+        }
+
+        {
+            // Every object of the first generation reached the cold backend
+            auto cold = Manager::instance().make_Backend (
+                coldParams, scheduler, journal_);
+            cold->open ();
+            Batch copy;
+            fetchCopyOfBatch (*cold, &copy, batch);
+            BEAST_EXPECT(areBatchesEqual (batch, copy));
+        }
+
+        {
+            auto db = makeDatabase ();
+
+            // Old objects are read from the cold backend
+            Batch copy;
+            fetchCopyOfBatch (*db, &copy, batch);
+            BEAST_EXPECT(areBatchesEqual (batch, copy));
+            fetchCopyOfBatch (*db, &copy, recent);
+            BEAST_EXPECT(areBatchesEqual (recent, copy));
+            BEAST_EXPECT(db->getPromoteCount () == 0);
+
+            // and promoted when read again
+            copy.clear ();
+            db->tune (0, std::chrono::seconds (0));
+            db->sweep ();
+            fetchCopyOfBatch (*db, &copy, batch);
+            BEAST_EXPECT(areBatchesEqual (batch, copy));
+            BEAST_EXPECT(db->getPromoteCount () == batch.size ());
+        }
+
+        {
+            Section params (hotParams);
+            params.set ("path", generation (2).string ());
+            auto backend = Manager::instance().make_Backend (
+                params, scheduler, journal_);
+            backend->open ();
+            Batch copy;
+            fetchCopyOfBatch (*backend, &copy, batch);
+            BEAST_EXPECT(areBatchesEqual (batch, copy));
+        }
+    }
+
+    void testTieredRotation (std::int64_t seedValue)
+    {
+        DummyScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+
+        testcase ("tiered rotation");
+
+        beast::temp_dir hotDir;
+        beast::temp_dir coldDir;
+        Section hotParams;
+        hotParams.set ("type", "nudb");
+        hotParams.set ("path", hotDir.path());
+        hotParams.set ("cold_after", "256");
+        Section coldParams;
+        coldParams.set ("type", "nudb");
+        coldParams.set ("path", coldDir.path());
+
+        auto cold = Manager::instance().make_Backend (
+            coldParams, scheduler, journal_);
+        cold->open ();
+        DatabaseTieredImp db ("test",
+            scheduler, 2, parent, std::move (cold), hotParams, journal_);
+        auto const generation = [&](int n)
+        {
+            return boost::filesystem::exists (
+                boost::filesystem::path (hotDir.path()) /
+                    std::to_string (n));
+        };
+
+        auto const batch = createPredictableBatch (64, seedValue);
+        std::size_t next = 0;
+        auto const store = [&](std::uint32_t seq)
+        {
+            auto const& object = batch[next++ % batch.size ()];
+            db.store (object->getType (), Blob (object->getData ()),
+                object->getHash (), seq);
+
+            // Let any rotation finish before the next store
+            db.waitForDemotion ();
+        };
+
+        // Ledgers older than the one the generation is aged from,
+        // as backfill would store them, do not age it faster
+        std::uint32_t const base = db.earliestSeq () + 1024;
+        store (base);
+        for (std::uint32_t i = 1; i < 16; ++i)
+        {
+            store (base + 16 * i);
+            store (base - 16 * i);
+        }
+        BEAST_EXPECT(generation (1));
+        BEAST_EXPECT(! generation (2));
+
+        // Reaching cold_after ledgers rotates exactly once
+        for (std::uint32_t i = 16; i < 32; ++i)
+        {
+            store (base + 16 * i);
+            store (base - 16 * i);
+        }
+        BEAST_EXPECT(! generation (1));
+        BEAST_EXPECT(generation (2));
+        BEAST_EXPECT(! generation (3));
+    }
+
+    //--------------------------------------------------------------------------
+
+    void testTrace (std::int64_t const seedValue)
+    {
+        DummyScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+
+        testcase ("trace");
+
+        beast::temp_dir node_db;
+        Section nodeParams;
+        nodeParams.set ("type", "memory");
+        nodeParams.set ("path", node_db.path());
+        nodeParams.set ("trace_file", node_db.file ("node.trace"));
+
+        auto const batch = createPredictableBatch (
+            numObjectsToTest, seedValue);
+        uint256 const missing = batch.front ()->getHash () ^
+            batch.back ()->getHash ();
+        std::uint32_t earliestSeq;
+        {
+            std::unique_ptr <Database> db = Manager::instance().make_Database (
+                "test", scheduler, 2, parent, nodeParams, journal_);
+            earliestSeq = db->earliestSeq ();
+            storeBatch (*db, batch);
+            Batch copy;
+            fetchCopyOfBatch (*db, &copy, batch);
+            BEAST_EXPECT(areBatchesEqual (batch, copy));
+            BEAST_EXPECT(! db->fetch (missing, 0));
+        }
+
+        auto const records = readTrace (node_db.file ("node.trace"));
+        if (! BEAST_EXPECT(records.size () == 2 * batch.size () + 1))
+            return;
+        for (std::size_t i = 0; i < batch.size (); ++i)
+        {
+            auto const& stored = records[i];
+            BEAST_EXPECT(stored.op == TraceRecord::Op::store);
+            BEAST_EXPECT(stored.hash == batch[i]->getHash ());
+            BEAST_EXPECT(stored.seq == earliestSeq);
+            BEAST_EXPECT(stored.size == batch[i]->getData ().size ());
+
+            auto const& fetched = records[batch.size () + i];
+            BEAST_EXPECT(fetched.op == TraceRecord::Op::fetch);
+            BEAST_EXPECT(fetched.hash == batch[i]->getHash ());
+            BEAST_EXPECT(fetched.size == batch[i]->getData ().size ());
+            BEAST_EXPECT(fetched.time >= stored.time);
+        }
+        BEAST_EXPECT(records.back ().op == TraceRecord::Op::fetch);
+        BEAST_EXPECT(records.back ().hash == missing);
+        BEAST_EXPECT(records.back ().size == 0);
+    }
+
+    //--------------------------------------------------------------------------
+
     void run () override
     {
         std::int64_t const seedValue = 50;
 
         testNodeStore ("memory", false, seedValue);
 
+        testConcurrentFetch (seedValue);
+        testFetchBatchReport (seedValue);
+
+        testTiered (seedValue);
+        testTieredRotation (seedValue);
+
+        testTrace (seedValue);
+
         // Persistent backend tests
         {
             testNodeStore ("nudb", true, seedValue);
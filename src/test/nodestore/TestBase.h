@@ -170,6 +170,25 @@ public:
         }
     }
 
+    // Get a copy of a batch in a backend using a single batch fetch
+    void fetchBatchCopyOfBatch (Backend& backend, Batch* pCopy, Batch const& batch)
+    {
+        std::vector<void const*> keys;
+        keys.reserve (batch.size ());
+        for (auto const& e : batch)
+            keys.push_back (e->getHash ().cbegin ());
+
+        auto const objects = backend.fetchBatch (keys.size (), keys.data ());
+        BEAST_EXPECT(objects.size () == batch.size ());
+
+        pCopy->clear ();
+        for (auto const& object : objects)
+        {
+            if (object != nullptr)
+                pCopy->push_back (object);
+        }
+    }
+
     void fetchMissing(Backend& backend, Batch const& batch)
     {
         for (int i = 0; i < batch.size (); ++i)
@@ -216,6 +235,24 @@ public:
                 pCopy->push_back (object);
         }
     }
+
+    // Fetch all the hashes in one batch with a single batch fetch
+    static void fetchBatchCopyOfBatch (Database& db,
+                                       Batch* pCopy,
+                                       Batch const& batch)
+    {
+        std::vector<uint256> hashes;
+        hashes.reserve (batch.size ());
+        for (auto const& e : batch)
+            hashes.push_back (e->getHash ());
+
+        pCopy->clear ();
+        for (auto const& object : db.fetchBatch (hashes, 0))
+        {
+            if (object != nullptr)
+                pCopy->push_back (object);
+        }
+    }
 };
 
 }
@@ -0,0 +1,256 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <ripple/basics/BasicConfig.h>
+#include <ripple/basics/UnorderedContainers.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/temp_dir.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <ripple/core/Stoppable.h>
+#include <ripple/nodestore/DummyScheduler.h>
+#include <ripple/nodestore/Manager.h>
+#include <ripple/nodestore/Trace.h>
+#include <test/unit_test/SuiteJournal.h>
+#include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace ripple {
+namespace NodeStore {
+
+/*  Replays a trace recorded with the `trace_file` database option.
+
+    Arguments are comma separated key=value pairs. `trace` names the
+    trace file and `threads` the number of threads replaying it. The
+    remaining pairs configure the database, as in [node_db]; when no
+    `path` is given a temporary directory is used.
+
+    Objects the trace fetches before storing are assumed to have been in
+    the database when recording began. They are written with random
+    contents of the recorded size before the database is reopened, so
+    the replay starts with cold caches.
+
+    Example:
+
+        --unittest=TraceReplay --unittest-arg=trace=node.trace,type=nudb,threads=8
+*/
+class TraceReplay_test : public beast::unit_test::suite
+{
+    using clock_type = std::chrono::steady_clock;
+
+    struct Result
+    {
+        std::vector<std::chrono::nanoseconds> fetches;
+        std::vector<std::chrono::nanoseconds> stores;
+        std::uint64_t found = 0;
+        std::uint64_t bytesRead = 0;
+    };
+
+    static
+    Section
+    parse (std::string s)
+    {
+        Section section;
+        std::vector <std::string> v;
+        boost::split (v, s,
+            boost::algorithm::is_any_of (","));
+        section.append(v);
+        return section;
+    }
+
+    static
+    Blob
+    randomBlob(std::size_t size, beast::xor_shift_engine& rng)
+    {
+        Blob blob(size);
+        std::uniform_int_distribution<int> d(0, 255);
+        for (auto& b : blob)
+            b = static_cast<std::uint8_t>(d(rng));
+        return blob;
+    }
+
+    // Latency percentiles in microseconds
+    static
+    std::string
+    percentiles(std::vector<std::chrono::nanoseconds>& v)
+    {
+        if (v.empty())
+            return "none";
+        std::sort(v.begin(), v.end());
+        auto const at = [&v](double p)
+        {
+            auto const i = static_cast<std::size_t>(p * (v.size() - 1));
+            return v[i].count() / 1000.;
+        };
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1) <<
+            v.size() << " ops, p50 " << at(0.5) << "us, p99 " <<
+            at(0.99) << "us, p999 " << at(0.999) << "us";
+        return ss.str();
+    }
+
+    std::unique_ptr<Database>
+    makeDatabase(Section const& config, Scheduler& scheduler,
+        Stoppable& parent, beast::Journal journal)
+    {
+        auto db = Manager::instance().make_Database(
+            "TraceReplay", scheduler, 0, parent, config, journal);
+        if (config.exists("cache_size") || config.exists("cache_age"))
+        {
+            db->tune(get<int>(config, "cache_size", 16384),
+                std::chrono::seconds{get<int>(config, "cache_age", 5)});
+        }
+        return db;
+    }
+
+public:
+    void
+    run() override
+    {
+        testcase ("TraceReplay", beast::unit_test::abort_on_fail);
+
+        auto config = parse(arg());
+        std::string traceFile;
+        if (!get_if_exists(config, "trace", traceFile))
+        {
+            log << "Usage: --unittest-arg=trace=<file>[,threads=<n>]"
+                "[,type=<backend>,...]" << std::endl;
+            pass();
+            return;
+        }
+        auto const threads = std::max<std::size_t>(
+            get<std::size_t>(config, "threads", 4), 1);
+        beast::temp_dir tempDir;
+        if (!config.exists("path"))
+            config.set("path", tempDir.path());
+        if (!config.exists("type"))
+            config.set("type", "nudb");
+
+        auto const records = readTrace(traceFile);
+        log << "Replaying " << records.size() << " records from " <<
+            traceFile << " with " << threads << " thread" <<
+            (threads > 1 ? "s" : "") << " on " <<
+            get<std::string>(config, "type") << std::endl;
+
+        DummyScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+        test::SuiteJournal journal ("TraceReplay_test", *this);
+
+        {
+            auto db = makeDatabase(config, scheduler, parent, journal);
+            beast::xor_shift_engine rng;
+            hash_set<uint256> seen;
+            std::size_t preloaded = 0;
+            for (auto const& r : records)
+            {
+                if (!seen.insert(r.hash).second)
+                    continue;
+                if (r.op == TraceRecord::Op::fetch && r.size != 0)
+                {
+                    db->store(hotUNKNOWN, randomBlob(r.size, rng),
+                        r.hash, r.seq);
+                    ++preloaded;
+                }
+            }
+            log << "Preloaded " << preloaded << " objects" << std::endl;
+        }
+
+        auto db = makeDatabase(config, scheduler, parent, journal);
+        std::vector<Result> results(threads);
+        std::atomic<std::size_t> next {0};
+        auto const start = clock_type::now();
+        {
+            std::vector<std::thread> workers;
+            workers.reserve(threads);
+            for (std::size_t t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&, t]
+                {
+                    beast::xor_shift_engine rng(t + 1);
+                    auto& result = results[t];
+                    for (;;)
+                    {
+                        auto const i = next++;
+                        if (i >= records.size())
+                            break;
+                        auto const& r = records[i];
+                        if (r.op == TraceRecord::Op::fetch)
+                        {
+                            auto const before = clock_type::now();
+                            auto const obj = db->fetch(r.hash, r.seq);
+                            result.fetches.push_back(
+                                clock_type::now() - before);
+                            if (obj)
+                            {
+                                ++result.found;
+                                result.bytesRead += obj->getData().size();
+                            }
+                        }
+                        else
+                        {
+                            auto data = randomBlob(r.size, rng);
+                            auto const before = clock_type::now();
+                            db->store(hotUNKNOWN, std::move(data),
+                                r.hash, r.seq);
+                            result.stores.push_back(
+                                clock_type::now() - before);
+                        }
+                    }
+                });
+            }
+            for (auto& w : workers)
+                w.join();
+        }
+        auto const elapsed = std::chrono::duration<double>(
+            clock_type::now() - start).count();
+
+        Result total;
+        for (auto& r : results)
+        {
+            total.fetches.insert(total.fetches.end(),
+                r.fetches.begin(), r.fetches.end());
+            total.stores.insert(total.stores.end(),
+                r.stores.begin(), r.stores.end());
+            total.found += r.found;
+            total.bytesRead += r.bytesRead;
+        }
+
+        log << std::fixed << std::setprecision(3) <<
+            "Elapsed " << elapsed << "s, " << std::setprecision(0) <<
+            (records.size() / elapsed) << " ops/s, " <<
+            total.bytesRead << " bytes read (" <<
+            (total.bytesRead / elapsed / (1024 * 1024)) << " MB/s)" <<
+            std::endl;
+        log << "Fetch: " << percentiles(total.fetches) << ", " <<
+            total.found << " found" << std::endl;
+        log << "Store: " << percentiles(total.stores) << std::endl;
+        pass();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(TraceReplay,NodeStore,ripple);
+
+} // NodeStore
+} // ripple
@@ -19,12 +19,14 @@
 
 #include <ripple/basics/contract.h>
 #include <ripple/nodestore/impl/codec.h>
+#include <ripple/nodestore/impl/CompressionDictionary.h>
 #include <ripple/beast/clock/basic_seconds_clock.h>
 #include <ripple/beast/rfc2616.h>
 #include <ripple/beast/core/LexicalCast.h>
 #include <ripple/beast/unit_test.h>
 #include <nudb/create.hpp>
 #include <nudb/detail/format.hpp>
+#include <nudb/visit.hpp>
 #include <nudb/xxhasher.hpp>
 #include <boost/beast/core/string.hpp>
 #include <boost/regex.hpp>
@@ -32,6 +34,7 @@
 #include <chrono>
 #include <iomanip>
 #include <map>
+#include <random>
 #include <sstream>
 
 #include <ripple/unity/rocksdb.h>
@@ -591,6 +594,105 @@ BEAST_DEFINE_TESTSUITE_MANUAL(import,NodeStore,ripple);
 
 //------------------------------------------------------------------------------
 
+// Train a compression dictionary from the objects in a NuDB database:
+// from=<path to nudb.dat>,to=<dictionary file>[,samples=<n>][,size=<bytes>]
+class train_dictionary_test : public beast::unit_test::suite
+{
+public:
+    void
+    run() override
+    {
+        testcase(beast::unit_test::abort_on_fail) << arg();
+
+        pass();
+        auto const args = parse_args(arg());
+        if (args.find("from") == args.end() ||
+            args.find("to") == args.end())
+        {
+            log <<
+                "Usage: --unittest-arg=from=<nudb.dat>,to=<file>"
+                "[,samples=<n>][,size=<bytes>]";
+            return;
+        }
+        auto const from = args.at("from");
+        auto const to = args.at("to");
+        std::size_t samples = 100000;
+        std::size_t size = CompressionDictionary::maxSize;
+        if (args.find("samples") != args.end())
+            samples = beast::lexicalCastThrow<std::size_t>(
+                args.at("samples"));
+        if (args.find("size") != args.end())
+            size = beast::lexicalCastThrow<std::size_t>(
+                args.at("size"));
+
+        // Reservoir sample the leaves, inner nodes are
+        // already compressed well without a dictionary.
+        std::vector<Blob> sample;
+        sample.reserve(samples);
+        std::mt19937_64 gen;
+        std::size_t seen = 0;
+        nudb::error_code ec;
+        nudb::visit(from,
+            [&](void const*, std::size_t,
+                void const* data, std::size_t bytes,
+                nudb::error_code&)
+            {
+                nudb::detail::buffer bf;
+                auto const result =
+                    nodeobject_decompress(data, bytes, bf);
+                if (result.second == 525)
+                    return;
+                auto const p = static_cast<
+                    std::uint8_t const*>(result.first);
+                if (sample.size() < samples)
+                {
+                    sample.emplace_back(p, p + result.second);
+                }
+                else
+                {
+                    auto const i = std::uniform_int_distribution<
+                        std::size_t>(0, seen)(gen);
+                    if (i < samples)
+                        sample[i].assign(p, p + result.second);
+                }
+                ++seen;
+            }, nudb::no_progress{}, ec);
+        if (ec)
+            Throw<nudb::system_error>(ec);
+
+        auto data = trainDictionary(sample, size);
+        if (! BEAST_EXPECT(! data.empty()))
+            return;
+        CompressionDictionary const dict(std::move(data));
+        if (! BEAST_EXPECT(dict.save(to)))
+            return;
+
+        std::size_t raw = 0;
+        std::size_t plain = 0;
+        std::size_t trained = 0;
+        for (auto const& s : sample)
+        {
+            nudb::detail::buffer bf;
+            raw += s.size();
+            plain += nodeobject_compress(
+                s.data(), s.size(), bf).second;
+            trained += nodeobject_compress(
+                s.data(), s.size(), bf, &dict).second;
+        }
+        log <<
+            "Dictionary: " << dict.data().size() << " bytes, id " <<
+                dict.id() << ", from " << sample.size() << " of " <<
+                    seen << " objects";
+        log <<
+            "Sample: " << raw << " bytes, lz4 " << plain <<
+                ", lz4 with dictionary " << trained;
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(train_dictionary,NodeStore,ripple);
+
+//------------------------------------------------------------------------------
+
 } // NodeStore
 } // ripple
 
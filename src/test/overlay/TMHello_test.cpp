@@ -58,10 +58,29 @@ public:
         check("RTXP/1.1, RTXP/1.0", "1.0,1.1");
     }
 
+    void
+    test_features()
+    {
+        boost::beast::http::fields h;
+        BEAST_EXPECT(! isCompressionOffered(h));
+        BEAST_EXPECT(! isTxBatchOffered(h));
+
+        h.insert("Compression", "zstd, LZ4");
+        h.insert("Tx-Batch", "1");
+        BEAST_EXPECT(isCompressionOffered(h));
+        BEAST_EXPECT(isTxBatchOffered(h));
+
+        h.set("Compression", "zstd");
+        h.set("Tx-Batch", "0");
+        BEAST_EXPECT(! isCompressionOffered(h));
+        BEAST_EXPECT(! isTxBatchOffered(h));
+    }
+
     void
     run() override
     {
         test_protocolVersions();
+        test_features();
     }
 };
 
@@ -0,0 +1,153 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/overlay/impl/SendQueue.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <ripple/beast/unit_test.h>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/strand.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace ripple {
+
+// Measures the cost of sending one message to many peers
+class broadcast_test : public beast::unit_test::suite
+{
+    // What a peer keeps that matters for writing
+    struct Peer
+    {
+        boost::asio::io_service::strand strand;
+        SendQueue queue;
+        std::vector<std::uint8_t> sink;
+
+        explicit
+        Peer (boost::asio::io_service& ios)
+            : strand (ios)
+            , queue (Tuning::sendQueueLimit)
+        {
+        }
+
+        // Stand in for the socket, which copies once into TLS
+        void
+        write (bool compressed)
+        {
+            while (! queue.empty ())
+            {
+                auto const& buffer = queue.next ()->getBuffer (compressed);
+                sink.resize (buffer.size ());
+                std::memcpy (sink.data (), buffer.data (), buffer.size ());
+                queue.pop ();
+            }
+        }
+    };
+
+    static
+    protocol::TMGetObjectByHash
+    makeObjects ()
+    {
+        protocol::TMGetObjectByHash objects;
+        objects.set_type (protocol::TMGetObjectByHash::otTRANSACTION_NODE);
+        objects.set_query (false);
+        for (int i = 0; i < 64; ++i)
+        {
+            auto o = objects.add_objects ();
+            o->set_hash (std::string (32, static_cast<char>(i)));
+            o->set_data (std::string (256, static_cast<char>(i % 5)));
+        }
+        return objects;
+    }
+
+    // Returns the time taken for a number of broadcasts. Every peer
+    // shares one Message per broadcast. Its wire form is either settled
+    // before the fan-out, or left to the first peer strand that writes
+    // it while the others wait in call_once.
+    std::chrono::milliseconds
+    measure (bool settled, bool compressed, int peerCount, int rounds)
+    {
+        using namespace std::chrono;
+
+        boost::asio::io_service ios;
+        std::vector<std::unique_ptr<Peer>> peers;
+        for (int i = 0; i < peerCount; ++i)
+            peers.push_back (std::make_unique<Peer> (ios));
+
+        auto const objects = makeObjects ();
+        std::atomic<int> written {0};
+
+        auto const begin = steady_clock::now ();
+        for (int r = 0; r < rounds; ++r)
+        {
+            auto const m = std::make_shared<Message> (
+                objects, protocol::mtGET_OBJECTS);
+            if (settled)
+                m->getBuffer (compressed);
+
+            for (auto& p : peers)
+            {
+                boost::asio::post (p->strand,
+                    [&, peer = p.get (), m]
+                    {
+                        peer->queue.push (m);
+                        peer->write (compressed);
+                        ++written;
+                    });
+            }
+        }
+
+        std::vector<std::thread> threads;
+        auto const n = std::max (2u, std::thread::hardware_concurrency ());
+        for (unsigned i = 0; i < n; ++i)
+            threads.emplace_back ([&ios] { ios.run (); });
+        for (auto& t : threads)
+            t.join ();
+
+        auto const elapsed = duration_cast<milliseconds> (
+            steady_clock::now () - begin);
+        BEAST_EXPECT(written == peerCount * rounds);
+        return elapsed;
+    }
+
+public:
+    void
+    run () override
+    {
+        int const peerCount = 200;
+        int const rounds = 500;
+
+        for (bool compressed : {false, true})
+        {
+            auto const lazy = measure (false, compressed, peerCount, rounds);
+            auto const settled = measure (true, compressed, peerCount, rounds);
+            log << peerCount << " peers, " << rounds << " broadcasts" <<
+                (compressed ? ", compressed" : "") << ": lazy " <<
+                lazy.count () << "ms, settled " << settled.count () <<
+                "ms" << std::endl;
+        }
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(broadcast,overlay,ripple);
+
+}
@@ -0,0 +1,231 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/overlay/Message.h>
+#include <ripple/overlay/impl/ProtocolMessage.h>
+#include <ripple/beast/unit_test.h>
+#include <boost/beast/core/multi_buffer.hpp>
+
+namespace ripple {
+
+class compression_test : public beast::unit_test::suite
+{
+private:
+    // Records what invokeProtocolMessage passes to a peer
+    struct Handler
+    {
+        std::shared_ptr<::google::protobuf::Message> message;
+        std::size_t size = 0;
+        std::size_t uncompressedSize = 0;
+
+        boost::system::error_code
+        onMessageUnknown (std::uint16_t)
+        {
+            return {};
+        }
+
+        boost::system::error_code
+        onMessageBegin (std::uint16_t,
+            std::shared_ptr<::google::protobuf::Message> const& m,
+            std::size_t size, std::size_t uncompressedSize)
+        {
+            message = m;
+            this->size = size;
+            this->uncompressedSize = uncompressedSize;
+            return {};
+        }
+
+        template <class T>
+        void
+        onMessage (std::shared_ptr<T> const&)
+        {
+        }
+
+        void
+        onMessageEnd (std::uint16_t,
+            std::shared_ptr<::google::protobuf::Message> const&)
+        {
+        }
+    };
+
+    std::pair<std::size_t, boost::system::error_code>
+    receive (std::vector<std::uint8_t> const& buffer, Handler& handler,
+        bool compressionEnabled = true)
+    {
+        // Split the message across buffers as the socket would
+        boost::beast::multi_buffer mb;
+        auto const half = buffer.size () / 2;
+        mb.commit (boost::asio::buffer_copy (mb.prepare (half),
+            boost::asio::buffer (buffer.data (), half)));
+        mb.commit (boost::asio::buffer_copy (
+            mb.prepare (buffer.size () - half),
+            boost::asio::buffer (buffer.data () + half,
+                buffer.size () - half)));
+        return invokeProtocolMessage (mb.data (), handler,
+            compressionEnabled);
+    }
+
+    static
+    protocol::TMGetObjectByHash
+    makeObjects (int count)
+    {
+        protocol::TMGetObjectByHash objects;
+        objects.set_type (protocol::TMGetObjectByHash::otSTATE_NODE);
+        objects.set_query (false);
+        for (int i = 0; i < count; ++i)
+        {
+            auto o = objects.add_objects ();
+            o->set_hash (std::string (32, static_cast<char>(i)));
+            o->set_data (std::string (200, static_cast<char>(i % 7)));
+        }
+        return objects;
+    }
+
+public:
+    void
+    testRoundTrip ()
+    {
+        testcase ("round trip");
+
+        auto const objects = makeObjects (100);
+        Message const m (objects, protocol::mtGET_OBJECTS);
+
+        auto const& plain = m.getBuffer ();
+        auto const& compressed = m.getBuffer (true);
+        BEAST_EXPECT(! Message::compressed (
+            plain.begin (), plain.end ()));
+        BEAST_EXPECT(Message::compressed (
+            compressed.begin (), compressed.end ()));
+        BEAST_EXPECT(compressed.size () < plain.size () / 4);
+        BEAST_EXPECT(Message::size (compressed.begin (), compressed.end ()) +
+            Message::kHeaderBytes == compressed.size ());
+        BEAST_EXPECT(Message::type (compressed.begin (), compressed.end ()) ==
+            protocol::mtGET_OBJECTS);
+
+        // The compressed buffer is made once and shared
+        BEAST_EXPECT(&m.getBuffer (true) == &compressed);
+
+        Handler handler;
+        auto const [consumed, ec] = receive (compressed, handler);
+        BEAST_EXPECT(! ec);
+        BEAST_EXPECT(consumed == compressed.size ());
+        BEAST_EXPECT(handler.size == compressed.size ());
+        BEAST_EXPECT(handler.uncompressedSize == plain.size ());
+        BEAST_EXPECT(handler.message &&
+            handler.message->SerializeAsString () ==
+                objects.SerializeAsString ());
+    }
+
+    void
+    testUncompressed ()
+    {
+        testcase ("uncompressed");
+
+        // Too small to be worth compressing
+        {
+            Message const m (makeObjects (0), protocol::mtGET_OBJECTS);
+            BEAST_EXPECT(&m.getBuffer (true) == &m.getBuffer ());
+        }
+
+        // Not a type that is compressed
+        {
+            protocol::TMStatusChange s;
+            s.set_ledgerhash (std::string (32, 'x'));
+            s.set_ledgerhashprevious (std::string (200, 'y'));
+            Message const m (s, protocol::mtSTATUS_CHANGE);
+            BEAST_EXPECT(&m.getBuffer (true) == &m.getBuffer ());
+
+            Handler handler;
+            auto const [consumed, ec] = receive (m.getBuffer (), handler);
+            BEAST_EXPECT(! ec);
+            BEAST_EXPECT(consumed == m.getBuffer ().size ());
+            BEAST_EXPECT(handler.size == handler.uncompressedSize);
+        }
+    }
+
+    void
+    testMalformed ()
+    {
+        testcase ("malformed");
+
+        Message const m (makeObjects (100), protocol::mtGET_OBJECTS);
+
+        // Corrupt the uncompressed size
+        {
+            auto buffer = m.getBuffer (true);
+            buffer[Message::kHeaderBytes] = 0xFF;
+            Handler handler;
+            BEAST_EXPECT(receive (buffer, handler).second);
+            BEAST_EXPECT(! handler.message);
+        }
+
+        // Truncate the block
+        {
+            auto buffer = m.getBuffer (true);
+            buffer.resize (buffer.size () - 8);
+            Message::encodeHeader (buffer.data (),
+                buffer.size () - Message::kHeaderBytes,
+                protocol::mtGET_OBJECTS, true);
+            Handler handler;
+            BEAST_EXPECT(receive (buffer, handler).second);
+            BEAST_EXPECT(! handler.message);
+        }
+    }
+
+    void
+    testNotNegotiated ()
+    {
+        testcase ("not negotiated");
+
+        Message const m (makeObjects (100), protocol::mtGET_OBJECTS);
+
+        // A peer that did not negotiate compression may not send it
+        {
+            Handler handler;
+            auto const [consumed, ec] =
+                receive (m.getBuffer (true), handler, false);
+            BEAST_EXPECT(ec == boost::system::errc::invalid_argument);
+            BEAST_EXPECT(consumed == 0);
+            BEAST_EXPECT(! handler.message);
+        }
+
+        // Uncompressed messages are still accepted
+        {
+            Handler handler;
+            auto const [consumed, ec] =
+                receive (m.getBuffer (), handler, false);
+            BEAST_EXPECT(! ec);
+            BEAST_EXPECT(consumed == m.getBuffer ().size ());
+            BEAST_EXPECT(handler.message);
+        }
+    }
+
+    void
+    run () override
+    {
+        testRoundTrip ();
+        testUncompressed ();
+        testMalformed ();
+        testNotNegotiated ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(compression,overlay,ripple);
+
+}
@@ -0,0 +1,153 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/overlay/impl/ReceivedTransactions.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <ripple/resource/Fees.h>
+#include <ripple/beast/unit_test.h>
+#include <functional>
+#include <vector>
+
+namespace ripple {
+
+class received_transactions_test : public beast::unit_test::suite
+{
+private:
+    // Stands in for the job queue, which can refuse a job
+    struct Queue
+    {
+        bool stopping = false;
+        std::vector<std::function<void()>> jobs;
+
+        bool
+        addJob (std::function<void()> job)
+        {
+            if (stopping)
+                return false;
+            jobs.push_back (std::move (job));
+            return true;
+        }
+
+        void
+        run ()
+        {
+            for (auto& job : jobs)
+                job ();
+            jobs.clear ();
+        }
+    };
+
+public:
+    void
+    testBatchSize ()
+    {
+        testcase ("batch size");
+
+        BEAST_EXPECT(ReceivedTransactions::acceptable (1));
+        BEAST_EXPECT(ReceivedTransactions::acceptable (
+            Tuning::maxTransactionBatch));
+        BEAST_EXPECT(! ReceivedTransactions::acceptable (
+            Tuning::maxTransactionBatch + 1));
+    }
+
+    void
+    testFee ()
+    {
+        testcase ("fee");
+
+        auto const& light = Resource::feeLightPeer;
+        BEAST_EXPECT(ReceivedTransactions::fee (1) == light);
+
+        // A batch costs what its transactions would one by one
+        for (int count : {2, 10, int {Tuning::maxTransactionBatch}})
+        {
+            auto const fee = ReceivedTransactions::fee (count);
+            BEAST_EXPECT(fee.cost () == light.cost () * count);
+            BEAST_EXPECT(fee.label () == light.label ());
+        }
+    }
+
+    void
+    testLimit ()
+    {
+        testcase ("limit");
+
+        ReceivedTransactions received (250);
+
+        auto first = received.hold (200);
+        BEAST_EXPECT(first);
+        BEAST_EXPECT(received.pending () == 200);
+
+        // A batch is taken whole or not at all
+        BEAST_EXPECT(! received.hold (51));
+        BEAST_EXPECT(received.pending () == 200);
+
+        auto second = received.hold (50);
+        BEAST_EXPECT(second);
+        BEAST_EXPECT(received.pending () == 250);
+        BEAST_EXPECT(! received.hold (1));
+
+        // Every copy of a hold must go before its batch is released
+        auto copy = first;
+        first.reset ();
+        BEAST_EXPECT(received.pending () == 250);
+        copy.reset ();
+        BEAST_EXPECT(received.pending () == 50);
+        BEAST_EXPECT(received.hold (200));
+        BEAST_EXPECT(received.pending () == 50);
+    }
+
+    void
+    testJobs ()
+    {
+        testcase ("jobs");
+
+        ReceivedTransactions received (250);
+        Queue queue;
+
+        // A queued batch counts until its job has run and is gone
+        int checked = 0;
+        BEAST_EXPECT(queue.addJob (
+            [hold = received.hold (100), &checked] { checked += 100; }));
+        BEAST_EXPECT(received.pending () == 100);
+        queue.run ();
+        BEAST_EXPECT(checked == 100);
+        BEAST_EXPECT(received.pending () == 0);
+
+        // A job the queue refuses releases its batch at once
+        queue.stopping = true;
+        BEAST_EXPECT(! queue.addJob (
+            [hold = received.hold (100), &checked] { checked += 100; }));
+        BEAST_EXPECT(received.pending () == 0);
+        BEAST_EXPECT(checked == 100);
+    }
+
+    void
+    run () override
+    {
+        testBatchSize ();
+        testFee ();
+        testLimit ();
+        testJobs ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(received_transactions,overlay,ripple);
+
+}
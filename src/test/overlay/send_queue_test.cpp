@@ -0,0 +1,205 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/overlay/impl/SendQueue.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <ripple/protocol/jss.h>
+#include <ripple/beast/unit_test.h>
+
+namespace ripple {
+
+class send_queue_test : public beast::unit_test::suite
+{
+private:
+    static
+    Message::pointer
+    makeValidation ()
+    {
+        protocol::TMValidation v;
+        v.set_validation ("validation");
+        return std::make_shared<Message> (v, protocol::mtVALIDATION);
+    }
+
+    static
+    Message::pointer
+    makeTransaction ()
+    {
+        protocol::TMTransaction tx;
+        tx.set_rawtransaction ("transaction");
+        tx.set_status (protocol::tsNEW);
+        return std::make_shared<Message> (tx, protocol::mtTRANSACTION);
+    }
+
+    static
+    Message::pointer
+    makeLedgerData ()
+    {
+        protocol::TMLedgerData ld;
+        ld.set_ledgerhash (std::string (32, 'x'));
+        ld.set_ledgerseq (1);
+        ld.set_type (protocol::liAS_NODE);
+        return std::make_shared<Message> (ld, protocol::mtLEDGER_DATA);
+    }
+
+    // Write everything queued, returning the classes in order
+    static
+    std::vector<SendQueue::Priority>
+    drain (SendQueue& q)
+    {
+        std::vector<SendQueue::Priority> order;
+        while (! q.empty ())
+        {
+            order.push_back (SendQueue::classify (*q.next ()));
+            q.pop ();
+        }
+        return order;
+    }
+
+public:
+    void
+    testClassify ()
+    {
+        testcase ("classify");
+
+        BEAST_EXPECT(SendQueue::classify (*makeValidation ()) ==
+            SendQueue::consensus);
+        BEAST_EXPECT(SendQueue::classify (*makeTransaction ()) ==
+            SendQueue::normal);
+        BEAST_EXPECT(SendQueue::classify (*makeLedgerData ()) ==
+            SendQueue::bulk);
+    }
+
+    void
+    testOrder ()
+    {
+        testcase ("order");
+
+        SendQueue q (100);
+        for (int i = 0; i < 10; ++i)
+        {
+            BEAST_EXPECT(q.push (makeLedgerData ()));
+            BEAST_EXPECT(q.push (makeTransaction ()));
+        }
+        BEAST_EXPECT(q.push (makeValidation ()));
+        BEAST_EXPECT(q.size () == 21);
+
+        auto const order = drain (q);
+        BEAST_EXPECT(order.size () == 21);
+
+        // Consensus first, then normal and bulk by weight
+        BEAST_EXPECT(order[0] == SendQueue::consensus);
+        for (int i = 0; i < Tuning::sendNormalWeight; ++i)
+            BEAST_EXPECT(order[1 + i] == SendQueue::normal);
+        BEAST_EXPECT(order[1 + Tuning::sendNormalWeight] ==
+            SendQueue::bulk);
+        BEAST_EXPECT(order.back () == SendQueue::bulk);
+    }
+
+    void
+    testLimit ()
+    {
+        testcase ("limit");
+
+        SendQueue q (4);
+
+        // The message being written does not count
+        BEAST_EXPECT(q.push (makeLedgerData ()));
+        q.next ();
+
+        for (int i = 0; i < 2; ++i)
+        {
+            BEAST_EXPECT(q.push (makeLedgerData ()));
+            BEAST_EXPECT(q.push (makeTransaction ()));
+        }
+        BEAST_EXPECT(q.size () == 5);
+
+        // Bulk messages make room for anything more important
+        BEAST_EXPECT(q.push (makeValidation ()));
+        BEAST_EXPECT(q.push (makeTransaction ()));
+        BEAST_EXPECT(q.size () == 5);
+
+        // Nothing queued is less important than a transaction now,
+        // so the stalest transaction goes
+        BEAST_EXPECT(q.push (makeTransaction ()));
+        BEAST_EXPECT(q.size () == 5);
+
+        // And a bulk message has nothing it outranks
+        BEAST_EXPECT(! q.push (makeLedgerData ()));
+        BEAST_EXPECT(q.size () == 5);
+
+        auto const json = q.json ();
+        BEAST_EXPECT(json["bulk"][jss::dropped].asUInt () == 3);
+        BEAST_EXPECT(json["normal"][jss::dropped].asUInt () == 1);
+        BEAST_EXPECT(json["consensus"][jss::dropped].asUInt () == 0);
+        BEAST_EXPECT(json["bulk"][jss::depth].asUInt () == 1);
+        BEAST_EXPECT(json["normal"][jss::depth].asUInt () == 3);
+
+        q.pop ();
+        auto const order = drain (q);
+        BEAST_EXPECT(order.size () == 4);
+        BEAST_EXPECT(order[0] == SendQueue::consensus);
+        BEAST_EXPECT(q.json ()["normal"][jss::depth].asUInt () == 0);
+    }
+
+    void
+    testWritten ()
+    {
+        testcase ("written");
+
+        SendQueue q (2);
+
+        auto const writing = makeLedgerData ();
+        auto const dropped = makeLedgerData ();
+        auto const tx = makeTransaction ();
+        auto const validation = makeValidation ();
+
+        BEAST_EXPECT(q.push (writing));
+        q.next ();
+        BEAST_EXPECT(q.push (dropped));
+        BEAST_EXPECT(q.push (tx));
+        BEAST_EXPECT(q.push (validation));
+
+        // Only what was written comes back, so a message
+        // dropped to make room is never reported as sent
+        std::vector<Message::pointer> written;
+        written.push_back (q.pop ());
+        while (! q.empty ())
+        {
+            q.next ();
+            written.push_back (q.pop ());
+        }
+        BEAST_EXPECT(written.size () == 3);
+        BEAST_EXPECT(written[0] == writing);
+        BEAST_EXPECT(written[1] == validation);
+        BEAST_EXPECT(written[2] == tx);
+    }
+
+    void
+    run () override
+    {
+        testClassify ();
+        testOrder ();
+        testLimit ();
+        testWritten ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(send_queue,overlay,ripple);
+
+}
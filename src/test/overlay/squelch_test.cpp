@@ -0,0 +1,206 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/overlay/impl/Squelch.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <ripple/beast/unit_test.h>
+#include <algorithm>
+
+namespace ripple {
+
+class squelch_test : public beast::unit_test::suite
+{
+private:
+    static
+    PublicKey
+    makeKey (std::uint8_t n)
+    {
+        std::array<std::uint8_t, 33> buf;
+        buf.fill (n);
+        buf[0] = 0xED;
+        return PublicKey (makeSlice (buf));
+    }
+
+    std::uint64_t messages_ = 0;
+
+    // Have each peer relay a number of the validator's messages, each
+    // verified once the first peer relayed it
+    std::vector<SquelchSlots::Action>
+    relay (SquelchSlots& slots, PublicKey const& validator,
+        Peer::id_t peers, std::uint32_t times)
+    {
+        std::vector<SquelchSlots::Action> actions;
+        auto const add = [&](std::vector<SquelchSlots::Action> const& a)
+        {
+            actions.insert (actions.end (), a.begin (), a.end ());
+        };
+        for (std::uint32_t i = 0; i < times; ++i)
+        {
+            uint256 const key {++messages_};
+            for (Peer::id_t id = 1; id <= peers; ++id)
+            {
+                add (slots.update (validator, key, id));
+                if (id == 1)
+                    add (slots.verified (validator, key));
+            }
+        }
+        return actions;
+    }
+
+public:
+    void
+    testSquelch ()
+    {
+        testcase ("squelch");
+
+        using namespace std::chrono;
+        auto const validator = makeKey (1);
+        Squelch squelch;
+
+        BEAST_EXPECT(! squelch.isSquelched (validator));
+        BEAST_EXPECT(! squelch.squelch (validator, seconds{0}));
+        BEAST_EXPECT(! squelch.squelch (validator,
+            Tuning::squelchMaxDuration + seconds{1}));
+        BEAST_EXPECT(! squelch.isSquelched (validator));
+
+        BEAST_EXPECT(squelch.squelch (validator, Tuning::squelchMinDuration));
+        BEAST_EXPECT(squelch.isSquelched (validator));
+        BEAST_EXPECT(! squelch.isSquelched (makeKey (2)));
+
+        squelch.unsquelch (validator);
+        BEAST_EXPECT(! squelch.isSquelched (validator));
+    }
+
+    void
+    testSelect ()
+    {
+        testcase ("select");
+
+        using namespace std::chrono;
+        auto const validator = makeKey (1);
+        auto const peers = Tuning::squelchSelectedPeers + 1;
+        SquelchSlots slots;
+
+        // Nothing happens until enough sources reach the threshold
+        BEAST_EXPECT(relay (slots, validator, peers,
+            Tuning::squelchMessageThreshold - 1).empty ());
+        BEAST_EXPECT(slots.selected (validator).empty ());
+
+        // The last source is squelched once the others are selected
+        auto actions = relay (slots, validator, peers, 1);
+        BEAST_EXPECT(actions.size () == 1);
+        BEAST_EXPECT(actions[0].peer == peers);
+        BEAST_EXPECT(actions[0].validator == validator);
+        BEAST_EXPECT(actions[0].squelch);
+        BEAST_EXPECT(actions[0].duration >= Tuning::squelchMinDuration &&
+            actions[0].duration <= Tuning::squelchMaxDuration);
+
+        auto selected = slots.selected (validator);
+        BEAST_EXPECT(selected.size () == Tuning::squelchSelectedPeers);
+        BEAST_EXPECT(std::find (selected.begin (), selected.end (), peers) ==
+            selected.end ());
+        BEAST_EXPECT(slots.selected (makeKey (2)).empty ());
+
+        // Squelched sources are told once
+        BEAST_EXPECT(relay (slots, validator, peers, 5).empty ());
+
+        // A new source is squelched for what remains
+        actions = slots.update (validator, uint256 {messages_}, peers + 1);
+        BEAST_EXPECT(actions.size () == 1);
+        BEAST_EXPECT(actions[0].squelch);
+        BEAST_EXPECT(actions[0].duration <= Tuning::squelchMaxDuration);
+
+        BEAST_EXPECT(slots.expire ().empty ());
+        BEAST_EXPECT(slots.selected (validator).size () ==
+            Tuning::squelchSelectedPeers);
+
+        // An unselected source leaving changes nothing
+        BEAST_EXPECT(slots.remove (peers).empty ());
+        BEAST_EXPECT(slots.selected (validator).size () ==
+            Tuning::squelchSelectedPeers);
+
+        // A selected source leaving unsquelches the rest
+        actions = slots.remove (selected[0]);
+        BEAST_EXPECT(actions.size () == 1);
+        BEAST_EXPECT(actions[0].peer == peers + 1);
+        BEAST_EXPECT(! actions[0].squelch);
+        BEAST_EXPECT(slots.selected (validator).empty ());
+
+        // And counting starts over
+        BEAST_EXPECT(relay (slots, validator, peers,
+            Tuning::squelchMessageThreshold - 1).empty ());
+    }
+
+    void
+    testCount ()
+    {
+        testcase ("count");
+
+        auto const validator = makeKey (1);
+        auto const peers = Tuning::squelchSelectedPeers + 1;
+        SquelchSlots slots;
+
+        // Copies of a message are not counted before it is verified,
+        // and a peer relaying the same message again counts once
+        std::vector<uint256> keys;
+        for (std::uint32_t i = 0; i < Tuning::squelchMessageThreshold; ++i)
+        {
+            keys.emplace_back (++messages_);
+            for (int repeat = 0; repeat < 3; ++repeat)
+            {
+                for (Peer::id_t id = 1; id <= peers; ++id)
+                {
+                    BEAST_EXPECT(slots.update (
+                        validator, keys.back (), id).empty ());
+                }
+            }
+        }
+        BEAST_EXPECT(slots.selected (validator).empty ());
+
+        // Verifying all but the last leaves every peer one short,
+        // and verifying a message again counts nothing more
+        for (std::size_t i = 0; i + 1 < keys.size (); ++i)
+            BEAST_EXPECT(slots.verified (validator, keys[i]).empty ());
+        BEAST_EXPECT(slots.verified (validator, keys[0]).empty ());
+        BEAST_EXPECT(slots.selected (validator).empty ());
+
+        // Verifying the last one counts every peer that relayed it
+        auto const actions = slots.verified (validator, keys.back ());
+        BEAST_EXPECT(actions.size () == 1);
+        BEAST_EXPECT(slots.selected (validator).size () ==
+            Tuning::squelchSelectedPeers);
+
+        // A message we never saw is not counted
+        BEAST_EXPECT(slots.verified (makeKey (2),
+            uint256 {++messages_}).empty ());
+        BEAST_EXPECT(slots.selected (makeKey (2)).empty ());
+    }
+
+    void
+    run () override
+    {
+        testSquelch ();
+        testSelect ();
+        testCount ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(squelch,overlay,ripple);
+
+}
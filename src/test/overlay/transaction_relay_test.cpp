@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/overlay/impl/ProtocolMessage.h>
+#include <ripple/overlay/impl/TransactionRelay.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <ripple/beast/unit_test.h>
+#include <boost/beast/core/multi_buffer.hpp>
+
+namespace ripple {
+
+class transaction_relay_test : public beast::unit_test::suite
+{
+private:
+    // Records the batches invokeProtocolMessage passes to a peer
+    struct Handler
+    {
+        std::shared_ptr<protocol::TMTransactions> batch;
+
+        boost::system::error_code
+        onMessageUnknown (std::uint16_t)
+        {
+            return {};
+        }
+
+        boost::system::error_code
+        onMessageBegin (std::uint16_t,
+            std::shared_ptr<::google::protobuf::Message> const&,
+            std::size_t, std::size_t)
+        {
+            return {};
+        }
+
+        void
+        onMessage (std::shared_ptr<protocol::TMTransactions> const& m)
+        {
+            batch = m;
+        }
+
+        template <class T>
+        void
+        onMessage (std::shared_ptr<T> const&)
+        {
+        }
+
+        void
+        onMessageEnd (std::uint16_t,
+            std::shared_ptr<::google::protobuf::Message> const&)
+        {
+        }
+    };
+
+    static
+    TransactionRelay::Transactions
+    makeTransactions (std::size_t count)
+    {
+        TransactionRelay::Transactions txs (count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            txs[i].first.set_rawtransaction (
+                std::to_string (i) + std::string (100, 'x'));
+            txs[i].first.set_status (protocol::tsCURRENT);
+        }
+        return txs;
+    }
+
+    // Returns the raw transactions carried by messages, in order
+    std::vector<std::string>
+    contents (std::vector<std::shared_ptr<Message>> const& messages,
+        bool compressed)
+    {
+        std::vector<std::string> result;
+        for (auto const& m : messages)
+        {
+            auto const& buffer = m->getBuffer (compressed);
+            boost::beast::multi_buffer mb;
+            mb.commit (boost::asio::buffer_copy (
+                mb.prepare (buffer.size ()), boost::asio::buffer (buffer)));
+
+            Handler handler;
+            auto const type = Message::type (buffer.begin (), buffer.end ());
+            if (type == protocol::mtTRANSACTIONS)
+            {
+                auto const [consumed, ec] =
+                    invokeProtocolMessage (mb.data (), handler, compressed);
+                BEAST_EXPECT(! ec && consumed == buffer.size ());
+                if (! BEAST_EXPECT(handler.batch))
+                    continue;
+                for (auto const& t : handler.batch->transactions ())
+                    result.push_back (t.rawtransaction ());
+            }
+            else if (BEAST_EXPECT(type == protocol::mtTRANSACTION))
+            {
+                protocol::TMTransaction t;
+                BEAST_EXPECT(t.ParseFromArray (
+                    buffer.data () + Message::kHeaderBytes,
+                    buffer.size () - Message::kHeaderBytes));
+                result.push_back (t.rawtransaction ());
+            }
+        }
+        return result;
+    }
+
+public:
+    void
+    testReceive ()
+    {
+        testcase ("receive");
+
+        auto const txs = makeTransactions (Tuning::maxTransactionBatch);
+        TransactionRelay relay (txs);
+        auto const messages = relay.messages (1, true);
+        BEAST_EXPECT(messages.size () == 1);
+
+        // The whole batch arrives as one message, compressed or not
+        for (bool compressed : {false, true})
+        {
+            auto const received = contents (messages, compressed);
+            BEAST_EXPECT(received.size () == txs.size ());
+            for (std::size_t i = 0; i < received.size (); ++i)
+                BEAST_EXPECT(received[i] == txs[i].first.rawtransaction ());
+        }
+    }
+
+    void
+    testSplit ()
+    {
+        testcase ("split");
+
+        auto const n = Tuning::maxTransactionBatch * 2 + 50;
+        auto txs = makeTransactions (n);
+
+        // Peer 2 has the first transaction, peer 3 has all but the last
+        txs[0].second.insert (2);
+        for (std::size_t i = 0; i + 1 < txs.size (); ++i)
+            txs[i].second.insert (3);
+
+        TransactionRelay relay (txs);
+
+        // A batching peer gets everything in as few messages as possible
+        auto const all = relay.messages (1, true);
+        BEAST_EXPECT(all.size () == 3);
+        auto received = contents (all, false);
+        BEAST_EXPECT(received.size () == n);
+        for (std::size_t i = 0; i < received.size (); ++i)
+            BEAST_EXPECT(received[i] == txs[i].first.rawtransaction ());
+
+        // Peers lacking the same transactions share the messages
+        auto const same = relay.messages (4, true);
+        BEAST_EXPECT(same == all);
+
+        // A peer is not sent what it has
+        auto const most = relay.messages (2, true);
+        BEAST_EXPECT(most.size () == 3);
+        BEAST_EXPECT(most[0] != all[0]);
+        received = contents (most, false);
+        BEAST_EXPECT(received.size () == n - 1);
+        BEAST_EXPECT(received.front () == txs[1].first.rawtransaction ());
+
+        // A single transaction is not batched
+        auto const last = relay.messages (3, true);
+        BEAST_EXPECT(last.size () == 1);
+        received = contents (last, false);
+        BEAST_EXPECT(received.size () == 1 &&
+            received[0] == txs.back ().first.rawtransaction ());
+
+        // Peers that do not batch get one message per transaction,
+        // shared with the other peers
+        auto const singles = relay.messages (5, false);
+        BEAST_EXPECT(singles.size () == n);
+        BEAST_EXPECT(singles.back () == last[0]);
+        BEAST_EXPECT(contents (singles, false).size () == n);
+    }
+
+    void
+    run () override
+    {
+        testReceive ();
+        testSplit ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(transaction_relay,overlay,ripple);
+
+}
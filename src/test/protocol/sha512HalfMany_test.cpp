@@ -0,0 +1,144 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <ripple/protocol/digest.h>
+#include <ripple/basics/Blob.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <algorithm>
+#include <vector>
+
+namespace ripple {
+
+class sha512HalfMany_test : public beast::unit_test::suite
+{
+    beast::xor_shift_engine eng_ {98765};
+
+    // Checks sha512HalfMany, and each kernel the processor
+    // supports, against sha512Half for messages of the given sizes
+    void
+    check (std::vector<std::size_t> const& sizes)
+    {
+        std::vector<Blob> blobs;
+        std::vector<Slice> messages;
+        blobs.reserve (sizes.size());
+        for (auto size : sizes)
+        {
+            blobs.emplace_back (size);
+            beast::rngfill (blobs.back().data(), size, eng_);
+            messages.push_back (makeSlice (blobs.back()));
+        }
+
+        std::vector<uint256> expected;
+        for (auto const& m : messages)
+            expected.push_back (sha512Half (m));
+
+        std::vector<uint256> digests (messages.size());
+        sha512HalfMany (messages.data(), digests.data(), messages.size());
+        BEAST_EXPECT(digests == expected);
+
+        for (auto const& kernel : detail::sha512Kernels())
+        {
+            std::fill (digests.begin(), digests.end(), uint256{});
+            detail::sha512HalfMany (messages.data(), digests.data(),
+                messages.size(), &kernel);
+            BEAST_EXPECTS(digests == expected, kernel.name);
+        }
+    }
+
+    void
+    testEmpty()
+    {
+        testcase ("empty");
+
+        sha512HalfMany (nullptr, nullptr, 0);
+        pass();
+
+        check ({0});
+        check ({0, 0, 0, 0, 0, 0, 0, 0, 0});
+    }
+
+    void
+    testBoundaries()
+    {
+        testcase ("padding boundaries");
+
+        // Sizes around the points where padding spills into
+        // another block
+        std::vector<std::size_t> sizes;
+        for (std::size_t size = 100; size < 150; ++size)
+            sizes.push_back (size);
+        for (std::size_t size = 230; size < 260; ++size)
+            sizes.push_back (size);
+        check (sizes);
+
+        // Enough of each size to fill every lane
+        sizes.clear();
+        for (std::size_t size : {111, 112, 239, 240})
+            sizes.insert (sizes.end(), 16, size);
+        check (sizes);
+    }
+
+    void
+    testNodes()
+    {
+        testcase ("tree nodes");
+
+        // The sizes of inner nodes and typical leaves, in varying
+        // counts so that some passes leave lanes idle
+        for (std::size_t count : {1, 2, 3, 5, 7, 8, 9, 17, 1000})
+        {
+            std::vector<std::size_t> sizes;
+            for (std::size_t i = 0; i < count; ++i)
+                sizes.push_back (i % 3 == 0 ? 516 : 36 + (i * 37) % 400);
+            check (sizes);
+        }
+    }
+
+    void
+    testKernels()
+    {
+        testcase ("kernels");
+
+        for (auto const& kernel : detail::sha512Kernels())
+            log << "sha512HalfMany kernel: " << kernel.name << std::endl;
+
+        // Every lane of each kernel, on messages of one to three blocks
+        std::vector<std::size_t> sizes;
+        for (std::size_t i = 0; i < 48; ++i)
+            sizes.push_back (1 + i * 7);
+        check (sizes);
+    }
+
+public:
+    void
+    run() override
+    {
+        testEmpty();
+        testBoundaries();
+        testNodes();
+        testKernels();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(sha512HalfMany,protocol,ripple);
+
+} // ripple
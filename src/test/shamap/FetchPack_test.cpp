@@ -28,7 +28,9 @@
 #include <test/shamap/common.h>
 #include <test/unit_test/SuiteJournal.h>
 #include <functional>
+#include <limits>
 #include <stdexcept>
+#include <thread>
 
 namespace ripple {
 namespace tests {
@@ -115,6 +117,53 @@ public:
         map.emplace (hash, blob);
     }
 
+    void testConcurrent (TestFamily& f)
+    {
+        testcase ("concurrent");
+
+        beast::xor_shift_engine r;
+        auto const t1 = std::make_shared <Table> (SHAMapType::FREE, f);
+        add_random_items (5000, *t1, r);
+        t1->getHash ();
+        auto const t2 = t1->snapShot (true);
+        add_random_items (200, *t2, r);
+        t2->getHash ();
+
+        Map expected;
+        t2->visitDifferences (t1.get (), [&](SHAMapAbstractNode& node)
+            {
+                Serializer s;
+                node.addRaw (s, snfPREFIX);
+                expected.emplace (node.getNodeHash (), s.peekData ());
+                return true;
+            });
+
+        // A pack built while another is under way is built
+        // on its own thread, and is just as complete
+        Map outer;
+        Map inner;
+        auto const max = std::numeric_limits<int>::max ();
+        t2->getFetchPack (t1.get (), true, max,
+            [&](SHAMapHash const& hash, Blob const& blob)
+            {
+                if (inner.empty ())
+                {
+                    auto const id = std::this_thread::get_id ();
+                    bool here = true;
+                    t2->getFetchPack (t1.get (), true, max,
+                        [&](SHAMapHash const& h, Blob const& b)
+                        {
+                            here = here && std::this_thread::get_id () == id;
+                            on_fetch (inner, h, b);
+                        });
+                    BEAST_EXPECT(here);
+                }
+                on_fetch (outer, hash, blob);
+            });
+        BEAST_EXPECT(outer == expected);
+        BEAST_EXPECT(inner == expected);
+    }
+
     void run () override
     {
         using namespace beast::severities;
@@ -126,6 +175,8 @@ public:
 
         pass ();
 
+        testConcurrent (f);
+
 //         beast::Random r;
 //         add_random_items (tableItems, *t1, r);
 //         std::shared_ptr <Table> t2 (t1->snapShot (true));
@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <ripple/shamap/SHAMap.h>
+#include <ripple/basics/BasicConfig.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/protocol/digest.h>
+#include <test/shamap/common.h>
+#include <test/unit_test/SuiteJournal.h>
+#include <boost/algorithm/string.hpp>
+#include <chrono>
+#include <limits>
+#include <thread>
+
+namespace ripple {
+namespace tests {
+
+/*  Measures the time taken to diff consecutive ledgers.
+
+    Builds a state map and a chain of ledgers, each modifying, adding
+    and deleting entries the way a busy mainnet ledger would, then
+    diffs every ledger with the one before it, first on one thread and
+    then on `threads` threads.
+
+    Arguments are comma separated key=value pairs: `items` in the map
+    (default 1000000), `changes` per ledger (default 5000), `ledgers`
+    (default 10) and `threads` (default the number of hardware threads).
+
+    Example:
+
+        --unittest=SHAMapCompare --unittest-arg=items=20000000,changes=20000
+*/
+class SHAMapCompare_test : public beast::unit_test::suite
+{
+    struct Result
+    {
+        std::size_t differences = 0;
+        std::chrono::microseconds elapsed {0};
+    };
+
+    Result
+    diff(std::vector<std::shared_ptr<SHAMap>> const& ledgers,
+        std::size_t threads)
+    {
+        using namespace std::chrono;
+
+        SHAMap::setWalkThreads(threads);
+        Result result;
+        for (std::size_t i = 1; i < ledgers.size(); ++i)
+        {
+            auto const start = steady_clock::now();
+            SHAMap::Delta delta;
+            BEAST_EXPECT(ledgers[i - 1]->compare(*ledgers[i], delta,
+                std::numeric_limits<int>::max()));
+            result.elapsed += duration_cast<microseconds>(
+                steady_clock::now() - start);
+            result.differences += delta.size();
+        }
+        return result;
+    }
+
+public:
+    void
+    run() override
+    {
+        testcase ("SHAMapCompare");
+        test::SuiteJournal journal ("SHAMapCompare_test", *this);
+
+        std::size_t items = 1000000;
+        std::size_t changes = 5000;
+        std::size_t ledgers = 10;
+        std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+        {
+            Section config;
+            std::vector <std::string> v;
+            boost::split (v, arg(), boost::algorithm::is_any_of (","));
+            config.append(v);
+            get_if_exists(config, "items", items);
+            get_if_exists(config, "changes", changes);
+            get_if_exists(config, "ledgers", ledgers);
+            get_if_exists(config, "threads", threads);
+        }
+
+        TestFamily f(journal);
+        auto map = std::make_shared<SHAMap>(SHAMapType::FREE, f);
+        for (std::size_t i = 0; i < items; ++i)
+        {
+            auto const key = sha512Half(i);
+            map->addItem(SHAMapItem{key, Blob(key.begin(), key.end())},
+                false, false);
+        }
+        map->flushDirty(hotACCOUNT_NODE, 1);
+        map->setImmutable();
+
+        // Most changes modify entries, the rest add and delete them
+        std::vector<std::shared_ptr<SHAMap>> chain {map};
+        std::size_t added = items;
+        for (std::size_t ledger = 0; ledger < ledgers; ++ledger)
+        {
+            auto next = chain.back()->snapShot(true);
+            for (std::size_t i = 0; i < changes; ++i)
+            {
+                auto const key = sha512Half(
+                    (ledger * changes + i) * 7 % items);
+                if (i % 10 == 0)
+                {
+                    next->delItem(key);
+                    auto const fresh = sha512Half(added++);
+                    next->addItem(SHAMapItem{fresh,
+                        Blob(fresh.begin(), fresh.end())}, false, false);
+                }
+                else
+                {
+                    Blob data(key.begin(), key.end());
+                    data.push_back(static_cast<std::uint8_t>(ledger));
+                    next->updateGiveItem(std::make_shared<SHAMapItem const>(
+                        key, std::move(data)), false, false);
+                }
+            }
+            next->flushDirty(hotACCOUNT_NODE, ledger + 2);
+            next->setImmutable();
+            chain.push_back(std::move(next));
+        }
+
+        auto const previous = SHAMap::setWalkThreads(threads);
+        auto const serial = diff(chain, 1);
+        auto const parallel = diff(chain, threads);
+        SHAMap::setWalkThreads(previous);
+        BEAST_EXPECT(serial.differences == parallel.differences);
+
+        log << items << " items, " << changes << " changes in each of " <<
+            ledgers << " ledgers, " << serial.differences / ledgers <<
+            " differences per ledger" << std::endl;
+        log << "1 thread: " << serial.elapsed.count() / ledgers <<
+            "us per diff" << std::endl;
+        log << threads << " threads: " << parallel.elapsed.count() / ledgers <<
+            "us per diff" << std::endl;
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(SHAMapCompare,shamap,ripple);
+
+} // tests
+} // ripple
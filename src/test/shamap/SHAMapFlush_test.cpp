@@ -0,0 +1,139 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <ripple/shamap/SHAMap.h>
+#include <ripple/basics/BasicConfig.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/protocol/digest.h>
+#include <test/shamap/common.h>
+#include <test/unit_test/SuiteJournal.h>
+#include <boost/algorithm/string.hpp>
+#include <chrono>
+#include <thread>
+
+namespace ripple {
+namespace tests {
+
+/*  Measures the time taken to flush the dirty nodes of a ledger.
+
+    Builds a state map, then repeatedly modifies a snapshot of it the
+    way a busy ledger would and flushes the snapshot to the node store,
+    first on one thread and then on `threads` threads.
+
+    Arguments are comma separated key=value pairs: `items` in the map
+    (default 1000000), `changes` per ledger (default 5000), `ledgers`
+    (default 20) and `threads` (default the number of hardware threads).
+
+    Example:
+
+        --unittest=SHAMapFlush --unittest-arg=items=5000000,changes=20000
+*/
+class SHAMapFlush_test : public beast::unit_test::suite
+{
+    struct Result
+    {
+        std::vector<SHAMapHash> hashes;
+        std::chrono::microseconds elapsed {0};
+        int flushed = 0;
+    };
+
+    Result
+    close(SHAMap& map, std::size_t threads, std::size_t changes,
+        std::size_t ledgers, std::size_t items)
+    {
+        using namespace std::chrono;
+
+        SHAMap::setFlushThreads(threads);
+        Result result;
+        for (std::size_t ledger = 0; ledger < ledgers; ++ledger)
+        {
+            auto next = map.snapShot(true);
+            for (std::size_t i = 0; i < changes; ++i)
+            {
+                auto const key = sha512Half((ledger * changes + i) % items);
+                Blob data(key.begin(), key.end());
+                data.push_back(static_cast<std::uint8_t>(ledger));
+                next->updateGiveItem(
+                    std::make_shared<SHAMapItem const>(key, std::move(data)),
+                        false, false);
+            }
+
+            auto const start = steady_clock::now();
+            result.flushed += next->flushDirty(hotACCOUNT_NODE, ledger + 2);
+            result.elapsed += duration_cast<microseconds>(
+                steady_clock::now() - start);
+            result.hashes.push_back(next->getHash());
+        }
+        return result;
+    }
+
+public:
+    void
+    run() override
+    {
+        testcase ("SHAMapFlush");
+        test::SuiteJournal journal ("SHAMapFlush_test", *this);
+
+        std::size_t items = 1000000;
+        std::size_t changes = 5000;
+        std::size_t ledgers = 20;
+        std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+        {
+            Section config;
+            std::vector <std::string> v;
+            boost::split (v, arg(), boost::algorithm::is_any_of (","));
+            config.append(v);
+            get_if_exists(config, "items", items);
+            get_if_exists(config, "changes", changes);
+            get_if_exists(config, "ledgers", ledgers);
+            get_if_exists(config, "threads", threads);
+        }
+
+        TestFamily f(journal);
+        SHAMap map(SHAMapType::FREE, f);
+        for (std::size_t i = 0; i < items; ++i)
+        {
+            auto const key = sha512Half(i);
+            map.addItem(SHAMapItem{key, Blob(key.begin(), key.end())},
+                false, false);
+        }
+        map.flushDirty(hotACCOUNT_NODE, 1);
+
+        auto const previous = SHAMap::setFlushThreads(threads);
+        auto const serial = close(map, 1, changes, ledgers, items);
+        auto const parallel = close(map, threads, changes, ledgers, items);
+        SHAMap::setFlushThreads(previous);
+        BEAST_EXPECT(serial.hashes == parallel.hashes);
+        BEAST_EXPECT(serial.flushed == parallel.flushed);
+
+        log << items << " items, " << changes << " changes in each of " <<
+            ledgers << " ledgers, " << serial.flushed / ledgers <<
+            " nodes flushed per ledger" << std::endl;
+        log << "1 thread: " << serial.elapsed.count() / ledgers <<
+            "us per ledger" << std::endl;
+        log << threads << " threads: " << parallel.elapsed.count() / ledgers <<
+            "us per ledger" << std::endl;
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(SHAMapFlush,shamap,ripple);
+
+} // tests
+} // ripple
@@ -0,0 +1,145 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <ripple/shamap/SHAMap.h>
+#include <ripple/basics/SlabAllocator.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/protocol/digest.h>
+#include <test/shamap/common.h>
+#include <test/unit_test/SuiteJournal.h>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+
+namespace ripple {
+namespace tests {
+
+/*  Compares the memory used by sparse and dense inner nodes.
+
+    Builds the same map of synthetic account state with each layout
+    and reports the number of inner nodes by branch count, the bytes
+    they occupy, the slab pool memory held by the whole map and the
+    time taken to build and hash the map. The argument is the number
+    of items, which defaults to one million; the main network state
+    holds tens of millions.
+
+    Example:
+
+        --unittest=SHAMapMemory --unittest-arg=20000000
+*/
+class SHAMapMemory_test : public beast::unit_test::suite
+{
+    struct Result
+    {
+        SHAMapHash hash;
+        std::array<std::uint64_t, 17> branches {};
+        std::uint64_t inner = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t pooled = 0;
+        std::chrono::milliseconds elapsed;
+    };
+
+    Result
+    build(std::size_t items, bool sparse, beast::Journal journal)
+    {
+        using namespace std::chrono;
+
+        SHAMapInnerNode::setSparse(sparse);
+        TestFamily f(journal);
+        SHAMap map(SHAMapType::FREE, f);
+        map.setUnbacked();
+
+        Result result;
+        auto const start = steady_clock::now();
+        for (std::size_t i = 0; i < items; ++i)
+        {
+            auto const key = sha512Half(i);
+            map.addItem(SHAMapItem{key, Blob(key.begin(), key.end())},
+                false, false);
+        }
+        result.hash = map.getHash();
+        result.elapsed = duration_cast<milliseconds>(
+            steady_clock::now() - start);
+        SHAMapInnerNode::setSparse(true);
+
+        map.visitNodes([&result](SHAMapAbstractNode& node)
+            {
+                if (node.isInner())
+                {
+                    auto const& inner =
+                        static_cast<SHAMapInnerNode const&>(node);
+                    ++result.inner;
+                    ++result.branches[inner.getBranchCount()];
+                    result.bytes += sizeof(SHAMapInnerNode) +
+                        inner.getCapacity() * (sizeof(SHAMapHash) +
+                            sizeof(std::shared_ptr<SHAMapAbstractNode>));
+                }
+                return true;
+            });
+        result.pooled = SlabPool::used();
+        return result;
+    }
+
+    void
+    report(char const* name, Result const& r)
+    {
+        log << name << ": " << r.inner << " inner nodes, " <<
+            r.bytes / r.inner << " bytes each, " <<
+            r.bytes / (1024 * 1024) << " MiB, built in " <<
+            r.elapsed.count() << "ms, " << r.pooled / (1024 * 1024) <<
+            " MiB of nodes and items in the slab pool" << std::endl;
+    }
+
+public:
+    void
+    run() override
+    {
+        testcase ("SHAMapMemory");
+        test::SuiteJournal journal ("SHAMapMemory_test", *this);
+
+        std::size_t items = 1000000;
+        if (! arg().empty())
+            items = std::strtoull(arg().c_str(), nullptr, 10);
+
+        auto const sparse = build(items, true, journal);
+        auto const dense = build(items, false, journal);
+        BEAST_EXPECT(sparse.hash == dense.hash);
+        BEAST_EXPECT(sparse.inner == dense.inner);
+
+        log << items << " items, inner nodes by branch count:";
+        for (int i = 1; i <= 16; ++i)
+        {
+            if (sparse.branches[i])
+                log << " " << i << ":" << sparse.branches[i];
+        }
+        log << std::endl;
+        report("Sparse", sparse);
+        report("Dense", dense);
+        log << std::fixed << std::setprecision(1) << "Sparse nodes use " <<
+            100. * sparse.bytes / dense.bytes << "% of the memory" <<
+            std::endl;
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(SHAMapMemory,shamap,ripple);
+
+} // tests
+} // ripple
@@ -25,6 +25,9 @@
 #include <ripple/beast/xor_shift_engine.h>
 #include <test/shamap/common.h>
 #include <test/unit_test/SuiteJournal.h>
+#include <algorithm>
+#include <limits>
+#include <sstream>
 
 namespace ripple {
 namespace tests {
@@ -85,8 +88,10 @@ public:
         return true;
     }
 
-    void run() override
+    void testSync (bool batched)
     {
+        testcase (batched ? "sync batched" : "sync");
+
         using namespace beast::severities;
         test::SuiteJournal journal ("SHAMapSync_test", *this);
 
@@ -178,16 +183,29 @@ public:
                 gotNodeIDs_b.empty())
                 fail("", __FILE__, __LINE__);
 
-            for (std::size_t i = 0; i < gotNodeIDs_b.size(); ++i)
+            if (batched)
             {
-                // Don't use BEAST_EXPECT here b/c it will be called a non-deterministic number of times
-                // and the number of tests run should be deterministic
-                if (!destination
-                         .addKnownNode(
-                             gotNodeIDs_b[i], makeSlice(gotNodes_b[i]), nullptr)
-                         .isUseful())
+                std::vector<std::pair<SHAMapNodeID, Slice>> nodes;
+                for (std::size_t i = 0; i < gotNodeIDs_b.size(); ++i)
+                    nodes.emplace_back (gotNodeIDs_b[i], makeSlice(gotNodes_b[i]));
+
+                auto const added = destination.addKnownNodes (nodes, nullptr);
+                if (!added.isUseful() || added.isInvalid())
                     fail("", __FILE__, __LINE__);
             }
+            else
+            {
+                for (std::size_t i = 0; i < gotNodeIDs_b.size(); ++i)
+                {
+                    // Don't use BEAST_EXPECT here b/c it will be called a non-deterministic number of times
+                    // and the number of tests run should be deterministic
+                    if (!destination
+                             .addKnownNode(
+                                 gotNodeIDs_b[i], makeSlice(gotNodes_b[i]), nullptr)
+                             .isUseful())
+                        fail("", __FILE__, __LINE__);
+                }
+            }
         }
         while (true);
 
@@ -199,6 +217,219 @@ public:
         destination.invariants();
     }
 
+    void testWalk ()
+    {
+        testcase ("walk");
+
+        test::SuiteJournal journal ("SHAMapSync_test", *this);
+
+        TestFamily f(journal), f2(journal);
+        SHAMap source (SHAMapType::FREE, f);
+        SHAMap destination (SHAMapType::FREE, f2);
+
+        for (int i = 0; i < 20000; ++i)
+            source.addItem (std::move (*makeRandomAS ()), false, false);
+        source.setImmutable ();
+        source.getHash ();
+
+        // Give the destination the top three levels of the map. The
+        // walks of the subtrees below them find the rest missing,
+        // which an unbacked map reports rather than throws.
+        std::vector<SHAMapNodeID> nodeIDs;
+        std::vector<Blob> nodes;
+        BEAST_EXPECT(source.getNodeFat (
+            SHAMapNodeID (), nodeIDs, nodes, false, 2));
+        destination.setUnbacked ();
+        destination.setSynching ();
+        BEAST_EXPECT(destination.addRootNode (source.getHash (),
+            makeSlice (nodes.front ()), snfWIRE, nullptr).isGood ());
+        std::vector<std::pair<SHAMapNodeID, Slice>> known;
+        for (std::size_t i = 1; i < nodeIDs.size (); ++i)
+            known.emplace_back (nodeIDs[i], makeSlice (nodes[i]));
+        BEAST_EXPECT(destination.addKnownNodes (known, nullptr).isGood ());
+
+        auto const walk = [&](std::size_t threads, int budget)
+        {
+            auto const saved = SHAMap::setWalkThreads (threads);
+            std::vector<SHAMapMissingNode> missing;
+            destination.walkMap (missing, budget);
+            SHAMap::setWalkThreads (saved);
+
+            std::vector<std::string> found;
+            for (auto const& m : missing)
+            {
+                std::ostringstream ss;
+                ss << m;
+                found.push_back (ss.str ());
+            }
+            std::sort (found.begin (), found.end ());
+            return found;
+        };
+
+        auto const all = walk (1, std::numeric_limits<int>::max ());
+        BEAST_EXPECT(all.size () > 256);
+        BEAST_EXPECT(f2.workers ().size () == 0);
+        BEAST_EXPECT(walk (4, std::numeric_limits<int>::max ()) == all);
+        BEAST_EXPECT(f2.workers ().size () == 3);
+
+        // Every walk stops at its budget, with nodes a serial walk finds
+        for (int budget : {1, 10, 100})
+        {
+            for (std::size_t threads : {1, 4})
+            {
+                auto const found = walk (threads, budget);
+                BEAST_EXPECT(found.size () == std::size_t (budget));
+                BEAST_EXPECT(std::includes (all.begin (), all.end (),
+                    found.begin (), found.end ()));
+            }
+        }
+    }
+
+    void testMalformedBatch ()
+    {
+        testcase ("malformed batch");
+
+        test::SuiteJournal journal ("SHAMapSync_test", *this);
+
+        TestFamily f(journal), f2(journal);
+        SHAMap source (SHAMapType::FREE, f);
+        SHAMap destination (SHAMapType::FREE, f2);
+
+        for (int i = 0; i < 1000; ++i)
+            source.addItem (std::move (*makeRandomAS ()), false, false);
+        source.setImmutable ();
+        source.getHash ();
+
+        // The root and the inner nodes below it
+        std::vector<SHAMapNodeID> nodeIDs;
+        std::vector<Blob> nodes;
+        BEAST_EXPECT(source.getNodeFat (
+            SHAMapNodeID (), nodeIDs, nodes, false, 1));
+        BEAST_EXPECT(nodeIDs.size () > 2);
+        destination.setSynching ();
+        BEAST_EXPECT(destination.addRootNode (source.getHash (),
+            makeSlice (nodes.front ()), snfWIRE, nullptr).isGood ());
+
+        // A node that cannot be decoded ends the batch
+        // but the valid nodes before it are added
+        Blob const malformed {1};
+        std::vector<std::pair<SHAMapNodeID, Slice>> batch;
+        for (std::size_t i = 1; i < nodeIDs.size (); ++i)
+            batch.emplace_back (nodeIDs[i], makeSlice (nodes[i]));
+        batch.emplace_back (nodeIDs.back (), makeSlice (malformed));
+        try
+        {
+            destination.addKnownNodes (batch, nullptr);
+            fail ("malformed node accepted");
+        }
+        catch (std::exception const&)
+        {
+            pass ();
+        }
+
+        batch.pop_back ();
+        auto const again = destination.addKnownNodes (batch, nullptr);
+        BEAST_EXPECT(! again.isUseful () && ! again.isInvalid ());
+    }
+
+    void testStoredSync ()
+    {
+        testcase ("sync from node store");
+
+        using namespace std::chrono_literals;
+        test::SuiteJournal journal ("SHAMapSync_test", *this);
+
+        TestFamily f(journal), f2(journal);
+        SHAMap source (SHAMapType::FREE, f);
+        SHAMap previous (SHAMapType::FREE, f);
+        SHAMap destination (SHAMapType::FREE, f2);
+
+        // The destination's node store holds an earlier state
+        // which differs from the source in one item in fifty
+        int const items = 5000;
+        for (int i = 0; i < items; ++i)
+        {
+            auto const item = makeRandomAS ();
+            previous.addItem (SHAMapItem {*item}, false, false);
+            if (i % 50 == 0)
+                source.addItem (SHAMapItem {item->key(),
+                    Blob (16, static_cast<std::uint8_t>(i))}, false, false);
+            else
+                source.addItem (std::move (*item), false, false);
+        }
+        source.setImmutable ();
+        source.getHash ();
+        previous.getHash ();
+
+        int stored = 0;
+        previous.visitNodes ([&f2, &stored](SHAMapAbstractNode& node)
+            {
+                Serializer s;
+                node.addRaw (s, snfPREFIX);
+                f2.db().store (hotACCOUNT_NODE, std::move (s.modData ()),
+                    node.getNodeHash ().as_uint256 (), 0);
+                ++stored;
+                return true;
+            });
+
+        // Empty the cache so the stored nodes are read asynchronously
+        f2.db().tune (0, 0s);
+        f2.db().sweep ();
+        f2.db().sweep ();
+
+        // Few reads in flight, so the traversal resumes many times
+        auto const saved = SHAMap::setMissingReads (4);
+
+        std::vector<SHAMapNodeID> nodeIDs;
+        std::vector<Blob> nodes;
+        BEAST_EXPECT(source.getNodeFat (
+            SHAMapNodeID (), nodeIDs, nodes, false, 0));
+        destination.setSynching ();
+        BEAST_EXPECT(destination.addRootNode (source.getHash (),
+            makeSlice (nodes.front ()), snfWIRE, nullptr).isGood ());
+
+        int fetched = 0;
+        while (true)
+        {
+            auto const missing = destination.getMissingNodes (256, nullptr);
+            if (missing.empty ())
+                break;
+
+            for (auto const& [nodeID, hash] : missing)
+            {
+                nodeIDs.clear ();
+                nodes.clear ();
+                if (! source.getNodeFat (nodeID, nodeIDs, nodes, false, 0))
+                    fail ("", __FILE__, __LINE__);
+
+                for (std::size_t i = 0; i < nodeIDs.size (); ++i)
+                {
+                    ++fetched;
+                    if (! destination.addKnownNode (nodeIDs[i],
+                            makeSlice (nodes[i]), nullptr).isUseful ())
+                        fail ("", __FILE__, __LINE__);
+                }
+            }
+        }
+        SHAMap::setMissingReads (saved);
+
+        destination.clearSynching ();
+        BEAST_EXPECT(source.deepCompare (destination));
+
+        // Most of the map came from the node store
+        BEAST_EXPECT(fetched < stored / 4);
+        destination.invariants();
+    }
+
+    void run() override
+    {
+        testSync (false);
+        testSync (true);
+        testWalk ();
+        testMalformedBatch ();
+        testStoredSync ();
+    }
+
 };
 
 BEAST_DEFINE_TESTSUITE(SHAMapSync,shamap,ripple);
@@ -0,0 +1,145 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2019 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/shamap/SHAMapWorkers.h>
+#include <ripple/beast/unit_test.h>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+namespace tests {
+
+class SHAMapWorkers_test : public beast::unit_test::suite
+{
+    void
+    testRun()
+    {
+        testcase ("run");
+
+        SHAMapWorkers workers;
+        std::vector<std::atomic<int>> runs (1000);
+        workers.run (runs.size(), 3, [&](std::size_t i)
+            {
+                ++runs[i];
+                return true;
+            });
+        BEAST_EXPECT(std::all_of (runs.begin(), runs.end(),
+            [](auto const& n) { return n == 1; }));
+        BEAST_EXPECT(workers.size() == 3);
+
+        // Threads are kept, and not started for fewer helpers
+        workers.run (runs.size(), 2, [&](std::size_t i)
+            {
+                ++runs[i];
+                return true;
+            });
+        BEAST_EXPECT(std::all_of (runs.begin(), runs.end(),
+            [](auto const& n) { return n == 2; }));
+        BEAST_EXPECT(workers.size() == 3);
+
+        // Without helpers the tasks run on this thread
+        auto const id = std::this_thread::get_id();
+        bool here = true;
+        workers.run (100, 0, [&](std::size_t)
+            {
+                here = here && std::this_thread::get_id() == id;
+                return true;
+            });
+        BEAST_EXPECT(here);
+    }
+
+    void
+    testStop()
+    {
+        testcase ("stop");
+
+        SHAMapWorkers workers;
+
+        // No task starts after one returns false
+        std::atomic<std::size_t> started {0};
+        workers.run (1000, 0, [&](std::size_t i)
+            {
+                ++started;
+                return i < 9;
+            });
+        BEAST_EXPECT(started == 10);
+
+        // The first exception is rethrown to the caller
+        try
+        {
+            workers.run (1000, 3, [&](std::size_t i)
+                {
+                    if (i == 500)
+                        throw std::runtime_error ("task");
+                    return true;
+                });
+            fail ("no exception");
+        }
+        catch (std::runtime_error const& e)
+        {
+            BEAST_EXPECT(std::string (e.what()) == "task");
+        }
+    }
+
+    void
+    testConcurrent()
+    {
+        testcase ("concurrent");
+
+        // Calls made at once share the threads of the pool
+        SHAMapWorkers workers;
+        std::atomic<std::size_t> total {0};
+        std::vector<std::thread> callers;
+        for (int c = 0; c < 8; ++c)
+        {
+            callers.emplace_back ([&]
+            {
+                for (int n = 0; n < 20; ++n)
+                {
+                    workers.run (100, 4, [&](std::size_t)
+                        {
+                            ++total;
+                            return true;
+                        });
+                }
+            });
+        }
+        for (auto& t : callers)
+            t.join();
+        BEAST_EXPECT(total == 8 * 20 * 100);
+        BEAST_EXPECT(workers.size() == 4);
+    }
+
+public:
+    void
+    run() override
+    {
+        testRun();
+        testStop();
+        testConcurrent();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SHAMapWorkers,shamap,ripple);
+
+} // tests
+} // ripple
@@ -22,8 +22,10 @@
 #include <ripple/basics/StringUtilities.h>
 #include <ripple/beast/unit_test.h>
 #include <ripple/beast/utility/Journal.h>
+#include <ripple/protocol/digest.h>
 #include <test/shamap/common.h>
 #include <test/unit_test/SuiteJournal.h>
+#include <set>
 
 namespace ripple {
 namespace tests {
@@ -111,6 +113,123 @@ public:
 
         run (true,  journal);
         run (false, journal);
+
+        // Inner nodes that always allocate all 16 branches
+        SHAMapInnerNode::setSparse (false);
+        run (true,  journal);
+        SHAMapInnerNode::setSparse (true);
+
+        testFlushParallel (journal);
+        testCompareParallel (journal);
+    }
+
+    void testFlushParallel (beast::Journal const& journal)
+    {
+        testcase ("parallel flush");
+
+        tests::TestFamily f(journal);
+        SHAMap map (SHAMapType::FREE, f);
+        for (int i = 0; i < 20000; ++i)
+        {
+            auto const key = sha512Half (i);
+            map.addItem (SHAMapItem{key, Blob (key.begin(), key.end())},
+                false, false);
+        }
+        map.flushDirty (hotACCOUNT_NODE, 1);
+
+        // Enough changes to spread over several threads
+        auto flush = [&](std::size_t threads)
+        {
+            SHAMap::setFlushThreads (threads);
+            auto next = map.snapShot (true);
+            for (int i = 0; i < 20000; i += 3)
+            {
+                auto const key = sha512Half (i);
+                next->updateGiveItem (std::make_shared<SHAMapItem const>(
+                    key, IntToVUC (i)), false, false);
+            }
+            for (int i = 1; i < 20000; i += 7)
+                next->delItem (sha512Half (i));
+            auto const flushed = next->flushDirty (hotACCOUNT_NODE, 2);
+            next->invariants();
+            return std::make_pair (flushed, next->getHash());
+        };
+
+        auto const threads = SHAMap::setFlushThreads (1);
+        auto const serial = flush (1);
+        auto const parallel = flush (4);
+        SHAMap::setFlushThreads (threads);
+        BEAST_EXPECT(serial.first == parallel.first);
+        BEAST_EXPECT(serial.second == parallel.second);
+        BEAST_EXPECT(serial.second != map.getHash());
+    }
+
+    void testCompareParallel (beast::Journal const& journal)
+    {
+        testcase ("parallel compare");
+
+        tests::TestFamily f(journal);
+        SHAMap map (SHAMapType::FREE, f);
+        for (int i = 0; i < 20000; ++i)
+        {
+            auto const key = sha512Half (i);
+            map.addItem (SHAMapItem{key, Blob (key.begin(), key.end())},
+                false, false);
+        }
+        map.flushDirty (hotACCOUNT_NODE, 1);
+        map.setImmutable ();
+
+        // Enough differing subtrees to spread over several threads
+        auto next = map.snapShot (true);
+        for (int i = 0; i < 20000; i += 5)
+        {
+            auto const key = sha512Half (i);
+            next->updateGiveItem (std::make_shared<SHAMapItem const>(
+                key, IntToVUC (i)), false, false);
+        }
+        for (int i = 1; i < 20000; i += 50)
+            next->delItem (sha512Half (i));
+        for (int i = 20000; i < 20400; ++i)
+        {
+            auto const key = sha512Half (i);
+            next->addItem (SHAMapItem{key, Blob (key.begin(), key.end())},
+                false, false);
+        }
+        next->flushDirty (hotACCOUNT_NODE, 2);
+        next->setImmutable ();
+
+        auto const threads = SHAMap::setWalkThreads (1);
+        SHAMap::Delta serial;
+        BEAST_EXPECT(map.compare (*next, serial, 100000));
+        BEAST_EXPECT(serial.size () == 4000 + 400 + 400);
+
+        SHAMap::setWalkThreads (8);
+        SHAMap::Delta parallel;
+        BEAST_EXPECT(map.compare (*next, parallel, 100000));
+        BEAST_EXPECT(parallel == serial);
+
+        // The limit holds across threads
+        std::size_t count = 0;
+        BEAST_EXPECT(! map.compare (*next,
+            [&count](uint256 const&, SHAMap::DeltaItem&&) { ++count; }, 500));
+        BEAST_EXPECT(count == 500);
+
+        std::set<SHAMapHash> visited, visitedParallel;
+        next->visitDifferences (&map,
+            [&visited](SHAMapAbstractNode& node)
+            {
+                visited.insert (node.getNodeHash ());
+                return true;
+            });
+        next->visitDifferencesParallel (&map,
+            [&visitedParallel](SHAMapAbstractNode& node)
+            {
+                visitedParallel.insert (node.getNodeHash ());
+                return true;
+            });
+        BEAST_EXPECT(! visited.empty ());
+        BEAST_EXPECT(visited == visitedParallel);
+        SHAMap::setWalkThreads (threads);
     }
 
     void run (bool backed, beast::Journal const& journal)
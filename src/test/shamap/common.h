@@ -39,6 +39,7 @@ private:
     RootStoppable parent_;
     std::unique_ptr<NodeStore::Database> db_;
     bool shardBacked_;
+    SHAMapWorkers workers_;
     beast::Journal j_;
 
 public:
@@ -112,6 +113,18 @@ public:
         return shardBacked_;
     }
 
+    SHAMapWorkers&
+    workers() override
+    {
+        return workers_;
+    }
+
+    ParsedSLECache*
+    parsedSLEs() override
+    {
+        return nullptr;
+    }
+
     void
     missing_node (std::uint32_t refNum) override
     {
@@ -30,6 +30,7 @@
 #include <test/basics/PerfLog_test.cpp>
 #include <test/basics/qalloc_test.cpp>
 #include <test/basics/RangeSet_test.cpp>
+#include <test/basics/SlabAllocator_test.cpp>
 #include <test/basics/Slice_test.cpp>
 #include <test/basics/StringUtilities_test.cpp>
 #include <test/basics/TaggedCache_test.cpp>
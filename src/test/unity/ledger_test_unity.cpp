@@ -22,6 +22,7 @@
 #include <test/ledger/CashDiff_test.cpp>
 #include <test/ledger/Directory_test.cpp>
 #include <test/ledger/Invariants_test.cpp>
+#include <test/ledger/ParsedSLECache_test.cpp>
 #include <test/ledger/PaymentSandbox_test.cpp>
 #include <test/ledger/PendingSaves_test.cpp>
 #include <test/ledger/SkipList_test.cpp>
@@ -23,4 +23,5 @@
 #include <test/nodestore/Database_test.cpp>
 #include <test/nodestore/import_test.cpp>
 #include <test/nodestore/Timing_test.cpp>
+#include <test/nodestore/TraceReplay_test.cpp>
 #include <test/nodestore/varint_test.cpp>
\ No newline at end of file
@@ -18,6 +18,12 @@
 */
 //==============================================================================
 
+#include <test/overlay/broadcast_test.cpp>
 #include <test/overlay/cluster_test.cpp>
+#include <test/overlay/compression_test.cpp>
+#include <test/overlay/received_transactions_test.cpp>
+#include <test/overlay/send_queue_test.cpp>
 #include <test/overlay/short_read_test.cpp>
+#include <test/overlay/squelch_test.cpp>
+#include <test/overlay/transaction_relay_test.cpp>
 #include <test/overlay/TMHello_test.cpp>
\ No newline at end of file
@@ -19,5 +19,9 @@
 //==============================================================================
 
 #include <test/shamap/FetchPack_test.cpp>
+#include <test/shamap/SHAMapCompare_test.cpp>
+#include <test/shamap/SHAMapFlush_test.cpp>
+#include <test/shamap/SHAMapMemory_test.cpp>
 #include <test/shamap/SHAMapSync_test.cpp>
-#include <test/shamap/SHAMap_test.cpp>
\ No newline at end of file
+#include <test/shamap/SHAMap_test.cpp>
+#include <test/shamap/SHAMapWorkers_test.cpp>
\ No newline at end of file